@@ -9,7 +9,10 @@
 #include "mock_ui/PreviewEventLogger.h"
 #include "ui/mock/PreviewSubscriber.h"
 #include "services/catalog/CatalogService.h"
+#include "services/catalog/SyncReconciler.h"
+#include "services/catalog/SyncWatcher.h"
 #include "services/delivery/DeliveryService.h"
+#include "services/ingest/IngestJob.h"
 #include "services/ingest/IngestService.h"
 #include "services/metadata/MetadataService.h"
 #include "services/preview/PreviewService.h"
@@ -32,15 +35,10 @@ void Application::bootstrap() {
   const auto root_id = catalog_service.registerRoot(root_path);
   const auto snapshot = catalog_service.scanRoot(root_path);
   catalog_service.ingestRecords(root_id, snapshot);
-  catalog_service.enqueueSyncEvent(root_id, "", "bootstrap", "{}");
-  auto pending_events = catalog_service.pendingSyncEvents();
-  if (!pending_events.empty()) {
-    catalog_service.markSyncEventProcessed(pending_events.front().id);
-    pending_events = catalog_service.pendingSyncEvents();
-  }
-  const auto stored_files = catalog_service.listFiles(root_id);
 
-  services::preview::PreviewService preview_service;
+  // One pool for every service; declared first so it outlives them.
+  services::tasks::TaskScheduler scheduler;
+  services::preview::PreviewService preview_service(64, 8, 0, &scheduler);
   preview_service.setCatalogService(&catalog_service);
   mock_ui::PreviewEventLogger preview_logger;
   ui::mock::PreviewSubscriber contact_sheet("ContactSheet");
@@ -55,8 +53,47 @@ void Application::bootstrap() {
   preview_service.primeCaches(2);
   preview_service.warmRoot(root_id, root_path);
 
-  services::ingest::IngestService ingest_service;
+  // sync_queue is applied to the catalog as it fills, in batches on the
+  // maintenance lane, and cached previews of the files a batch touched are
+  // dropped. Whatever an earlier session left queued is applied first.
+  services::catalog::SyncReconciler sync_reconciler(
+      catalog_service, root_id, root_path, {}, &scheduler);
+  sync_reconciler.setChangeSink(
+      [&](int changed_root, const services::catalog::SyncOutcome& outcome) {
+        preview_service.invalidatePreviews(changed_root, outcome.changed);
+        preview_service.invalidatePreviews(changed_root, outcome.removed);
+      });
+  sync_reconciler.drain();
+  const auto stored_files = catalog_service.listFiles(root_id);
+  // Changes made to the root from here on reach sync_queue as they happen.
+  // Without inotify (start() fails) the next bootstrap scan catches them.
+  services::catalog::SyncWatcher sync_watcher(catalog_service, root_id, root_path);
+  sync_watcher.setQueuedSink([&](std::size_t) { sync_reconciler.wake(); });
+  [[maybe_unused]] const auto watch_error = sync_watcher.start();
+
+  services::ingest::IngestService ingest_service(&scheduler);
   ingest_service.queueSources({});
+  // Ingests an earlier session left unfinished carry on from their journal.
+  // Each catalog batch goes straight to the preview pipeline, reusing the
+  // leading bytes the copy already read.
+  services::ingest::IngestJob::Options ingest_options;
+  ingest_options.copy.head_bytes = services::preview::PreviewExtractor::kLeadingBytes;
+  for (const auto& job : catalog_service.unfinishedIngestJobs()) {
+    const std::filesystem::path destination_root(job.destination_root);
+    services::ingest::IngestJob(catalog_service, job.id, ingest_options, &scheduler)
+        .run({}, [&](int destination_id,
+                     const std::vector<services::ingest::CatalogedFile>& files) {
+          std::vector<services::preview::PreviewDescriptor> descriptors;
+          descriptors.reserve(files.size());
+          for (const auto& file : files) {
+            auto& descriptor = descriptors.emplace_back(services::preview::DirectoryScanner::describe(
+                destination_root, file.record.absolute_path));
+            descriptor.file_id = file.file_id;
+            descriptor.head = file.head;
+          }
+          preview_service.publishFiles(destination_id, std::move(descriptors));
+        });
+  }
 
   services::metadata::MetadataService metadata_service;
   metadata_service.applyTemplate("bootstrap");
@@ -64,8 +101,10 @@ void Application::bootstrap() {
   services::delivery::DeliveryService delivery_service;
   delivery_service.configureEndpoint("localhost");
 
-  services::tasks::TaskScheduler scheduler;
-  scheduler.schedule("bootstrap");
+  const auto bootstrap_task = scheduler.submit(
+      services::tasks::Lane::kMaintenance,
+      [](std::stop_token) {},
+      {.name = "bootstrap"});
 
   if (!snapshot.empty()) {
     preview_service.requestPreview(root_id, snapshot.front().relative_path);
@@ -79,6 +118,7 @@ void Application::bootstrap() {
                         : preview_service.cachedPreview(cache_key);
 
   preview_service.waitUntilIdle();
+  bootstrap_task.wait();
 
   std::size_t cache_hits = 0;
   std::size_t cache_misses = 0;
@@ -98,8 +138,9 @@ void Application::bootstrap() {
   [[maybe_unused]] const auto queued_sources = ingest_service.sources().size();
   [[maybe_unused]] const auto last_template = metadata_service.lastTemplate();
   [[maybe_unused]] const auto endpoint = delivery_service.endpoint();
-  [[maybe_unused]] const auto scheduled_tasks = scheduler.size();
-  [[maybe_unused]] const auto sync_backlog = pending_events.size();
+  [[maybe_unused]] const auto scheduled_tasks =
+      scheduler.laneStats(services::tasks::Lane::kMaintenance).completed;
+  [[maybe_unused]] const auto sync_backlog = catalog_service.pendingSyncEvents().size();
   [[maybe_unused]] const auto platform_name = platform_.displayName();
   [[maybe_unused]] const auto profile = settings_.activeProfile();
   (void)catalog_size;
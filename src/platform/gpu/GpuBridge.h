@@ -1,21 +1,80 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "services/preview/PreviewTypes.h"
 
 namespace cataloger::platform::gpu {
 
-enum class Backend { kMetal, kStub };
+enum class Backend { kMetal, kSoftware, kStub };
+
+struct ResidencyStats {
+  std::size_t resident_textures{0};
+  std::size_t resident_bytes{0};   // texel bytes of live textures
+  std::size_t allocated_bytes{0};  // backing memory, pooled storage included
+  std::size_t budget_bytes{0};
+  std::uint64_t uploads{0};
+  std::uint64_t reuses{0};  // uploads served from pooled storage
+  std::uint64_t evictions{0};
+};
+
+struct UploadOutcome {
+  bool ok{false};
+  std::string error;
+};
 
 class GpuBridge {
 public:
+  // Called with the cache key of every texture that stops being resident,
+  // whether evicted for budget or on request. Never called under bridge locks.
+  using EvictionHandler = std::function<void(const std::string& cache_key)>;
+
   virtual ~GpuBridge() = default;
   virtual bool upload(const cataloger::services::preview::PreviewImage& image,
                       std::string& error) = 0;
+  // Uploads several images as one submission and waits for all of them.
+  // The default uploads them one at a time.
+  virtual std::vector<UploadOutcome> uploadBatch(
+      std::span<const cataloger::services::preview::PreviewImage* const> images) {
+    std::vector<UploadOutcome> outcomes(images.size());
+    for (std::size_t i = 0; i < images.size(); ++i) {
+      outcomes[i].ok = upload(*images[i], outcomes[i].error);
+    }
+    return outcomes;
+  }
   [[nodiscard]] virtual Backend backend() const noexcept = 0;
   [[nodiscard]] virtual std::string textureDebugLabel() const { return {}; }
+
+  // Residency. Backends that do not track textures report nothing resident;
+  // callers treat their successful uploads as resident until told otherwise.
+  [[nodiscard]] virtual bool tracksResidency() const noexcept { return false; }
+  [[nodiscard]] virtual bool isResident(const std::string&) const { return false; }
+  virtual bool evict(const std::string&) { return false; }
+  // Marks a resident texture as just used, so budget eviction takes it last.
+  virtual void touch(const std::string&) {}
+  virtual void setBudget(std::size_t) {}
+  [[nodiscard]] virtual ResidencyStats residency() const { return {}; }
+
+  void setEvictionHandler(EvictionHandler handler) {
+    eviction_handler_ = std::move(handler);
+  }
+
+protected:
+  void notifyEvicted(const std::string& cache_key) const {
+    if (eviction_handler_) {
+      eviction_handler_(cache_key);
+    }
+  }
+
+private:
+  EvictionHandler eviction_handler_;
 };
 
 std::unique_ptr<GpuBridge> CreateBridge();
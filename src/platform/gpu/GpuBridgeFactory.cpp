@@ -1,30 +1,10 @@
 #include "GpuBridge.h"
 
 #include <memory>
-#include <string>
 
-namespace cataloger::platform::gpu {
-
-namespace {
-
-class StubBridge : public GpuBridge {
-public:
-  bool upload(const cataloger::services::preview::PreviewImage&,
-              std::string& error) override {
-    error = "GPU backend unavailable on this platform.";
-    return false;
-  }
+#include "SoftwareBridge.h"
 
-  Backend backend() const noexcept override {
-    return Backend::kStub;
-  }
-
-  std::string textureDebugLabel() const override {
-    return "none";
-  }
-};
-
-}  // namespace
+namespace cataloger::platform::gpu {
 
 #if defined(__APPLE__)
 std::unique_ptr<GpuBridge> CreateMetalBridge();
@@ -34,7 +14,7 @@ std::unique_ptr<GpuBridge> CreateBridge() {
 #if defined(__APPLE__)
   return CreateMetalBridge();
 #else
-  return std::make_unique<StubBridge>();
+  return CreateSoftwareBridge();
 #endif
 }
 
@@ -4,9 +4,17 @@
 
 #import <Metal/Metal.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <span>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "TextureResidency.h"
+
 namespace cataloger::platform::gpu {
 
 namespace {
@@ -20,127 +28,367 @@ std::vector<std::uint8_t> toBGRA(
                            static_cast<std::size_t>(image.height);
   std::vector<std::uint8_t> bgra(pixel_count * 4, 255);
   const auto src = image.pixels.data();
+  const auto bpp = static_cast<std::size_t>(
+      cataloger::services::preview::BytesPerPixel(image.layout));
   for (std::size_t i = 0, j = 0;
-       j < pixel_count && (i + 2) < image.pixels.size();
-       ++j, i += 3) {
+       j < pixel_count && (i + bpp - 1) < image.pixels.size();
+       ++j, i += bpp) {
     bgra[j * 4 + 0] = src[i + 2];  // B
     bgra[j * 4 + 1] = src[i + 1];  // G
     bgra[j * 4 + 2] = src[i + 0];  // R
+    if (bpp == 4) {
+      bgra[j * 4 + 3] = src[i + 3];  // A
+    }
   }
   return bgra;
 }
 
+void releaseObject(id object) {
+#if !__has_feature(objc_arc)
+  [object release];
+#else
+  (void)object;
+#endif
+}
+
+std::uint64_t bucketKey(int width, int height) {
+  return (static_cast<std::uint64_t>(width) << 32) | static_cast<std::uint32_t>(height);
+}
+
+// Textures are allocated at bucket size and kept in a per-bucket pool when
+// they stop being resident, so the next preview of similar size reuses one
+// instead of allocating. Resident plus pooled bytes stay under the budget.
 class MetalBridge : public GpuBridge {
 public:
   MetalBridge()
       : backend_(Backend::kMetal),
         device_(MTLCreateSystemDefaultDevice()),
         queue_(device_ ? [device_ newCommandQueue] : nil),
-        last_texture_label_("nil") {}
+        budget_(kDefaultBudget),
+        last_texture_label_("nil") {
+    if (device_ && [device_ respondsToSelector:@selector(recommendedMaxWorkingSetSize)]) {
+      // Leave the rest of the working set to the viewer and the system.
+      budget_ = static_cast<std::size_t>([device_ recommendedMaxWorkingSetSize] / 4);
+    }
+  }
+
+  ~MetalBridge() override {
+    for (auto& [key, entry] : textures_) {
+      releaseObject(entry.texture);
+    }
+    for (auto& [bucket, textures] : pool_) {
+      for (id<MTLTexture> texture : textures) {
+        releaseObject(texture);
+      }
+    }
+    releaseObject(queue_);
+    releaseObject(device_);
+  }
 
   bool upload(const cataloger::services::preview::PreviewImage& image,
               std::string& error) override {
-    @autoreleasepool {
-      if (!device_ || !queue_) {
-        error = "Metal device/queue unavailable.";
-        backend_ = Backend::kStub;
-        return false;
-      }
+    const cataloger::services::preview::PreviewImage* images[] = {&image};
+    auto outcomes = uploadBatch(images);
+    error = std::move(outcomes.front().error);
+    return outcomes.front().ok;
+  }
 
-      const auto bgra = toBGRA(image);
-      if (bgra.empty()) {
-        error = "Preview pixels missing or malformed.";
-        backend_ = Backend::kStub;
-        return false;
-      }
+  std::vector<UploadOutcome> uploadBatch(
+      std::span<const cataloger::services::preview::PreviewImage* const> images) override {
+    std::vector<UploadOutcome> outcomes(images.size());
+    std::vector<std::string> evicted;
+    encodeAndWait(images, outcomes, evicted);
+    for (const auto& key : evicted) {
+      notifyEvicted(key);
+    }
+    return outcomes;
+  }
 
-      const NSUInteger bytes_per_row =
-          static_cast<NSUInteger>(image.width) * 4;
-      const NSUInteger byte_count = bytes_per_row *
-                                    static_cast<NSUInteger>(image.height);
-      id<MTLBuffer> staging =
-          [device_ newBufferWithLength:byte_count options:MTLResourceStorageModeShared];
-      if (!staging) {
-        error = "Failed to allocate Metal staging buffer.";
-        backend_ = Backend::kStub;
-        return false;
-      }
-      std::memcpy([staging contents], bgra.data(), byte_count);
-
-      MTLTextureDescriptor* descriptor =
-          [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatBGRA8Unorm
-                                                             width:image.width
-                                                            height:image.height
-                                                         mipmapped:NO];
-      descriptor.usage = MTLTextureUsageShaderRead | MTLTextureUsageRenderTarget;
-      id<MTLTexture> texture = [device_ newTextureWithDescriptor:descriptor];
-      if (!texture) {
-        error = "Failed to allocate Metal texture.";
-        backend_ = Backend::kStub;
+  Backend backend() const noexcept override {
+    return backend_;
+  }
+
+  std::string textureDebugLabel() const override {
+    std::lock_guard lock(mutex_);
+    return last_texture_label_;
+  }
+
+  bool tracksResidency() const noexcept override {
+    return true;
+  }
+
+  bool isResident(const std::string& cache_key) const override {
+    std::lock_guard lock(mutex_);
+    return residency_.contains(cache_key);
+  }
+
+  bool evict(const std::string& cache_key) override {
+    {
+      std::lock_guard lock(mutex_);
+      if (!textures_.contains(cache_key)) {
         return false;
       }
+      retire(cache_key);
+      ++evictions_;
+    }
+    notifyEvicted(cache_key);
+    return true;
+  }
 
-      id<MTLCommandBuffer> command = [queue_ commandBuffer];
-      if (!command) {
-        error = "Failed to create Metal command buffer.";
+  void touch(const std::string& cache_key) override {
+    std::lock_guard lock(mutex_);
+    residency_.touch(cache_key);
+  }
+
+  void setBudget(std::size_t bytes) override {
+    std::vector<std::string> evicted;
+    {
+      std::lock_guard lock(mutex_);
+      budget_ = bytes;
+      makeRoom(0, 0, evicted);
+    }
+    for (const auto& key : evicted) {
+      notifyEvicted(key);
+    }
+  }
+
+  ResidencyStats residency() const override {
+    std::lock_guard lock(mutex_);
+    ResidencyStats stats;
+    stats.resident_textures = residency_.count();
+    stats.resident_bytes = residency_.bytes();
+    stats.allocated_bytes = allocated_bytes_;
+    stats.budget_bytes = budget_;
+    stats.uploads = uploads_;
+    stats.reuses = reuses_;
+    stats.evictions = evictions_;
+    return stats;
+  }
+
+private:
+  static constexpr std::size_t kDefaultBudget = 512u * 1024 * 1024;
+
+  struct Entry {
+    id<MTLTexture> texture;
+    std::uint64_t bucket;
+    std::size_t bytes;
+  };
+
+  struct Staged {
+    std::size_t index;
+    id<MTLTexture> texture;
+    id<MTLBuffer> staging;
+    std::uint64_t bucket;
+    std::size_t bytes;
+  };
+
+  // The whole batch shares one command buffer: every blit is encoded first,
+  // then the buffer is committed and waited on once.
+  void encodeAndWait(std::span<const cataloger::services::preview::PreviewImage* const> images,
+                     std::vector<UploadOutcome>& outcomes,
+                     std::vector<std::string>& evicted) {
+    @autoreleasepool {
+      std::lock_guard lock(mutex_);
+      auto failAll = [&](const char* message) {
+        for (auto& outcome : outcomes) {
+          outcome.error = message;
+        }
         backend_ = Backend::kStub;
-        return false;
+      };
+      if (!device_ || !queue_) {
+        failAll("Metal device/queue unavailable.");
+        return;
       }
-
-      id<MTLBlitCommandEncoder> blit = [command blitCommandEncoder];
+      id<MTLCommandBuffer> command = [queue_ commandBuffer];
+      id<MTLBlitCommandEncoder> blit = command ? [command blitCommandEncoder] : nil;
       if (!blit) {
-        error = "Failed to acquire Metal blit encoder.";
-        backend_ = Backend::kStub;
-        return false;
+        failAll("Failed to acquire Metal blit encoder.");
+        return;
       }
 
-      MTLSize size =
-          MTLSizeMake(static_cast<NSUInteger>(image.width),
-                      static_cast<NSUInteger>(image.height),
-                      1);
-      [blit copyFromBuffer:staging
-               sourceOffset:0
-          sourceBytesPerRow:bytes_per_row
-        sourceBytesPerImage:bytes_per_row *
-                             static_cast<NSUInteger>(image.height)
-                 sourceSize:size
-                  toTexture:texture
-           destinationSlice:0
-           destinationLevel:0
-          destinationOrigin:MTLOriginMake(0, 0, 0)];
+      std::vector<Staged> staged;
+      staged.reserve(images.size());
+      for (std::size_t i = 0; i < images.size(); ++i) {
+        const auto& image = *images[i];
+        auto& error = outcomes[i].error;
+        const auto bgra = toBGRA(image);
+        if (bgra.empty()) {
+          error = "Preview pixels missing or malformed.";
+          continue;
+        }
+
+        const int texture_width = BucketExtent(image.width);
+        const int texture_height = BucketExtent(image.height);
+        const auto bucket = bucketKey(texture_width, texture_height);
+        const auto texture_bytes = static_cast<std::size_t>(texture_width) *
+                                   static_cast<std::size_t>(texture_height) * 4;
+        if (textures_.contains(image.cache_key)) {
+          retire(image.cache_key);
+        }
+        makeRoom(bucket, texture_bytes, evicted);
+
+        id<MTLTexture> texture = takePooled(bucket, texture_bytes);
+        if (!texture) {
+          if (allocated_bytes_ + texture_bytes > budget_) {
+            error = "Preview exceeds the GPU texture budget.";
+            continue;
+          }
+          MTLTextureDescriptor* descriptor = [MTLTextureDescriptor
+              texture2DDescriptorWithPixelFormat:MTLPixelFormatBGRA8Unorm
+                                           width:static_cast<NSUInteger>(texture_width)
+                                          height:static_cast<NSUInteger>(texture_height)
+                                       mipmapped:NO];
+          descriptor.usage = MTLTextureUsageShaderRead | MTLTextureUsageRenderTarget;
+          texture = [device_ newTextureWithDescriptor:descriptor];
+          if (!texture) {
+            error = "Failed to allocate Metal texture.";
+            continue;
+          }
+          allocated_bytes_ += texture_bytes;
+        }
+
+        const NSUInteger bytes_per_row =
+            static_cast<NSUInteger>(image.width) * 4;
+        const NSUInteger byte_count = bytes_per_row *
+                                      static_cast<NSUInteger>(image.height);
+        id<MTLBuffer> staging =
+            [device_ newBufferWithLength:byte_count options:MTLResourceStorageModeShared];
+        if (!staging) {
+          error = "Failed to allocate Metal staging buffer.";
+          pool(bucket, texture, texture_bytes);
+          continue;
+        }
+        std::memcpy([staging contents], bgra.data(), byte_count);
+
+        MTLSize size =
+            MTLSizeMake(static_cast<NSUInteger>(image.width),
+                        static_cast<NSUInteger>(image.height),
+                        1);
+        [blit copyFromBuffer:staging
+                 sourceOffset:0
+            sourceBytesPerRow:bytes_per_row
+          sourceBytesPerImage:byte_count
+                   sourceSize:size
+                    toTexture:texture
+             destinationSlice:0
+             destinationLevel:0
+            destinationOrigin:MTLOriginMake(0, 0, 0)];
+        staged.push_back(Staged{i, texture, staging, bucket, texture_bytes});
+      }
       [blit endEncoding];
 
       [command commit];
       [command waitUntilCompleted];
 
-      if (command.error) {
-        error = [[command.error description] UTF8String];
-        backend_ = Backend::kStub;
-        return false;
+      const bool failed = command.error != nil;
+      const std::string command_error =
+          failed ? [[command.error description] UTF8String] : std::string{};
+      for (auto& item : staged) {
+        releaseObject(item.staging);
+        const auto& image = *images[item.index];
+        if (failed) {
+          outcomes[item.index].error = command_error;
+          pool(item.bucket, item.texture, item.bytes);
+          continue;
+        }
+        if (textures_.contains(image.cache_key)) {
+          retire(image.cache_key);  // same key twice in one batch
+        }
+        textures_[image.cache_key] = Entry{item.texture, item.bucket, item.bytes};
+        residency_.add(image.cache_key, static_cast<std::size_t>(image.width) *
+                                            static_cast<std::size_t>(image.height) * 4);
+        ++uploads_;
+        outcomes[item.index].ok = true;
+        last_texture_label_ = [item.texture label] ? [[item.texture label] UTF8String]
+                                                   : "MTLTexture";
       }
+      const bool any_failed = std::any_of(outcomes.begin(), outcomes.end(),
+                                          [](const UploadOutcome& outcome) {
+                                            return !outcome.ok;
+                                          });
+      backend_ = any_failed ? Backend::kStub : Backend::kMetal;
+    }
+  }
 
-      last_texture_label_ = [texture label] ? [[texture label] UTF8String]
-                                            : "MTLTexture";
-      last_texture_ = texture;
-      backend_ = Backend::kMetal;
-      error.clear();
-      return true;
+  // Frees pooled textures, then evicts least recently used ones, until a
+  // texture of `bytes` fits (or can be taken from the `bucket` pool).
+  void makeRoom(std::uint64_t bucket, std::size_t bytes, std::vector<std::string>& evicted) {
+    while (allocated_bytes_ + bytes > budget_) {
+      if (bytes > 0) {
+        if (const auto it = pool_.find(bucket); it != pool_.end() && !it->second.empty()) {
+          return;
+        }
+      }
+      if (pooled_bytes_ > 0) {
+        dropPooled(bucket);
+      } else if (const auto oldest = residency_.leastRecent()) {
+        retire(*oldest);
+        ++evictions_;
+        evicted.push_back(*oldest);
+      } else {
+        return;
+      }
     }
   }
 
-  Backend backend() const noexcept override {
-    return backend_;
+  // Moves a resident texture into its bucket's pool.
+  void retire(const std::string& key) {
+    const auto it = textures_.find(key);
+    const auto entry = it->second;
+    textures_.erase(it);
+    residency_.remove(key);
+    pool(entry.bucket, entry.texture, entry.bytes);
   }
 
-  std::string textureDebugLabel() const override {
-    return last_texture_label_;
+  void pool(std::uint64_t bucket, id<MTLTexture> texture, std::size_t bytes) {
+    pool_[bucket].push_back(texture);
+    pooled_bytes_ += bytes;
+  }
+
+  id<MTLTexture> takePooled(std::uint64_t bucket, std::size_t bytes) {
+    const auto it = pool_.find(bucket);
+    if (it == pool_.end() || it->second.empty()) {
+      return nil;
+    }
+    id<MTLTexture> texture = it->second.back();
+    it->second.pop_back();
+    pooled_bytes_ -= bytes;
+    ++reuses_;
+    return texture;
+  }
+
+  // Releases one pooled texture, preferring buckets other than `keep`.
+  void dropPooled(std::uint64_t keep) {
+    auto victim = pool_.end();
+    for (auto it = pool_.begin(); it != pool_.end(); ++it) {
+      if (!it->second.empty() && (victim == pool_.end() || it->first != keep)) {
+        victim = it;
+      }
+    }
+    if (victim == pool_.end()) {
+      return;
+    }
+    const auto bytes = static_cast<std::size_t>(victim->first >> 32) *
+                       static_cast<std::size_t>(victim->first & 0xFFFFFFFFu) * 4;
+    releaseObject(victim->second.back());
+    victim->second.pop_back();
+    pooled_bytes_ -= bytes;
+    allocated_bytes_ -= bytes;
   }
 
-private:
   Backend backend_;
   id<MTLDevice> device_;
   id<MTLCommandQueue> queue_;
-  id<MTLTexture> last_texture_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Entry> textures_;
+  std::unordered_map<std::uint64_t, std::vector<id<MTLTexture>>> pool_;
+  TextureResidency residency_;
+  std::size_t budget_;
+  std::size_t allocated_bytes_{0};
+  std::size_t pooled_bytes_{0};
+  std::uint64_t uploads_{0};
+  std::uint64_t reuses_{0};
+  std::uint64_t evictions_{0};
   std::string last_texture_label_;
 };
 
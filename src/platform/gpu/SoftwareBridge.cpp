@@ -0,0 +1,360 @@
+#include "SoftwareBridge.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace cataloger::platform::gpu {
+
+namespace {
+
+constexpr std::size_t kTexelBytes = 4;
+
+std::uint64_t bucketKey(int width, int height) {
+  return (static_cast<std::uint64_t>(width) << 32) | static_cast<std::uint32_t>(height);
+}
+
+}  // namespace
+
+SoftwareBridge::SoftwareBridge(Options options) : options_(options) {
+  options_.page_extent = std::max(options_.page_extent, 1);
+}
+
+bool SoftwareBridge::upload(const cataloger::services::preview::PreviewImage& image,
+                            std::string& error) {
+  if (image.width <= 0 || image.height <= 0) {
+    error = "Preview pixels missing or malformed.";
+    return false;
+  }
+  const int width = image.width;
+  const int height = image.height;
+  const int extent = options_.page_extent;
+  const bool standard = width <= extent && height <= extent;
+  // Oversized previews get a page of their own.
+  const int page_width = standard ? extent : width;
+  const int page_height = standard ? extent : height;
+  const auto page_bytes = static_cast<std::size_t>(page_width) *
+                          static_cast<std::size_t>(page_height) * kTexelBytes;
+
+  std::vector<std::string> evicted;
+  {
+    std::lock_guard lock(mutex_);
+    if (page_bytes > options_.budget_bytes) {
+      error = "Preview exceeds the software texture budget.";
+      return false;
+    }
+    if (regions_.contains(image.cache_key)) {
+      release(image.cache_key);
+    }
+
+    // Reuse a slot or pack into an open page; otherwise open a page,
+    // evicting least recently used textures until it fits the budget.
+    std::optional<Region> region;
+    while (!(region = allocate(width, height))) {
+      const auto needed = (standard && !spares_.empty()) ? 0 : page_bytes;
+      if (atlas_bytes_ + needed <= options_.budget_bytes) {
+        const auto index = openPage(page_width, page_height);
+        region = standard ? allocateInPage(index, std::min(BucketExtent(width), extent),
+                                           std::min(BucketExtent(height), extent))
+                          : allocateInPage(index, width, height);
+        break;
+      }
+      if (!spares_.empty()) {
+        spares_.pop_back();
+        atlas_bytes_ -= spareBytes();
+      } else {
+        evictOldest(evicted);  // non-empty: an empty atlas always fits one page
+      }
+    }
+    region->width = width;
+    region->height = height;
+
+    // Rows past the end of the source bytes are filled opaque white, as the
+    // Metal path does for short buffers.
+    auto& page = pages_[region->page];
+    const auto* source = image.pixels.data();
+    const auto source_size = image.pixels.size();
+    const auto source_bpp =
+        static_cast<std::size_t>(cataloger::services::preview::BytesPerPixel(image.layout));
+    const auto row_bytes = static_cast<std::size_t>(width) * source_bpp;
+    for (int row = 0; row < height; ++row) {
+      auto* dst = page.texels.get() +
+                  (static_cast<std::size_t>(region->y + row) * page.width + region->x) *
+                      kTexelBytes;
+      const auto offset = static_cast<std::size_t>(row) * row_bytes;
+      const auto available =
+          offset < source_size
+              ? std::min<std::size_t>(width, (source_size - offset) / source_bpp)
+              : 0;
+      if (available > 0 && source_bpp == 4) {
+        SwizzleRgba(source + offset, dst, available, options_.format);
+      } else if (available > 0) {
+        SwizzleRgb(source + offset, dst, available, options_.format);
+      }
+      std::memset(dst + available * kTexelBytes, 0xFF,
+                  (static_cast<std::size_t>(width) - available) * kTexelBytes);
+    }
+
+    ++page.live;
+    regions_[image.cache_key] = *region;
+    residency_.add(image.cache_key, static_cast<std::size_t>(width) *
+                                        static_cast<std::size_t>(height) * kTexelBytes);
+    ++uploads_;
+    last_label_ = "atlas" + std::to_string(region->page) + "@" +
+                  std::to_string(region->x) + "," + std::to_string(region->y) + " " +
+                  std::to_string(width) + "x" + std::to_string(height);
+  }
+
+  for (const auto& key : evicted) {
+    notifyEvicted(key);
+  }
+  error.clear();
+  return true;
+}
+
+std::string SoftwareBridge::textureDebugLabel() const {
+  std::lock_guard lock(mutex_);
+  return last_label_;
+}
+
+bool SoftwareBridge::isResident(const std::string& cache_key) const {
+  std::lock_guard lock(mutex_);
+  return residency_.contains(cache_key);
+}
+
+bool SoftwareBridge::evict(const std::string& cache_key) {
+  {
+    std::lock_guard lock(mutex_);
+    if (!regions_.contains(cache_key)) {
+      return false;
+    }
+    release(cache_key);
+    ++evictions_;
+  }
+  notifyEvicted(cache_key);
+  return true;
+}
+
+void SoftwareBridge::touch(const std::string& cache_key) {
+  std::lock_guard lock(mutex_);
+  residency_.touch(cache_key);
+}
+
+void SoftwareBridge::setBudget(std::size_t bytes) {
+  std::vector<std::string> evicted;
+  {
+    std::lock_guard lock(mutex_);
+    options_.budget_bytes = bytes;
+    while (atlas_bytes_ > options_.budget_bytes) {
+      if (!spares_.empty()) {
+        spares_.pop_back();
+        atlas_bytes_ -= spareBytes();
+      } else if (residency_.count() > 0) {
+        evictOldest(evicted);
+      } else {
+        break;
+      }
+    }
+  }
+  for (const auto& key : evicted) {
+    notifyEvicted(key);
+  }
+}
+
+ResidencyStats SoftwareBridge::residency() const {
+  std::lock_guard lock(mutex_);
+  ResidencyStats stats;
+  stats.resident_textures = residency_.count();
+  stats.resident_bytes = residency_.bytes();
+  stats.allocated_bytes = atlas_bytes_;
+  stats.budget_bytes = options_.budget_bytes;
+  stats.uploads = uploads_;
+  stats.reuses = reuses_;
+  stats.evictions = evictions_;
+  return stats;
+}
+
+std::size_t SoftwareBridge::atlasPages() const {
+  std::lock_guard lock(mutex_);
+  return static_cast<std::size_t>(
+      std::count_if(pages_.begin(), pages_.end(),
+                    [](const Page& page) { return page.texels != nullptr; }));
+}
+
+std::optional<SoftwareBridge::Region> SoftwareBridge::lookup(const std::string& key) const {
+  std::lock_guard lock(mutex_);
+  const auto it = regions_.find(key);
+  if (it == regions_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+std::vector<std::uint8_t> SoftwareBridge::readTexels(const std::string& key) const {
+  std::lock_guard lock(mutex_);
+  const auto it = regions_.find(key);
+  if (it == regions_.end()) {
+    return {};
+  }
+  const auto& region = it->second;
+  const auto& page = pages_[region.page];
+  const auto row_bytes = static_cast<std::size_t>(region.width) * kTexelBytes;
+  std::vector<std::uint8_t> texels(row_bytes * static_cast<std::size_t>(region.height));
+  for (int row = 0; row < region.height; ++row) {
+    const auto* src = page.texels.get() +
+                      (static_cast<std::size_t>(region.y + row) * page.width + region.x) *
+                          kTexelBytes;
+    std::memcpy(texels.data() + static_cast<std::size_t>(row) * row_bytes, src, row_bytes);
+  }
+  return texels;
+}
+
+bool SoftwareBridge::visitTexture(const std::string& key,
+                                  const std::function<void(const TextureView&)>& visit) const {
+  std::lock_guard lock(mutex_);
+  const auto it = regions_.find(key);
+  if (it == regions_.end()) {
+    return false;
+  }
+  const auto& region = it->second;
+  const auto& page = pages_[region.page];
+  const auto row_bytes = static_cast<std::size_t>(page.width) * kTexelBytes;
+  visit(TextureView{page.texels.get() + static_cast<std::size_t>(region.y) * row_bytes +
+                        static_cast<std::size_t>(region.x) * kTexelBytes,
+                    region.width, region.height, row_bytes});
+  return true;
+}
+
+std::size_t SoftwareBridge::pageBytes(const Page& page) const {
+  return static_cast<std::size_t>(page.width) * static_cast<std::size_t>(page.height) *
+         kTexelBytes;
+}
+
+std::size_t SoftwareBridge::spareBytes() const {
+  return static_cast<std::size_t>(options_.page_extent) *
+         static_cast<std::size_t>(options_.page_extent) * kTexelBytes;
+}
+
+bool SoftwareBridge::isStandard(const Page& page) const {
+  return page.width == options_.page_extent && page.height == options_.page_extent;
+}
+
+// Standard-size textures take a slot of their bucket: a free one when
+// available, else freshly packed into an open page.
+std::optional<SoftwareBridge::Region> SoftwareBridge::allocate(int width, int height) {
+  const int extent = options_.page_extent;
+  if (width > extent || height > extent) {
+    return std::nullopt;
+  }
+  const int slot_width = std::min(BucketExtent(width), extent);
+  const int slot_height = std::min(BucketExtent(height), extent);
+  auto& free = free_slots_[bucketKey(slot_width, slot_height)];
+  if (!free.empty()) {
+    const auto slot = free.back();
+    free.pop_back();
+    ++reuses_;
+    return Region{slot.page, slot.x, slot.y, slot_width, slot_height};
+  }
+  for (std::size_t index = 0; index < pages_.size(); ++index) {
+    if (pages_[index].texels && isStandard(pages_[index])) {
+      if (auto region = allocateInPage(index, slot_width, slot_height)) {
+        return region;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+// Shelf packing: the shortest shelf that is tall enough and has room wins;
+// otherwise a new shelf of exactly `height` opens below the last one.
+std::optional<SoftwareBridge::Region> SoftwareBridge::allocateInPage(std::size_t index,
+                                                                     int width,
+                                                                     int height) {
+  auto& page = pages_[index];
+  if (width > page.width || height > page.height) {
+    return std::nullopt;
+  }
+  Shelf* best = nullptr;
+  for (auto& shelf : page.shelves) {
+    if (shelf.height >= height && page.width - shelf.next_x >= width &&
+        (!best || shelf.height < best->height)) {
+      best = &shelf;
+    }
+  }
+  if (!best) {
+    if (page.height - page.next_y < height) {
+      return std::nullopt;
+    }
+    best = &page.shelves.emplace_back(Shelf{page.next_y, height, 0});
+    page.next_y += height;
+  }
+  Region region{index, best->next_x, best->y, width, height};
+  best->next_x += width;
+  return region;
+}
+
+std::size_t SoftwareBridge::openPage(int width, int height) {
+  Page page;
+  page.width = width;
+  page.height = height;
+  if (isStandard(page) && !spares_.empty()) {
+    page.texels = std::move(spares_.back());
+    spares_.pop_back();
+    ++reuses_;
+  } else {
+    page.texels = std::make_unique_for_overwrite<std::uint8_t[]>(pageBytes(page));
+    atlas_bytes_ += pageBytes(page);
+  }
+
+  const auto closed = std::find_if(pages_.begin(), pages_.end(),
+                                   [](const Page& slot) { return !slot.texels; });
+  if (closed != pages_.end()) {
+    *closed = std::move(page);
+    return static_cast<std::size_t>(closed - pages_.begin());
+  }
+  pages_.push_back(std::move(page));
+  return pages_.size() - 1;
+}
+
+void SoftwareBridge::release(const std::string& key) {
+  const auto it = regions_.find(key);
+  const auto region = it->second;
+  regions_.erase(it);
+  residency_.remove(key);
+
+  const auto index = region.page;
+  auto& page = pages_[index];
+  if (--page.live > 0) {
+    if (isStandard(page)) {
+      const int extent = options_.page_extent;
+      free_slots_[bucketKey(std::min(BucketExtent(region.width), extent),
+                            std::min(BucketExtent(region.height), extent))]
+          .push_back(Slot{index, region.x, region.y});
+    }
+    return;
+  }
+
+  // Last texture gone: the page is recycled whole, so its free slots go too.
+  for (auto& [bucket, slots] : free_slots_) {
+    std::erase_if(slots, [index](const Slot& slot) { return slot.page == index; });
+  }
+  if (isStandard(page) && spares_.size() < options_.spare_pages) {
+    spares_.push_back(std::move(page.texels));
+  } else {
+    atlas_bytes_ -= pageBytes(page);
+  }
+  page = Page{};
+}
+
+void SoftwareBridge::evictOldest(std::vector<std::string>& evicted) {
+  auto key = *residency_.leastRecent();
+  release(key);
+  ++evictions_;
+  evicted.push_back(std::move(key));
+}
+
+std::unique_ptr<GpuBridge> CreateSoftwareBridge() {
+  return std::make_unique<SoftwareBridge>();
+}
+
+}  // namespace cataloger::platform::gpu
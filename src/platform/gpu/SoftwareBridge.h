@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GpuBridge.h"
+#include "Swizzle.h"
+#include "TextureResidency.h"
+
+namespace cataloger::platform::gpu {
+
+// CPU "texture memory" backend for platforms without a GPU bridge. Uploads
+// do the same work a real upload does on the CPU side: swizzle into the
+// device pixel format and copy into texture storage. Storage is a set of
+// square atlas pages carved into size-bucketed slots; a released slot is
+// reused by the next texture of its bucket, and pages whose textures are
+// all gone are recycled whole. Page memory is bounded by the budget with
+// LRU eviction, so latency and memory numbers from Linux runs are real.
+class SoftwareBridge : public GpuBridge {
+public:
+  struct Options {
+    PixelFormat format{PixelFormat::kBGRA8};
+    int page_extent{2048};  // texels per atlas page side
+    std::size_t budget_bytes{512u * 1024 * 1024};
+    std::size_t spare_pages{2};  // empty pages kept for reuse
+  };
+
+  struct Region {
+    std::size_t page{0};
+    int x{0};
+    int y{0};
+    int width{0};
+    int height{0};
+  };
+
+  struct TextureView {
+    const std::uint8_t* texels{nullptr};
+    int width{0};
+    int height{0};
+    std::size_t row_bytes{0};  // page pitch
+  };
+
+  explicit SoftwareBridge(Options options);
+  SoftwareBridge() : SoftwareBridge(Options{}) {}
+
+  bool upload(const cataloger::services::preview::PreviewImage& image,
+              std::string& error) override;
+
+  Backend backend() const noexcept override {
+    return Backend::kSoftware;
+  }
+
+  std::string textureDebugLabel() const override;
+
+  bool tracksResidency() const noexcept override { return true; }
+  bool isResident(const std::string& cache_key) const override;
+  bool evict(const std::string& cache_key) override;
+  void touch(const std::string& cache_key) override;
+  void setBudget(std::size_t bytes) override;
+  ResidencyStats residency() const override;
+
+  [[nodiscard]] std::size_t atlasPages() const;
+  [[nodiscard]] std::optional<Region> lookup(const std::string& key) const;
+  // Copies a resident texture out of the atlas, row by row.
+  [[nodiscard]] std::vector<std::uint8_t> readTexels(const std::string& key) const;
+  // Runs `visit` on a resident texture in place, holding the bridge lock so
+  // the texture cannot be evicted or overwritten meanwhile. Returns false,
+  // without calling `visit`, when the key is not resident.
+  bool visitTexture(const std::string& key,
+                    const std::function<void(const TextureView&)>& visit) const;
+
+private:
+  struct Shelf {
+    int y{0};
+    int height{0};
+    int next_x{0};
+  };
+
+  struct Page {
+    int width{0};
+    int height{0};
+    std::unique_ptr<std::uint8_t[]> texels;
+    std::vector<Shelf> shelves;
+    int next_y{0};
+    std::size_t live{0};
+  };
+
+  struct Slot {
+    std::size_t page{0};
+    int x{0};
+    int y{0};
+  };
+
+  [[nodiscard]] std::size_t pageBytes(const Page& page) const;
+  [[nodiscard]] std::size_t spareBytes() const;
+  [[nodiscard]] bool isStandard(const Page& page) const;
+  std::optional<Region> allocate(int width, int height);
+  std::optional<Region> allocateInPage(std::size_t index, int width, int height);
+  std::size_t openPage(int width, int height);
+  void release(const std::string& key);
+  void evictOldest(std::vector<std::string>& evicted);
+
+  Options options_;
+  mutable std::mutex mutex_;
+  std::vector<Page> pages_;  // slots without texels are closed pages
+  std::vector<std::unique_ptr<std::uint8_t[]>> spares_;
+  std::unordered_map<std::uint64_t, std::vector<Slot>> free_slots_;  // by bucket
+  std::unordered_map<std::string, Region> regions_;
+  TextureResidency residency_;
+  std::size_t atlas_bytes_{0};
+  std::uint64_t uploads_{0};
+  std::uint64_t reuses_{0};
+  std::uint64_t evictions_{0};
+  std::string last_label_{"none"};
+};
+
+std::unique_ptr<GpuBridge> CreateSoftwareBridge();
+
+}  // namespace cataloger::platform::gpu
@@ -0,0 +1,137 @@
+#include "Swizzle.h"
+
+#include <cstring>
+#include <utility>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CATALOGER_SWIZZLE_NEON 1
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CATALOGER_SWIZZLE_SSSE3 1
+#endif
+
+namespace cataloger::platform::gpu {
+
+namespace {
+
+constexpr std::size_t kTexelBytes = 4;
+
+
+void swizzleScalar(const std::uint8_t* rgb,
+                   std::uint8_t* out,
+                   std::size_t pixel_count,
+                   PixelFormat format) {
+  const bool bgra = format == PixelFormat::kBGRA8;
+  for (std::size_t j = 0; j < pixel_count; ++j, rgb += 3, out += kTexelBytes) {
+    out[0] = bgra ? rgb[2] : rgb[0];
+    out[1] = rgb[1];
+    out[2] = bgra ? rgb[0] : rgb[2];
+    out[3] = 255;
+  }
+}
+
+void swizzleRgbaScalar(const std::uint8_t* rgba,
+                       std::uint8_t* out,
+                       std::size_t pixel_count,
+                       PixelFormat format) {
+  if (format == PixelFormat::kRGBA8) {
+    std::memcpy(out, rgba, pixel_count * kTexelBytes);
+    return;
+  }
+  for (std::size_t j = 0; j < pixel_count; ++j, rgba += 4, out += kTexelBytes) {
+    out[0] = rgba[2];
+    out[1] = rgba[1];
+    out[2] = rgba[0];
+    out[3] = rgba[3];
+  }
+}
+
+#if defined(CATALOGER_SWIZZLE_SSSE3)
+__attribute__((target("ssse3"))) std::size_t swapRedBlueSsse3(const std::uint8_t* rgba,
+                                                              std::uint8_t* out,
+                                                              std::size_t pixel_count) {
+  const auto mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  std::size_t j = 0;
+  for (; j + 4 <= pixel_count; j += 4) {
+    const auto in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + j * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j * kTexelBytes),
+                     _mm_shuffle_epi8(in, mask));
+  }
+  return j;
+}
+
+// Four pixels per shuffle: a 16-byte load covers 12 bytes of RGB, and the
+// mask drops the spare bytes into the alpha lanes, which are then forced on.
+__attribute__((target("ssse3"))) std::size_t swizzleSsse3(const std::uint8_t* rgb,
+                                                          std::uint8_t* out,
+                                                          std::size_t pixel_count,
+                                                          PixelFormat format) {
+  const auto mask = format == PixelFormat::kBGRA8
+                        ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+                        : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const auto alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+  std::size_t j = 0;
+  // The load reads 4 bytes past the 12 it uses; stop while those are in range.
+  for (; j + 6 <= pixel_count; j += 4) {
+    const auto in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + j * 3));
+    const auto texels = _mm_or_si128(_mm_shuffle_epi8(in, mask), alpha);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j * kTexelBytes), texels);
+  }
+  return j;
+}
+
+bool hasSsse3() {
+  static const bool supported = __builtin_cpu_supports("ssse3");
+  return supported;
+}
+#endif
+
+}  // namespace
+
+void SwizzleRgb(const std::uint8_t* rgb,
+                std::uint8_t* out,
+                std::size_t pixel_count,
+                PixelFormat format) {
+  std::size_t done = 0;
+#if defined(CATALOGER_SWIZZLE_NEON)
+  const auto alpha = vdupq_n_u8(255);
+  for (; done + 16 <= pixel_count; done += 16) {
+    const auto in = vld3q_u8(rgb + done * 3);
+    uint8x16x4_t texels;
+    texels.val[0] = format == PixelFormat::kBGRA8 ? in.val[2] : in.val[0];
+    texels.val[1] = in.val[1];
+    texels.val[2] = format == PixelFormat::kBGRA8 ? in.val[0] : in.val[2];
+    texels.val[3] = alpha;
+    vst4q_u8(out + done * kTexelBytes, texels);
+  }
+#elif defined(CATALOGER_SWIZZLE_SSSE3)
+  if (hasSsse3()) {
+    done = swizzleSsse3(rgb, out, pixel_count, format);
+  }
+#endif
+  swizzleScalar(rgb + done * 3, out + done * kTexelBytes, pixel_count - done, format);
+}
+
+void SwizzleRgba(const std::uint8_t* rgba,
+                 std::uint8_t* out,
+                 std::size_t pixel_count,
+                 PixelFormat format) {
+  std::size_t done = 0;
+  if (format == PixelFormat::kBGRA8) {
+#if defined(CATALOGER_SWIZZLE_NEON)
+    for (; done + 16 <= pixel_count; done += 16) {
+      auto texels = vld4q_u8(rgba + done * 4);
+      std::swap(texels.val[0], texels.val[2]);
+      vst4q_u8(out + done * kTexelBytes, texels);
+    }
+#elif defined(CATALOGER_SWIZZLE_SSSE3)
+    if (hasSsse3()) {
+      done = swapRedBlueSsse3(rgba, out, pixel_count);
+    }
+#endif
+  }
+  swizzleRgbaScalar(rgba + done * 4, out + done * kTexelBytes, pixel_count - done, format);
+}
+
+}  // namespace cataloger::platform::gpu
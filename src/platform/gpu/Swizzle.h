@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cataloger::platform::gpu {
+
+enum class PixelFormat { kBGRA8, kRGBA8 };
+
+// Expands `pixel_count` packed RGB pixels into 4-byte texels with opaque
+// alpha. Uses SSSE3 or NEON shuffles when the CPU has them.
+void SwizzleRgb(const std::uint8_t* rgb,
+                std::uint8_t* out,
+                std::size_t pixel_count,
+                PixelFormat format);
+
+// Same for RGBA input (mip levels and tiles); alpha is passed through.
+void SwizzleRgba(const std::uint8_t* rgba,
+                 std::uint8_t* out,
+                 std::size_t pixel_count,
+                 PixelFormat format);
+
+}  // namespace cataloger::platform::gpu
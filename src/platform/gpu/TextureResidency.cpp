@@ -0,0 +1,42 @@
+#include "TextureResidency.h"
+
+namespace cataloger::platform::gpu {
+
+bool TextureResidency::contains(const std::string& key) const {
+  return entries_.contains(key);
+}
+
+void TextureResidency::add(const std::string& key, std::size_t bytes) {
+  remove(key);
+  order_.push_front(key);
+  entries_.emplace(key, Entry{bytes, order_.begin()});
+  bytes_ += bytes;
+}
+
+void TextureResidency::touch(const std::string& key) {
+  const auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    order_.splice(order_.begin(), order_, it->second.position);
+  }
+}
+
+std::optional<std::size_t> TextureResidency::remove(const std::string& key) {
+  const auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return std::nullopt;
+  }
+  const auto bytes = it->second.bytes;
+  order_.erase(it->second.position);
+  entries_.erase(it);
+  bytes_ -= bytes;
+  return bytes;
+}
+
+std::optional<std::string> TextureResidency::leastRecent() const {
+  if (order_.empty()) {
+    return std::nullopt;
+  }
+  return order_.back();
+}
+
+}  // namespace cataloger::platform::gpu
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace cataloger::platform::gpu {
+
+// LRU bookkeeping shared by the bridges: which cache keys own a texture,
+// how many bytes each holds and which was used least recently. Storage is
+// the backend's business; this only decides who goes next. Not thread-safe.
+class TextureResidency {
+public:
+  [[nodiscard]] bool contains(const std::string& key) const;
+  // Inserts or refreshes `key` as most recently used.
+  void add(const std::string& key, std::size_t bytes);
+  void touch(const std::string& key);
+  // Returns the bytes `key` held, if it was resident.
+  std::optional<std::size_t> remove(const std::string& key);
+  [[nodiscard]] std::optional<std::string> leastRecent() const;
+
+  [[nodiscard]] std::size_t count() const { return entries_.size(); }
+  [[nodiscard]] std::size_t bytes() const { return bytes_; }
+
+private:
+  struct Entry {
+    std::size_t bytes{0};
+    std::list<std::string>::iterator position;
+  };
+
+  std::unordered_map<std::string, Entry> entries_;
+  std::list<std::string> order_;  // front = most recently used
+  std::size_t bytes_{0};
+};
+
+// Texture storage is pooled by size bucket: dimensions round up to this
+// many texels, so previews of similar size can reuse each other's storage.
+constexpr int kTextureBucketAlign = 32;
+
+[[nodiscard]] inline int BucketExtent(int extent) {
+  return (extent + kTextureBucketAlign - 1) / kTextureBucketAlign * kTextureBucketAlign;
+}
+
+}  // namespace cataloger::platform::gpu
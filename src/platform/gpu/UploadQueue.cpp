@@ -0,0 +1,119 @@
+#include "UploadQueue.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace cataloger::platform::gpu {
+
+namespace {
+
+double elapsedMs(std::chrono::steady_clock::time_point from,
+                 std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+}  // namespace
+
+UploadQueue::UploadQueue(GpuBridge& bridge, Options options)
+    : bridge_(bridge), options_(options) {
+  options_.max_batch = std::max<std::size_t>(options_.max_batch, 1);
+  options_.max_pending = std::max(options_.max_pending, options_.max_batch);
+  thread_ = std::jthread([this](std::stop_token token) { run(token); });
+}
+
+UploadQueue::~UploadQueue() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+  thread_ = {};  // joins after draining
+}
+
+UploadFence UploadQueue::submit(cataloger::services::preview::PreviewImage image,
+                                Completion completion) {
+  Pending pending{std::move(image), std::move(completion), {},
+                  std::chrono::steady_clock::now()};
+  auto fence = pending.promise.get_future().share();
+  {
+    std::unique_lock lock(mutex_);
+    space_cv_.wait(lock, [&] { return pending_.size() < options_.max_pending; });
+    pending_.push_back(std::move(pending));
+    ++stats_.submitted;
+    // Wake the thread to start a frame, or to submit a batch that filled.
+    if (pending_.size() == 1 || pending_.size() >= options_.max_batch) {
+      work_cv_.notify_one();
+    }
+  }
+  return fence;
+}
+
+void UploadQueue::flush() const {
+  std::unique_lock lock(mutex_);
+  idle_cv_.wait(lock, [&] { return pending_.empty() && in_flight_ == 0; });
+}
+
+UploadQueue::Stats UploadQueue::stats() const {
+  std::lock_guard lock(mutex_);
+  return stats_;
+}
+
+void UploadQueue::run(std::stop_token) {
+  for (;;) {
+    std::vector<Pending> batch;
+    {
+      std::unique_lock lock(mutex_);
+      work_cv_.wait(lock, [&] { return stopping_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        return;  // stopping and drained
+      }
+      // Give the frame a chance to fill before submitting.
+      const auto deadline = pending_.front().submitted + options_.frame_interval;
+      work_cv_.wait_until(lock, deadline, [&] {
+        return stopping_ || pending_.size() >= options_.max_batch;
+      });
+      const auto count = std::min(pending_.size(), options_.max_batch);
+      batch.assign(std::make_move_iterator(pending_.begin()),
+                   std::make_move_iterator(pending_.begin() + static_cast<std::ptrdiff_t>(count)));
+      pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(count));
+      in_flight_ = count;
+      ++stats_.batches;
+      stats_.largest_batch = std::max(stats_.largest_batch, count);
+    }
+    space_cv_.notify_all();
+
+    std::vector<const cataloger::services::preview::PreviewImage*> images;
+    images.reserve(batch.size());
+    for (const auto& pending : batch) {
+      images.push_back(&pending.image);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto outcomes = bridge_.uploadBatch(images);
+    const auto batch_ms = elapsedMs(start, std::chrono::steady_clock::now());
+
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      UploadResult result;
+      result.ok = outcomes[i].ok;
+      result.error = outcomes[i].error;
+      result.batch_ms = batch_ms;
+      result.upload_ms = batch_ms / static_cast<double>(batch.size());
+      result.queued_ms = elapsedMs(batch[i].submitted, start);
+      result.batch_size = batch.size();
+      if (batch[i].completion) {
+        batch[i].completion(result);
+      }
+      batch[i].promise.set_value(std::move(result));
+    }
+
+    {
+      std::lock_guard lock(mutex_);
+      in_flight_ = 0;
+      if (pending_.empty()) {
+        idle_cv_.notify_all();
+      }
+    }
+  }
+}
+
+}  // namespace cataloger::platform::gpu
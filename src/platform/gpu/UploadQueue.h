@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GpuBridge.h"
+
+namespace cataloger::platform::gpu {
+
+struct UploadResult {
+  bool ok{false};
+  std::string error;
+  double upload_ms{0.0};  // this image's share of its batch
+  double batch_ms{0.0};   // wall time of the whole submission
+  double queued_ms{0.0};  // submit() to batch start
+  std::size_t batch_size{0};
+};
+
+// Completes once the texture is on the device (or the upload failed).
+using UploadFence = std::shared_future<UploadResult>;
+
+// Moves uploads off the caller's thread. Submissions are collected for up
+// to one frame interval (or until a batch fills) and handed to the bridge
+// as one uploadBatch() call, which Metal turns into a single command
+// buffer. Completions run on the queue's thread, in submission order.
+class UploadQueue {
+public:
+  using Completion = std::function<void(const UploadResult&)>;
+
+  struct Options {
+    std::chrono::microseconds frame_interval{16667};
+    std::size_t max_batch{16};
+    std::size_t max_pending{64};  // submit() blocks beyond this
+  };
+
+  struct Stats {
+    std::uint64_t submitted{0};
+    std::uint64_t batches{0};
+    std::size_t largest_batch{0};
+  };
+
+  UploadQueue(GpuBridge& bridge, Options options);
+  explicit UploadQueue(GpuBridge& bridge) : UploadQueue(bridge, Options{}) {}
+  // Uploads everything already submitted before returning.
+  ~UploadQueue();
+
+  UploadQueue(const UploadQueue&) = delete;
+  UploadQueue& operator=(const UploadQueue&) = delete;
+
+  UploadFence submit(cataloger::services::preview::PreviewImage image,
+                     Completion completion = {});
+  // Blocks until every submitted upload has completed and its completion ran.
+  void flush() const;
+  [[nodiscard]] Stats stats() const;
+
+private:
+  struct Pending {
+    cataloger::services::preview::PreviewImage image;
+    Completion completion;
+    std::promise<UploadResult> promise;
+    std::chrono::steady_clock::time_point submitted;
+  };
+
+  void run(std::stop_token token);
+
+  GpuBridge& bridge_;
+  Options options_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable space_cv_;
+  mutable std::condition_variable idle_cv_;
+  std::vector<Pending> pending_;
+  std::size_t in_flight_{0};
+  bool stopping_{false};
+  Stats stats_;
+  std::jthread thread_;
+};
+
+}  // namespace cataloger::platform::gpu
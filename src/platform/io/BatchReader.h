@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace cataloger::platform::io {
+
+enum class Backend { kIoUring, kThreadPool };
+
+// One positional read into caller-owned memory.
+struct ReadRequest {
+  int fd{-1};
+  std::uint64_t offset{};
+  std::span<std::uint8_t> destination;
+};
+
+struct ReadResult {
+  std::size_t bytes_read{};  // short only at end of file or on error
+  int error{};               // errno value; 0 on success
+};
+
+// Submits many positional reads at once so the device sees a deep queue
+// instead of one request per calling thread.
+class BatchReader {
+public:
+  virtual ~BatchReader() = default;
+  // Blocks until every request has completed. Results are index-aligned
+  // with `requests`. Safe to call from several threads at once.
+  virtual std::vector<ReadResult> readBatch(std::span<const ReadRequest> requests) = 0;
+  [[nodiscard]] virtual Backend backend() const noexcept = 0;
+};
+
+// Read-only descriptor that closes itself.
+class FileHandle {
+public:
+  FileHandle() = default;
+  explicit FileHandle(const std::filesystem::path& path);
+  FileHandle(const FileHandle&) = delete;
+  FileHandle& operator=(const FileHandle&) = delete;
+  FileHandle(FileHandle&& other) noexcept;
+  FileHandle& operator=(FileHandle&& other) noexcept;
+  ~FileHandle();
+
+  [[nodiscard]] bool isOpen() const noexcept { return fd_ >= 0; }
+  [[nodiscard]] int fd() const noexcept { return fd_; }
+  [[nodiscard]] std::uint64_t size() const noexcept { return size_; }
+
+private:
+  int fd_{-1};
+  std::uint64_t size_{0};
+};
+
+// Reads until `destination` is full, stopping early only at end of file or
+// on an error. Safe to call on one descriptor from several threads.
+ReadResult ReadFully(int fd, std::span<std::uint8_t> destination, std::uint64_t offset);
+
+// Returns the io_uring reader when it was compiled in
+// (CATALOGER_ENABLE_IO_URING) and the running kernel allows it, otherwise a
+// pread thread pool. `queue_depth` bounds in-flight reads per batch.
+std::unique_ptr<BatchReader> CreateBatchReader(std::size_t queue_depth = 64);
+std::unique_ptr<BatchReader> CreateThreadPoolReader(std::size_t thread_count);
+
+const char* BackendName(Backend backend) noexcept;
+
+}  // namespace cataloger::platform::io
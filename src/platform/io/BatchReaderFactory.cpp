@@ -0,0 +1,31 @@
+#include "BatchReader.h"
+
+#include <algorithm>
+
+namespace cataloger::platform::io {
+
+#if defined(CATALOGER_HAVE_IO_URING)
+std::unique_ptr<BatchReader> CreateIoUringReader(std::size_t queue_depth);
+#endif
+
+std::unique_ptr<BatchReader> CreateBatchReader(std::size_t queue_depth) {
+#if defined(CATALOGER_HAVE_IO_URING)
+  if (auto reader = CreateIoUringReader(queue_depth)) {
+    return reader;
+  }
+#endif
+  // Blocking preads only reach queue depth N with N threads; stop at a
+  // count that saturates SATA/NVMe without flooding network shares.
+  return CreateThreadPoolReader(std::clamp<std::size_t>(queue_depth / 4, 2, 16));
+}
+
+const char* BackendName(Backend backend) noexcept {
+  switch (backend) {
+    case Backend::kIoUring:
+      return "io_uring";
+    default:
+      return "pread";
+  }
+}
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,150 @@
+#include "ContentHash.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace cataloger::platform::io {
+
+namespace {
+
+constexpr std::uint64_t kPrime1 = 11400714785074694791ull;
+constexpr std::uint64_t kPrime2 = 14029467366897019727ull;
+constexpr std::uint64_t kPrime3 = 1609587929392839161ull;
+constexpr std::uint64_t kPrime4 = 9650029242287828579ull;
+constexpr std::uint64_t kPrime5 = 2870177450012600261ull;
+
+constexpr std::uint64_t rotl(std::uint64_t value, int bits) noexcept {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+// Little-endian loads. memcpy compiles to a plain move; big-endian hosts
+// reassemble the bytes instead so hashes match across machines.
+template <typename T>
+T readLittleEndian(const std::uint8_t* data) noexcept {
+  T value;
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(&value, data, sizeof(value));
+  } else {
+    value = 0;
+    for (std::size_t i = sizeof(T); i > 0; --i) {
+      value = static_cast<T>(value << 8) | data[i - 1];
+    }
+  }
+  return value;
+}
+
+std::uint64_t read64(const std::uint8_t* data) noexcept {
+  return readLittleEndian<std::uint64_t>(data);
+}
+
+std::uint32_t read32(const std::uint8_t* data) noexcept {
+  return readLittleEndian<std::uint32_t>(data);
+}
+
+std::uint64_t round(std::uint64_t lane, std::uint64_t input) noexcept {
+  lane += input * kPrime2;
+  return rotl(lane, 31) * kPrime1;
+}
+
+std::uint64_t mergeRound(std::uint64_t hash, std::uint64_t lane) noexcept {
+  hash ^= round(0, lane);
+  return hash * kPrime1 + kPrime4;
+}
+
+void consumeStripe(std::array<std::uint64_t, 4>& lanes, const std::uint8_t* data) noexcept {
+  lanes[0] = round(lanes[0], read64(data));
+  lanes[1] = round(lanes[1], read64(data + 8));
+  lanes[2] = round(lanes[2], read64(data + 16));
+  lanes[3] = round(lanes[3], read64(data + 24));
+}
+
+}  // namespace
+
+void ContentHasher::reset() noexcept {
+  lanes_ = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+  pending_size_ = 0;
+  total_ = 0;
+}
+
+void ContentHasher::update(std::span<const std::uint8_t> data) noexcept {
+  total_ += data.size();
+  const auto* cursor = data.data();
+  auto remaining = data.size();
+
+  if (pending_size_ > 0) {
+    const auto take = std::min(remaining, pending_.size() - pending_size_);
+    std::memcpy(pending_.data() + pending_size_, cursor, take);
+    pending_size_ += take;
+    cursor += take;
+    remaining -= take;
+    if (pending_size_ < pending_.size()) {
+      return;
+    }
+    consumeStripe(lanes_, pending_.data());
+    pending_size_ = 0;
+  }
+  if (remaining >= pending_.size()) {
+    // Locals stay in registers across the hot loop.
+    auto lanes = lanes_;
+    do {
+      consumeStripe(lanes, cursor);
+      cursor += pending_.size();
+      remaining -= pending_.size();
+    } while (remaining >= pending_.size());
+    lanes_ = lanes;
+  }
+  if (remaining > 0) {
+    std::memcpy(pending_.data(), cursor, remaining);
+    pending_size_ = remaining;
+  }
+}
+
+std::uint64_t ContentHasher::digest() const noexcept {
+  std::uint64_t hash = 0;
+  if (total_ >= pending_.size()) {
+    hash = rotl(lanes_[0], 1) + rotl(lanes_[1], 7) + rotl(lanes_[2], 12) + rotl(lanes_[3], 18);
+    for (const auto lane : lanes_) {
+      hash = mergeRound(hash, lane);
+    }
+  } else {
+    hash = kPrime5;
+  }
+  hash += total_;
+
+  const auto* tail = pending_.data();
+  auto remaining = pending_size_;
+  while (remaining >= 8) {
+    hash ^= round(0, read64(tail));
+    hash = rotl(hash, 27) * kPrime1 + kPrime4;
+    tail += 8;
+    remaining -= 8;
+  }
+  if (remaining >= 4) {
+    hash ^= static_cast<std::uint64_t>(read32(tail)) * kPrime1;
+    hash = rotl(hash, 23) * kPrime2 + kPrime3;
+    tail += 4;
+    remaining -= 4;
+  }
+  while (remaining > 0) {
+    hash ^= *tail * kPrime5;
+    hash = rotl(hash, 11) * kPrime1;
+    ++tail;
+    --remaining;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+std::uint64_t HashBytes(std::span<const std::uint8_t> data) noexcept {
+  ContentHasher hasher;
+  hasher.update(data);
+  return hasher.digest();
+}
+
+}  // namespace cataloger::platform::io
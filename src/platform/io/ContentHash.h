@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace cataloger::platform::io {
+
+// Streaming XXH64 (seed 0). Fed the chunks a copy already holds in memory,
+// it fingerprints a file without reading it a second time; scalar XXH64
+// runs well above card and disk speeds.
+class ContentHasher {
+public:
+  ContentHasher() noexcept { reset(); }
+
+  void reset() noexcept;
+  void update(std::span<const std::uint8_t> data) noexcept;
+  [[nodiscard]] std::uint64_t digest() const noexcept;
+
+private:
+  std::array<std::uint64_t, 4> lanes_{};
+  std::array<std::uint8_t, 32> pending_{};
+  std::size_t pending_size_{0};
+  std::uint64_t total_{0};
+};
+
+[[nodiscard]] std::uint64_t HashBytes(std::span<const std::uint8_t> data) noexcept;
+
+struct ReadBackHash {
+  std::uint64_t hash{};
+  std::uint64_t bytes{};
+  bool direct{false};  // read with O_DIRECT rather than through dropped cache
+  int error{};         // errno value; 0 on success
+};
+
+// Hashes `path` from the storage rather than the page cache, to confirm
+// what actually reached the disk. Uses O_DIRECT where the filesystem takes
+// it; elsewhere the file's cached pages are dropped before reading (they
+// are clean once fsynced) and again afterwards, so verifying an ingest
+// does not evict the working set.
+ReadBackHash HashFileUncached(const std::filesystem::path& path,
+                              std::size_t buffer_bytes = 1024 * 1024);
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,383 @@
+#include "FileCopy.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <utility>
+
+#include "ContentHash.h"
+
+namespace cataloger::platform::io {
+
+namespace {
+
+// One kernel call moves at most this much, so a stop between calls stays
+// reasonably prompt on slow media.
+constexpr std::uint64_t kKernelChunk = 64ull * 1024 * 1024;
+
+bool kernelPathRefused(int error) {
+  return error == EXDEV || error == ENOSYS || error == EINVAL || error == EOPNOTSUPP ||
+         error == EPERM || error == EBADF;
+}
+
+int renameNoReplace(const std::filesystem::path& from, const std::filesystem::path& to) {
+#if defined(__linux__) && defined(RENAME_NOREPLACE)
+  if (::renameat2(AT_FDCWD, from.c_str(), AT_FDCWD, to.c_str(), RENAME_NOREPLACE) == 0) {
+    return 0;
+  }
+  if (errno != EINVAL && errno != ENOSYS) {
+    return errno;
+  }
+#elif defined(__APPLE__)
+  if (::renamex_np(from.c_str(), to.c_str(), RENAME_EXCL) == 0) {
+    return 0;
+  }
+  if (errno != ENOTSUP) {
+    return errno;
+  }
+#endif
+  // Filesystems without an exclusive rename: check, then rename.
+  struct stat info {};
+  if (::lstat(to.c_str(), &info) == 0) {
+    return EEXIST;
+  }
+  return ::rename(from.c_str(), to.c_str()) == 0 ? 0 : errno;
+}
+
+// A rename lives in the directory, so it is only durable once the
+// directory is synced too.
+int syncDirectory(const std::filesystem::path& directory) {
+  const auto path = directory.empty() ? std::filesystem::path(".") : directory;
+  const int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return errno;
+  }
+  int error = 0;
+  // Some filesystems cannot sync a directory and say so with EINVAL.
+  if (::fsync(fd) != 0 && errno != EINVAL) {
+    error = errno;
+  }
+  ::close(fd);
+  return error;
+}
+
+}  // namespace
+
+int WriteFully(int fd, const std::uint8_t* data, std::size_t length, std::uint64_t offset) {
+  while (length > 0) {
+    const auto wrote = ::pwrite(fd, data, length, static_cast<off_t>(offset));
+    if (wrote < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    }
+    if (wrote == 0) {
+      return EIO;
+    }
+    data += wrote;
+    offset += static_cast<std::uint64_t>(wrote);
+    length -= static_cast<std::size_t>(wrote);
+  }
+  return 0;
+}
+
+CopyOutcome CopyFileData(int in_fd,
+                         int out_fd,
+                         std::uint64_t length,
+                         std::span<std::uint8_t> buffer,
+                         bool allow_kernel_copy,
+                         ContentHasher* hasher) {
+  CopyOutcome outcome;
+  std::uint64_t offset = 0;
+
+#if defined(__linux__)
+  if (allow_kernel_copy && !hasher) {
+    outcome.method = CopyMethod::kCopyFileRange;
+    bool refused = false;
+    while (offset < length) {
+      loff_t in_off = static_cast<loff_t>(offset);
+      loff_t out_off = static_cast<loff_t>(offset);
+      const auto chunk = static_cast<std::size_t>(std::min(length - offset, kKernelChunk));
+      const auto moved = ::copy_file_range(in_fd, &in_off, out_fd, &out_off, chunk, 0);
+      if (moved < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (!kernelPathRefused(errno)) {
+          outcome.error = errno;
+          outcome.bytes_copied = offset;
+          return outcome;
+        }
+        refused = true;
+        break;
+      }
+      if (moved == 0) {
+        break;  // source shorter than expected
+      }
+      offset += static_cast<std::uint64_t>(moved);
+    }
+
+    // sendfile reads at an explicit offset but writes at the output's file
+    // position, which has to be moved to match.
+    if (refused && ::lseek(out_fd, static_cast<off_t>(offset), SEEK_SET) >= 0) {
+      outcome.method = CopyMethod::kSendfile;
+      refused = false;
+      while (offset < length) {
+        off_t in_off = static_cast<off_t>(offset);
+        const auto chunk = static_cast<std::size_t>(std::min(length - offset, kKernelChunk));
+        const auto moved = ::sendfile(out_fd, in_fd, &in_off, chunk);
+        if (moved < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          if (!kernelPathRefused(errno)) {
+            outcome.error = errno;
+            outcome.bytes_copied = offset;
+            return outcome;
+          }
+          refused = true;
+          break;
+        }
+        if (moved == 0) {
+          break;
+        }
+        offset += static_cast<std::uint64_t>(moved);
+      }
+    }
+    if (!refused) {
+      outcome.bytes_copied = offset;
+      return outcome;
+    }
+  }
+#else
+  (void)allow_kernel_copy;
+#endif
+
+  outcome.method = CopyMethod::kReadWrite;
+  if (buffer.empty()) {
+    outcome.error = EINVAL;
+    outcome.bytes_copied = offset;
+    return outcome;
+  }
+  while (offset < length) {
+    const auto want = static_cast<std::size_t>(
+        std::min<std::uint64_t>(length - offset, buffer.size()));
+    const auto got = ::pread(in_fd, buffer.data(), want, static_cast<off_t>(offset));
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      outcome.error = errno;
+      break;
+    }
+    if (got == 0) {
+      break;
+    }
+    if (const auto error = WriteFully(out_fd, buffer.data(), static_cast<std::size_t>(got), offset)) {
+      outcome.error = error;
+      break;
+    }
+    if (hasher) {
+      hasher->update({buffer.data(), static_cast<std::size_t>(got)});
+    }
+    offset += static_cast<std::uint64_t>(got);
+  }
+  outcome.bytes_copied = offset;
+  return outcome;
+}
+
+PartialFile::PartialFile(std::filesystem::path destination)
+    : destination_(std::move(destination)) {
+  temporary_ = destination_.parent_path() /
+               ("." + destination_.filename().string() + ".cataloger-partial");
+  // A stale temporary from an interrupted run is simply overwritten.
+  fd_ = ::open(temporary_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    open_error_ = errno;
+  }
+}
+
+PartialFile::PartialFile(PartialFile&& other) noexcept
+    : destination_(std::move(other.destination_)),
+      temporary_(std::move(other.temporary_)),
+      fd_(std::exchange(other.fd_, -1)),
+      open_error_(other.open_error_) {}
+
+PartialFile& PartialFile::operator=(PartialFile&& other) noexcept {
+  if (this != &other) {
+    abandon();
+    destination_ = std::move(other.destination_);
+    temporary_ = std::move(other.temporary_);
+    fd_ = std::exchange(other.fd_, -1);
+    open_error_ = other.open_error_;
+  }
+  return *this;
+}
+
+PartialFile::~PartialFile() {
+  abandon();
+}
+
+int PartialFile::commit(bool sync, bool overwrite) {
+  if (fd_ < 0) {
+    return open_error_ != 0 ? open_error_ : EBADF;
+  }
+  int error = 0;
+  if (sync) {
+#if defined(__APPLE__)
+    // fsync() on Darwin does not flush the drive's cache.
+    if (::fcntl(fd_, F_FULLFSYNC) != 0 && ::fsync(fd_) != 0) {
+      error = errno;
+    }
+#else
+    if (::fsync(fd_) != 0) {
+      error = errno;
+    }
+#endif
+  }
+  if (::close(std::exchange(fd_, -1)) != 0 && error == 0) {
+    error = errno;
+  }
+  if (error == 0) {
+    if (overwrite) {
+      error = ::rename(temporary_.c_str(), destination_.c_str()) == 0 ? 0 : errno;
+    } else {
+      error = renameNoReplace(temporary_, destination_);
+    }
+  }
+  if (error != 0) {
+    ::unlink(temporary_.c_str());
+  } else if (sync) {
+    error = syncDirectory(destination_.parent_path());
+  }
+  temporary_.clear();
+  return error;
+}
+
+void PartialFile::abandon() noexcept {
+  if (fd_ >= 0) {
+    ::close(std::exchange(fd_, -1));
+  }
+  if (!temporary_.empty()) {
+    ::unlink(temporary_.c_str());
+    temporary_.clear();
+  }
+}
+
+AppendFile::~AppendFile() {
+  close();
+}
+
+int AppendFile::open(const std::filesystem::path& path) {
+  close();
+  fd_ = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+  return fd_ >= 0 ? 0 : errno;
+}
+
+int AppendFile::append(std::span<const std::uint8_t> data) {
+  if (fd_ < 0) {
+    return EBADF;
+  }
+  const auto* bytes = data.data();
+  auto length = data.size();
+  while (length > 0) {
+    const auto wrote = ::write(fd_, bytes, length);
+    if (wrote < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    }
+    bytes += wrote;
+    length -= static_cast<std::size_t>(wrote);
+  }
+  return 0;
+}
+
+int AppendFile::sync() {
+  if (fd_ < 0) {
+    return 0;
+  }
+  return ::fsync(fd_) == 0 ? 0 : errno;
+}
+
+void AppendFile::close() noexcept {
+  if (fd_ >= 0) {
+    ::close(std::exchange(fd_, -1));
+  }
+}
+
+std::uint64_t DeviceId(const std::filesystem::path& path) {
+  auto probe = path;
+  while (!probe.empty()) {
+    struct stat info {};
+    if (::stat(probe.c_str(), &info) == 0) {
+      return static_cast<std::uint64_t>(info.st_dev);
+    }
+    if (probe == probe.parent_path()) {
+      break;
+    }
+    probe = probe.parent_path();
+  }
+  return 0;
+}
+
+VolumeInfo DescribeVolume(const std::filesystem::path& path) {
+  VolumeInfo volume;
+  std::error_code ec;
+  auto current = std::filesystem::canonical(path, ec);
+  struct stat info {};
+  if (ec || ::stat(current.c_str(), &info) != 0) {
+    return volume;
+  }
+  const auto device = info.st_dev;
+  while (current.has_relative_path()) {
+    const auto parent = current.parent_path();
+    struct stat parent_info {};
+    if (::stat(parent.c_str(), &parent_info) != 0 || parent_info.st_dev != device) {
+      break;
+    }
+    current = parent;
+  }
+  volume.mount_root = current;
+
+#if defined(__linux__)
+  // udev names a link after each filesystem UUID (the FAT/exFAT serial on
+  // cards); the one resolving to our device is the volume's identity.
+  for (const auto& entry : std::filesystem::directory_iterator("/dev/disk/by-uuid", ec)) {
+    struct stat link_info {};
+    if (::stat(entry.path().c_str(), &link_info) == 0 && S_ISBLK(link_info.st_mode) &&
+        link_info.st_rdev == device) {
+      volume.id = "uuid:" + entry.path().filename().string();
+      return volume;
+    }
+  }
+#endif
+  char fallback[32];
+  std::snprintf(fallback, sizeof(fallback), "dev:%llx",
+                static_cast<unsigned long long>(device));
+  volume.id = fallback;
+  return volume;
+}
+
+const char* CopyMethodName(CopyMethod method) noexcept {
+  switch (method) {
+    case CopyMethod::kCopyFileRange:
+      return "copy_file_range";
+    case CopyMethod::kSendfile:
+      return "sendfile";
+    default:
+      return "pread/pwrite";
+  }
+}
+
+}  // namespace cataloger::platform::io
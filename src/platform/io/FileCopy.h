@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace cataloger::platform::io {
+
+class ContentHasher;
+
+enum class CopyMethod { kCopyFileRange, kSendfile, kReadWrite };
+
+struct CopyOutcome {
+  std::uint64_t bytes_copied{};
+  CopyMethod method{CopyMethod::kReadWrite};  // the last one used
+  int error{};                                // errno value; 0 on success
+};
+
+// Copies the first `length` bytes of `in_fd` to `out_fd`, both from offset
+// 0. Stays in the kernel when allowed (copy_file_range, then sendfile, on
+// Linux) and falls back to pread/pwrite through `buffer` wherever the
+// kernel path is refused: cross-device on older kernels, FUSE and some
+// exFAT card drivers. With a `hasher`, every byte copied is fed to it on
+// the way through, which needs the bytes in userspace: the kernel paths are
+// skipped.
+CopyOutcome CopyFileData(int in_fd,
+                         int out_fd,
+                         std::uint64_t length,
+                         std::span<std::uint8_t> buffer,
+                         bool allow_kernel_copy = true,
+                         ContentHasher* hasher = nullptr);
+
+// Writes `length` bytes from `data` at `offset`, retrying short writes.
+// Returns 0 or the errno value.
+int WriteFully(int fd, const std::uint8_t* data, std::size_t length, std::uint64_t offset);
+
+// A destination file written under a hidden temporary name next to it and
+// renamed into place by commit(), so readers never see a half-copied file.
+// Destroying an uncommitted file unlinks the temporary.
+class PartialFile {
+public:
+  PartialFile() = default;
+  explicit PartialFile(std::filesystem::path destination);
+  PartialFile(const PartialFile&) = delete;
+  PartialFile& operator=(const PartialFile&) = delete;
+  PartialFile(PartialFile&& other) noexcept;
+  PartialFile& operator=(PartialFile&& other) noexcept;
+  ~PartialFile();
+
+  [[nodiscard]] bool isOpen() const noexcept { return fd_ >= 0; }
+  [[nodiscard]] int fd() const noexcept { return fd_; }
+  // errno from opening the temporary; 0 when open.
+  [[nodiscard]] int openError() const noexcept { return open_error_; }
+  [[nodiscard]] const std::filesystem::path& destination() const noexcept { return destination_; }
+
+  // Optionally fsyncs, closes and renames into place. Fails with EEXIST
+  // rather than replace an existing destination unless `overwrite`. With
+  // `sync` the directory is fsynced after the rename as well, so the new
+  // name survives a crash. Returns 0 or the errno value; the temporary is
+  // removed on failure.
+  int commit(bool sync, bool overwrite);
+  void abandon() noexcept;
+
+private:
+  std::filesystem::path destination_;
+  std::filesystem::path temporary_;
+  int fd_{-1};
+  int open_error_{0};
+};
+
+// An existing file opened for appending, as journals and indexes grow:
+// every append lands at the current end of the file. Closes itself.
+class AppendFile {
+public:
+  AppendFile() = default;
+  AppendFile(const AppendFile&) = delete;
+  AppendFile& operator=(const AppendFile&) = delete;
+  ~AppendFile();
+
+  // Returns 0 or the errno value.
+  int open(const std::filesystem::path& path);
+  [[nodiscard]] bool isOpen() const noexcept { return fd_ >= 0; }
+  // Writes all of `data`, retrying short writes. Returns 0 or the errno
+  // value.
+  int append(std::span<const std::uint8_t> data);
+  // Flushes what was appended to the device. Returns 0 or the errno value.
+  int sync();
+  void close() noexcept;
+
+private:
+  int fd_{-1};
+};
+
+// st_dev of `path`, or of its nearest existing ancestor; 0 if none exists.
+std::uint64_t DeviceId(const std::filesystem::path& path);
+
+struct VolumeInfo {
+  // Stable across remounts where the filesystem has a UUID or serial
+  // ("uuid:1234-ABCD"); otherwise the device number ("dev:803"), which a
+  // card reader may reassign on the next insert.
+  std::string id;
+  // Top of the filesystem holding the path, so card-relative paths do not
+  // depend on which folder the user picked.
+  std::filesystem::path mount_root;
+};
+
+// Empty id when `path` does not exist.
+VolumeInfo DescribeVolume(const std::filesystem::path& path);
+
+const char* CopyMethodName(CopyMethod method) noexcept;
+
+}  // namespace cataloger::platform::io
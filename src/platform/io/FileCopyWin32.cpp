@@ -0,0 +1,261 @@
+#include "FileCopy.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <optional>
+#include <utility>
+
+#include "ContentHash.h"
+#include "Win32File.h"
+
+namespace cataloger::platform::io {
+
+namespace {
+
+struct Volume {
+  std::filesystem::path root;
+  DWORD serial{0};
+};
+
+std::optional<Volume> volumeOf(const std::filesystem::path& path) {
+  std::array<wchar_t, MAX_PATH + 1> root{};
+  if (!::GetVolumePathNameW(path.c_str(), root.data(), static_cast<DWORD>(root.size()))) {
+    return std::nullopt;
+  }
+  Volume volume;
+  if (!::GetVolumeInformationW(root.data(), nullptr, 0, &volume.serial, nullptr, nullptr,
+                               nullptr, 0)) {
+    return std::nullopt;
+  }
+  volume.root = root.data();
+  return volume;
+}
+
+}  // namespace
+
+int WriteFully(int fd, const std::uint8_t* data, std::size_t length, std::uint64_t offset) {
+  while (length > 0) {
+    std::size_t wrote = 0;
+    if (const auto error = win32::WriteAt(fd, data, length, offset, wrote)) {
+      return error;
+    }
+    if (wrote == 0) {
+      return EIO;
+    }
+    data += wrote;
+    offset += wrote;
+    length -= wrote;
+  }
+  return 0;
+}
+
+// No descriptor-to-descriptor copy call exists, so every copy goes through
+// `buffer`.
+CopyOutcome CopyFileData(int in_fd,
+                         int out_fd,
+                         std::uint64_t length,
+                         std::span<std::uint8_t> buffer,
+                         bool /*allow_kernel_copy*/,
+                         ContentHasher* hasher) {
+  CopyOutcome outcome;
+  if (buffer.empty()) {
+    outcome.error = EINVAL;
+    return outcome;
+  }
+  std::uint64_t offset = 0;
+  while (offset < length) {
+    const auto want = static_cast<std::size_t>(
+        std::min<std::uint64_t>(length - offset, buffer.size()));
+    std::size_t got = 0;
+    if (const auto error = win32::ReadAt(in_fd, buffer.data(), want, offset, got)) {
+      outcome.error = error;
+      break;
+    }
+    if (got == 0) {
+      break;
+    }
+    if (const auto error = WriteFully(out_fd, buffer.data(), got, offset)) {
+      outcome.error = error;
+      break;
+    }
+    if (hasher) {
+      hasher->update({buffer.data(), got});
+    }
+    offset += got;
+  }
+  outcome.bytes_copied = offset;
+  return outcome;
+}
+
+PartialFile::PartialFile(std::filesystem::path destination)
+    : destination_(std::move(destination)) {
+  temporary_ = destination_.parent_path() /
+               (L"." + destination_.filename().wstring() + L".cataloger-partial");
+  // A stale temporary from an interrupted run is simply overwritten.
+  fd_ = ::_wopen(temporary_.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY | _O_NOINHERIT,
+                 _S_IREAD | _S_IWRITE);
+  if (fd_ < 0) {
+    open_error_ = errno;
+  }
+}
+
+PartialFile::PartialFile(PartialFile&& other) noexcept
+    : destination_(std::move(other.destination_)),
+      temporary_(std::move(other.temporary_)),
+      fd_(std::exchange(other.fd_, -1)),
+      open_error_(other.open_error_) {}
+
+PartialFile& PartialFile::operator=(PartialFile&& other) noexcept {
+  if (this != &other) {
+    abandon();
+    destination_ = std::move(other.destination_);
+    temporary_ = std::move(other.temporary_);
+    fd_ = std::exchange(other.fd_, -1);
+    open_error_ = other.open_error_;
+  }
+  return *this;
+}
+
+PartialFile::~PartialFile() {
+  abandon();
+}
+
+int PartialFile::commit(bool sync, bool overwrite) {
+  if (fd_ < 0) {
+    return open_error_ != 0 ? open_error_ : EBADF;
+  }
+  int error = 0;
+  if (sync && ::_commit(fd_) != 0) {
+    error = errno;
+  }
+  if (::_close(std::exchange(fd_, -1)) != 0 && error == 0) {
+    error = errno;
+  }
+  if (error == 0) {
+    // Without MOVEFILE_REPLACE_EXISTING the move fails on an existing
+    // destination, which is the exclusive rename POSIX needs renameat2 for.
+    // Write-through returns only once the new name is on disk.
+    DWORD flags = overwrite ? MOVEFILE_REPLACE_EXISTING : 0;
+    if (sync) {
+      flags |= MOVEFILE_WRITE_THROUGH;
+    }
+    if (!::MoveFileExW(temporary_.c_str(), destination_.c_str(), flags)) {
+      error = win32::ErrnoFromWin32(::GetLastError());
+    }
+  }
+  if (error != 0) {
+    ::_wunlink(temporary_.c_str());
+  }
+  temporary_.clear();
+  return error;
+}
+
+void PartialFile::abandon() noexcept {
+  if (fd_ >= 0) {
+    ::_close(std::exchange(fd_, -1));
+  }
+  if (!temporary_.empty()) {
+    ::_wunlink(temporary_.c_str());
+    temporary_.clear();
+  }
+}
+
+AppendFile::~AppendFile() {
+  close();
+}
+
+int AppendFile::open(const std::filesystem::path& path) {
+  close();
+  fd_ = ::_wopen(path.c_str(), _O_WRONLY | _O_APPEND | _O_BINARY | _O_NOINHERIT);
+  return fd_ >= 0 ? 0 : errno;
+}
+
+int AppendFile::append(std::span<const std::uint8_t> data) {
+  if (fd_ < 0) {
+    return EBADF;
+  }
+  const auto* bytes = data.data();
+  auto length = data.size();
+  while (length > 0) {
+    const auto want = static_cast<unsigned>(std::min(length, win32::kMaxTransfer));
+    const auto wrote = ::_write(fd_, bytes, want);
+    if (wrote < 0) {
+      return errno;
+    }
+    if (wrote == 0) {
+      return EIO;
+    }
+    bytes += wrote;
+    length -= static_cast<std::size_t>(wrote);
+  }
+  return 0;
+}
+
+int AppendFile::sync() {
+  if (fd_ < 0) {
+    return 0;
+  }
+  return ::_commit(fd_) == 0 ? 0 : errno;
+}
+
+void AppendFile::close() noexcept {
+  if (fd_ >= 0) {
+    ::_close(std::exchange(fd_, -1));
+  }
+}
+
+// The volume serial stands in for st_dev.
+std::uint64_t DeviceId(const std::filesystem::path& path) {
+  auto probe = path;
+  while (!probe.empty()) {
+    std::error_code ec;
+    if (std::filesystem::exists(probe, ec)) {
+      const auto volume = volumeOf(probe);
+      return volume ? static_cast<std::uint64_t>(volume->serial) + 1 : 0;
+    }
+    if (probe == probe.parent_path()) {
+      break;
+    }
+    probe = probe.parent_path();
+  }
+  return 0;
+}
+
+VolumeInfo DescribeVolume(const std::filesystem::path& path) {
+  VolumeInfo info;
+  std::error_code ec;
+  const auto current = std::filesystem::canonical(path, ec);
+  if (ec) {
+    return info;
+  }
+  const auto volume = volumeOf(current);
+  if (!volume) {
+    return info;
+  }
+  info.mount_root = volume->root;
+  // Written as Linux names a FAT/exFAT card's by-uuid link, so a card keeps
+  // its identity between machines.
+  char id[32];
+  std::snprintf(id, sizeof(id), "uuid:%04lX-%04lX",
+                static_cast<unsigned long>(volume->serial >> 16),
+                static_cast<unsigned long>(volume->serial & 0xffff));
+  info.id = id;
+  return info;
+}
+
+const char* CopyMethodName(CopyMethod method) noexcept {
+  switch (method) {
+    case CopyMethod::kCopyFileRange:
+      return "copy_file_range";
+    case CopyMethod::kSendfile:
+      return "sendfile";
+    default:
+      return "ReadFile/WriteFile";
+  }
+}
+
+}  // namespace cataloger::platform::io
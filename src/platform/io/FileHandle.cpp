@@ -0,0 +1,68 @@
+#include "BatchReader.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <utility>
+
+namespace cataloger::platform::io {
+
+FileHandle::FileHandle(const std::filesystem::path& path) {
+  fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    return;
+  }
+  struct stat info {};
+  if (::fstat(fd_, &info) == 0) {
+    size_ = static_cast<std::uint64_t>(info.st_size);
+  }
+}
+
+FileHandle::FileHandle(FileHandle&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)), size_(std::exchange(other.size_, 0)) {}
+
+FileHandle& FileHandle::operator=(FileHandle&& other) noexcept {
+  if (this != &other) {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    fd_ = std::exchange(other.fd_, -1);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+FileHandle::~FileHandle() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+ReadResult ReadFully(int fd, std::span<std::uint8_t> destination, std::uint64_t offset) {
+  ReadResult result;
+  auto* out = destination.data();
+  auto remaining = destination.size();
+  auto at = static_cast<off_t>(offset);
+  while (remaining > 0) {
+    const auto got = ::pread(fd, out, remaining, at);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      result.error = errno;
+      break;
+    }
+    if (got == 0) {
+      break;
+    }
+    out += got;
+    at += got;
+    remaining -= static_cast<std::size_t>(got);
+    result.bytes_read += static_cast<std::size_t>(got);
+  }
+  return result;
+}
+
+}  // namespace cataloger::platform::io
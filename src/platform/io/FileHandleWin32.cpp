@@ -0,0 +1,58 @@
+#include "BatchReader.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <utility>
+
+#include "Win32File.h"
+
+namespace cataloger::platform::io {
+
+FileHandle::FileHandle(const std::filesystem::path& path) {
+  fd_ = ::_wopen(path.c_str(), _O_RDONLY | _O_BINARY | _O_NOINHERIT);
+  if (fd_ < 0) {
+    return;
+  }
+  struct _stat64 info {};
+  if (::_fstat64(fd_, &info) == 0) {
+    size_ = static_cast<std::uint64_t>(info.st_size);
+  }
+}
+
+FileHandle::FileHandle(FileHandle&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)), size_(std::exchange(other.size_, 0)) {}
+
+FileHandle& FileHandle::operator=(FileHandle&& other) noexcept {
+  if (this != &other) {
+    if (fd_ >= 0) {
+      ::_close(fd_);
+    }
+    fd_ = std::exchange(other.fd_, -1);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+FileHandle::~FileHandle() {
+  if (fd_ >= 0) {
+    ::_close(fd_);
+  }
+}
+
+ReadResult ReadFully(int fd, std::span<std::uint8_t> destination, std::uint64_t offset) {
+  ReadResult result;
+  while (result.bytes_read < destination.size()) {
+    std::size_t got = 0;
+    result.error = win32::ReadAt(fd, destination.data() + result.bytes_read,
+                                 destination.size() - result.bytes_read,
+                                 offset + result.bytes_read, got);
+    if (result.error != 0 || got == 0) {
+      break;
+    }
+    result.bytes_read += got;
+  }
+  return result;
+}
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,442 @@
+#include "FileWatcher.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+
+namespace cataloger::platform::io {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+#if defined(__linux__)
+constexpr std::uint32_t kWatchMask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                     IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR |
+                                     IN_EXCL_UNLINK;
+#endif
+
+int openNotifier() {
+#if defined(__linux__)
+  const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  return fd >= 0 ? fd : -errno;
+#else
+  return -ENOSYS;
+#endif
+}
+
+int addWatch([[maybe_unused]] int fd, [[maybe_unused]] const std::filesystem::path& path) {
+#if defined(__linux__)
+  // Fails with ENOSPC past fs.inotify.max_user_watches; that directory
+  // then goes unwatched.
+  return ::inotify_add_watch(fd, path.c_str(), kWatchMask);
+#else
+  return -1;
+#endif
+}
+
+void removeWatch([[maybe_unused]] int fd, [[maybe_unused]] int wd) {
+#if defined(__linux__)
+  ::inotify_rm_watch(fd, wd);
+#endif
+}
+
+// Timestamps are taken from a coarse clock, so a file written just after
+// a check can carry an mtime slightly before it.
+constexpr std::int64_t kMtimeSlackNs = 1'000'000'000;
+
+std::int64_t mtimeNs(const std::filesystem::path& path) {
+  struct stat info {};
+  if (::stat(path.c_str(), &info) != 0) {
+    return -1;
+  }
+#if defined(__APPLE__)
+  const auto& mtime = info.st_mtimespec;
+#else
+  const auto& mtime = info.st_mtim;
+#endif
+  return static_cast<std::int64_t>(mtime.tv_sec) * 1'000'000'000 + mtime.tv_nsec;
+}
+
+std::int64_t wallClockNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string join(const std::string& directory, std::string_view name) {
+  if (directory.empty()) {
+    return std::string(name);
+  }
+  std::string path;
+  path.reserve(directory.size() + 1 + name.size());
+  path.append(directory).append("/").append(name);
+  return path;
+}
+
+bool isWithin(const std::string& path, const std::string& directory) {
+  return directory.empty() || path == directory ||
+         (path.size() > directory.size() && path.starts_with(directory) &&
+          path[directory.size()] == '/');
+}
+
+std::string parentOf(const std::string& path) {
+  const auto slash = path.rfind('/');
+  return slash == std::string::npos ? std::string{} : path.substr(0, slash);
+}
+
+}  // namespace
+
+FileWatcher::FileWatcher(std::filesystem::path root, Options options, BatchSink on_batch)
+    : root_(std::move(root)), options_(options), on_batch_(std::move(on_batch)) {}
+
+FileWatcher::~FileWatcher() {
+  stop();
+}
+
+int FileWatcher::start() {
+  if (thread_.joinable()) {
+    return 0;
+  }
+  const int fd = openNotifier();
+  if (fd < 0) {
+    return -fd;
+  }
+  if (::pipe(wake_) != 0) {
+    const int error = errno;
+    ::close(fd);
+    return error;
+  }
+  for (const int end : wake_) {
+    ::fcntl(end, F_SETFD, FD_CLOEXEC);
+  }
+  {
+    std::lock_guard lock(mutex_);
+    fd_ = fd;
+    watchTreeLocked({}, false);
+    if (directories_.empty()) {
+      // The root itself could not be watched.
+      ::close(fd_);
+      fd_ = -1;
+      for (auto& end : wake_) {
+        ::close(end);
+        end = -1;
+      }
+      return ENOENT;
+    }
+  }
+  thread_ = std::jthread([this](std::stop_token token) { run(token); });
+  return 0;
+}
+
+void FileWatcher::stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  thread_.request_stop();
+  const char byte = 0;
+  [[maybe_unused]] const auto written = ::write(wake_[1], &byte, 1);
+  thread_.join();
+
+  std::vector<std::vector<FileChange>> batches;
+  {
+    std::lock_guard lock(mutex_);
+    readEventsLocked(Clock::now());
+    batches = takeDueLocked(Clock::now(), true);
+    ::close(fd_);
+    fd_ = -1;
+    directories_.clear();
+    watch_by_path_.clear();
+  }
+  for (auto& end : wake_) {
+    ::close(end);
+    end = -1;
+  }
+  for (auto& batch : batches) {
+    if (on_batch_) {
+      on_batch_(std::move(batch));
+    }
+  }
+}
+
+void FileWatcher::recoverFromOverflow() {
+  std::lock_guard lock(mutex_);
+  recoverFromOverflowLocked(Clock::now());
+}
+
+std::size_t FileWatcher::watchedDirectories() const {
+  std::lock_guard lock(mutex_);
+  return directories_.size();
+}
+
+void FileWatcher::run(std::stop_token token) {
+  while (!token.stop_requested()) {
+    int timeout = -1;
+    {
+      std::lock_guard lock(mutex_);
+      timeout = nextTimeoutLocked(Clock::now());
+    }
+    std::array<pollfd, 2> fds{{{fd_, POLLIN, 0}, {wake_[0], POLLIN, 0}}};
+    ::poll(fds.data(), fds.size(), timeout);
+    if (token.stop_requested()) {
+      break;
+    }
+    std::vector<std::vector<FileChange>> batches;
+    {
+      std::lock_guard lock(mutex_);
+      const auto now = Clock::now();
+      readEventsLocked(now);
+      batches = takeDueLocked(now, false);
+    }
+    for (auto& batch : batches) {
+      if (on_batch_) {
+        on_batch_(std::move(batch));
+      }
+    }
+  }
+}
+
+void FileWatcher::watchTreeLocked(const std::string& relative_path, bool report) {
+  const auto now = Clock::now();
+  std::vector<std::string> stack{relative_path};
+  while (!stack.empty()) {
+    auto directory = std::move(stack.back());
+    stack.pop_back();
+    if (watch_by_path_.contains(directory)) {
+      continue;
+    }
+    const auto path = absolute(directory);
+    const auto checked = wallClockNs() - kMtimeSlackNs;
+    // Watch before listing, so nothing created in between is missed.
+    const int wd = addWatch(fd_, path);
+    if (wd < 0) {
+      continue;
+    }
+    directories_[wd] = {directory, mtimeNs(path), checked};
+    watch_by_path_[directory] = wd;
+    if (report) {
+      noteLocked(directory, FileChangeKind::kRescan, true, now);
+    }
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(path, ec), end; !ec && it != end;
+         it.increment(ec)) {
+      const auto name = it->path().filename().string();
+      std::error_code type_ec;
+      if (hidden(name) || !it->is_directory(type_ec) || it->is_symlink(type_ec)) {
+        continue;
+      }
+      stack.push_back(join(directory, name));
+    }
+  }
+}
+
+void FileWatcher::unwatchTreeLocked(const std::string& relative_path) {
+  for (auto it = watch_by_path_.begin(); it != watch_by_path_.end();) {
+    if (!isWithin(it->first, relative_path)) {
+      ++it;
+      continue;
+    }
+    removeWatch(fd_, it->second);
+    directories_.erase(it->second);
+    it = watch_by_path_.erase(it);
+  }
+}
+
+void FileWatcher::noteLocked(const std::string& relative_path,
+                             FileChangeKind kind,
+                             bool created,
+                             Clock::time_point now) {
+  const auto [it, inserted] = pending_.try_emplace(relative_path);
+  auto& pending = it->second;
+  if (inserted) {
+    pending.kind = kind;
+    pending.existed_before = !created;
+    pending.first_seen = now;
+  } else if (kind == FileChangeKind::kRemoved && !pending.existed_before) {
+    // Came and went within the window.
+    pending_.erase(it);
+    return;
+  } else if (!(pending.kind == FileChangeKind::kRescan && kind == FileChangeKind::kChanged)) {
+    pending.kind = kind;
+  }
+  pending.last_seen = now;
+}
+
+void FileWatcher::readEventsLocked([[maybe_unused]] Clock::time_point now) {
+#if defined(__linux__)
+  if (fd_ < 0) {
+    return;
+  }
+  alignas(inotify_event) std::array<char, 64 * 1024> buffer{};
+  bool overflowed = false;
+  for (;;) {
+    const auto count = ::read(fd_, buffer.data(), buffer.size());
+    if (count <= 0) {
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    for (std::size_t offset = 0; offset < static_cast<std::size_t>(count);) {
+      const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+      offset += sizeof(inotify_event) + event->len;
+      if ((event->mask & IN_Q_OVERFLOW) != 0) {
+        overflowed = true;
+        continue;
+      }
+      const auto directory = directories_.find(event->wd);
+      if (directory == directories_.end()) {
+        continue;
+      }
+      if ((event->mask & IN_IGNORED) != 0) {
+        watch_by_path_.erase(directory->second.relative_path);
+        directories_.erase(directory);
+        continue;
+      }
+      if (event->len == 0) {
+        continue;  // about the directory itself
+      }
+      const std::string_view name(event->name);
+      if (hidden(name)) {
+        continue;
+      }
+      auto path = join(directory->second.relative_path, name);
+      const bool arrived = (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0;
+      const bool left = (event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0;
+      if ((event->mask & IN_ISDIR) != 0) {
+        if (arrived) {
+          watchTreeLocked(path, true);
+        } else if (left) {
+          unwatchTreeLocked(path);
+          noteLocked(path, FileChangeKind::kRemoved, false, now);
+        }
+        continue;
+      }
+      noteLocked(path, left ? FileChangeKind::kRemoved : FileChangeKind::kChanged, arrived, now);
+    }
+  }
+  if (overflowed) {
+    recoverFromOverflowLocked(now);
+  }
+#endif
+}
+
+void FileWatcher::recoverFromOverflowLocked(Clock::time_point now) {
+  // Events were dropped, but not from directories whose mtime is the one
+  // last recorded and whose files are all older than their last check; a
+  // file modified in place leaves its directory's mtime alone. Directories
+  // with events pending were busy when the queue filled, so they are
+  // rescanned as well.
+  std::unordered_set<std::string> busy;
+  for (const auto& [path, pending] : pending_) {
+    busy.insert(pending.kind == FileChangeKind::kRescan ? path : parentOf(path));
+  }
+  const auto checked = wallClockNs() - kMtimeSlackNs;
+  std::vector<std::string> rescan;
+  for (auto& [wd, directory] : directories_) {
+    const auto path = absolute(directory.relative_path);
+    const auto mtime = mtimeNs(path);
+    if (mtime != directory.mtime_ns || busy.contains(directory.relative_path) ||
+        writtenSince(path, directory.checked_ns)) {
+      directory.mtime_ns = mtime;
+      rescan.push_back(directory.relative_path);
+    }
+    directory.checked_ns = checked;
+  }
+  for (const auto& directory : rescan) {
+    noteLocked(directory, FileChangeKind::kRescan, false, now);
+    // Subdirectories made while events were lost have no watch yet.
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(absolute(directory), ec), end;
+         !ec && it != end; it.increment(ec)) {
+      const auto name = it->path().filename().string();
+      std::error_code type_ec;
+      if (hidden(name) || !it->is_directory(type_ec) || it->is_symlink(type_ec)) {
+        continue;
+      }
+      watchTreeLocked(join(directory, name), true);
+    }
+  }
+}
+
+std::vector<std::vector<FileChange>> FileWatcher::takeDueLocked(Clock::time_point now,
+                                                                bool everything) {
+  std::vector<FileChange> due;
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    const auto& pending = it->second;
+    if (everything || now - pending.last_seen >= options_.debounce ||
+        now - pending.first_seen >= options_.max_delay) {
+      due.push_back({pending.kind, it->first});
+      it = pending_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  std::sort(due.begin(), due.end(), [](const FileChange& a, const FileChange& b) {
+    return a.relative_path < b.relative_path;
+  });
+  std::vector<std::vector<FileChange>> batches;
+  const auto batch_size = std::max<std::size_t>(options_.max_batch, 1);
+  for (std::size_t begin = 0; begin < due.size(); begin += batch_size) {
+    const auto end = std::min(due.size(), begin + batch_size);
+    batches.emplace_back(std::make_move_iterator(due.begin() + static_cast<std::ptrdiff_t>(begin)),
+                         std::make_move_iterator(due.begin() + static_cast<std::ptrdiff_t>(end)));
+  }
+  return batches;
+}
+
+int FileWatcher::nextTimeoutLocked(Clock::time_point now) const {
+  if (pending_.empty()) {
+    return -1;
+  }
+  auto next = Clock::time_point::max();
+  for (const auto& [path, pending] : pending_) {
+    next = std::min({next, pending.last_seen + options_.debounce,
+                     pending.first_seen + options_.max_delay});
+  }
+  if (next <= now) {
+    return 0;
+  }
+  // Rounded up, so the wake-up finds the entry due.
+  return static_cast<int>(
+      std::chrono::ceil<std::chrono::milliseconds>(next - now).count());
+}
+
+bool FileWatcher::writtenSince(const std::filesystem::path& directory,
+                               std::int64_t since_ns) const {
+  std::error_code ec;
+  for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    std::error_code type_ec;
+    if (hidden(it->path().filename().string()) || !it->is_regular_file(type_ec)) {
+      continue;
+    }
+    if (mtimeNs(it->path()) >= since_ns) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FileWatcher::hidden(std::string_view name) const {
+  return options_.skip_hidden && name.starts_with('.');
+}
+
+std::filesystem::path FileWatcher::absolute(const std::string& relative_path) const {
+  return relative_path.empty() ? root_ : root_ / relative_path;
+}
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cataloger::platform::io {
+
+enum class FileChangeKind {
+  kChanged,  // the file exists and may differ from what was last seen
+  kRemoved,  // the file or directory, and everything below it, is gone
+  kRescan,   // compare the directory's entries; events for it were lost
+};
+
+struct FileChange {
+  FileChangeKind kind{FileChangeKind::kChanged};
+  std::string relative_path;  // generic form below the root; "" is the root
+};
+
+// Recursively watches a folder with inotify (one watch per directory) and
+// reports coalesced changes in batches. Events for a path are held until
+// it has been quiet for `debounce`, so create, modify and close_write of
+// one file become a single kChanged, and a file created and deleted within
+// the window is not reported at all. New directories are watched as they
+// appear and reported as kRescan, since files can land in them before
+// their watch exists. When the kernel queue overflows, only directories
+// whose mtime moved, that hold a file written since they were last checked
+// or that had events pending are reported for rescan, rather than the whole
+// tree. Hidden entries (temporaries such as
+// `.<name>.cataloger-partial`) are skipped unless `skip_hidden` is off.
+// Linux only; start() returns ENOSYS elsewhere.
+class FileWatcher {
+public:
+  // Runs on the watcher thread; each call is one batch.
+  using BatchSink = std::function<void(std::vector<FileChange> changes)>;
+
+  struct Options {
+    std::chrono::milliseconds debounce{250};
+    // A path that keeps changing is still reported this often.
+    std::chrono::milliseconds max_delay{2000};
+    std::size_t max_batch{512};
+    bool skip_hidden{true};
+  };
+
+  FileWatcher(std::filesystem::path root, Options options, BatchSink on_batch);
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher&) = delete;
+  FileWatcher& operator=(const FileWatcher&) = delete;
+
+  // Watches every directory below the root and starts the watcher thread.
+  // Returns 0 or the errno value.
+  int start();
+  // Stops the thread and reports whatever is still pending.
+  void stop();
+
+  // What the watcher does on IN_Q_OVERFLOW; public for tests.
+  void recoverFromOverflow();
+
+  [[nodiscard]] std::size_t watchedDirectories() const;
+
+private:
+  struct Pending {
+    FileChangeKind kind{FileChangeKind::kChanged};
+    bool existed_before{true};
+    std::chrono::steady_clock::time_point first_seen;
+    std::chrono::steady_clock::time_point last_seen;
+  };
+  struct Directory {
+    std::string relative_path;
+    std::int64_t mtime_ns{0};
+    // Wall-clock time of the last look; files with a later mtime were
+    // written since.
+    std::int64_t checked_ns{0};
+  };
+
+  void run(std::stop_token token);
+  [[nodiscard]] bool hidden(std::string_view name) const;
+  // True when a file directly in `directory` has an mtime at or after
+  // `since_ns`.
+  [[nodiscard]] bool writtenSince(const std::filesystem::path& directory,
+                                  std::int64_t since_ns) const;
+  std::filesystem::path absolute(const std::string& relative_path) const;
+  // The rest require mutex_.
+  void watchTreeLocked(const std::string& relative_path, bool report);
+  void unwatchTreeLocked(const std::string& relative_path);
+  void noteLocked(const std::string& relative_path,
+                  FileChangeKind kind,
+                  bool created,
+                  std::chrono::steady_clock::time_point now);
+  void readEventsLocked(std::chrono::steady_clock::time_point now);
+  void recoverFromOverflowLocked(std::chrono::steady_clock::time_point now);
+  std::vector<std::vector<FileChange>> takeDueLocked(std::chrono::steady_clock::time_point now,
+                                                     bool everything);
+  int nextTimeoutLocked(std::chrono::steady_clock::time_point now) const;
+
+  std::filesystem::path root_;
+  Options options_;
+  BatchSink on_batch_;
+  mutable std::mutex mutex_;
+  int fd_{-1};
+  int wake_[2]{-1, -1};
+  std::unordered_map<int, Directory> directories_;     // by watch descriptor
+  std::unordered_map<std::string, int> watch_by_path_;  // relative path -> wd
+  std::unordered_map<std::string, Pending> pending_;
+  std::jthread thread_;
+};
+
+}  // namespace cataloger::platform::io
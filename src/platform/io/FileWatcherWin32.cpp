@@ -0,0 +1,28 @@
+#include "FileWatcher.h"
+
+#include <cerrno>
+#include <utility>
+
+namespace cataloger::platform::io {
+
+// No ReadDirectoryChangesW port yet: start() reports ENOSYS, as it does on
+// every other system without inotify.
+FileWatcher::FileWatcher(std::filesystem::path root, Options options, BatchSink on_batch)
+    : root_(std::move(root)), options_(options), on_batch_(std::move(on_batch)) {}
+
+FileWatcher::~FileWatcher() = default;
+
+int FileWatcher::start() {
+  return ENOSYS;
+}
+
+void FileWatcher::stop() {}
+
+void FileWatcher::recoverFromOverflow() {}
+
+std::size_t FileWatcher::watchedDirectories() const {
+  std::lock_guard lock(mutex_);
+  return directories_.size();
+}
+
+}  // namespace cataloger::platform::io
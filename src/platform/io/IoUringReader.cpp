@@ -0,0 +1,281 @@
+#include "BatchReader.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace cataloger::platform::io {
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(
+      ::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+unsigned loadAcquire(unsigned* value) {
+  return std::atomic_ref<unsigned>(*value).load(std::memory_order_acquire);
+}
+
+void storeRelease(unsigned* value, unsigned next) {
+  std::atomic_ref<unsigned>(*value).store(next, std::memory_order_release);
+}
+
+ReadResult preadRemainder(const ReadRequest& request, ReadResult result) {
+  while (result.bytes_read < request.destination.size()) {
+    const auto got = ::pread(request.fd,
+                             request.destination.data() + result.bytes_read,
+                             request.destination.size() - result.bytes_read,
+                             static_cast<off_t>(request.offset + result.bytes_read));
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      result.error = got < 0 ? errno : 0;
+      break;
+    }
+    result.bytes_read += static_cast<std::size_t>(got);
+  }
+  return result;
+}
+
+// Single ring driven with raw syscalls (no liburing dependency). Batches are
+// serialized on the ring; one caller keeps up to `queue_depth` reads in
+// flight, which is what the device needs to reach its bandwidth.
+class IoUringReader : public BatchReader {
+public:
+  ~IoUringReader() override {
+    if (sqes_) {
+      ::munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ && cq_ring_ != sq_ring_) {
+      ::munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_) {
+      ::munmap(sq_ring_, sq_ring_size_);
+    }
+    if (ring_fd_ >= 0) {
+      ::close(ring_fd_);
+    }
+  }
+
+  bool initialize(unsigned queue_depth) {
+    io_uring_params params{};
+    ring_fd_ = ioUringSetup(queue_depth, &params);
+    if (ring_fd_ < 0) {
+      return false;  // ENOSYS on old kernels, EPERM under seccomp.
+    }
+    depth_ = params.sq_entries;
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      sq_ring_ = nullptr;
+      return false;
+    }
+    if (single_mmap) {
+      cq_ring_ = sq_ring_;
+    } else {
+      cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+      if (cq_ring_ == MAP_FAILED) {
+        cq_ring_ = nullptr;
+        return false;
+      }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    auto* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<std::uint8_t*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    auto* cq = static_cast<std::uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  std::vector<ReadResult> readBatch(std::span<const ReadRequest> requests) override {
+    std::vector<ReadResult> results(requests.size());
+    std::lock_guard lock(mutex_);
+    if (broken_) {
+      return finishWithPread(requests, results, 0, 0);
+    }
+
+    std::vector<std::size_t> retry;
+    std::size_t next = 0;
+    unsigned in_flight = 0;
+    unsigned unsubmitted = 0;
+    while (next < requests.size() || in_flight > 0 || !retry.empty()) {
+      while (in_flight < depth_ && (!retry.empty() || next < requests.size())) {
+        std::size_t index = 0;
+        if (!retry.empty()) {
+          index = retry.back();
+          retry.pop_back();
+        } else {
+          index = next++;
+          if (requests[index].destination.empty()) {
+            continue;
+          }
+        }
+        prepareRead(index, requests[index], results[index].bytes_read);
+        ++in_flight;
+        ++unsubmitted;
+      }
+
+      const auto consumed =
+          ioUringEnter(ring_fd_, unsubmitted, in_flight > 0 ? 1 : 0,
+                       IORING_ENTER_GETEVENTS);
+      if (consumed < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          reap(requests, results, retry, in_flight);
+          continue;
+        }
+        return finishWithPread(requests, results, in_flight, unsubmitted);
+      }
+      unsubmitted -= std::min(unsubmitted, static_cast<unsigned>(consumed));
+      reap(requests, results, retry, in_flight);
+    }
+    return results;
+  }
+
+  Backend backend() const noexcept override {
+    return Backend::kIoUring;
+  }
+
+private:
+  void prepareRead(std::size_t index, const ReadRequest& request, std::size_t done) {
+    const auto tail = *sq_tail_;
+    const auto slot = tail & sq_mask_;
+    auto& sqe = sqes_[slot];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = request.fd;
+    sqe.off = request.offset + done;
+    sqe.addr = reinterpret_cast<std::uint64_t>(request.destination.data() + done);
+    sqe.len = static_cast<unsigned>(
+        std::min<std::size_t>(request.destination.size() - done, 1u << 30));
+    sqe.user_data = index;
+    sq_array_[slot] = slot;
+    storeRelease(sq_tail_, tail + 1);
+  }
+
+  void reap(std::span<const ReadRequest> requests,
+            std::vector<ReadResult>& results,
+            std::vector<std::size_t>& retry,
+            unsigned& in_flight) {
+    auto head = *cq_head_;
+    while (head != loadAcquire(cq_tail_)) {
+      const auto& cqe = cqes_[head & cq_mask_];
+      const auto index = static_cast<std::size_t>(cqe.user_data);
+      const auto& request = requests[index];
+      auto& result = results[index];
+      --in_flight;
+      if (cqe.res == -EAGAIN || cqe.res == -EINTR) {
+        retry.push_back(index);
+      } else if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+        // Kernels before 5.6 lack IORING_OP_READ.
+        result = preadRemainder(request, result);
+      } else if (cqe.res < 0) {
+        result.error = -cqe.res;
+      } else if (cqe.res > 0) {
+        result.bytes_read += static_cast<std::size_t>(cqe.res);
+        if (result.bytes_read < request.destination.size()) {
+          retry.push_back(index);  // short read before EOF
+        }
+      }
+      ++head;
+    }
+    storeRelease(cq_head_, head);
+  }
+
+  // The ring is unusable, for this batch and every later one. Reads the
+  // kernel never took are rewound off the SQ ring; those it took still
+  // write into the callers' buffers, so they are waited for. The rest is
+  // then read synchronously.
+  std::vector<ReadResult> finishWithPread(std::span<const ReadRequest> requests,
+                                          std::vector<ReadResult>& results,
+                                          unsigned in_flight,
+                                          unsigned unsubmitted) {
+    broken_ = true;
+    if (unsubmitted > 0) {
+      storeRelease(sq_tail_, *sq_tail_ - unsubmitted);
+      in_flight -= unsubmitted;
+    }
+    std::vector<std::size_t> ignored;  // finished by pread below
+    reap(requests, results, ignored, in_flight);
+    while (in_flight > 0) {
+      if (ioUringEnter(ring_fd_, 0, in_flight, IORING_ENTER_GETEVENTS) < 0 &&
+          errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        // Completions are still posted without waiting in the kernel.
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      reap(requests, results, ignored, in_flight);
+    }
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+      if (results[i].error == 0 && results[i].bytes_read < requests[i].destination.size()) {
+        results[i] = preadRemainder(requests[i], results[i]);
+      }
+    }
+    return results;
+  }
+
+  std::mutex mutex_;
+  bool broken_{false};
+  int ring_fd_{-1};
+  unsigned depth_{0};
+  void* sq_ring_{nullptr};
+  void* cq_ring_{nullptr};
+  std::size_t sq_ring_size_{0};
+  std::size_t cq_ring_size_{0};
+  io_uring_sqe* sqes_{nullptr};
+  std::size_t sqes_size_{0};
+  unsigned* sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned* sq_array_{nullptr};
+  unsigned* cq_head_{nullptr};
+  unsigned* cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe* cqes_{nullptr};
+};
+
+}  // namespace
+
+std::unique_ptr<BatchReader> CreateIoUringReader(std::size_t queue_depth) {
+  auto reader = std::make_unique<IoUringReader>();
+  const auto depth = static_cast<unsigned>(std::clamp<std::size_t>(queue_depth, 1, 4096));
+  if (!reader->initialize(depth)) {
+    return nullptr;
+  }
+  return reader;
+}
+
+}  // namespace cataloger::platform::io
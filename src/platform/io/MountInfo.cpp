@@ -0,0 +1,93 @@
+#include "MountWatcher.h"
+
+#include <array>
+#include <string>
+#include <utility>
+
+namespace cataloger::platform::io {
+
+namespace {
+
+// mountinfo escapes space, tab, newline and backslash as \ooo.
+std::string unescape(std::string_view field) {
+  std::string out;
+  out.reserve(field.size());
+  for (std::size_t i = 0; i < field.size(); ++i) {
+    if (field[i] == '\\' && i + 3 < field.size() && field[i + 1] >= '0' &&
+        field[i + 1] <= '3') {
+      const auto digit = [&](std::size_t at) { return field[at] - '0'; };
+      out.push_back(static_cast<char>(digit(i + 1) * 64 + digit(i + 2) * 8 + digit(i + 3)));
+      i += 3;
+    } else {
+      out.push_back(field[i]);
+    }
+  }
+  return out;
+}
+
+std::vector<std::string_view> splitFields(std::string_view line) {
+  std::vector<std::string_view> fields;
+  std::size_t pos = 0;
+  while (pos < line.size()) {
+    const auto start = line.find_first_not_of(' ', pos);
+    if (start == std::string_view::npos) {
+      break;
+    }
+    const auto end = line.find(' ', start);
+    fields.push_back(line.substr(start, end - start));
+    pos = end == std::string_view::npos ? line.size() : end;
+  }
+  return fields;
+}
+
+}  // namespace
+
+std::vector<MountEntry> ParseMountInfo(std::string_view text) {
+  std::vector<MountEntry> mounts;
+  while (!text.empty()) {
+    const auto newline = text.find('\n');
+    const auto line = text.substr(0, newline);
+    text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+
+    // id parent major:minor root mount_point options [optional...] - type source super
+    const auto fields = splitFields(line);
+    std::size_t separator = 6;
+    while (separator < fields.size() && fields[separator] != "-") {
+      ++separator;
+    }
+    if (fields.size() < 6 || separator + 2 >= fields.size()) {
+      continue;
+    }
+    MountEntry mount;
+    try {
+      mount.mount_id = std::stoi(std::string(fields[0]));
+    } catch (...) {
+      continue;
+    }
+    mount.device = std::string(fields[2]);
+    mount.mount_point = unescape(fields[4]);
+    mount.fs_type = std::string(fields[separator + 1]);
+    mount.source = unescape(fields[separator + 2]);
+    mounts.push_back(std::move(mount));
+  }
+  return mounts;
+}
+
+bool IsRemovableMediaCandidate(const MountEntry& mount) {
+  static constexpr std::array<std::string_view, 8> kCardFilesystems = {
+      "vfat", "exfat", "msdos", "ntfs", "ntfs3", "fuseblk", "hfsplus", "udf"};
+  for (const auto type : kCardFilesystems) {
+    if (mount.fs_type == type) {
+      return true;
+    }
+  }
+  const auto point = mount.mount_point.generic_string();
+  for (const std::string_view prefix : {"/media/", "/run/media/", "/mnt/", "/Volumes/"}) {
+    if (point.starts_with(prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,201 @@
+#include "MountWatcher.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <set>
+#include <tuple>
+#include <utility>
+
+namespace cataloger::platform::io {
+
+namespace {
+
+auto mountKey(const MountEntry& mount) {
+  return std::tie(mount.mount_id, mount.mount_point, mount.source, mount.fs_type);
+}
+
+struct KeyLess {
+  bool operator()(const MountEntry& a, const MountEntry& b) const {
+    return mountKey(a) < mountKey(b);
+  }
+};
+
+MountChange diff(const std::vector<MountEntry>& before, const std::vector<MountEntry>& after) {
+  const std::set<MountEntry, KeyLess> old_set(before.begin(), before.end());
+  const std::set<MountEntry, KeyLess> new_set(after.begin(), after.end());
+  MountChange change;
+  for (const auto& mount : after) {
+    if (!old_set.contains(mount)) {
+      change.added.push_back(mount);
+    }
+  }
+  for (const auto& mount : before) {
+    if (!new_set.contains(mount)) {
+      change.removed.push_back(mount);
+    }
+  }
+  return change;
+}
+
+}  // namespace
+
+std::optional<std::filesystem::path> FindCameraFolder(const std::filesystem::path& mount_point) {
+  // DCF names the folder DCIM; case-sensitive filesystems may show it lower case.
+  for (const char* name : {"DCIM", "dcim"}) {
+    auto folder = mount_point / name;
+    struct stat info {};
+    if (::stat(folder.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+      continue;
+    }
+    // Readable, not just present: a card still being probed fails here.
+    DIR* dir = ::opendir(folder.c_str());
+    if (dir == nullptr) {
+      return std::nullopt;
+    }
+    errno = 0;
+    const bool readable = ::readdir(dir) != nullptr || errno == 0;
+    ::closedir(dir);
+    if (readable) {
+      return folder;
+    }
+  }
+  return std::nullopt;
+}
+
+MountWatcher::MountWatcher(Options options, ChangeSink on_change)
+    : options_(std::move(options)), on_change_(std::move(on_change)) {}
+
+MountWatcher::~MountWatcher() {
+  stop();
+}
+
+int MountWatcher::start() {
+  if (thread_.joinable()) {
+    return 0;
+  }
+  {
+    std::lock_guard lock(mutex_);
+    if (const int error = readTableLocked(last_text_); error != 0) {
+      return error;
+    }
+    mounts_ = ParseMountInfo(last_text_);
+  }
+  if (::pipe(wake_) != 0) {
+    return errno;
+  }
+  for (const int fd : wake_) {
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  thread_ = std::jthread([this](std::stop_token token) { run(token); });
+  return 0;
+}
+
+void MountWatcher::stop() {
+  if (thread_.joinable()) {
+    thread_.request_stop();
+    const char byte = 0;
+    [[maybe_unused]] const auto written = ::write(wake_[1], &byte, 1);
+    thread_.join();
+  }
+  for (auto& fd : wake_) {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  std::lock_guard lock(mutex_);
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool MountWatcher::refresh() {
+  std::lock_guard refresh_lock(refresh_mutex_);
+  MountChange change;
+  {
+    std::lock_guard lock(mutex_);
+    std::string text;
+    if (readTableLocked(text) != 0 || text == last_text_) {
+      return false;
+    }
+    auto mounts = ParseMountInfo(text);
+    // There is always a root mount; an empty table is a file caught
+    // between truncate and write.
+    if (mounts.empty()) {
+      return false;
+    }
+    change = diff(mounts_, mounts);
+    mounts_ = std::move(mounts);
+    last_text_ = std::move(text);
+  }
+  if (change.added.empty() && change.removed.empty()) {
+    return false;
+  }
+  if (on_change_) {
+    on_change_(change);
+  }
+  return true;
+}
+
+std::vector<MountEntry> MountWatcher::mounts() const {
+  std::lock_guard lock(mutex_);
+  return mounts_;
+}
+
+void MountWatcher::run(std::stop_token token) {
+  const auto timeout = static_cast<int>(options_.rescan_interval.count());
+  while (!token.stop_requested()) {
+    int fd = -1;
+    {
+      std::lock_guard lock(mutex_);
+      fd = fd_;
+    }
+    // A regular file never raises POLLPRI, so it is re-read on the timeout.
+    std::array<pollfd, 2> fds{{{fd, POLLPRI, 0}, {wake_[0], POLLIN, 0}}};
+    const int ready = ::poll(fds.data(), fds.size(), timeout);
+    if (token.stop_requested()) {
+      break;
+    }
+    if (ready < 0 && errno != EINTR) {
+      std::this_thread::sleep_for(options_.rescan_interval);
+    }
+    refresh();
+  }
+}
+
+int MountWatcher::readTableLocked(std::string& text) {
+  if (fd_ < 0) {
+    fd_ = ::open(options_.mountinfo.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+      return errno;
+    }
+  }
+  // Reading the table from the start also acknowledges the POLLPRI.
+  if (::lseek(fd_, 0, SEEK_SET) < 0) {
+    return errno;
+  }
+  text.clear();
+  std::array<char, 16 * 1024> buffer{};
+  for (;;) {
+    const auto count = ::read(fd_, buffer.data(), buffer.size());
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    }
+    if (count == 0) {
+      return 0;
+    }
+    text.append(buffer.data(), static_cast<std::size_t>(count));
+  }
+}
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace cataloger::platform::io {
+
+// One line of /proc/<pid>/mountinfo.
+struct MountEntry {
+  int mount_id{0};
+  std::string device;  // "major:minor"
+  std::filesystem::path mount_point;
+  std::string fs_type;
+  std::string source;  // e.g. /dev/sdb1
+};
+
+struct MountChange {
+  std::vector<MountEntry> added;
+  std::vector<MountEntry> removed;
+};
+
+// Parses mountinfo text, undoing the kernel's octal escapes in paths.
+// Lines that do not parse are skipped.
+std::vector<MountEntry> ParseMountInfo(std::string_view text);
+
+// Filesystems cameras write and desktop automounters mount cards with,
+// or a mount point under /media, /run/media, /mnt or /Volumes.
+bool IsRemovableMediaCandidate(const MountEntry& mount);
+
+// The DCIM folder at the top of a mounted card, found with a stat and the
+// first entry of one readdir rather than a directory walk; empty until the
+// folder is there and readable.
+std::optional<std::filesystem::path> FindCameraFolder(const std::filesystem::path& mount_point);
+
+// Watches a mountinfo file and reports mounts that appear and disappear.
+// The kernel flags /proc/self/mountinfo with POLLPRI on every change, so
+// the watcher thread sleeps in poll() and re-reads the table only when it
+// moves; `rescan_interval` is a fallback that also lets a plain file stand
+// in for the table in tests (rewrite it in place: the watcher keeps it
+// open). The sink runs on the watcher thread. Windows has no mount table:
+// start() returns ENOSYS there.
+class MountWatcher {
+public:
+  using ChangeSink = std::function<void(const MountChange& change)>;
+
+  struct Options {
+    std::filesystem::path mountinfo{"/proc/self/mountinfo"};
+    std::chrono::milliseconds rescan_interval{2000};
+  };
+
+  MountWatcher(Options options, ChangeSink on_change);
+  ~MountWatcher();
+
+  MountWatcher(const MountWatcher&) = delete;
+  MountWatcher& operator=(const MountWatcher&) = delete;
+
+  // Reads the current table, which later changes are measured against,
+  // and starts the watcher thread. Returns 0 or the errno value.
+  int start();
+  void stop();
+
+  // Re-reads the table now and reports any change; true if there was one.
+  bool refresh();
+
+  [[nodiscard]] std::vector<MountEntry> mounts() const;
+
+private:
+  void run(std::stop_token token);
+  // Requires mutex_. Returns the errno value of a failed read, else 0.
+  int readTableLocked(std::string& text);
+
+  Options options_;
+  ChangeSink on_change_;
+  std::mutex refresh_mutex_;  // one refresh, sink included, at a time
+  mutable std::mutex mutex_;
+  int fd_{-1};
+  int wake_[2]{-1, -1};
+  std::string last_text_;
+  std::vector<MountEntry> mounts_;
+  std::jthread thread_;
+};
+
+}  // namespace cataloger::platform::io
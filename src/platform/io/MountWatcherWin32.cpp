@@ -0,0 +1,46 @@
+#include "MountWatcher.h"
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+namespace cataloger::platform::io {
+
+std::optional<std::filesystem::path> FindCameraFolder(const std::filesystem::path& mount_point) {
+  // NTFS and exFAT compare names without case, so one spelling finds both.
+  auto folder = mount_point / "DCIM";
+  std::error_code ec;
+  if (!std::filesystem::is_directory(folder, ec)) {
+    return std::nullopt;
+  }
+  // Readable, not just present: a card still being probed fails here.
+  std::filesystem::directory_iterator entries(folder, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return folder;
+}
+
+// There is no mountinfo to watch; drive arrival would come from
+// RegisterDeviceNotification, which needs a window to deliver to.
+MountWatcher::MountWatcher(Options options, ChangeSink on_change)
+    : options_(std::move(options)), on_change_(std::move(on_change)) {}
+
+MountWatcher::~MountWatcher() = default;
+
+int MountWatcher::start() {
+  return ENOSYS;
+}
+
+void MountWatcher::stop() {}
+
+bool MountWatcher::refresh() {
+  return false;
+}
+
+std::vector<MountEntry> MountWatcher::mounts() const {
+  std::lock_guard lock(mutex_);
+  return mounts_;
+}
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,52 @@
+#include "PageCacheHints.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace cataloger::platform::io {
+
+bool AdviseRange(const std::filesystem::path& path,
+                 std::uint64_t offset,
+                 std::uint64_t length,
+                 PageCacheAdvice advice) {
+  if (length == 0) {
+    return false;
+  }
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  bool ok = false;
+#if defined(__linux__)
+  if (advice == PageCacheAdvice::kWillNeed) {
+    // readahead() queues the I/O immediately; fadvise is the fallback for
+    // filesystems that reject it.
+    ok = ::readahead(fd, static_cast<off64_t>(offset), static_cast<std::size_t>(length)) == 0;
+    if (!ok) {
+      ok = ::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length),
+                           POSIX_FADV_WILLNEED) == 0;
+    }
+  } else {
+    ok = ::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length),
+                         POSIX_FADV_DONTNEED) == 0;
+  }
+#elif defined(__APPLE__)
+  if (advice == PageCacheAdvice::kWillNeed) {
+    radvisory hint{};
+    hint.ra_offset = static_cast<off_t>(offset);
+    hint.ra_count = static_cast<int>(
+        std::min<std::uint64_t>(length, std::numeric_limits<int>::max()));
+    ok = ::fcntl(fd, F_RDADVISE, &hint) != -1;
+  }
+  // Darwin has no per-range eviction hint; DONTNEED is a no-op there.
+#endif
+
+  ::close(fd);
+  return ok;
+}
+
+}  // namespace cataloger::platform::io
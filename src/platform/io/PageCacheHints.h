@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+namespace cataloger::platform::io {
+
+enum class PageCacheAdvice { kWillNeed, kDontNeed };
+
+// Tells the OS page cache about a byte range we are about to read (start
+// fetching it now) or are done with (its pages may be dropped). Purely
+// advisory: returns false when the platform or filesystem ignores the hint.
+bool AdviseRange(const std::filesystem::path& path,
+                 std::uint64_t offset,
+                 std::uint64_t length,
+                 PageCacheAdvice advice);
+
+}  // namespace cataloger::platform::io
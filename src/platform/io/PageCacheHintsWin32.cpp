@@ -0,0 +1,14 @@
+#include "PageCacheHints.h"
+
+namespace cataloger::platform::io {
+
+// The Windows cache manager takes no per-range hints on a file it does not
+// map, so every hint is ignored, as the header allows.
+bool AdviseRange(const std::filesystem::path& /*path*/,
+                 std::uint64_t /*offset*/,
+                 std::uint64_t /*length*/,
+                 PageCacheAdvice /*advice*/) {
+  return false;
+}
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,100 @@
+#include "ContentHash.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <memory>
+
+namespace cataloger::platform::io {
+
+namespace {
+
+// O_DIRECT wants buffers, offsets and lengths on the logical block size;
+// 4 KiB covers every disk and card we see.
+constexpr std::size_t kDirectAlignment = 4096;
+
+struct FreeDeleter {
+  void operator()(std::uint8_t* data) const noexcept { std::free(data); }
+};
+
+}  // namespace
+
+ReadBackHash HashFileUncached(const std::filesystem::path& path, std::size_t buffer_bytes) {
+  ReadBackHash result;
+  const auto size = (std::max(buffer_bytes, kDirectAlignment) + kDirectAlignment - 1) /
+                    kDirectAlignment * kDirectAlignment;
+  std::unique_ptr<std::uint8_t, FreeDeleter> buffer(
+      static_cast<std::uint8_t*>(std::aligned_alloc(kDirectAlignment, size)));
+  if (!buffer) {
+    result.error = ENOMEM;
+    return result;
+  }
+
+  int fd = -1;
+#if defined(O_DIRECT)
+  fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+  result.direct = fd >= 0;
+#endif
+  if (fd < 0) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      result.error = errno;
+      return result;
+    }
+#if defined(__APPLE__)
+    result.direct = ::fcntl(fd, F_NOCACHE, 1) != -1;
+#endif
+  }
+#if defined(__linux__)
+  if (!result.direct) {
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  }
+#endif
+
+  ContentHasher hasher;
+  std::uint64_t offset = 0;
+  while (true) {
+    const auto got = ::pread(fd, buffer.get(), size, static_cast<off_t>(offset));
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+#if defined(O_DIRECT)
+      // Some filesystems accept O_DIRECT at open and refuse it on read.
+      if (errno == EINVAL && result.direct && offset == 0) {
+        ::close(fd);
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+          result.error = errno;
+          return result;
+        }
+        result.direct = false;
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        continue;
+      }
+#endif
+      result.error = errno;
+      break;
+    }
+    if (got == 0) {
+      break;
+    }
+    hasher.update({buffer.get(), static_cast<std::size_t>(got)});
+    offset += static_cast<std::uint64_t>(got);
+  }
+#if defined(__linux__)
+  if (!result.direct) {
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  }
+#endif
+  ::close(fd);
+
+  result.bytes = offset;
+  result.hash = hasher.digest();
+  return result;
+}
+
+}  // namespace cataloger::platform::io
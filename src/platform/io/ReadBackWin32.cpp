@@ -0,0 +1,94 @@
+#include "ContentHash.h"
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "Win32File.h"
+
+namespace cataloger::platform::io {
+
+namespace {
+
+// FILE_FLAG_NO_BUFFERING wants buffers and lengths on the sector size;
+// 4 KiB covers every disk and card we see.
+constexpr std::size_t kDirectAlignment = 4096;
+
+struct AlignedFree {
+  void operator()(std::uint8_t* data) const noexcept { ::_aligned_free(data); }
+};
+
+struct HandleCloser {
+  void operator()(HANDLE handle) const noexcept { ::CloseHandle(handle); }
+};
+using UniqueHandle = std::unique_ptr<void, HandleCloser>;
+
+UniqueHandle openForHashing(const std::filesystem::path& path, bool direct) {
+  const DWORD flags = FILE_FLAG_SEQUENTIAL_SCAN | (direct ? FILE_FLAG_NO_BUFFERING : 0);
+  const auto handle = ::CreateFileW(path.c_str(), GENERIC_READ,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    nullptr, OPEN_EXISTING, flags, nullptr);
+  return UniqueHandle(handle == INVALID_HANDLE_VALUE ? nullptr : handle);
+}
+
+}  // namespace
+
+// Unbuffered reads come from the device, as O_DIRECT does on Linux; a
+// volume that refuses them is read through the cache.
+ReadBackHash HashFileUncached(const std::filesystem::path& path, std::size_t buffer_bytes) {
+  ReadBackHash result;
+  const auto size = (std::max(buffer_bytes, kDirectAlignment) + kDirectAlignment - 1) /
+                    kDirectAlignment * kDirectAlignment;
+  std::unique_ptr<std::uint8_t, AlignedFree> buffer(
+      static_cast<std::uint8_t*>(::_aligned_malloc(size, kDirectAlignment)));
+  if (!buffer) {
+    result.error = ENOMEM;
+    return result;
+  }
+
+  auto file = openForHashing(path, true);
+  result.direct = file != nullptr;
+  if (!file) {
+    file = openForHashing(path, false);
+    if (!file) {
+      result.error = win32::ErrnoFromWin32(::GetLastError());
+      return result;
+    }
+  }
+
+  ContentHasher hasher;
+  std::uint64_t offset = 0;
+  while (true) {
+    DWORD got = 0;
+    const auto want = static_cast<DWORD>(std::min(size, win32::kMaxTransfer));
+    if (!::ReadFile(file.get(), buffer.get(), want, &got, nullptr)) {
+      const auto error = ::GetLastError();
+      // Some volumes accept the flag at open and refuse it on read.
+      if (error == ERROR_INVALID_PARAMETER && result.direct && offset == 0) {
+        file = openForHashing(path, false);
+        if (!file) {
+          result.error = win32::ErrnoFromWin32(::GetLastError());
+          return result;
+        }
+        result.direct = false;
+        continue;
+      }
+      if (error != ERROR_HANDLE_EOF) {
+        result.error = win32::ErrnoFromWin32(error);
+      }
+      break;
+    }
+    if (got == 0) {
+      break;
+    }
+    hasher.update({buffer.get(), got});
+    offset += got;
+  }
+
+  result.bytes = offset;
+  result.hash = hasher.digest();
+  return result;
+}
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,108 @@
+#include "BatchReader.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace cataloger::platform::io {
+
+namespace {
+
+// Portable fallback: a fixed set of threads issuing blocking positional
+// reads. The queue depth the device sees equals the thread count.
+class ThreadPoolReader : public BatchReader {
+public:
+  explicit ThreadPoolReader(std::size_t thread_count) {
+    thread_count = std::max<std::size_t>(1, thread_count);
+    threads_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      threads_.emplace_back([this](std::stop_token token) { run(token); });
+    }
+  }
+
+  ~ThreadPoolReader() override {
+    {
+      std::lock_guard lock(mutex_);
+      stop_ = true;
+    }
+    work_cv_.notify_all();
+    threads_.clear();
+  }
+
+  std::vector<ReadResult> readBatch(std::span<const ReadRequest> requests) override {
+    std::vector<ReadResult> results(requests.size());
+    if (requests.empty()) {
+      return results;
+    }
+    Batch batch{requests, results, requests.size()};
+    {
+      std::lock_guard lock(mutex_);
+      for (std::size_t i = 0; i < requests.size(); ++i) {
+        work_.push_back({&batch, i});
+      }
+    }
+    work_cv_.notify_all();
+
+    std::unique_lock lock(mutex_);
+    done_cv_.wait(lock, [&] { return batch.remaining == 0; });
+    return results;
+  }
+
+  Backend backend() const noexcept override {
+    return Backend::kThreadPool;
+  }
+
+private:
+  struct Batch {
+    std::span<const ReadRequest> requests;
+    std::vector<ReadResult>& results;
+    std::size_t remaining;
+  };
+
+  struct WorkItem {
+    Batch* batch;
+    std::size_t index;
+  };
+
+  void run(std::stop_token token) {
+    while (!token.stop_requested()) {
+      WorkItem item{};
+      {
+        std::unique_lock lock(mutex_);
+        work_cv_.wait(lock, [&] { return stop_ || !work_.empty(); });
+        if (stop_) {
+          return;
+        }
+        item = work_.front();
+        work_.pop_front();
+      }
+
+      const auto& request = item.batch->requests[item.index];
+      const auto result = ReadFully(request.fd, request.destination, request.offset);
+
+      std::lock_guard lock(mutex_);
+      item.batch->results[item.index] = result;
+      if (--item.batch->remaining == 0) {
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::deque<WorkItem> work_;
+  bool stop_{false};
+  std::vector<std::jthread> threads_;
+};
+
+}  // namespace
+
+std::unique_ptr<BatchReader> CreateThreadPoolReader(std::size_t thread_count) {
+  return std::make_unique<ThreadPoolReader>(thread_count);
+}
+
+}  // namespace cataloger::platform::io
@@ -0,0 +1,109 @@
+#pragma once
+
+// Shared by the *Win32.cpp builds of the io layer. They keep the CRT's int
+// descriptors so the interfaces match the POSIX builds; positional reads
+// and writes go through the descriptor's handle with an explicit offset,
+// which, unlike _lseeki64 then _read, is safe from several threads.
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <io.h>
+#include <windows.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+namespace cataloger::platform::io::win32 {
+
+// ReadFile and WriteFile take a 32-bit length.
+constexpr std::size_t kMaxTransfer = std::size_t{1} << 30;
+
+// The errno value closest to a Win32 error, for errno-returning interfaces.
+inline int ErrnoFromWin32(DWORD error) {
+  switch (error) {
+    case ERROR_SUCCESS:
+      return 0;
+    case ERROR_FILE_NOT_FOUND:
+    case ERROR_PATH_NOT_FOUND:
+      return ENOENT;
+    case ERROR_ACCESS_DENIED:
+    case ERROR_SHARING_VIOLATION:
+    case ERROR_LOCK_VIOLATION:
+      return EACCES;
+    case ERROR_FILE_EXISTS:
+    case ERROR_ALREADY_EXISTS:
+      return EEXIST;
+    case ERROR_DISK_FULL:
+    case ERROR_HANDLE_DISK_FULL:
+      return ENOSPC;
+    case ERROR_NOT_SAME_DEVICE:
+      return EXDEV;
+    case ERROR_INVALID_HANDLE:
+      return EBADF;
+    case ERROR_NOT_ENOUGH_MEMORY:
+    case ERROR_OUTOFMEMORY:
+      return ENOMEM;
+    case ERROR_NOT_SUPPORTED:
+    case ERROR_CALL_NOT_IMPLEMENTED:
+      return ENOSYS;
+    default:
+      return EIO;
+  }
+}
+
+inline HANDLE HandleOf(int fd) {
+  return reinterpret_cast<HANDLE>(::_get_osfhandle(fd));
+}
+
+// One read of up to `length` bytes at `offset`; `got` is 0 at end of file.
+// Returns 0 or the errno value.
+inline int ReadAt(int fd, void* data, std::size_t length, std::uint64_t offset, std::size_t& got) {
+  got = 0;
+  const auto handle = HandleOf(fd);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return EBADF;
+  }
+  OVERLAPPED at{};
+  at.Offset = static_cast<DWORD>(offset);
+  at.OffsetHigh = static_cast<DWORD>(offset >> 32);
+  DWORD done = 0;
+  if (!::ReadFile(handle, data, static_cast<DWORD>((std::min)(length, kMaxTransfer)), &done,
+                  &at)) {
+    const auto error = ::GetLastError();
+    return error == ERROR_HANDLE_EOF ? 0 : ErrnoFromWin32(error);
+  }
+  got = done;
+  return 0;
+}
+
+// One write of up to `length` bytes at `offset`. Returns 0 or the errno
+// value.
+inline int WriteAt(int fd,
+                   const void* data,
+                   std::size_t length,
+                   std::uint64_t offset,
+                   std::size_t& wrote) {
+  wrote = 0;
+  const auto handle = HandleOf(fd);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return EBADF;
+  }
+  OVERLAPPED at{};
+  at.Offset = static_cast<DWORD>(offset);
+  at.OffsetHigh = static_cast<DWORD>(offset >> 32);
+  DWORD done = 0;
+  if (!::WriteFile(handle, data, static_cast<DWORD>((std::min)(length, kMaxTransfer)), &done,
+                   &at)) {
+    return ErrnoFromWin32(::GetLastError());
+  }
+  wrote = done;
+  return 0;
+}
+
+}  // namespace cataloger::platform::io::win32
@@ -5,8 +5,10 @@
 #include <cctype>
 #include <map>
 #include <mutex>
+#include <set>
 #include <stdexcept>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <sqlite3.h>
 
@@ -99,6 +101,89 @@ std::string stackType(const StackAccumulator& acc) {
   return "single";
 }
 
+// Groups of two or more files sharing a basename become one stack.
+void insertStacks(sqlite3* db, const std::unordered_map<std::string, StackAccumulator>& accumulators) {
+  Statement insert_stack(db, "INSERT INTO stacks(type, anchor_file_id) VALUES(?, ?);");
+  Statement update_file(db, "UPDATE files SET stack_group_id=? WHERE id=?;");
+
+  for (const auto& [_, bucket] : accumulators) {
+    if (bucket.file_ids.size() < 2) {
+      continue;
+    }
+
+    insert_stack.reset();
+    const auto type = stackType(bucket);
+    sqlite3_bind_text(insert_stack.get(), 1, type.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(insert_stack.get(), 2, bucket.file_ids.front());
+    if (sqlite3_step(insert_stack.get()) != SQLITE_DONE) {
+      throw std::runtime_error(sqlite3_errmsg(db));
+    }
+    const auto stack_id = sqlite3_last_insert_rowid(db);
+
+    for (const auto file_id : bucket.file_ids) {
+      update_file.reset();
+      sqlite3_bind_int64(update_file.get(), 1, stack_id);
+      sqlite3_bind_int64(update_file.get(), 2, file_id);
+      if (sqlite3_step(update_file.get()) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db));
+      }
+    }
+  }
+}
+
+// Rebuilds the stacks of the files in `root_id` with these basenames, so
+// files cataloged in separate transactions still pair up.
+void restackBasenames(sqlite3* db, int root_id, const std::unordered_set<std::string>& basenames) {
+  // "IMG_0001" and every "IMG_0001.<ext>": '/' sorts right after '.'.
+  Statement members(db,
+                    "SELECT id, filename, extension, stack_group_id FROM files "
+                    "WHERE root_id=? AND (filename=? OR (filename>=? AND filename<?)) "
+                    "ORDER BY id;");
+  Statement clear_stack(db, "UPDATE files SET stack_group_id=NULL WHERE stack_group_id=?;");
+  Statement drop_stack(db, "DELETE FROM stacks WHERE stack_group_id=?;");
+
+  std::unordered_map<std::string, StackAccumulator> accumulators;
+  for (const auto& base : basenames) {
+    const auto low = base + ".";
+    const auto high = base + "/";
+    members.reset();
+    sqlite3_bind_int(members.get(), 1, root_id);
+    sqlite3_bind_text(members.get(), 2, base.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(members.get(), 3, low.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(members.get(), 4, high.c_str(), -1, SQLITE_TRANSIENT);
+    StackAccumulator bucket;
+    std::set<std::int64_t> old_stacks;
+    while (sqlite3_step(members.get()) == SQLITE_ROW) {
+      const auto* filename =
+          reinterpret_cast<const char*>(sqlite3_column_text(members.get(), 1));
+      if (!filename || baseName(filename) != base) {
+        continue;  // "IMG_0001.edit.jpg" belongs to "IMG_0001.edit"
+      }
+      bucket.file_ids.push_back(sqlite3_column_int64(members.get(), 0));
+      const auto* extension =
+          reinterpret_cast<const char*>(sqlite3_column_text(members.get(), 2));
+      const auto classification = classifyExtension(extension ? extension : "");
+      bucket.has_jpeg = bucket.has_jpeg || classification == ExtensionClass::kJpeg;
+      bucket.has_raw = bucket.has_raw || classification == ExtensionClass::kRaw;
+      if (sqlite3_column_type(members.get(), 3) != SQLITE_NULL) {
+        old_stacks.insert(sqlite3_column_int64(members.get(), 3));
+      }
+    }
+    for (const auto stack_id : old_stacks) {
+      clear_stack.reset();
+      sqlite3_bind_int64(clear_stack.get(), 1, stack_id);
+      drop_stack.reset();
+      sqlite3_bind_int64(drop_stack.get(), 1, stack_id);
+      if (sqlite3_step(clear_stack.get()) != SQLITE_DONE ||
+          sqlite3_step(drop_stack.get()) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db));
+      }
+    }
+    accumulators.emplace(base, std::move(bucket));
+  }
+  insertStacks(db, accumulators);
+}
+
 constexpr std::string_view kSchemaSql = R"SQL(
 CREATE TABLE IF NOT EXISTS root_folders (
   id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -120,6 +205,8 @@ CREATE TABLE IF NOT EXISTS files (
   stack_group_id INTEGER,
   metadata_rev INTEGER DEFAULT 0,
   preview_state INTEGER DEFAULT 0,
+  content_hash INTEGER,
+  mtime_ticks INTEGER,
   UNIQUE(root_id, relative_path)
 );
 
@@ -147,11 +234,109 @@ CREATE TABLE IF NOT EXISTS sync_queue (
   created_at INTEGER NOT NULL
 );
 
+CREATE TABLE IF NOT EXISTS icc_profiles (
+  profile_hash INTEGER PRIMARY KEY,
+  data BLOB NOT NULL,
+  created_at INTEGER NOT NULL
+);
+
+CREATE TABLE IF NOT EXISTS icc_discovery (
+  absolute_path TEXT PRIMARY KEY,
+  file_size INTEGER NOT NULL,
+  mtime INTEGER NOT NULL,
+  source INTEGER NOT NULL,
+  profile_hash INTEGER REFERENCES icc_profiles(profile_hash)
+);
+
+CREATE TABLE IF NOT EXISTS ingest_jobs (
+  id INTEGER PRIMARY KEY AUTOINCREMENT,
+  destination_root TEXT NOT NULL,
+  mirror_root TEXT,
+  finished INTEGER NOT NULL DEFAULT 0,
+  created_at INTEGER NOT NULL,
+  finished_at INTEGER
+);
+
+CREATE TABLE IF NOT EXISTS ingest_job_files (
+  job_id INTEGER NOT NULL REFERENCES ingest_jobs(id) ON DELETE CASCADE,
+  seq INTEGER NOT NULL,
+  source TEXT NOT NULL,
+  destination TEXT NOT NULL,
+  mirror TEXT,
+  file_size INTEGER,
+  capture_ticks INTEGER,
+  state INTEGER NOT NULL DEFAULT 0,
+  content_hash INTEGER,
+  error TEXT,
+  PRIMARY KEY(job_id, seq)
+);
+
 CREATE INDEX IF NOT EXISTS idx_files_root_path ON files(root_id, relative_path);
 CREATE INDEX IF NOT EXISTS idx_files_sort ON files(root_id, capture_ts, ingest_seq, id);
+CREATE INDEX IF NOT EXISTS idx_files_root_filename ON files(root_id, filename);
 CREATE INDEX IF NOT EXISTS idx_sync_queue_processed ON sync_queue(processed_flag, id);
 )SQL";
 
+// Columns added after the first release, for catalogs created before them.
+// CREATE TABLE IF NOT EXISTS leaves an existing table as it was.
+struct AddedColumn {
+  const char* table;
+  const char* column;
+  const char* definition;
+};
+
+constexpr AddedColumn kAddedColumns[] = {
+    {"files", "content_hash", "INTEGER"},
+    {"files", "mtime_ticks", "INTEGER"},
+};
+
+constexpr std::string_view kPostMigrationSql = R"SQL(
+CREATE INDEX IF NOT EXISTS idx_files_content_hash ON files(content_hash);
+)SQL";
+
+// sync_queue.processed_flag values.
+constexpr int kSyncPending = 0;
+constexpr int kSyncProcessed = 1;
+constexpr int kSyncClaimed = 2;
+
+// Reads a row selected as id, root_id, relative_path, event_type, payload,
+// processed_flag, created_at.
+SyncEvent readSyncEvent(sqlite3_stmt* stmt) {
+  SyncEvent event;
+  event.id = sqlite3_column_int64(stmt, 0);
+  event.root_id = sqlite3_column_int(stmt, 1);
+  event.relative_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+  event.event_type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+  if (sqlite3_column_type(stmt, 4) != SQLITE_NULL) {
+    event.payload = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+  }
+  event.processed = sqlite3_column_int(stmt, 5) == kSyncProcessed;
+  event.created_at = sqlite3_column_int64(stmt, 6);
+  return event;
+}
+
+// Binds the rows at `relative_path` and below it, for a statement whose
+// parameters `first`.. are "relative_path=? OR (relative_path>=? AND
+// relative_path<?)". '0' sorts right after '/'.
+void bindSubtree(sqlite3_stmt* stmt, int first, const std::string& relative_path) {
+  const auto low = relative_path + "/";
+  const auto high = relative_path + "0";
+  sqlite3_bind_text(stmt, first, relative_path.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, first + 1, low.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, first + 2, high.c_str(), -1, SQLITE_TRANSIENT);
+}
+
+bool hasColumn(sqlite3* db, const std::string& table, const std::string& column) {
+  Statement info(db, "PRAGMA table_info(" + table + ");");
+  while (sqlite3_step(info.get()) == SQLITE_ROW) {
+    const auto* name = reinterpret_cast<const char*>(sqlite3_column_text(info.get(), 1));
+    if (name && column == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
 CatalogService::CatalogService() : db_(nullptr) {}
@@ -177,6 +362,7 @@ void CatalogService::initializeSchema() {
   std::scoped_lock lock(db_mutex_);
   ensureOpen();
   applySchema(std::string(kSchemaSql));
+  migrateSchema();
 }
 
 int CatalogService::registerRoot(const std::filesystem::path& root_path) {
@@ -207,31 +393,47 @@ std::vector<FileRecord> CatalogService::scanRoot(
   }
 
   std::vector<FileRecord> files;
-  for (const auto& entry :
-       std::filesystem::recursive_directory_iterator(root_path)) {
+  for (auto it = std::filesystem::recursive_directory_iterator(root_path);
+       it != std::filesystem::recursive_directory_iterator(); ++it) {
+    const auto& entry = *it;
+    // Skipped as DirectoryScanner and FileWatcher skip them.
+    if (entry.path().filename().string().starts_with('.')) {
+      if (entry.is_directory()) {
+        it.disable_recursion_pending();
+      }
+      continue;
+    }
     if (!entry.is_regular_file()) {
       continue;
     }
 
-    FileRecord record;
-    record.absolute_path = entry.path();
-    record.relative_path =
-        std::filesystem::relative(entry.path(), root_path).generic_string();
-    record.filename = entry.path().filename().string();
-    record.extension = normalizeExtension(entry.path().extension().string());
-    record.file_size = entry.file_size();
-    std::error_code ec;
-    const auto ts = std::filesystem::last_write_time(entry.path(), ec);
-    if (ec) {
-      record.capture_ts = 0;
-    } else {
-      record.capture_ts = toUnixTimestamp(ts);
-    }
-    files.push_back(std::move(record));
+    files.push_back(describeFile(root_path, entry.path()));
   }
   return files;
 }
 
+FileRecord CatalogService::describeFile(const std::filesystem::path& root_path,
+                                        const std::filesystem::path& file) {
+  FileRecord record;
+  record.absolute_path = file;
+  record.relative_path = std::filesystem::relative(file, root_path).generic_string();
+  record.filename = file.filename().string();
+  record.extension = normalizeExtension(file.extension().string());
+  std::error_code ec;
+  record.file_size = std::filesystem::file_size(file, ec);
+  if (ec) {
+    record.file_size = 0;
+  }
+  const auto ts = std::filesystem::last_write_time(file, ec);
+  if (ec) {
+    record.capture_ts = 0;
+  } else {
+    record.capture_ts = toUnixTimestamp(ts);
+    record.mtime_ticks = static_cast<std::int64_t>(ts.time_since_epoch().count());
+  }
+  return record;
+}
+
 void CatalogService::ingestRecords(int root_id, const std::vector<FileRecord>& files) {
   if (files.empty()) {
     return;
@@ -242,8 +444,8 @@ void CatalogService::ingestRecords(int root_id, const std::vector<FileRecord>& f
 
   Statement insert(db_,
                    "INSERT INTO files (root_id, relative_path, filename, extension, "
-                   "capture_ts, file_size) "
-                   "VALUES (?, ?, ?, ?, ?, ?);");
+                   "capture_ts, file_size, content_hash, mtime_ticks) "
+                   "VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
 
   std::unordered_map<std::string, StackAccumulator> accumulators;
 
@@ -256,6 +458,12 @@ void CatalogService::ingestRecords(int root_id, const std::vector<FileRecord>& f
     sqlite3_bind_text(insert.get(), 4, record.extension.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int64(insert.get(), 5, record.capture_ts);
     sqlite3_bind_int64(insert.get(), 6, static_cast<std::int64_t>(record.file_size));
+    if (record.content_hash.has_value()) {
+      sqlite3_bind_int64(insert.get(), 7, static_cast<std::int64_t>(*record.content_hash));
+    } else {
+      sqlite3_bind_null(insert.get(), 7);
+    }
+    sqlite3_bind_int64(insert.get(), 8, record.mtime_ticks);
 
     if (sqlite3_step(insert.get()) != SQLITE_DONE) {
       exec(db_, "ROLLBACK;");
@@ -270,34 +478,11 @@ void CatalogService::ingestRecords(int root_id, const std::vector<FileRecord>& f
     bucket.has_raw = bucket.has_raw || classification == ExtensionClass::kRaw;
   }
 
-  Statement insert_stack(
-      db_, "INSERT INTO stacks(type, anchor_file_id) VALUES(?, ?);");
-  Statement update_file(db_, "UPDATE files SET stack_group_id=? WHERE id=?;");
-
-  for (auto& [_, bucket] : accumulators) {
-    if (bucket.file_ids.size() < 2) {
-      continue;
-    }
-
-    insert_stack.reset();
-    const auto type = stackType(bucket);
-    sqlite3_bind_text(insert_stack.get(), 1, type.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int64(insert_stack.get(), 2, bucket.file_ids.front());
-    if (sqlite3_step(insert_stack.get()) != SQLITE_DONE) {
-      exec(db_, "ROLLBACK;");
-      throw std::runtime_error(sqlite3_errmsg(db_));
-    }
-    const auto stack_id = sqlite3_last_insert_rowid(db_);
-
-    for (const auto file_id : bucket.file_ids) {
-      update_file.reset();
-      sqlite3_bind_int64(update_file.get(), 1, stack_id);
-      sqlite3_bind_int64(update_file.get(), 2, file_id);
-      if (sqlite3_step(update_file.get()) != SQLITE_DONE) {
-        exec(db_, "ROLLBACK;");
-        throw std::runtime_error(sqlite3_errmsg(db_));
-      }
-    }
+  try {
+    insertStacks(db_, accumulators);
+  } catch (...) {
+    exec(db_, "ROLLBACK;");
+    throw;
   }
 
   exec(db_, "COMMIT;");
@@ -307,8 +492,8 @@ std::vector<StoredFile> CatalogService::listFiles(int root_id) const {
   std::scoped_lock lock(db_mutex_);
   ensureOpen();
   Statement stmt(db_,
-                 "SELECT id, relative_path, extension, stack_group_id, preview_state "
-                 "FROM files WHERE root_id=? ORDER BY id ASC;");
+                 "SELECT id, relative_path, extension, stack_group_id, preview_state, "
+                 "content_hash FROM files WHERE root_id=? ORDER BY id ASC;");
   sqlite3_bind_int(stmt.get(), 1, root_id);
 
   std::vector<StoredFile> rows;
@@ -323,11 +508,28 @@ std::vector<StoredFile> CatalogService::listFiles(int root_id) const {
       file.stack_group_id = sqlite3_column_int64(stmt.get(), 3);
     }
     file.preview_state = sqlite3_column_int(stmt.get(), 4);
+    if (sqlite3_column_type(stmt.get(), 5) != SQLITE_NULL) {
+      file.content_hash = static_cast<std::uint64_t>(sqlite3_column_int64(stmt.get(), 5));
+    }
     rows.push_back(std::move(file));
   }
   return rows;
 }
 
+tasks::Task<std::vector<FileRecord>> CatalogService::scanRootAsync(
+    std::filesystem::path root_path,
+    tasks::Executor& executor) const {
+  co_await tasks::ResumeOn(executor);
+  co_return scanRoot(root_path);
+}
+
+tasks::Task<std::vector<StoredFile>> CatalogService::listFilesAsync(
+    int root_id,
+    tasks::Executor& executor) const {
+  co_await tasks::ResumeOn(executor);
+  co_return listFiles(root_id);
+}
+
 void CatalogService::enqueueSyncEvent(int root_id,
                                       std::string relative_path,
                                       std::string event_type,
@@ -348,6 +550,32 @@ void CatalogService::enqueueSyncEvent(int root_id,
   }
 }
 
+void CatalogService::enqueueSyncEvents(const std::vector<SyncEvent>& events) {
+  if (events.empty()) {
+    return;
+  }
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  exec(db_, "BEGIN IMMEDIATE TRANSACTION;");
+  Statement insert(db_,
+                   "INSERT INTO sync_queue(root_id, relative_path, event_type, payload, "
+                   "created_at) VALUES(?, ?, ?, ?, ?);");
+  const auto now = unixTimestampNow();
+  for (const auto& event : events) {
+    insert.reset();
+    sqlite3_bind_int(insert.get(), 1, event.root_id);
+    sqlite3_bind_text(insert.get(), 2, event.relative_path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(insert.get(), 3, event.event_type.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(insert.get(), 4, event.payload.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(insert.get(), 5, now);
+    if (sqlite3_step(insert.get()) != SQLITE_DONE) {
+      exec(db_, "ROLLBACK;");
+      throw std::runtime_error(sqlite3_errmsg(db_));
+    }
+  }
+  exec(db_, "COMMIT;");
+}
+
 std::vector<SyncEvent> CatalogService::pendingSyncEvents() const {
   std::scoped_lock lock(db_mutex_);
   ensureOpen();
@@ -357,20 +585,7 @@ std::vector<SyncEvent> CatalogService::pendingSyncEvents() const {
 
   std::vector<SyncEvent> events;
   while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
-    SyncEvent event;
-    event.id = sqlite3_column_int64(stmt.get(), 0);
-    event.root_id = sqlite3_column_int(stmt.get(), 1);
-    event.relative_path =
-        reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 2));
-    event.event_type =
-        reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 3));
-    if (sqlite3_column_type(stmt.get(), 4) != SQLITE_NULL) {
-      event.payload =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 4));
-    }
-    event.processed = sqlite3_column_int(stmt.get(), 5) != 0;
-    event.created_at = sqlite3_column_int64(stmt.get(), 6);
-    events.push_back(std::move(event));
+    events.push_back(readSyncEvent(stmt.get()));
   }
   return events;
 }
@@ -385,6 +600,248 @@ void CatalogService::markSyncEventProcessed(std::int64_t event_id) {
   }
 }
 
+std::vector<SyncEvent> CatalogService::claimSyncEvents(int root_id, std::size_t limit) {
+  std::vector<SyncEvent> events;
+  if (limit == 0) {
+    return events;
+  }
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  exec(db_, "BEGIN IMMEDIATE TRANSACTION;");
+  try {
+    Statement select(db_,
+                     "SELECT id, root_id, relative_path, event_type, payload, processed_flag, "
+                     "created_at FROM sync_queue WHERE processed_flag=? AND root_id=? "
+                     "AND event_type IN (?, ?, ?) ORDER BY id ASC LIMIT ?;");
+    sqlite3_bind_int(select.get(), 1, kSyncPending);
+    sqlite3_bind_int(select.get(), 2, root_id);
+    sqlite3_bind_text(select.get(), 3, kSyncChanged, -1, SQLITE_STATIC);
+    sqlite3_bind_text(select.get(), 4, kSyncRemoved, -1, SQLITE_STATIC);
+    sqlite3_bind_text(select.get(), 5, kSyncRescan, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(select.get(), 6, static_cast<std::int64_t>(limit));
+    while (sqlite3_step(select.get()) == SQLITE_ROW) {
+      events.push_back(readSyncEvent(select.get()));
+    }
+
+    Statement claim(db_, "UPDATE sync_queue SET processed_flag=? WHERE id=?;");
+    for (const auto& event : events) {
+      claim.reset();
+      sqlite3_bind_int(claim.get(), 1, kSyncClaimed);
+      sqlite3_bind_int64(claim.get(), 2, event.id);
+      if (sqlite3_step(claim.get()) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db_));
+      }
+    }
+  } catch (...) {
+    exec(db_, "ROLLBACK;");
+    throw;
+  }
+  exec(db_, "COMMIT;");
+  return events;
+}
+
+std::size_t CatalogService::releaseSyncEvents(int root_id) {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  Statement stmt(db_,
+                 "UPDATE sync_queue SET processed_flag=? WHERE processed_flag=? AND root_id=?;");
+  sqlite3_bind_int(stmt.get(), 1, kSyncPending);
+  sqlite3_bind_int(stmt.get(), 2, kSyncClaimed);
+  sqlite3_bind_int(stmt.get(), 3, root_id);
+  if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+    throw std::runtime_error(sqlite3_errmsg(db_));
+  }
+  return static_cast<std::size_t>(sqlite3_changes(db_));
+}
+
+std::vector<FileStamp> CatalogService::fileStamps(
+    int root_id,
+    const std::vector<std::string>& relative_paths,
+    const std::vector<std::string>& folders) const {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  Statement at(db_,
+               "SELECT relative_path, file_size, mtime_ticks FROM files "
+               "WHERE root_id=? AND relative_path=?;");
+  Statement below(db_,
+                  "SELECT relative_path, file_size, mtime_ticks FROM files "
+                  "WHERE root_id=? AND relative_path>=? AND relative_path<?;");
+  Statement everything(db_,
+                       "SELECT relative_path, file_size, mtime_ticks FROM files "
+                       "WHERE root_id=?;");
+
+  std::vector<FileStamp> stamps;
+  const auto collect = [&](sqlite3_stmt* stmt) {
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      FileStamp stamp;
+      stamp.relative_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+      stamp.file_size = static_cast<std::uintmax_t>(sqlite3_column_int64(stmt, 1));
+      if (sqlite3_column_type(stmt, 2) != SQLITE_NULL) {
+        stamp.mtime_ticks = sqlite3_column_int64(stmt, 2);
+      }
+      stamps.push_back(std::move(stamp));
+    }
+  };
+  for (const auto& relative_path : relative_paths) {
+    at.reset();
+    sqlite3_bind_int(at.get(), 1, root_id);
+    sqlite3_bind_text(at.get(), 2, relative_path.c_str(), -1, SQLITE_TRANSIENT);
+    collect(at.get());
+  }
+  for (const auto& folder : folders) {
+    if (folder.empty()) {
+      everything.reset();
+      sqlite3_bind_int(everything.get(), 1, root_id);
+      collect(everything.get());
+      continue;
+    }
+    const auto low = folder + "/";
+    const auto high = folder + "0";
+    below.reset();
+    sqlite3_bind_int(below.get(), 1, root_id);
+    sqlite3_bind_text(below.get(), 2, low.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(below.get(), 3, high.c_str(), -1, SQLITE_TRANSIENT);
+    collect(below.get());
+  }
+  return stamps;
+}
+
+std::vector<std::string> CatalogService::applySyncBatch(
+    int root_id,
+    const std::vector<FileRecord>& upserts,
+    const std::vector<std::string>& removals,
+    const std::vector<std::int64_t>& event_ids) {
+  std::vector<std::string> removed;
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  exec(db_, "BEGIN IMMEDIATE TRANSACTION;");
+  try {
+    std::unordered_set<std::string> touched_basenames;
+
+    // Removals first, collected before anything is deleted; a folder and a
+    // file inside it may both be listed.
+    Statement subtree(db_,
+                      "SELECT id, relative_path, filename, stack_group_id FROM files "
+                      "WHERE root_id=? AND (relative_path=? OR "
+                      "(relative_path>=? AND relative_path<?));");
+    Statement everything(db_,
+                         "SELECT id, relative_path, filename, stack_group_id FROM files "
+                         "WHERE root_id=?;");
+    std::map<std::int64_t, std::string> doomed;
+    std::set<std::int64_t> doomed_stacks;
+    const auto collect = [&](sqlite3_stmt* stmt) {
+      while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const auto id = sqlite3_column_int64(stmt, 0);
+        doomed.emplace(id, reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
+        touched_basenames.insert(
+            baseName(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2))));
+        if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
+          doomed_stacks.insert(sqlite3_column_int64(stmt, 3));
+        }
+      }
+    };
+    for (const auto& relative_path : removals) {
+      if (relative_path.empty()) {
+        everything.reset();
+        sqlite3_bind_int(everything.get(), 1, root_id);
+        collect(everything.get());
+        continue;
+      }
+      subtree.reset();
+      sqlite3_bind_int(subtree.get(), 1, root_id);
+      bindSubtree(subtree.get(), 2, relative_path);
+      collect(subtree.get());
+    }
+
+    // Whatever is left of a stack that lost a member is restacked below.
+    Statement clear_stack(db_, "UPDATE files SET stack_group_id=NULL WHERE stack_group_id=?;");
+    Statement drop_stack(db_, "DELETE FROM stacks WHERE stack_group_id=?;");
+    for (const auto stack_id : doomed_stacks) {
+      clear_stack.reset();
+      sqlite3_bind_int64(clear_stack.get(), 1, stack_id);
+      drop_stack.reset();
+      sqlite3_bind_int64(drop_stack.get(), 1, stack_id);
+      if (sqlite3_step(clear_stack.get()) != SQLITE_DONE ||
+          sqlite3_step(drop_stack.get()) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db_));
+      }
+    }
+    Statement drop_blob(db_, "DELETE FROM metadata_blobs WHERE file_id=?;");
+    Statement drop_file(db_, "DELETE FROM files WHERE id=?;");
+    removed.reserve(doomed.size());
+    for (auto& [file_id, relative_path] : doomed) {
+      drop_blob.reset();
+      sqlite3_bind_int64(drop_blob.get(), 1, file_id);
+      drop_file.reset();
+      sqlite3_bind_int64(drop_file.get(), 1, file_id);
+      if (sqlite3_step(drop_blob.get()) != SQLITE_DONE ||
+          sqlite3_step(drop_file.get()) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db_));
+      }
+      removed.push_back(std::move(relative_path));
+    }
+
+    // New contents: the old hash and previews no longer describe the file.
+    Statement find(db_, "SELECT id FROM files WHERE root_id=? AND relative_path=?;");
+    Statement update(db_,
+                     "UPDATE files SET capture_ts=?, file_size=?, mtime_ticks=?, "
+                     "content_hash=NULL, preview_state=0 WHERE id=?;");
+    Statement insert(db_,
+                     "INSERT INTO files (root_id, relative_path, filename, extension, "
+                     "capture_ts, file_size, content_hash, mtime_ticks) "
+                     "VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+    for (const auto& record : upserts) {
+      find.reset();
+      sqlite3_bind_int(find.get(), 1, root_id);
+      sqlite3_bind_text(find.get(), 2, record.relative_path.c_str(), -1, SQLITE_TRANSIENT);
+      if (sqlite3_step(find.get()) == SQLITE_ROW) {
+        update.reset();
+        sqlite3_bind_int64(update.get(), 1, record.capture_ts);
+        sqlite3_bind_int64(update.get(), 2, static_cast<std::int64_t>(record.file_size));
+        sqlite3_bind_int64(update.get(), 3, record.mtime_ticks);
+        sqlite3_bind_int64(update.get(), 4, sqlite3_column_int64(find.get(), 0));
+        if (sqlite3_step(update.get()) != SQLITE_DONE) {
+          throw std::runtime_error(sqlite3_errmsg(db_));
+        }
+        continue;
+      }
+      insert.reset();
+      sqlite3_bind_int(insert.get(), 1, root_id);
+      sqlite3_bind_text(insert.get(), 2, record.relative_path.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_text(insert.get(), 3, record.filename.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_text(insert.get(), 4, record.extension.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_int64(insert.get(), 5, record.capture_ts);
+      sqlite3_bind_int64(insert.get(), 6, static_cast<std::int64_t>(record.file_size));
+      if (record.content_hash.has_value()) {
+        sqlite3_bind_int64(insert.get(), 7, static_cast<std::int64_t>(*record.content_hash));
+      } else {
+        sqlite3_bind_null(insert.get(), 7);
+      }
+      sqlite3_bind_int64(insert.get(), 8, record.mtime_ticks);
+      if (sqlite3_step(insert.get()) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db_));
+      }
+      touched_basenames.insert(baseName(record.filename));
+    }
+    restackBasenames(db_, root_id, touched_basenames);
+
+    Statement mark(db_, "UPDATE sync_queue SET processed_flag=? WHERE id=?;");
+    for (const auto event_id : event_ids) {
+      mark.reset();
+      sqlite3_bind_int(mark.get(), 1, kSyncProcessed);
+      sqlite3_bind_int64(mark.get(), 2, event_id);
+      if (sqlite3_step(mark.get()) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db_));
+      }
+    }
+  } catch (...) {
+    exec(db_, "ROLLBACK;");
+    throw;
+  }
+  exec(db_, "COMMIT;");
+  return removed;
+}
+
 void CatalogService::updatePreviewState(std::int64_t file_id, int preview_state) {
   std::scoped_lock lock(db_mutex_);
   ensureOpen();
@@ -396,6 +853,369 @@ void CatalogService::updatePreviewState(std::int64_t file_id, int preview_state)
   }
 }
 
+void CatalogService::updateContentHash(std::int64_t file_id, std::uint64_t content_hash) {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  Statement stmt(db_, "UPDATE files SET content_hash=? WHERE id=?;");
+  sqlite3_bind_int64(stmt.get(), 1, static_cast<std::int64_t>(content_hash));
+  sqlite3_bind_int64(stmt.get(), 2, file_id);
+  if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+    throw std::runtime_error(sqlite3_errmsg(db_));
+  }
+}
+
+std::int64_t CatalogService::createIngestJob(const std::string& destination_root,
+                                             const std::string& mirror_root,
+                                             const std::vector<IngestJobFile>& files) {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  exec(db_, "BEGIN IMMEDIATE TRANSACTION;");
+
+  Statement insert_job(db_,
+                       "INSERT INTO ingest_jobs(destination_root, mirror_root, created_at) "
+                       "VALUES(?, ?, ?);");
+  sqlite3_bind_text(insert_job.get(), 1, destination_root.c_str(), -1, SQLITE_TRANSIENT);
+  if (mirror_root.empty()) {
+    sqlite3_bind_null(insert_job.get(), 2);
+  } else {
+    sqlite3_bind_text(insert_job.get(), 2, mirror_root.c_str(), -1, SQLITE_TRANSIENT);
+  }
+  sqlite3_bind_int64(insert_job.get(), 3, unixTimestampNow());
+  if (sqlite3_step(insert_job.get()) != SQLITE_DONE) {
+    exec(db_, "ROLLBACK;");
+    throw std::runtime_error(sqlite3_errmsg(db_));
+  }
+  const auto job_id = sqlite3_last_insert_rowid(db_);
+
+  Statement insert_file(db_,
+                        "INSERT INTO ingest_job_files(job_id, seq, source, destination, mirror, "
+                        "file_size, capture_ticks, state) VALUES(?, ?, ?, ?, ?, ?, ?, ?);");
+  for (const auto& file : files) {
+    insert_file.reset();
+    sqlite3_bind_int64(insert_file.get(), 1, job_id);
+    sqlite3_bind_int64(insert_file.get(), 2, file.seq);
+    sqlite3_bind_text(insert_file.get(), 3, file.source.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(insert_file.get(), 4, file.destination.c_str(), -1, SQLITE_TRANSIENT);
+    if (file.mirror.empty()) {
+      sqlite3_bind_null(insert_file.get(), 5);
+    } else {
+      sqlite3_bind_text(insert_file.get(), 5, file.mirror.c_str(), -1, SQLITE_TRANSIENT);
+    }
+    sqlite3_bind_int64(insert_file.get(), 6, static_cast<std::int64_t>(file.file_size));
+    sqlite3_bind_int64(insert_file.get(), 7, file.capture_ticks);
+    sqlite3_bind_int(insert_file.get(), 8, static_cast<int>(file.state));
+    if (sqlite3_step(insert_file.get()) != SQLITE_DONE) {
+      exec(db_, "ROLLBACK;");
+      throw std::runtime_error(sqlite3_errmsg(db_));
+    }
+  }
+
+  exec(db_, "COMMIT;");
+  return job_id;
+}
+
+std::vector<IngestJobRecord> CatalogService::unfinishedIngestJobs() const {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  Statement stmt(db_,
+                 "SELECT id, destination_root, mirror_root, finished, created_at "
+                 "FROM ingest_jobs WHERE finished=0 ORDER BY id ASC;");
+  std::vector<IngestJobRecord> jobs;
+  while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+    IngestJobRecord job;
+    job.id = sqlite3_column_int64(stmt.get(), 0);
+    job.destination_root =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 1));
+    if (sqlite3_column_type(stmt.get(), 2) != SQLITE_NULL) {
+      job.mirror_root = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 2));
+    }
+    job.finished = sqlite3_column_int(stmt.get(), 3) != 0;
+    job.created_at = sqlite3_column_int64(stmt.get(), 4);
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+std::optional<IngestJobRecord> CatalogService::loadIngestJob(std::int64_t job_id) const {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  Statement stmt(db_,
+                 "SELECT id, destination_root, mirror_root, finished, created_at "
+                 "FROM ingest_jobs WHERE id=?;");
+  sqlite3_bind_int64(stmt.get(), 1, job_id);
+  if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+    return std::nullopt;
+  }
+  IngestJobRecord job;
+  job.id = sqlite3_column_int64(stmt.get(), 0);
+  job.destination_root = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 1));
+  if (sqlite3_column_type(stmt.get(), 2) != SQLITE_NULL) {
+    job.mirror_root = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 2));
+  }
+  job.finished = sqlite3_column_int(stmt.get(), 3) != 0;
+  job.created_at = sqlite3_column_int64(stmt.get(), 4);
+  return job;
+}
+
+std::vector<IngestJobFile> CatalogService::loadIngestJobFiles(std::int64_t job_id) const {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  Statement stmt(db_,
+                 "SELECT seq, source, destination, mirror, file_size, capture_ticks, state, "
+                 "content_hash, error FROM ingest_job_files WHERE job_id=? ORDER BY seq ASC;");
+  sqlite3_bind_int64(stmt.get(), 1, job_id);
+  std::vector<IngestJobFile> files;
+  while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+    IngestJobFile file;
+    file.seq = sqlite3_column_int64(stmt.get(), 0);
+    file.source = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 1));
+    file.destination = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 2));
+    if (sqlite3_column_type(stmt.get(), 3) != SQLITE_NULL) {
+      file.mirror = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 3));
+    }
+    file.file_size = static_cast<std::uint64_t>(sqlite3_column_int64(stmt.get(), 4));
+    file.capture_ticks = sqlite3_column_int64(stmt.get(), 5);
+    file.state = static_cast<IngestFileState>(sqlite3_column_int(stmt.get(), 6));
+    if (sqlite3_column_type(stmt.get(), 7) != SQLITE_NULL) {
+      file.content_hash = static_cast<std::uint64_t>(sqlite3_column_int64(stmt.get(), 7));
+    }
+    if (sqlite3_column_type(stmt.get(), 8) != SQLITE_NULL) {
+      file.error = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 8));
+    }
+    files.push_back(std::move(file));
+  }
+  return files;
+}
+
+void CatalogService::updateIngestFiles(std::int64_t job_id,
+                                       const std::vector<IngestFileUpdate>& updates) {
+  if (updates.empty()) {
+    return;
+  }
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  exec(db_, "BEGIN IMMEDIATE TRANSACTION;");
+  // A missing hash keeps the one already stored.
+  Statement update(db_,
+                   "UPDATE ingest_job_files SET state=?, "
+                   "content_hash=COALESCE(?, content_hash), error=? "
+                   "WHERE job_id=? AND seq=?;");
+  for (const auto& change : updates) {
+    update.reset();
+    sqlite3_bind_int(update.get(), 1, static_cast<int>(change.state));
+    if (change.content_hash.has_value()) {
+      sqlite3_bind_int64(update.get(), 2, static_cast<std::int64_t>(*change.content_hash));
+    } else {
+      sqlite3_bind_null(update.get(), 2);
+    }
+    if (change.error.empty()) {
+      sqlite3_bind_null(update.get(), 3);
+    } else {
+      sqlite3_bind_text(update.get(), 3, change.error.c_str(), -1, SQLITE_TRANSIENT);
+    }
+    sqlite3_bind_int64(update.get(), 4, job_id);
+    sqlite3_bind_int64(update.get(), 5, change.seq);
+    if (sqlite3_step(update.get()) != SQLITE_DONE) {
+      exec(db_, "ROLLBACK;");
+      throw std::runtime_error(sqlite3_errmsg(db_));
+    }
+  }
+  exec(db_, "COMMIT;");
+}
+
+void CatalogService::finishIngestJob(std::int64_t job_id) {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  Statement stmt(db_, "UPDATE ingest_jobs SET finished=1, finished_at=? WHERE id=?;");
+  sqlite3_bind_int64(stmt.get(), 1, unixTimestampNow());
+  sqlite3_bind_int64(stmt.get(), 2, job_id);
+  if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+    throw std::runtime_error(sqlite3_errmsg(db_));
+  }
+}
+
+std::vector<std::int64_t> CatalogService::catalogIngestedFiles(
+    std::int64_t job_id,
+    int root_id,
+    const std::vector<std::pair<std::int64_t, FileRecord>>& files) {
+  std::vector<std::int64_t> file_ids;
+  if (files.empty()) {
+    return file_ids;
+  }
+  file_ids.reserve(files.size());
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  exec(db_, "BEGIN IMMEDIATE TRANSACTION;");
+  try {
+    Statement find(db_, "SELECT id FROM files WHERE root_id=? AND relative_path=?;");
+    Statement update(db_,
+                     "UPDATE files SET capture_ts=?, file_size=?, "
+                     "content_hash=COALESCE(?, content_hash), mtime_ticks=? WHERE id=?;");
+    Statement insert(db_,
+                     "INSERT INTO files (root_id, relative_path, filename, extension, "
+                     "capture_ts, file_size, content_hash, mtime_ticks) "
+                     "VALUES (?, ?, ?, ?, ?, ?, ?, ?);");
+    Statement mark(db_,
+                   "UPDATE ingest_job_files SET state=?, error=NULL WHERE job_id=? AND seq=?;");
+    const auto bindHash = [](sqlite3_stmt* stmt, int index, const FileRecord& record) {
+      if (record.content_hash.has_value()) {
+        sqlite3_bind_int64(stmt, index, static_cast<std::int64_t>(*record.content_hash));
+      } else {
+        sqlite3_bind_null(stmt, index);
+      }
+    };
+
+    std::unordered_set<std::string> added_basenames;
+    for (const auto& [seq, record] : files) {
+      find.reset();
+      sqlite3_bind_int(find.get(), 1, root_id);
+      sqlite3_bind_text(find.get(), 2, record.relative_path.c_str(), -1, SQLITE_TRANSIENT);
+      if (sqlite3_step(find.get()) == SQLITE_ROW) {
+        const auto file_id = sqlite3_column_int64(find.get(), 0);
+        file_ids.push_back(file_id);
+        update.reset();
+        sqlite3_bind_int64(update.get(), 1, record.capture_ts);
+        sqlite3_bind_int64(update.get(), 2, static_cast<std::int64_t>(record.file_size));
+        bindHash(update.get(), 3, record);
+        sqlite3_bind_int64(update.get(), 4, record.mtime_ticks);
+        sqlite3_bind_int64(update.get(), 5, file_id);
+        if (sqlite3_step(update.get()) != SQLITE_DONE) {
+          throw std::runtime_error(sqlite3_errmsg(db_));
+        }
+      } else {
+        insert.reset();
+        sqlite3_bind_int(insert.get(), 1, root_id);
+        sqlite3_bind_text(insert.get(), 2, record.relative_path.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insert.get(), 3, record.filename.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insert.get(), 4, record.extension.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(insert.get(), 5, record.capture_ts);
+        sqlite3_bind_int64(insert.get(), 6, static_cast<std::int64_t>(record.file_size));
+        bindHash(insert.get(), 7, record);
+        sqlite3_bind_int64(insert.get(), 8, record.mtime_ticks);
+        if (sqlite3_step(insert.get()) != SQLITE_DONE) {
+          throw std::runtime_error(sqlite3_errmsg(db_));
+        }
+        file_ids.push_back(sqlite3_last_insert_rowid(db_));
+        added_basenames.insert(baseName(record.filename));
+      }
+
+      mark.reset();
+      sqlite3_bind_int(mark.get(), 1, static_cast<int>(IngestFileState::kCataloged));
+      sqlite3_bind_int64(mark.get(), 2, job_id);
+      sqlite3_bind_int64(mark.get(), 3, seq);
+      if (sqlite3_step(mark.get()) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db_));
+      }
+    }
+    // A RAW and its JPEG may arrive in different batches.
+    restackBasenames(db_, root_id, added_basenames);
+  } catch (...) {
+    exec(db_, "ROLLBACK;");
+    throw;
+  }
+  exec(db_, "COMMIT;");
+  return file_ids;
+}
+
+void CatalogService::storeIccDiscoveries(
+    const std::vector<std::pair<IccDiscoveryRecord, const std::vector<std::uint8_t>*>>&
+        discoveries) {
+  if (discoveries.empty()) {
+    return;
+  }
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  exec(db_, "BEGIN IMMEDIATE TRANSACTION;");
+  try {
+    Statement insert_profile(db_,
+                             "INSERT INTO icc_profiles(profile_hash, data, created_at) "
+                             "VALUES(?, ?, ?) ON CONFLICT(profile_hash) DO NOTHING;");
+    Statement upsert(db_,
+                     "INSERT INTO icc_discovery(absolute_path, file_size, mtime, source, "
+                     "profile_hash) VALUES(?, ?, ?, ?, ?) "
+                     "ON CONFLICT(absolute_path) DO UPDATE SET file_size=excluded.file_size, "
+                     "mtime=excluded.mtime, source=excluded.source, "
+                     "profile_hash=excluded.profile_hash;");
+    const auto now = unixTimestampNow();
+    for (const auto& [record, profile_bytes] : discoveries) {
+      if (record.profile_hash.has_value() && profile_bytes && !profile_bytes->empty()) {
+        insert_profile.reset();
+        sqlite3_bind_int64(insert_profile.get(), 1,
+                           static_cast<std::int64_t>(*record.profile_hash));
+        sqlite3_bind_blob(insert_profile.get(), 2, profile_bytes->data(),
+                          static_cast<int>(profile_bytes->size()), SQLITE_TRANSIENT);
+        sqlite3_bind_int64(insert_profile.get(), 3, now);
+        if (sqlite3_step(insert_profile.get()) != SQLITE_DONE) {
+          throw std::runtime_error(sqlite3_errmsg(db_));
+        }
+      }
+
+      upsert.reset();
+      sqlite3_bind_text(upsert.get(), 1, record.absolute_path.c_str(), -1,
+                        SQLITE_TRANSIENT);
+      sqlite3_bind_int64(upsert.get(), 2, static_cast<std::int64_t>(record.file_size));
+      sqlite3_bind_int64(upsert.get(), 3, record.mtime);
+      sqlite3_bind_int(upsert.get(), 4, record.source);
+      if (record.profile_hash.has_value()) {
+        sqlite3_bind_int64(upsert.get(), 5,
+                           static_cast<std::int64_t>(*record.profile_hash));
+      } else {
+        sqlite3_bind_null(upsert.get(), 5);
+      }
+      if (sqlite3_step(upsert.get()) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db_));
+      }
+    }
+  } catch (...) {
+    exec(db_, "ROLLBACK;");
+    throw;
+  }
+  exec(db_, "COMMIT;");
+}
+
+std::vector<IccDiscoveryRecord> CatalogService::loadIccDiscoveries() const {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  Statement stmt(db_,
+                 "SELECT absolute_path, file_size, mtime, source, profile_hash "
+                 "FROM icc_discovery;");
+
+  std::vector<IccDiscoveryRecord> records;
+  while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+    IccDiscoveryRecord record;
+    record.absolute_path =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 0));
+    record.file_size =
+        static_cast<std::uintmax_t>(sqlite3_column_int64(stmt.get(), 1));
+    record.mtime = sqlite3_column_int64(stmt.get(), 2);
+    record.source = sqlite3_column_int(stmt.get(), 3);
+    if (sqlite3_column_type(stmt.get(), 4) != SQLITE_NULL) {
+      record.profile_hash =
+          static_cast<std::uint64_t>(sqlite3_column_int64(stmt.get(), 4));
+    }
+    records.push_back(std::move(record));
+  }
+  return records;
+}
+
+std::optional<std::vector<std::uint8_t>> CatalogService::loadIccProfile(
+    std::uint64_t profile_hash) const {
+  std::scoped_lock lock(db_mutex_);
+  ensureOpen();
+  Statement stmt(db_, "SELECT data FROM icc_profiles WHERE profile_hash=?;");
+  sqlite3_bind_int64(stmt.get(), 1, static_cast<std::int64_t>(profile_hash));
+  if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+    return std::nullopt;
+  }
+  const auto* data =
+      static_cast<const std::uint8_t*>(sqlite3_column_blob(stmt.get(), 0));
+  const auto size = static_cast<std::size_t>(sqlite3_column_bytes(stmt.get(), 0));
+  if (!data || size == 0) {
+    return std::nullopt;
+  }
+  return std::vector<std::uint8_t>(data, data + size);
+}
+
 void CatalogService::open() {
   if (db_) {
     return;
@@ -430,6 +1250,16 @@ void CatalogService::applySchema(const std::string& sql) const {
   exec(db_, sql);
 }
 
+void CatalogService::migrateSchema() const {
+  for (const auto& added : kAddedColumns) {
+    if (!hasColumn(db_, added.table, added.column)) {
+      exec(db_, std::string("ALTER TABLE ") + added.table + " ADD COLUMN " + added.column + " " +
+                    added.definition + ";");
+    }
+  }
+  exec(db_, std::string(kPostMigrationSql));
+}
+
 std::int64_t CatalogService::unixTimestampNow() {
   const auto now = std::chrono::system_clock::now();
   return std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch())
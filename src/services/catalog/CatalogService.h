@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "services/tasks/Task.h"
+
 struct sqlite3;
 
 namespace cataloger::services::catalog {
@@ -18,6 +22,9 @@ struct FileRecord {
   std::string extension;
   std::uintmax_t file_size{};
   std::int64_t capture_ts{};
+  std::int64_t mtime_ticks{};  // file_time_type ticks
+  // XXH64 of the file's bytes, when ingest hashed it on the way in.
+  std::optional<std::uint64_t> content_hash;
 };
 
 struct StoredFile {
@@ -26,18 +33,77 @@ struct StoredFile {
   std::string extension;
   std::optional<std::int64_t> stack_group_id;
   int preview_state{};
+  std::optional<std::uint64_t> content_hash;
+};
+
+// What the catalog last recorded for a file, to compare against a stat.
+struct FileStamp {
+  std::string relative_path;
+  std::uintmax_t file_size{};
+  // Absent for rows cataloged before mtimes were kept; never a match.
+  std::optional<std::int64_t> mtime_ticks;
+};
+
+struct IccDiscoveryRecord {
+  std::string absolute_path;
+  std::uintmax_t file_size{};
+  std::int64_t mtime{};  // file_time_type ticks
+  int source{};
+  std::optional<std::uint64_t> profile_hash;
 };
 
 struct SyncEvent {
   std::int64_t id{};
   int root_id{};
   std::string relative_path;
-  std::string event_type;
+  std::string event_type;  // one of the kSync* types below, or app-defined
   std::string payload;
   bool processed{false};
   std::int64_t created_at{};
 };
 
+// Sync event types a SyncWatcher produces.
+inline constexpr const char* kSyncChanged = "changed";  // file added or modified
+inline constexpr const char* kSyncRemoved = "removed";  // file or folder, recursively
+inline constexpr const char* kSyncRescan = "rescan";    // compare one folder's entries
+
+// Where one file of a journaled ingest job has got to. Values are stored.
+enum class IngestFileState : int {
+  kPending = 0,
+  kCopying = 1,
+  kCopied = 2,
+  kVerified = 3,
+  kCataloged = 4,
+  kFailed = 5,
+};
+
+struct IngestJobRecord {
+  std::int64_t id{};
+  std::string destination_root;
+  std::string mirror_root;
+  bool finished{false};
+  std::int64_t created_at{};
+};
+
+struct IngestJobFile {
+  std::int64_t seq{};  // capture order within the job
+  std::string source;
+  std::string destination;
+  std::string mirror;
+  std::uint64_t file_size{};
+  std::int64_t capture_ticks{};  // file_time_type ticks
+  IngestFileState state{IngestFileState::kPending};
+  std::optional<std::uint64_t> content_hash;
+  std::string error;
+};
+
+struct IngestFileUpdate {
+  std::int64_t seq{};
+  IngestFileState state{IngestFileState::kPending};
+  std::optional<std::uint64_t> content_hash;
+  std::string error;
+};
+
 class CatalogService {
 public:
   CatalogService();
@@ -47,23 +113,92 @@ public:
   void initializeSchema();
 
   int registerRoot(const std::filesystem::path& root_path);
+  // Every regular file below `root_path`; hidden files and folders are skipped.
   std::vector<FileRecord> scanRoot(const std::filesystem::path& root_path) const;
+  // The record scanRoot() would produce for one file below `root_path`.
+  static FileRecord describeFile(const std::filesystem::path& root_path,
+                                 const std::filesystem::path& file);
   void ingestRecords(int root_id, const std::vector<FileRecord>& files);
   std::vector<StoredFile> listFiles(int root_id) const;
+  // Awaitable forms: the work runs on `executor` and the awaiting
+  // coroutine continues there.
+  tasks::Task<std::vector<FileRecord>> scanRootAsync(std::filesystem::path root_path,
+                                                     tasks::Executor& executor) const;
+  tasks::Task<std::vector<StoredFile>> listFilesAsync(int root_id,
+                                                      tasks::Executor& executor) const;
 
   void enqueueSyncEvent(int root_id,
                         std::string relative_path,
                         std::string event_type,
                         std::string payload);
+  // Appends `events` in one transaction; ids, flags and times are assigned.
+  void enqueueSyncEvents(const std::vector<SyncEvent>& events);
   std::vector<SyncEvent> pendingSyncEvents() const;
   void markSyncEventProcessed(std::int64_t event_id);
+
+  // Sync reconciliation. Claimed events are neither pending nor processed:
+  // they belong to the reconciler that claimed them until it applies them
+  // or they are released.
+  //
+  // Claims up to `limit` of the root's unprocessed kSync* events, oldest
+  // first. Other event types are left in the queue.
+  std::vector<SyncEvent> claimSyncEvents(int root_id, std::size_t limit);
+  // Puts the root's claimed but unapplied events back in the queue, e.g.
+  // after a reconciler failed or a session ended mid-batch.
+  std::size_t releaseSyncEvents(int root_id);
+  // Rows at `relative_paths`, plus every row below `folders` ("" is the
+  // whole root).
+  std::vector<FileStamp> fileStamps(int root_id,
+                                    const std::vector<std::string>& relative_paths,
+                                    const std::vector<std::string>& folders) const;
+  // Applies one reconciled batch in one transaction: `upserts` update the
+  // row at their path (clearing its content hash and preview state) or add
+  // one, each of `removals` deletes the row at that path and every row
+  // below it, stacks are rebuilt for the basenames that gained or lost a
+  // file, and `event_ids` are marked processed. Returns the relative paths
+  // of the rows removed.
+  std::vector<std::string> applySyncBatch(int root_id,
+                                          const std::vector<FileRecord>& upserts,
+                                          const std::vector<std::string>& removals,
+                                          const std::vector<std::int64_t>& event_ids);
   void updatePreviewState(std::int64_t file_id, int preview_state);
+  void updateContentHash(std::int64_t file_id, std::uint64_t content_hash);
+
+  // Ingest journal. A job and its planned files are written in one
+  // transaction; progress is applied in batches, each one transaction, so
+  // a restart sees every file at its last durable state.
+  std::int64_t createIngestJob(const std::string& destination_root,
+                               const std::string& mirror_root,
+                               const std::vector<IngestJobFile>& files);
+  std::vector<IngestJobRecord> unfinishedIngestJobs() const;
+  std::optional<IngestJobRecord> loadIngestJob(std::int64_t job_id) const;
+  std::vector<IngestJobFile> loadIngestJobFiles(std::int64_t job_id) const;
+  void updateIngestFiles(std::int64_t job_id, const std::vector<IngestFileUpdate>& updates);
+  void finishIngestJob(std::int64_t job_id);
+  // Adds copied files to `root_id` and marks their journal rows cataloged
+  // in the same transaction. Files already in the root are updated in
+  // place, so a resumed job can repeat a batch. Returns the file ids in
+  // the order given.
+  std::vector<std::int64_t> catalogIngestedFiles(
+      std::int64_t job_id,
+      int root_id,
+      const std::vector<std::pair<std::int64_t, FileRecord>>& files);
+
+  // Writes a batch of discoveries in one transaction. Profile bytes may be
+  // null; a profile already stored under its hash is kept.
+  void storeIccDiscoveries(
+      const std::vector<std::pair<IccDiscoveryRecord, const std::vector<std::uint8_t>*>>&
+          discoveries);
+  std::vector<IccDiscoveryRecord> loadIccDiscoveries() const;
+  std::optional<std::vector<std::uint8_t>> loadIccProfile(
+      std::uint64_t profile_hash) const;
 
 private:
   void open();
   void close();
   void ensureOpen() const;
   void applySchema(const std::string& sql) const;
+  void migrateSchema() const;
   static std::int64_t unixTimestampNow();
   static std::int64_t toUnixTimestamp(std::filesystem::file_time_type ts);
 
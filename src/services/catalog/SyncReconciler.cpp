@@ -0,0 +1,298 @@
+#include "SyncReconciler.h"
+
+#include <exception>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace cataloger::services::catalog {
+
+namespace {
+
+// True when `relative_path` lies below `folder` ("" is the root); `rest`
+// is then the part after it.
+bool below(const std::string& folder, const std::string& relative_path, std::string& rest) {
+  if (folder.empty()) {
+    rest = relative_path;
+    return true;
+  }
+  if (relative_path.size() <= folder.size() + 1 ||
+      relative_path.compare(0, folder.size(), folder) != 0 ||
+      relative_path[folder.size()] != '/') {
+    return false;
+  }
+  rest = relative_path.substr(folder.size() + 1);
+  return true;
+}
+
+std::string child(const std::string& folder, const std::string& name) {
+  return folder.empty() ? name : folder + "/" + name;
+}
+
+}  // namespace
+
+SyncReconciler::SyncReconciler(CatalogService& catalog,
+                               int root_id,
+                               std::filesystem::path root_path,
+                               Options options,
+                               tasks::TaskScheduler* scheduler)
+    : catalog_(catalog),
+      root_id_(root_id),
+      root_path_(std::move(root_path)),
+      options_(options),
+      scheduler_(scheduler) {
+  if (!scheduler_) {
+    tasks::TaskScheduler::Options pool;
+    pool.worker_count = 1;
+    pool.interactive_reserve = 0;
+    owned_scheduler_ = std::make_unique<tasks::TaskScheduler>(pool);
+    scheduler_ = owned_scheduler_.get();
+  }
+}
+
+SyncReconciler::~SyncReconciler() {
+  stop();
+}
+
+void SyncReconciler::setChangeSink(ChangeSink sink) {
+  on_change_ = std::move(sink);
+}
+
+void SyncReconciler::wake() {
+  std::lock_guard lock(mutex_);
+  if (stopping_) {
+    return;
+  }
+  if (scheduled_) {
+    again_ = true;
+    return;
+  }
+  scheduled_ = true;
+  task_ = scheduler_->submit(
+      tasks::Lane::kMaintenance, [this](std::stop_token) { run(); }, {.name = "sync-reconcile"});
+}
+
+void SyncReconciler::waitIdle() const {
+  std::unique_lock lock(mutex_);
+  idle_cv_.wait(lock, [&] { return !scheduled_; });
+}
+
+void SyncReconciler::stop() {
+  tasks::TaskHandle task;
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+    task = task_;
+  }
+  if (task.valid()) {
+    task.cancel();  // drops it if it has not started
+    task.wait();
+  }
+  std::lock_guard lock(mutex_);
+  scheduled_ = false;
+  idle_cv_.notify_all();
+}
+
+std::size_t SyncReconciler::drain() {
+  {
+    std::scoped_lock batch(batch_mutex_);
+    catalog_.releaseSyncEvents(root_id_);
+  }
+  std::size_t applied = 0;
+  for (;;) {
+    const auto outcome = reconcileBatch();
+    applied += outcome.events;
+    if (outcome.events < options_.batch_size) {
+      return applied;
+    }
+  }
+}
+
+void SyncReconciler::run() {
+  for (;;) {
+    {
+      std::lock_guard lock(mutex_);
+      again_ = false;
+    }
+    try {
+      // A full batch means there may be more behind it.
+      while (reconcileBatch().events == options_.batch_size) {
+        std::lock_guard lock(mutex_);
+        if (stopping_) {
+          break;
+        }
+      }
+    } catch (const std::exception&) {
+      // Counted in reconcileBatch; the events are back in the queue for
+      // the next wake().
+    }
+    std::lock_guard lock(mutex_);
+    if (!again_ || stopping_) {
+      scheduled_ = false;
+      idle_cv_.notify_all();
+      return;
+    }
+  }
+}
+
+SyncOutcome SyncReconciler::reconcileBatch() {
+  SyncOutcome outcome;
+  std::scoped_lock batch(batch_mutex_);
+  const auto events = catalog_.claimSyncEvents(root_id_, options_.batch_size);
+  if (events.empty()) {
+    return outcome;
+  }
+
+  try {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root_path_, ec)) {
+      // An unmounted volume is not a deleted one.
+      throw std::runtime_error("sync root is not reachable: " + root_path_.string());
+    }
+
+    std::set<std::string> paths;
+    std::set<std::string> folders;
+    std::vector<std::int64_t> event_ids;
+    event_ids.reserve(events.size());
+    for (const auto& event : events) {
+      event_ids.push_back(event.id);
+      if (event.event_type == kSyncRescan || event.relative_path.empty()) {
+        folders.insert(event.relative_path);
+      } else {
+        paths.insert(event.relative_path);
+      }
+    }
+
+    // One stat per named path; whatever it turned into decides what
+    // happens, whichever event named it.
+    std::map<std::string, FileRecord> present;
+    std::set<std::string> removals;
+    for (const auto& relative_path : paths) {
+      const auto absolute = root_path_ / relative_path;
+      const auto status = std::filesystem::status(absolute, ec);
+      if (!std::filesystem::exists(status)) {
+        removals.insert(relative_path);
+      } else if (std::filesystem::is_directory(status)) {
+        folders.insert(relative_path);
+      } else if (std::filesystem::is_regular_file(status)) {
+        present.emplace(relative_path, CatalogService::describeFile(root_path_, absolute));
+      }
+    }
+
+    // A rescan lists the folder's own entries; its subfolders have events
+    // of their own, and only those that are gone matter here.
+    std::map<std::string, std::set<std::string>> subfolders;
+    for (const auto& folder : folders) {
+      const auto absolute = folder.empty() ? root_path_ : root_path_ / folder;
+      std::filesystem::directory_iterator it(absolute, ec);
+      if (ec) {
+        if (!std::filesystem::exists(absolute, ec)) {
+          removals.insert(folder);
+        }
+        continue;
+      }
+      auto& listed = subfolders[folder];
+      for (const auto& entry : it) {
+        const auto name = entry.path().filename().string();
+        if (hidden(name)) {
+          continue;
+        }
+        if (entry.is_directory(ec)) {
+          listed.insert(name);
+        } else if (entry.is_regular_file(ec)) {
+          present.emplace(child(folder, name),
+                          CatalogService::describeFile(root_path_, entry.path()));
+        }
+      }
+    }
+
+    std::vector<std::string> stamp_paths;
+    stamp_paths.reserve(present.size());
+    for (const auto& [relative_path, _] : present) {
+      stamp_paths.push_back(relative_path);
+    }
+    std::vector<std::string> stamp_folders;
+    for (const auto& [folder, _] : subfolders) {
+      stamp_folders.push_back(folder);
+    }
+    std::map<std::string, FileStamp> stamps;
+    for (auto& stamp : catalog_.fileStamps(root_id_, stamp_paths, stamp_folders)) {
+      auto relative_path = stamp.relative_path;
+      stamps.emplace(std::move(relative_path), std::move(stamp));
+    }
+
+    // Stored rows a rescanned folder no longer holds.
+    for (const auto& [relative_path, _] : stamps) {
+      for (const auto& [folder, listed] : subfolders) {
+        std::string rest;
+        if (!below(folder, relative_path, rest)) {
+          continue;
+        }
+        const auto slash = rest.find('/');
+        const auto name = rest.substr(0, slash);
+        if (hidden(name)) {
+          continue;
+        }
+        if (slash == std::string::npos) {
+          if (!present.contains(relative_path)) {
+            removals.insert(relative_path);
+          }
+        } else if (!listed.contains(name)) {
+          removals.insert(child(folder, name));
+        }
+      }
+    }
+
+    std::vector<FileRecord> upserts;
+    for (auto& [relative_path, record] : present) {
+      const auto stamp = stamps.find(relative_path);
+      if (stamp != stamps.end() && stamp->second.file_size == record.file_size &&
+          stamp->second.mtime_ticks == record.mtime_ticks) {
+        ++outcome.unchanged;
+        continue;
+      }
+      outcome.changed.push_back(relative_path);
+      upserts.push_back(std::move(record));
+    }
+
+    outcome.removed = catalog_.applySyncBatch(
+        root_id_, upserts, std::vector<std::string>(removals.begin(), removals.end()), event_ids);
+    outcome.events = events.size();
+  } catch (...) {
+    try {
+      catalog_.releaseSyncEvents(root_id_);
+    } catch (const std::exception&) {
+      // Left claimed; the next drain() releases them.
+    }
+    std::lock_guard lock(mutex_);
+    ++failed_batches_;
+    throw;
+  }
+
+  {
+    std::lock_guard lock(mutex_);
+    reconciled_events_ += outcome.events;
+  }
+  if (on_change_ && (!outcome.changed.empty() || !outcome.removed.empty())) {
+    on_change_(root_id_, outcome);
+  }
+  return outcome;
+}
+
+std::size_t SyncReconciler::reconciledEvents() const {
+  std::lock_guard lock(mutex_);
+  return reconciled_events_;
+}
+
+std::size_t SyncReconciler::failedBatches() const {
+  std::lock_guard lock(mutex_);
+  return failed_batches_;
+}
+
+bool SyncReconciler::hidden(const std::string& name) const {
+  return options_.skip_hidden && !name.empty() && name.front() == '.';
+}
+
+}  // namespace cataloger::services::catalog
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CatalogService.h"
+#include "services/tasks/TaskScheduler.h"
+
+namespace cataloger::services::catalog {
+
+// What one reconciled batch changed in `files`.
+struct SyncOutcome {
+  std::size_t events{0};  // claimed and applied
+  std::vector<std::string> changed;  // rows added or updated
+  std::vector<std::string> removed;  // rows deleted
+  std::size_t unchanged{0};  // stat'ed files whose size and mtime matched
+};
+
+// Applies a root's sync_queue to `files` without rescanning the root.
+// Events are claimed in batches; each batch stats only the paths it names
+// (a kSyncRescan lists that one folder), compares size and mtime with the
+// stored rows, and writes the upserts, deletions and restacking in one
+// transaction together with marking its events processed. Batches run as
+// kMaintenance tasks, one at a time, whenever wake() is called.
+class SyncReconciler {
+public:
+  // Runs on the reconciling thread after each batch that changed rows,
+  // e.g. to drop cached previews of the files.
+  using ChangeSink = std::function<void(int root_id, const SyncOutcome& outcome)>;
+
+  struct Options {
+    std::size_t batch_size{256};
+    bool skip_hidden{true};  // as FileWatcher::Options::skip_hidden
+  };
+
+  // `catalog` and `scheduler` must outlive the reconciler; without a
+  // scheduler it owns a one-worker one.
+  SyncReconciler(CatalogService& catalog,
+                 int root_id,
+                 std::filesystem::path root_path,
+                 Options options,
+                 tasks::TaskScheduler* scheduler = nullptr);
+  ~SyncReconciler();
+
+  SyncReconciler(const SyncReconciler&) = delete;
+  SyncReconciler& operator=(const SyncReconciler&) = delete;
+
+  void setChangeSink(ChangeSink sink);
+
+  // Schedules batches until the queue is empty. Cheap to call often; a
+  // call while batches are running makes them look again when done.
+  void wake();
+  // Blocks until no batch is scheduled or running.
+  void waitIdle() const;
+  // Stops scheduling batches and waits for the running one.
+  void stop();
+
+  // Reconciles batches on the calling thread until the queue is empty,
+  // first releasing claims a previous run left behind. Returns the number
+  // of events applied.
+  std::size_t drain();
+  // Reconciles one batch on the calling thread; `events` is 0 once the
+  // queue is empty. Throws what the catalog throws, after releasing the
+  // batch's claims.
+  SyncOutcome reconcileBatch();
+
+  [[nodiscard]] std::size_t reconciledEvents() const;
+  [[nodiscard]] std::size_t failedBatches() const;
+
+private:
+  void run();
+  [[nodiscard]] bool hidden(const std::string& name) const;
+
+  CatalogService& catalog_;
+  int root_id_;
+  std::filesystem::path root_path_;
+  Options options_;
+  ChangeSink on_change_;
+  std::unique_ptr<tasks::TaskScheduler> owned_scheduler_;
+  tasks::TaskScheduler* scheduler_;
+
+  // Batches are applied one at a time, so a stale stat never lands after
+  // a newer one for the same path.
+  std::mutex batch_mutex_;
+  mutable std::mutex mutex_;
+  mutable std::condition_variable idle_cv_;
+  tasks::TaskHandle task_;
+  bool scheduled_{false};
+  bool again_{false};
+  bool stopping_{false};
+  std::size_t reconciled_events_{0};
+  std::size_t failed_batches_{0};
+};
+
+}  // namespace cataloger::services::catalog
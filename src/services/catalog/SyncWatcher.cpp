@@ -0,0 +1,85 @@
+#include "SyncWatcher.h"
+
+#include <exception>
+#include <utility>
+
+namespace cataloger::services::catalog {
+
+namespace io = cataloger::platform::io;
+
+namespace {
+
+const char* eventType(io::FileChangeKind kind) {
+  switch (kind) {
+    case io::FileChangeKind::kChanged:
+      return kSyncChanged;
+    case io::FileChangeKind::kRemoved:
+      return kSyncRemoved;
+    case io::FileChangeKind::kRescan:
+      return kSyncRescan;
+  }
+  return kSyncRescan;
+}
+
+}  // namespace
+
+SyncWatcher::SyncWatcher(CatalogService& catalog,
+                         int root_id,
+                         std::filesystem::path root_path,
+                         io::FileWatcher::Options options)
+    : catalog_(catalog),
+      root_id_(root_id),
+      watcher_(std::move(root_path), options, [this](std::vector<io::FileChange> changes) {
+        enqueue(std::move(changes));
+      }) {}
+
+void SyncWatcher::setQueuedSink(QueuedSink sink) {
+  on_queued_ = std::move(sink);
+}
+
+int SyncWatcher::start() {
+  return watcher_.start();
+}
+
+void SyncWatcher::stop() {
+  watcher_.stop();
+}
+
+std::size_t SyncWatcher::queuedEvents() const {
+  std::lock_guard lock(mutex_);
+  return queued_events_;
+}
+
+std::size_t SyncWatcher::failedBatches() const {
+  std::lock_guard lock(mutex_);
+  return failed_batches_;
+}
+
+void SyncWatcher::enqueue(std::vector<io::FileChange> changes) {
+  std::vector<SyncEvent> events;
+  events.reserve(changes.size());
+  for (auto& change : changes) {
+    SyncEvent event;
+    event.root_id = root_id_;
+    event.relative_path = std::move(change.relative_path);
+    event.event_type = eventType(change.kind);
+    event.payload = "{}";
+    events.push_back(std::move(event));
+  }
+  try {
+    catalog_.enqueueSyncEvents(events);
+    std::lock_guard lock(mutex_);
+    queued_events_ += events.size();
+  } catch (const std::exception&) {
+    // Runs on the watcher thread; the batch is lost, so the next startup
+    // scan has to catch what it held.
+    std::lock_guard lock(mutex_);
+    ++failed_batches_;
+    return;
+  }
+  if (on_queued_) {
+    on_queued_(events.size());
+  }
+}
+
+}  // namespace cataloger::services::catalog
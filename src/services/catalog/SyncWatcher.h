@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+
+#include "CatalogService.h"
+#include "platform/io/FileWatcher.h"
+
+namespace cataloger::services::catalog {
+
+// Keeps a root's sync_queue fed from a platform::io::FileWatcher, so the
+// catalog hears about changes without rescanning the root. Every batch
+// the watcher reports is written in one transaction.
+class SyncWatcher {
+public:
+  // Runs on the watcher thread after each batch is queued, e.g. to wake a
+  // SyncReconciler.
+  using QueuedSink = std::function<void(std::size_t events)>;
+
+  // `catalog` must outlive the watcher.
+  SyncWatcher(CatalogService& catalog,
+              int root_id,
+              std::filesystem::path root_path,
+              platform::io::FileWatcher::Options options = {});
+
+  // Set before start().
+  void setQueuedSink(QueuedSink sink);
+
+  // Returns 0 or the errno value; see FileWatcher::start.
+  int start();
+  // Stops watching after queueing the changes still pending.
+  void stop();
+
+  [[nodiscard]] std::size_t queuedEvents() const;
+  [[nodiscard]] std::size_t failedBatches() const;
+
+  [[nodiscard]] platform::io::FileWatcher& watcher() noexcept { return watcher_; }
+
+private:
+  void enqueue(std::vector<platform::io::FileChange> changes);
+
+  CatalogService& catalog_;
+  int root_id_;
+  QueuedSink on_queued_;
+  mutable std::mutex mutex_;
+  std::size_t queued_events_{0};
+  std::size_t failed_batches_{0};
+  platform::io::FileWatcher watcher_;  // last: its thread calls enqueue()
+};
+
+}  // namespace cataloger::services::catalog
@@ -0,0 +1,183 @@
+#include "AutoIngest.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <utility>
+
+#include "platform/io/FileCopy.h"
+
+namespace cataloger::services::ingest {
+
+namespace io = cataloger::platform::io;
+
+AutoIngest::AutoIngest(catalog::CatalogService& catalog,
+                       IngestPreset preset,
+                       Options options,
+                       tasks::TaskScheduler* scheduler)
+    : catalog_(catalog),
+      preset_(std::move(preset)),
+      options_(std::move(options)),
+      scheduler_(scheduler),
+      watcher_(options_.watcher, [this](const io::MountChange& change) { handle(change); }) {
+  if (!scheduler_) {
+    // Otherwise every card's CopyEngine would start a pool of its own.
+    tasks::TaskScheduler::Options scheduler_options;
+    scheduler_options.worker_count = std::max<std::size_t>(2, std::thread::hardware_concurrency());
+    scheduler_options.interactive_reserve = 0;
+    scheduler_options.lane_limits[static_cast<std::size_t>(tasks::Lane::kIngest)] =
+        scheduler_options.worker_count;
+    owned_scheduler_ = std::make_unique<tasks::TaskScheduler>(scheduler_options);
+    scheduler_ = owned_scheduler_.get();
+  }
+}
+
+AutoIngest::~AutoIngest() {
+  stop();
+}
+
+void AutoIngest::setStartSink(StartSink sink) {
+  std::lock_guard lock(mutex_);
+  on_start_ = std::move(sink);
+}
+
+void AutoIngest::setFinishSink(FinishSink sink) {
+  std::lock_guard lock(mutex_);
+  on_finish_ = std::move(sink);
+}
+
+void AutoIngest::setCatalogedSink(IngestJob::CatalogedSink sink) {
+  std::lock_guard lock(mutex_);
+  on_cataloged_ = std::move(sink);
+}
+
+int AutoIngest::start() {
+  return watcher_.start();
+}
+
+void AutoIngest::stop() {
+  watcher_.stop();
+  std::vector<std::jthread> ingests;
+  {
+    std::lock_guard lock(mutex_);
+    ingests.swap(ingests_);
+  }
+  // Joining lets running copies finish; only a settle wait is cut short.
+  for (auto& ingest : ingests) {
+    ingest.request_stop();
+  }
+  ingests.clear();
+  std::lock_guard lock(mutex_);
+  done_ingests_.clear();
+}
+
+void AutoIngest::handle(const io::MountChange& change) {
+  std::lock_guard lock(mutex_);
+  reapLocked();
+  for (const auto& mount : change.added) {
+    if (!io::IsRemovableMediaCandidate(mount) ||
+        !active_cards_.insert(mount.mount_point.string()).second) {
+      continue;
+    }
+    ingests_.emplace_back([this, mount](std::stop_token token) {
+      ingestCard(std::move(token), mount);
+      std::lock_guard done(mutex_);
+      done_ingests_.push_back(std::this_thread::get_id());
+    });
+  }
+}
+
+void AutoIngest::reapLocked() {
+  // Each of these has released mutex_ for the last time, so joining it
+  // here cannot deadlock.
+  for (const auto id : done_ingests_) {
+    const auto it = std::find_if(ingests_.begin(), ingests_.end(),
+                                 [&](const std::jthread& ingest) { return ingest.get_id() == id; });
+    if (it != ingests_.end()) {
+      it->join();
+      ingests_.erase(it);
+    }
+  }
+  done_ingests_.clear();
+}
+
+void AutoIngest::ingestCard(std::stop_token token, io::MountEntry mount) {
+  const auto card = mount.mount_point;
+
+  // Mounted is not always ready: some readers expose the filesystem before
+  // it answers. One stat and one readdir per poll, never a walk.
+  const auto deadline = std::chrono::steady_clock::now() + options_.settle_time;
+  auto camera_folder = io::FindCameraFolder(card);
+  while (!camera_folder && !token.stop_requested() &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(options_.settle_poll);
+    camera_folder = io::FindCameraFolder(card);
+  }
+  const auto volume_id = camera_folder ? io::DescribeVolume(*camera_folder).id : std::string{};
+  StartSink on_start;
+  FinishSink on_finish;
+  IngestJob::CatalogedSink on_cataloged;
+  bool already_ingested = false;
+  {
+    std::lock_guard lock(mutex_);
+    on_start = on_start_;
+    on_finish = on_finish_;
+    on_cataloged = on_cataloged_;
+    already_ingested = finished_cards_.contains(volume_id);
+  }
+
+  IngestJobStats stats;
+  std::int64_t job_id = 0;
+  try {
+    if (camera_folder && !token.stop_requested()) {
+      job_id = jobFor(card);
+    }
+    if (job_id == 0 && (!camera_folder || token.stop_requested() || already_ingested)) {
+      std::lock_guard lock(mutex_);
+      active_cards_.erase(card.string());
+      return;
+    }
+    if (job_id == 0) {
+      IngestService ingest(scheduler_);
+      ingest.setRenameOptions(preset_.rename);
+      ingest.queueSources({camera_folder->string()});
+      job_id = ingest.createJob(catalog_, preset_.destination_root, preset_.mirror_root);
+    }
+    if (on_start) {
+      on_start(card, job_id);
+    }
+    stats = IngestJob(catalog_, job_id, preset_.job, scheduler_).run({}, on_cataloged);
+  } catch (const std::exception&) {
+    // A catalog failure leaves the job journaled and unfinished.
+    stats.finished = false;
+  }
+
+  {
+    std::lock_guard lock(mutex_);
+    if (stats.finished && !volume_id.empty()) {
+      finished_cards_.insert(volume_id);
+    }
+    active_cards_.erase(card.string());
+  }
+  if (on_finish) {
+    on_finish(card, job_id, stats);
+  }
+}
+
+// The unfinished job this preset left on the card, or 0.
+std::int64_t AutoIngest::jobFor(const std::filesystem::path& card_root) {
+  const auto prefix = card_root.string() + "/";
+  for (const auto& job : catalog_.unfinishedIngestJobs()) {
+    if (std::filesystem::path(job.destination_root) != preset_.destination_root ||
+        std::filesystem::path(job.mirror_root) != preset_.mirror_root) {
+      continue;
+    }
+    const auto files = catalog_.loadIngestJobFiles(job.id);
+    if (!files.empty() && files.front().source.starts_with(prefix)) {
+      return job.id;
+    }
+  }
+  return 0;
+}
+
+}  // namespace cataloger::services::ingest
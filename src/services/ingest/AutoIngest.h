@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IngestJob.h"
+#include "IngestService.h"
+#include "platform/io/MountWatcher.h"
+
+namespace cataloger::services::ingest {
+
+// A saved ingest setup that runs unattended when a card is inserted.
+struct IngestPreset {
+  std::string name;
+  std::filesystem::path destination_root;
+  std::filesystem::path mirror_root;  // empty: no second copy
+  IngestRenamer::Options rename;
+  IngestJob::Options job;
+};
+
+// Starts `preset` for every camera card that gets mounted. Mounts come
+// from a platform::io::MountWatcher; ones that look like removable media
+// are given `settle_time` for their DCIM folder to become readable, then
+// the card's DCIM folder is journaled as an IngestJob and run on its own
+// thread (a job waits on its copies, so it cannot sit on a scheduler
+// lane). That thread only waits: the copies run as tasks on `scheduler`,
+// or on one scheduler the watcher owns and every card shares. A card
+// pulled mid-ingest leaves its job unfinished, and putting
+// it back resumes that job rather than starting another. A card that was
+// ingested completely is not ingested again while the watcher runs.
+class AutoIngest {
+public:
+  struct Options {
+    platform::io::MountWatcher::Options watcher;
+    std::chrono::milliseconds settle_time{5000};
+    std::chrono::milliseconds settle_poll{100};
+  };
+
+  // Called on the card's ingest thread when its job starts and when it ends.
+  using StartSink = std::function<void(const std::filesystem::path& card, std::int64_t job_id)>;
+  using FinishSink = std::function<void(const std::filesystem::path& card,
+                                        std::int64_t job_id,
+                                        const IngestJobStats& stats)>;
+
+  // `catalog` and `scheduler` must outlive the watcher.
+  AutoIngest(catalog::CatalogService& catalog,
+             IngestPreset preset,
+             Options options,
+             tasks::TaskScheduler* scheduler = nullptr);
+  ~AutoIngest();
+
+  AutoIngest(const AutoIngest&) = delete;
+  AutoIngest& operator=(const AutoIngest&) = delete;
+
+  void setStartSink(StartSink sink);
+  void setFinishSink(FinishSink sink);
+  void setCatalogedSink(IngestJob::CatalogedSink sink);
+
+  // Starts watching mounts. Cards already mounted are not ingested.
+  // Returns 0 or the errno value from reading the mount table.
+  int start();
+  // Stops watching and waits for running ingests to finish. A card still
+  // settling is given up at once, but a job that has started copying runs
+  // to its end: IngestJob::run cannot be interrupted, so this blocks for
+  // as long as the cards being ingested take to copy.
+  void stop();
+
+  // Mount changes as the watcher reports them; public for tests.
+  void handle(const platform::io::MountChange& change);
+
+private:
+  void ingestCard(std::stop_token token, platform::io::MountEntry mount);
+  std::int64_t jobFor(const std::filesystem::path& card_root);
+  // Joins the threads of cards that are done; requires mutex_.
+  void reapLocked();
+
+  catalog::CatalogService& catalog_;
+  IngestPreset preset_;
+  Options options_;
+  std::unique_ptr<tasks::TaskScheduler> owned_scheduler_;
+  tasks::TaskScheduler* scheduler_;
+  platform::io::MountWatcher watcher_;
+  std::mutex mutex_;
+  StartSink on_start_;
+  FinishSink on_finish_;
+  IngestJob::CatalogedSink on_cataloged_;
+  std::set<std::string> active_cards_;    // mount points being ingested
+  std::set<std::string> finished_cards_;  // volume ids ingested to the end
+  std::vector<std::jthread> ingests_;
+  std::vector<std::thread::id> done_ingests_;  // returned, not yet joined
+};
+
+}  // namespace cataloger::services::ingest
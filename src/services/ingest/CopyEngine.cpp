@@ -0,0 +1,461 @@
+#include "CopyEngine.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include "platform/io/BatchReader.h"
+#include "platform/io/ContentHash.h"
+
+namespace cataloger::services::ingest {
+
+namespace io = cataloger::platform::io;
+
+namespace {
+
+// How far past the oldest unstarted job a free slot may look for one on a
+// less busy device.
+constexpr std::size_t kLookahead = 64;
+
+std::string currentExceptionMessage() {
+  try {
+    throw;
+  } catch (const std::exception& error) {
+    return error.what();
+  } catch (...) {
+    return "copy failed";
+  }
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+std::string describe(const char* what, int error) {
+  return std::string(what) + ": " + std::generic_category().message(error);
+}
+
+// Re-reads a committed copy and compares it with the hash taken in flight.
+// Returns an empty string on a match; otherwise the copy is removed so a
+// retry is not refused as an existing file.
+std::string verifyCopy(const std::filesystem::path& destination,
+                       std::uint64_t expected_hash,
+                       std::uint64_t expected_bytes) {
+  const auto read_back = io::HashFileUncached(destination);
+  std::string error;
+  if (read_back.error != 0) {
+    error = describe("cannot verify copy", read_back.error);
+  } else if (read_back.bytes != expected_bytes || read_back.hash != expected_hash) {
+    error = "copy does not match the source";
+  }
+  if (!error.empty()) {
+    std::error_code ec;
+    std::filesystem::remove(destination, ec);
+  }
+  return error;
+}
+
+}  // namespace
+
+struct CopyEngine::Run {
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  const ResultSink* sink{nullptr};
+  const StartSink* start_sink{nullptr};
+
+  std::vector<CopyJob> jobs;
+  // Distinct devices each job touches: source, destination and mirror.
+  std::vector<std::vector<std::uint64_t>> devices;
+  std::vector<bool> started;
+  std::vector<std::optional<CopyResult>> results;
+  std::unordered_map<std::uint64_t, std::size_t> in_flight;  // by device
+  std::size_t first_unstarted{0};
+  std::size_t active{0};
+  std::size_t finished{0};
+  std::size_t next_handoff{0};
+  bool handing_off{false};
+  std::exception_ptr sink_error;  // the first one the result sink threw
+  CopyStats stats;
+
+  // One writer per destination for each mirrored copy in flight, reused
+  // by later copies; with one destination root that is at most
+  // per_device_limit pairs. Declared last so they drain before anything
+  // else goes.
+  struct Writers {
+    explicit Writers(std::size_t queued) : primary(queued), mirror(queued) {}
+    DestinationWriter primary;
+    DestinationWriter mirror;
+  };
+  std::vector<std::unique_ptr<Writers>> writers;
+  std::vector<Writers*> idle_writers;
+};
+
+CopyEngine::CopyEngine(Options options, tasks::TaskScheduler* scheduler)
+    : options_(options),
+      scheduler_(scheduler),
+      // A mirrored copy holds at most a full queue per destination plus the
+      // chunk being read.
+      chunks_(std::max<std::size_t>(64 * 1024, options.buffer_bytes),
+              std::max<std::size_t>(1, options.per_device_limit) *
+                  (2 * std::max<std::size_t>(1, options.mirror_queue_chunks) + 1)) {
+  options_.per_device_limit = std::max<std::size_t>(1, options_.per_device_limit);
+  options_.buffer_bytes = chunks_.chunkBytes();
+  options_.hash = options_.hash || options_.verify;
+  if (!scheduler_) {
+    // Source and destination devices each get their full share.
+    tasks::TaskScheduler::Options scheduler_options;
+    scheduler_options.worker_count = options_.per_device_limit * 2;
+    scheduler_options.interactive_reserve = 0;
+    scheduler_options.lane_limits[static_cast<std::size_t>(tasks::Lane::kIngest)] =
+        scheduler_options.worker_count;
+    owned_scheduler_ = std::make_unique<tasks::TaskScheduler>(scheduler_options);
+    scheduler_ = owned_scheduler_.get();
+  }
+}
+
+CopyEngine::~CopyEngine() = default;
+
+CopyStats CopyEngine::run(std::vector<CopyJob> jobs,
+                          const ResultSink& on_result,
+                          const StartSink& on_start) {
+  const auto start = std::chrono::steady_clock::now();
+  Run run;
+  run.sink = on_result ? &on_result : nullptr;
+  run.start_sink = on_start ? &on_start : nullptr;
+  run.jobs = std::move(jobs);
+  std::stable_sort(run.jobs.begin(), run.jobs.end(), [](const CopyJob& lhs, const CopyJob& rhs) {
+    if (lhs.capture_time != rhs.capture_time) {
+      return lhs.capture_time < rhs.capture_time;
+    }
+    return lhs.source < rhs.source;
+  });
+
+  const auto count = run.jobs.size();
+  run.devices.reserve(count);
+  std::unordered_map<std::string, std::uint64_t> directory_devices;
+  const auto deviceOf = [&](const std::filesystem::path& file) {
+    const auto directory = file.parent_path().string();
+    const auto [it, inserted] = directory_devices.try_emplace(directory, 0);
+    if (inserted) {
+      it->second = io::DeviceId(file.parent_path());
+    }
+    return it->second;
+  };
+  for (const auto& job : run.jobs) {
+    std::vector<std::uint64_t> devices{deviceOf(job.source)};
+    auto paths = {&job.destination, &job.mirror};
+    for (const auto* path : paths) {
+      if (path->empty()) {
+        continue;
+      }
+      const auto device = deviceOf(*path);
+      if (std::find(devices.begin(), devices.end(), device) == devices.end()) {
+        devices.push_back(device);
+      }
+    }
+    run.devices.push_back(std::move(devices));
+  }
+  run.started.assign(count, false);
+  run.results.resize(count);
+
+  std::unique_lock lock(run.mutex);
+  startJobsLocked(run);
+  run.done_cv.wait(lock, [&] {
+    return run.finished == count && run.next_handoff == count && !run.handing_off;
+  });
+  if (run.sink_error) {
+    std::rethrow_exception(run.sink_error);
+  }
+  run.stats.elapsed_ms = elapsedMs(start);
+  return run.stats;
+}
+
+void CopyEngine::startJobsLocked(Run& run) {
+  const auto count = run.jobs.size();
+  const auto limit = options_.per_device_limit;
+  const auto end = std::min(count, run.first_unstarted + kLookahead);
+  for (std::size_t i = run.first_unstarted; i < end; ++i) {
+    if (run.started[i]) {
+      continue;
+    }
+    const auto& devices = run.devices[i];
+    if (std::any_of(devices.begin(), devices.end(),
+                    [&](std::uint64_t device) { return run.in_flight[device] >= limit; })) {
+      continue;
+    }
+    run.started[i] = true;
+    for (const auto device : devices) {
+      ++run.in_flight[device];
+    }
+    ++run.active;
+    run.stats.peak_in_flight = std::max(run.stats.peak_in_flight, run.active);
+    scheduler_->submit(
+        tasks::Lane::kIngest, [this, &run, i](std::stop_token) { copyOne(run, i); },
+        {.name = "ingest-copy"});
+  }
+  while (run.first_unstarted < count && run.started[run.first_unstarted]) {
+    ++run.first_unstarted;
+  }
+}
+
+void CopyEngine::copyOne(Run& run, std::size_t index) {
+  const auto& job = run.jobs[index];
+  // Whatever happens to this file, the run's accounting below must see it
+  // finish, or run() waits forever.
+  CopyResult result;
+  try {
+    if (run.start_sink) {
+      (*run.start_sink)(job);
+    }
+    result = job.mirror.empty() ? copyFile(job) : copyMirrored(run, job);
+  } catch (...) {
+    result = CopyResult{};
+    result.job = job;
+    result.error = currentExceptionMessage();
+    result.mirror_error = job.mirror.empty() ? std::string{} : result.error;
+  }
+
+  std::unique_lock lock(run.mutex);
+  for (const auto device : run.devices[index]) {
+    --run.in_flight[device];
+  }
+  --run.active;
+  ++run.finished;
+  ++run.stats.files;
+  run.stats.bytes += result.bytes;
+  if (!result.ok) {
+    ++run.stats.failed;
+  }
+  if (!job.mirror.empty() && !result.mirror_ok) {
+    ++run.stats.mirror_failed;
+  }
+  run.results[index] = std::move(result);
+  startJobsLocked(run);
+
+  // Whoever finds the next result ready hands off the whole ready prefix;
+  // results finishing meanwhile are picked up by the same loop.
+  if (!run.handing_off) {
+    run.handing_off = true;
+    while (run.next_handoff < run.results.size() && run.results[run.next_handoff]) {
+      auto ready = std::move(*run.results[run.next_handoff]);
+      run.results[run.next_handoff].reset();
+      ++run.next_handoff;
+      if (run.sink) {
+        lock.unlock();
+        try {
+          (*run.sink)(ready);
+        } catch (...) {
+          lock.lock();
+          if (!run.sink_error) {
+            run.sink_error = std::current_exception();
+          }
+          continue;
+        }
+        lock.lock();
+      }
+    }
+    run.handing_off = false;
+  }
+  if (run.finished == run.jobs.size() && run.next_handoff == run.jobs.size()) {
+    run.done_cv.notify_all();
+  }
+}
+
+CopyResult CopyEngine::copyFile(const CopyJob& job) {
+  const auto start = std::chrono::steady_clock::now();
+  CopyResult result;
+  result.job = job;
+
+  io::FileHandle source(job.source);
+  if (!source.isOpen()) {
+    result.error = describe("cannot open source", errno);
+    return result;
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(job.destination.parent_path(), ec);
+  if (ec) {
+    result.error = "cannot create destination folder: " + ec.message();
+    return result;
+  }
+  io::PartialFile destination(job.destination);
+  if (!destination.isOpen()) {
+    result.error = describe("cannot create destination", destination.openError());
+    return result;
+  }
+
+  std::optional<io::ContentHasher> hasher;
+  if (options_.hash) {
+    hasher.emplace();
+  }
+  const auto outcome = [&] {
+    const auto buffer = chunks_.acquire();
+    return io::CopyFileData(source.fd(), destination.fd(), source.size(),
+                            std::span<std::uint8_t>(buffer->data.get(), chunks_.chunkBytes()),
+                            options_.kernel_copy, hasher ? &*hasher : nullptr);
+  }();
+  result.method = outcome.method;
+  result.bytes = outcome.bytes_copied;
+  if (outcome.error != 0) {
+    result.error = describe("copy failed", outcome.error);
+    return result;
+  }
+  if (outcome.bytes_copied != source.size()) {
+    result.error = "source shrank while copying";
+    return result;
+  }
+  if (const auto error = destination.commit(options_.sync, options_.overwrite)) {
+    result.error = describe("cannot move into place", error);
+    return result;
+  }
+  if (hasher) {
+    result.content_hash = hasher->digest();
+  }
+  if (options_.head_bytes > 0) {
+    std::vector<std::uint8_t> head(
+        static_cast<std::size_t>(std::min<std::uint64_t>(options_.head_bytes, result.bytes)));
+    const auto read = io::ReadFully(source.fd(), head, 0);
+    if (read.error == 0) {
+      head.resize(read.bytes_read);
+      result.head = std::make_shared<const std::vector<std::uint8_t>>(std::move(head));
+    }
+  }
+  if (options_.verify) {
+    result.error = verifyCopy(job.destination, *result.content_hash, result.bytes);
+    if (!result.error.empty()) {
+      return result;
+    }
+    result.verified = true;
+  }
+  // Keep the capture time on the copy; later ingests order by it too.
+  const auto modified = std::filesystem::last_write_time(job.source, ec);
+  if (!ec) {
+    std::filesystem::last_write_time(job.destination, modified, ec);
+  }
+  result.ok = true;
+  result.copy_ms = elapsedMs(start);
+  return result;
+}
+
+// The task reads each chunk once and queues it to both destination
+// writers, which write concurrently on their own threads. A destination
+// that fails stops receiving chunks; the other one carries on. Writers are
+// threads rather than ingest-lane tasks so the reading task never waits on
+// work queued behind it in its own lane.
+CopyResult CopyEngine::copyMirrored(Run& run, const CopyJob& job) {
+  const auto start = std::chrono::steady_clock::now();
+  CopyResult result;
+  result.job = job;
+
+  io::FileHandle source(job.source);
+  if (!source.isOpen()) {
+    result.error = describe("cannot open source", errno);
+    result.mirror_error = result.error;
+    return result;
+  }
+
+  const std::array<std::shared_ptr<MirrorTarget>, 2> targets{
+      std::make_shared<MirrorTarget>(job.destination),
+      std::make_shared<MirrorTarget>(job.mirror)};
+  Run::Writers* pair = nullptr;
+  {
+    std::lock_guard lock(run.mutex);
+    if (run.idle_writers.empty()) {
+      run.writers.push_back(std::make_unique<Run::Writers>(options_.mirror_queue_chunks));
+      run.idle_writers.push_back(run.writers.back().get());
+    }
+    pair = run.idle_writers.back();
+    run.idle_writers.pop_back();
+  }
+  const std::array<DestinationWriter*, 2> writers{&pair->primary, &pair->mirror};
+  const auto anyAlive = [&] {
+    return std::any_of(targets.begin(), targets.end(),
+                       [](const auto& target) { return !target->failed(); });
+  };
+
+  std::optional<io::ContentHasher> hasher;
+  if (options_.hash) {
+    hasher.emplace();
+  }
+  std::uint64_t offset = 0;
+  const auto length = source.size();
+  while (offset < length && anyAlive()) {
+    auto chunk = chunks_.acquire();
+    const auto want = static_cast<std::size_t>(
+        std::min<std::uint64_t>(length - offset, chunks_.chunkBytes()));
+    const auto read = io::ReadFully(source.fd(), {chunk->data.get(), want}, offset);
+    if (read.error != 0 || read.bytes_read == 0) {
+      const auto message = read.error != 0 ? describe("read failed", read.error)
+                                           : std::string("source shrank while copying");
+      for (const auto& target : targets) {
+        target->fail(message);
+      }
+      break;
+    }
+    chunk->size = read.bytes_read;
+    if (offset == 0 && options_.head_bytes > 0) {
+      const auto* data = chunk->data.get();
+      result.head = std::make_shared<const std::vector<std::uint8_t>>(
+          data, data + std::min(chunk->size, options_.head_bytes));
+    }
+    if (hasher) {
+      // On the reading thread, while both writers work on earlier chunks.
+      hasher->update({chunk->data.get(), chunk->size});
+    }
+    std::shared_ptr<const ChunkPool::Chunk> shared = std::move(chunk);
+    for (std::size_t i = 0; i < targets.size(); ++i) {
+      if (!targets[i]->failed()) {
+        writers[i]->write(targets[i], shared, offset);
+      }
+    }
+    offset += read.bytes_read;
+  }
+  result.bytes = offset;
+
+  for (std::size_t i = 0; i < targets.size(); ++i) {
+    writers[i]->commit(targets[i], options_.sync, options_.overwrite);
+  }
+  std::error_code ec;
+  const auto modified = std::filesystem::last_write_time(job.source, ec);
+  for (const auto& target : targets) {
+    target->waitDone();
+    if (!ec && !target->failed()) {
+      std::error_code ignored;
+      std::filesystem::last_write_time(target->destination(), modified, ignored);
+    }
+  }
+  {
+    std::lock_guard lock(run.mutex);
+    run.idle_writers.push_back(pair);
+  }
+  if (hasher && offset == length) {
+    result.content_hash = hasher->digest();
+  }
+  if (options_.verify && result.content_hash) {
+    for (const auto& target : targets) {
+      if (!target->failed()) {
+        if (auto error = verifyCopy(target->destination(), *result.content_hash, offset);
+            !error.empty()) {
+          target->fail(std::move(error));
+        }
+      }
+    }
+  }
+  result.ok = !targets[0]->failed();
+  result.error = targets[0]->error();
+  result.mirror_ok = !targets[1]->failed();
+  result.mirror_error = targets[1]->error();
+  result.verified = options_.verify && result.ok && result.mirror_ok;
+  result.copy_ms = elapsedMs(start);
+  return result;
+}
+
+}  // namespace cataloger::services::ingest
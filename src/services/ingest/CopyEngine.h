@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "MirrorWriter.h"
+#include "platform/io/FileCopy.h"
+#include "services/tasks/TaskScheduler.h"
+
+namespace cataloger::services::ingest {
+
+struct CopyJob {
+  std::filesystem::path source{};
+  std::filesystem::path destination{};
+  // Cameras stamp files with their capture time; jobs start and results
+  // are handed off in this order.
+  std::filesystem::file_time_type capture_time{};
+  // Optional second copy. The source is read once and each chunk goes to
+  // both destinations.
+  std::filesystem::path mirror{};
+};
+
+struct CopyResult {
+  CopyJob job;
+  std::uint64_t bytes{0};
+  cataloger::platform::io::CopyMethod method{cataloger::platform::io::CopyMethod::kReadWrite};
+  bool ok{false};  // the primary destination
+  std::string error;
+  bool mirror_ok{false};
+  std::string mirror_error;
+  // XXH64 of the bytes read from the source, when hashing was on.
+  std::optional<std::uint64_t> content_hash;
+  // Every destination that was copied read back to the same hash.
+  bool verified{false};
+  // The file's first Options::head_bytes, for consumers that parse the
+  // copy straight away (previews) without reading it again.
+  std::shared_ptr<const std::vector<std::uint8_t>> head;
+  double copy_ms{0.0};
+};
+
+struct CopyStats {
+  std::size_t files{0};
+  std::size_t failed{0};
+  std::size_t mirror_failed{0};
+  // Left out by IngestService as already copied; not counted in `files`.
+  std::size_t skipped{0};
+  std::uint64_t bytes{0};
+  double elapsed_ms{0.0};
+  std::size_t peak_in_flight{0};
+
+  [[nodiscard]] double megabytesPerSecond() const noexcept {
+    return elapsed_ms > 0.0 ? (static_cast<double>(bytes) / (1024.0 * 1024.0)) /
+                                  (elapsed_ms / 1000.0)
+                            : 0.0;
+  }
+};
+
+// Copies files on the ingest lane of a TaskScheduler. Each file goes to a
+// hidden temporary next to its destination and is renamed into place once
+// complete; timestamps are carried over.
+class CopyEngine {
+public:
+  struct Options {
+    // Copies in flight per device, counted on both the source and the
+    // destination device. Card readers want a few outstanding requests;
+    // more just seeks.
+    std::size_t per_device_limit{4};
+    // pread/pwrite chunk when the kernel copy path is unavailable, and the
+    // read size for mirrored copies.
+    std::size_t buffer_bytes{4u * 1024 * 1024};
+    // Chunks each mirrored destination may have waiting before the reader
+    // stalls for it.
+    std::size_t mirror_queue_chunks{2};
+    bool kernel_copy{true};
+    // Hash each file from the chunks already in memory. Needs the bytes in
+    // userspace, so single-destination copies skip the kernel path.
+    bool hash{false};
+    // Also read every committed copy back past the page cache and compare.
+    // Implies `hash`. A mismatched copy is removed and fails.
+    bool verify{false};
+    bool sync{true};
+    bool overwrite{false};
+    // Keep this many leading bytes of each file in CopyResult::head.
+    // Mirrored copies take them from the first chunk; other copies re-read
+    // them from the source while its pages are still cached.
+    std::size_t head_bytes{0};
+  };
+
+  // Called one result at a time, in capture order, as soon as a file and
+  // every file before it are done.
+  using ResultSink = std::function<void(const CopyResult&)>;
+  // Called on the copying task just before a file starts; copies start
+  // concurrently, so this may be called from several threads at once.
+  using StartSink = std::function<void(const CopyJob&)>;
+
+  // Without a scheduler the engine owns one sized for per_device_limit.
+  explicit CopyEngine(Options options, tasks::TaskScheduler* scheduler = nullptr);
+  CopyEngine() : CopyEngine(Options{}) {}
+  ~CopyEngine();
+
+  CopyEngine(const CopyEngine&) = delete;
+  CopyEngine& operator=(const CopyEngine&) = delete;
+
+  // Copies every job and blocks until all are done. A failed mirror copy
+  // never fails the primary one, or the other way round. A file whose start
+  // sink or copy throws is reported as failed; the first exception thrown by
+  // the result sink is rethrown once every file is done. Must not be called
+  // from an ingest-lane task: it waits on work queued to that lane.
+  CopyStats run(std::vector<CopyJob> jobs,
+                const ResultSink& on_result = {},
+                const StartSink& on_start = {});
+
+  [[nodiscard]] const Options& options() const noexcept { return options_; }
+
+private:
+  struct Run;
+
+  void startJobsLocked(Run& run);
+  void copyOne(Run& run, std::size_t index);
+  CopyResult copyFile(const CopyJob& job);
+  CopyResult copyMirrored(Run& run, const CopyJob& job);
+
+  Options options_;
+  std::unique_ptr<tasks::TaskScheduler> owned_scheduler_;
+  tasks::TaskScheduler* scheduler_;
+
+  ChunkPool chunks_;
+};
+
+}  // namespace cataloger::services::ingest
@@ -0,0 +1,336 @@
+#include "IngestJob.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include "platform/io/ContentHash.h"
+
+namespace cataloger::services::ingest {
+
+namespace io = cataloger::platform::io;
+using catalog::IngestFileState;
+using catalog::IngestFileUpdate;
+using catalog::IngestJobFile;
+
+namespace {
+
+// Final names are only ever created by renaming a finished temporary, and
+// the copy is then given the source's mtime. A file under one with the
+// source's size and mtime is that copy; any other file there is not ours,
+// however alike its name and size (a second body numbers its frames the
+// same way).
+bool isCopyOf(const std::filesystem::path& path, const IngestJobFile& file) {
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(path, ec) ||
+      std::filesystem::file_size(path, ec) != file.file_size || ec) {
+    return false;
+  }
+  const auto source_mtime = std::filesystem::last_write_time(file.source, ec);
+  if (ec) {
+    return false;
+  }
+  const auto copy_mtime = std::filesystem::last_write_time(path, ec);
+  return !ec && copy_mtime == source_mtime;
+}
+
+bool isCopied(IngestFileState state) {
+  return state == IngestFileState::kCopied || state == IngestFileState::kVerified;
+}
+
+// A copy journaled as done can still be deleted or lost with its disk
+// before the job is resumed.
+bool copiesExist(const IngestJobFile& file) {
+  std::error_code ec;
+  return std::filesystem::exists(file.destination, ec) &&
+         (file.mirror.empty() || std::filesystem::exists(file.mirror, ec));
+}
+
+// Collects journal updates and copied files from the copy tasks and
+// commits them in batches: journal states first, then the catalog rows,
+// which also mark their files cataloged. Sinks run on copy tasks, where an
+// exception cannot propagate, so the first catalog failure is kept and
+// rethrown by finish().
+class JobJournal {
+public:
+  JobJournal(catalog::CatalogService& catalog,
+             std::int64_t job_id,
+             int root_id,
+             const IngestJob::Options& options,
+             const IngestJob::CatalogedSink& on_cataloged)
+      : catalog_(catalog),
+        job_id_(job_id),
+        root_id_(root_id),
+        batch_files_(std::max<std::size_t>(options.batch_files, 1)),
+        batch_interval_(options.batch_interval),
+        on_cataloged_(on_cataloged),
+        last_flush_(std::chrono::steady_clock::now()) {}
+
+  void add(IngestFileUpdate update) {
+    std::lock_guard lock(mutex_);
+    updates_.push_back(std::move(update));
+  }
+
+  void addCopied(std::int64_t seq, CatalogedFile file) {
+    std::lock_guard lock(mutex_);
+    copied_.emplace_back(seq, std::move(file));
+  }
+
+  // Commits what has collected if the batch is full or old enough.
+  void flushIfDue() {
+    std::lock_guard lock(mutex_);
+    if (updates_.size() + copied_.size() < batch_files_ &&
+        std::chrono::steady_clock::now() - last_flush_ < batch_interval_) {
+      return;
+    }
+    flushLocked();
+  }
+
+  void finish() {
+    std::lock_guard lock(mutex_);
+    flushLocked();
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  [[nodiscard]] std::size_t cataloged() const {
+    std::lock_guard lock(mutex_);
+    return cataloged_;
+  }
+
+private:
+  void flushLocked() {
+    last_flush_ = std::chrono::steady_clock::now();
+    if (error_) {
+      return;
+    }
+    try {
+      if (!updates_.empty()) {
+        catalog_.updateIngestFiles(job_id_, updates_);
+        updates_.clear();
+      }
+      for (std::size_t begin = 0; begin < copied_.size(); begin += batch_files_) {
+        const auto end = std::min(copied_.size(), begin + batch_files_);
+        std::vector<std::pair<std::int64_t, catalog::FileRecord>> records;
+        records.reserve(end - begin);
+        for (auto i = begin; i < end; ++i) {
+          records.emplace_back(copied_[i].first, copied_[i].second.record);
+        }
+        const auto file_ids = catalog_.catalogIngestedFiles(job_id_, root_id_, records);
+        std::vector<CatalogedFile> files;
+        files.reserve(end - begin);
+        for (auto i = begin; i < end; ++i) {
+          auto& file = files.emplace_back(std::move(copied_[i].second));
+          file.file_id = file_ids[i - begin];
+        }
+        cataloged_ += files.size();
+        if (on_cataloged_) {
+          on_cataloged_(root_id_, files);
+        }
+      }
+      copied_.clear();
+    } catch (...) {
+      error_ = std::current_exception();
+    }
+  }
+
+  catalog::CatalogService& catalog_;
+  std::int64_t job_id_;
+  int root_id_;
+  std::size_t batch_files_;
+  std::chrono::milliseconds batch_interval_;
+  const IngestJob::CatalogedSink& on_cataloged_;
+  mutable std::mutex mutex_;
+  std::vector<IngestFileUpdate> updates_;
+  std::vector<std::pair<std::int64_t, CatalogedFile>> copied_;
+  std::size_t cataloged_{0};
+  std::chrono::steady_clock::time_point last_flush_;
+  std::exception_ptr error_;
+};
+
+}  // namespace
+
+std::int64_t IngestJob::create(catalog::CatalogService& catalog,
+                               std::vector<CopyJob> plan,
+                               const std::filesystem::path& destination_root,
+                               const std::filesystem::path& mirror_root) {
+  std::stable_sort(plan.begin(), plan.end(), [](const CopyJob& a, const CopyJob& b) {
+    return a.capture_time < b.capture_time;
+  });
+  std::vector<IngestJobFile> files;
+  files.reserve(plan.size());
+  for (std::size_t i = 0; i < plan.size(); ++i) {
+    const auto& job = plan[i];
+    IngestJobFile file;
+    file.seq = static_cast<std::int64_t>(i);
+    file.source = job.source.string();
+    file.destination = job.destination.string();
+    file.mirror = job.mirror.string();
+    std::error_code ec;
+    file.file_size = std::filesystem::file_size(job.source, ec);
+    file.capture_ticks = static_cast<std::int64_t>(job.capture_time.time_since_epoch().count());
+    files.push_back(std::move(file));
+  }
+  return catalog.createIngestJob(destination_root.string(), mirror_root.string(), files);
+}
+
+IngestJob::IngestJob(catalog::CatalogService& catalog,
+                     std::int64_t job_id,
+                     Options options,
+                     tasks::TaskScheduler* scheduler)
+    : catalog_(catalog), job_id_(job_id), options_(std::move(options)), scheduler_(scheduler) {}
+
+IngestJobStats IngestJob::run(const CopyEngine::ResultSink& on_result,
+                              const CatalogedSink& on_cataloged) {
+  const auto job = catalog_.loadIngestJob(job_id_);
+  if (!job) {
+    throw std::runtime_error("unknown ingest job: " + std::to_string(job_id_));
+  }
+  auto files = catalog_.loadIngestJobFiles(job_id_);
+  const bool hashing = options_.copy.hash || options_.copy.verify;
+  const std::filesystem::path destination_root(job->destination_root);
+  const auto root_id =
+      options_.catalog_destination ? catalog_.registerRoot(destination_root) : 0;
+  IngestJobStats stats;
+  JobJournal journal(catalog_, job_id_, root_id, options_, on_cataloged);
+
+  // Copied files go to the catalog; without one they are done.
+  const auto landed = [&](IngestJobFile& file,
+                          std::shared_ptr<const std::vector<std::uint8_t>> head) {
+    if (!options_.catalog_destination) {
+      return;
+    }
+    CatalogedFile cataloged;
+    cataloged.record = catalog::CatalogService::describeFile(destination_root, file.destination);
+    cataloged.record.content_hash = file.content_hash;
+    cataloged.head = std::move(head);
+    journal.addCopied(file.seq, std::move(cataloged));
+    file.state = IngestFileState::kCataloged;
+  };
+
+  // Work out what is left. Anything short of copied may have been in
+  // flight when the last run stopped, and anything copied may have gone
+  // since.
+  std::vector<CopyJob> remaining;
+  std::unordered_map<std::string, std::size_t> file_by_source;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    auto& file = files[i];
+    const bool done = file.state == IngestFileState::kCataloged || isCopied(file.state);
+    if (done && copiesExist(file)) {
+      ++stats.already_done;
+      if (file.state != IngestFileState::kCataloged) {
+        landed(file, nullptr);
+      }
+      continue;
+    }
+    // Only a file this job began copying can have landed. Anything else
+    // already at its destination is copied anyway, which fails with EEXIST
+    // rather than cataloging someone else's file as this one.
+    const bool started = done || file.state == IngestFileState::kCopying ||
+                         file.state == IngestFileState::kFailed;
+    const bool primary_done = started && isCopyOf(file.destination, file);
+    const bool mirror_done = file.mirror.empty() || (started && isCopyOf(file.mirror, file));
+    if (primary_done && mirror_done) {
+      IngestFileUpdate update{file.seq, IngestFileState::kCopied, std::nullopt, {}};
+      if (hashing) {
+        const auto copy = io::HashFileUncached(file.destination, options_.copy.buffer_bytes);
+        if (copy.error == 0) {
+          update.content_hash = copy.hash;
+        }
+        if (options_.copy.verify) {
+          const auto source = io::HashFileUncached(file.source, options_.copy.buffer_bytes);
+          if (copy.error != 0 || source.error != 0 || source.hash != copy.hash) {
+            update.state = IngestFileState::kFailed;
+            update.error = "destination exists and does not match the source";
+          } else {
+            update.state = IngestFileState::kVerified;
+          }
+        }
+      }
+      file.state = update.state;
+      file.content_hash = update.content_hash;
+      file.error = update.error;
+      journal.add(std::move(update));
+      if (file.state != IngestFileState::kFailed) {
+        ++stats.recovered;
+        landed(file, nullptr);
+      }
+      continue;
+    }
+
+    // A half-written temporary is simply truncated by the new copy. When
+    // only one of a mirrored pair made it, only the other is copied.
+    CopyJob copy;
+    copy.source = file.source;
+    copy.destination = primary_done ? std::filesystem::path(file.mirror)
+                                    : std::filesystem::path(file.destination);
+    if (!primary_done && !mirror_done) {
+      copy.mirror = file.mirror;
+    }
+    copy.capture_time = std::filesystem::file_time_type(
+        std::filesystem::file_time_type::duration(file.capture_ticks));
+    file_by_source.emplace(file.source, i);
+    remaining.push_back(std::move(copy));
+  }
+  journal.flushIfDue();
+
+  if (!remaining.empty()) {
+    CopyEngine engine(options_.copy, scheduler_);
+    const auto on_start = [&](const CopyJob& copy) {
+      if (const auto it = file_by_source.find(copy.source.string()); it != file_by_source.end()) {
+        journal.add({files[it->second].seq, IngestFileState::kCopying, std::nullopt, {}});
+      }
+    };
+    stats.copy = engine.run(
+        std::move(remaining),
+        [&](const CopyResult& result) {
+          if (const auto it = file_by_source.find(result.job.source.string());
+              it != file_by_source.end()) {
+            auto& file = files[it->second];
+            IngestFileUpdate update{file.seq, IngestFileState::kCopied, result.content_hash, {}};
+            if (!result.ok) {
+              update.state = IngestFileState::kFailed;
+              update.error = result.error;
+            } else if (!result.job.mirror.empty() && !result.mirror_ok) {
+              // Resuming copies just the mirror.
+              update.state = IngestFileState::kFailed;
+              update.error = "mirror: " + result.mirror_error;
+            } else if (result.verified) {
+              update.state = IngestFileState::kVerified;
+            }
+            file.state = update.state;
+            file.content_hash = update.content_hash;
+            file.error = update.error;
+            journal.add(std::move(update));
+            if (isCopied(file.state)) {
+              landed(file, result.head);
+            }
+            journal.flushIfDue();
+          }
+          if (on_result) {
+            on_result(result);
+          }
+        },
+        on_start);
+  }
+  journal.finish();
+  stats.cataloged = journal.cataloged();
+
+  stats.failed = static_cast<std::size_t>(
+      std::count_if(files.begin(), files.end(), [](const IngestJobFile& file) {
+        return file.state == IngestFileState::kFailed;
+      }));
+  if (stats.failed == 0) {
+    catalog_.finishIngestJob(job_id_);
+    stats.finished = true;
+  }
+  return stats;
+}
+
+}  // namespace cataloger::services::ingest
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "CopyEngine.h"
+#include "services/catalog/CatalogService.h"
+
+namespace cataloger::services::ingest {
+
+struct IngestJobStats {
+  CopyStats copy;  // copies made by this run
+  // Files a previous run already got to copied or further.
+  std::size_t already_done{0};
+  // Files the journal had as copying (or failed) whose destination already
+  // held the copy, e.g. renamed into place just before a crash.
+  std::size_t recovered{0};
+  std::size_t cataloged{0};
+  // Files left failed when the run ended; the job stays resumable.
+  std::size_t failed{0};
+  bool finished{false};
+};
+
+// A file an IngestJob has just added to the catalog.
+struct CatalogedFile {
+  std::int64_t file_id{};
+  catalog::FileRecord record;  // absolute_path is the copy
+  // Leading bytes kept from the copy (CopyEngine::Options::head_bytes);
+  // null for files an earlier run copied.
+  std::shared_ptr<const std::vector<std::uint8_t>> head;
+};
+
+// An ingest whose progress is journaled in the catalog, so a crash, a
+// pulled card or a power cut costs at most the files that were in flight.
+// Every file moves pending -> copying -> copied/verified -> cataloged, and
+// state changes reach the journal in batched transactions. Copied files
+// are cataloged in those same batches while the copy carries on, so they
+// can be browsed within a batch interval of landing. Running a job
+// again picks up from the journal: finished files are skipped, copies that
+// landed before their state was journaled are recognised by size and mtime
+// without copying, and half-written temporaries are overwritten. A file the
+// job never started is not taken for one that landed: if its destination is
+// already taken, the file fails with EEXIST.
+class IngestJob {
+public:
+  struct Options {
+    CopyEngine::Options copy;
+    // Journal updates are committed every `batch_files` state changes, or
+    // sooner once `batch_interval` has passed.
+    std::size_t batch_files{64};
+    std::chrono::milliseconds batch_interval{250};
+    // Register the destination root and add each copied file to it.
+    bool catalog_destination{true};
+  };
+
+  // Called after each batch of files is committed to the catalog, in
+  // capture order, with the destination's root id.
+  using CatalogedSink =
+      std::function<void(int root_id, const std::vector<CatalogedFile>& files)>;
+
+  // Journals `plan` as a new job, in capture order, and returns its id.
+  // Nothing is copied until run().
+  static std::int64_t create(catalog::CatalogService& catalog,
+                             std::vector<CopyJob> plan,
+                             const std::filesystem::path& destination_root,
+                             const std::filesystem::path& mirror_root = {});
+
+  // `catalog` and `scheduler` must outlive the job.
+  IngestJob(catalog::CatalogService& catalog,
+            std::int64_t job_id,
+            Options options,
+            tasks::TaskScheduler* scheduler = nullptr);
+  IngestJob(catalog::CatalogService& catalog, std::int64_t job_id)
+      : IngestJob(catalog, job_id, Options{}) {}
+
+  // Runs the job to the end, or resumes it from its last durable state.
+  // Results are forwarded as CopyEngine::run produces them. The job is
+  // marked finished once no file is left failed. Throws std::runtime_error
+  // for an unknown job or a catalog failure.
+  IngestJobStats run(const CopyEngine::ResultSink& on_result = {},
+                     const CatalogedSink& on_cataloged = {});
+
+  [[nodiscard]] std::int64_t id() const noexcept { return job_id_; }
+
+private:
+  catalog::CatalogService& catalog_;
+  std::int64_t job_id_;
+  Options options_;
+  tasks::TaskScheduler* scheduler_;
+};
+
+}  // namespace cataloger::services::ingest
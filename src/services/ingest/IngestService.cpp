@@ -1,7 +1,69 @@
 #include "IngestService.h"
 
+#include <algorithm>
+#include <optional>
+#include <system_error>
+#include <unordered_map>
+
+#include "platform/io/FileCopy.h"
+
 namespace cataloger::services::ingest {
 
+namespace {
+
+void addJob(const std::filesystem::path& source,
+            const std::filesystem::path& relative,
+            std::vector<CopyJob>& jobs) {
+  std::error_code ec;
+  CopyJob job;
+  job.source = source;
+  job.destination = relative;  // made absolute once every job is known
+  job.capture_time = std::filesystem::last_write_time(source, ec);
+  jobs.push_back(std::move(job));
+}
+
+// Builds index keys, describing each source volume once.
+class KeyMaker {
+public:
+  std::optional<IngestStateKey> keyFor(const std::filesystem::path& source) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(source, ec);
+    if (ec) {
+      return std::nullopt;
+    }
+    const auto mtime = std::filesystem::last_write_time(source, ec);
+    if (ec) {
+      return std::nullopt;
+    }
+    const auto device = platform::io::DeviceId(source);
+    auto it = volumes_.find(device);
+    if (it == volumes_.end()) {
+      it = volumes_.emplace(device, platform::io::DescribeVolume(source)).first;
+    }
+    const auto& volume = it->second;
+    if (volume.id.empty()) {
+      return std::nullopt;
+    }
+    const auto canonical = std::filesystem::canonical(source, ec);
+    if (ec) {
+      return std::nullopt;
+    }
+    IngestStateKey key;
+    key.volume_id = volume.id;
+    key.relative_path = canonical.lexically_relative(volume.mount_root).generic_string();
+    key.size = size;
+    key.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+    return key;
+  }
+
+private:
+  std::unordered_map<std::uint64_t, platform::io::VolumeInfo> volumes_;
+};
+
+}  // namespace
+
+IngestService::IngestService(tasks::TaskScheduler* scheduler) : scheduler_(scheduler) {}
+
 void IngestService::queueSources(PathList paths) {
   sources_ = std::move(paths);
 }
@@ -10,4 +72,169 @@ const IngestService::PathList& IngestService::sources() const noexcept {
   return sources_;
 }
 
+void IngestService::setCopyOptions(CopyEngine::Options options) {
+  copy_options_ = options;
+}
+
+const CopyEngine::Options& IngestService::copyOptions() const noexcept {
+  return copy_options_;
+}
+
+void IngestService::setSkipPolicy(SkipPolicy policy) {
+  skip_policy_ = policy;
+}
+
+IngestService::SkipPolicy IngestService::skipPolicy() const noexcept {
+  return skip_policy_;
+}
+
+void IngestService::setRenameOptions(IngestRenamer::Options options) {
+  // Parse now so a bad template is reported here rather than mid-ingest.
+  [[maybe_unused]] const IngestRenamer check(options, {});
+  rename_options_ = std::move(options);
+}
+
+const IngestRenamer::Options& IngestService::renameOptions() const noexcept {
+  return rename_options_;
+}
+
+std::vector<CopyJob> IngestService::planCopy(
+    const std::filesystem::path& destination_root,
+    const std::filesystem::path& mirror_root) const {
+  auto jobs = collectJobs();
+  placeJobs(jobs, destination_root, mirror_root);
+  return jobs;
+}
+
+std::vector<CopyJob> IngestService::collectJobs() const {
+  std::vector<CopyJob> jobs;
+  for (const auto& source : sources_) {
+    const std::filesystem::path source_path(source);
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(source_path, ec)) {
+      addJob(source_path, source_path.filename(), jobs);
+      continue;
+    }
+    if (!std::filesystem::is_directory(source_path, ec)) {
+      continue;
+    }
+    for (auto it = std::filesystem::recursive_directory_iterator(
+             source_path, std::filesystem::directory_options::skip_permission_denied, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+      if (!it->is_regular_file(ec)) {
+        continue;
+      }
+      addJob(it->path(), std::filesystem::relative(it->path(), source_path, ec), jobs);
+    }
+  }
+  return jobs;
+}
+
+void IngestService::placeJobs(std::vector<CopyJob>& jobs,
+                              const std::filesystem::path& destination_root,
+                              const std::filesystem::path& mirror_root) const {
+  IngestRenamer renamer(rename_options_, destination_root);
+  if (renamer.active()) {
+    std::stable_sort(jobs.begin(), jobs.end(), [](const CopyJob& a, const CopyJob& b) {
+      return a.capture_time < b.capture_time;
+    });
+  }
+  std::string relative;
+  for (auto& job : jobs) {
+    if (renamer.active()) {
+      renamer.assign(job.source, job.destination, job.capture_time, relative);
+      job.destination = relative;
+    }
+    if (!mirror_root.empty()) {
+      job.mirror = mirror_root / job.destination;
+    }
+    job.destination = destination_root / job.destination;
+  }
+}
+
+CopyStats IngestService::copyTo(const std::filesystem::path& destination_root,
+                                const CopyEngine::ResultSink& on_result) {
+  return copyTo(destination_root, {}, on_result);
+}
+
+CopyStats IngestService::copyTo(const std::filesystem::path& destination_root,
+                                const std::filesystem::path& mirror_root,
+                                const CopyEngine::ResultSink& on_result) {
+  CopyEngine engine(copy_options_, scheduler_);
+  if (skip_policy_ == SkipPolicy::kNone) {
+    return engine.run(planCopy(destination_root, mirror_root), on_result);
+  }
+
+  struct Pending {
+    IngestStateKey key;
+    std::optional<std::uint64_t> fingerprint;
+  };
+  IngestStateIndex index(destination_root / IngestStateIndex::kFileName);
+  KeyMaker keys;
+  std::unordered_map<std::string, Pending> pending;
+  auto jobs = collectJobs();
+  std::vector<CopyJob> remaining;
+  remaining.reserve(jobs.size());
+  std::size_t skipped = 0;
+  // Skipping is decided before renaming: the renamer counts copies already
+  // in the destination as taken, so a frame ingested before would be given
+  // a fresh name that does not exist yet.
+  for (auto& job : jobs) {
+    auto key = keys.keyFor(job.source);
+    if (!key) {
+      remaining.push_back(std::move(job));
+      continue;
+    }
+    // Stat-only checks never open the source; a fingerprint is read only
+    // for a file the index already knows. A copy that has since gone from
+    // the destination, under whatever name it was given, is made again.
+    std::optional<std::uint64_t> fingerprint;
+    if (index.contains(*key)) {
+      if (skip_policy_ == SkipPolicy::kFingerprint) {
+        fingerprint = IngestStateIndex::fingerprint(job.source);
+      }
+      const std::filesystem::path copied =
+          index.destination(*key).value_or(job.destination.generic_string());
+      std::error_code ec;
+      if (index.contains(*key, fingerprint) &&
+          std::filesystem::exists(destination_root / copied, ec) &&
+          (mirror_root.empty() || std::filesystem::exists(mirror_root / copied, ec))) {
+        ++skipped;
+        continue;
+      }
+    }
+    pending.emplace(job.source.string(), Pending{std::move(*key), fingerprint});
+    remaining.push_back(std::move(job));
+  }
+  placeJobs(remaining, destination_root, mirror_root);
+
+  auto stats = engine.run(std::move(remaining), [&](const CopyResult& result) {
+    // A failed mirror copy is retried by the next ingest.
+    if (result.ok && (result.job.mirror.empty() || result.mirror_ok)) {
+      if (const auto it = pending.find(result.job.source.string()); it != pending.end()) {
+        auto fingerprint = it->second.fingerprint;
+        if (!fingerprint && skip_policy_ == SkipPolicy::kFingerprint) {
+          // Same bytes as the source, and just written, so likely cached.
+          fingerprint = IngestStateIndex::fingerprint(result.job.destination);
+        }
+        index.record(it->second.key, fingerprint, result.content_hash,
+                     result.job.destination.lexically_relative(destination_root).generic_string());
+      }
+    }
+    if (on_result) {
+      on_result(result);
+    }
+  });
+  index.flush();
+  stats.skipped = skipped;
+  return stats;
+}
+
+std::int64_t IngestService::createJob(catalog::CatalogService& catalog,
+                                      const std::filesystem::path& destination_root,
+                                      const std::filesystem::path& mirror_root) const {
+  return IngestJob::create(catalog, planCopy(destination_root, mirror_root), destination_root,
+                           mirror_root);
+}
+
 }  // namespace cataloger::services::ingest
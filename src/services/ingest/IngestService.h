@@ -1,19 +1,80 @@
 #pragma once
 
+#include <filesystem>
 #include <string>
 #include <vector>
 
+#include "CopyEngine.h"
+#include "IngestJob.h"
+#include "IngestStateIndex.h"
+#include "RenameTemplate.h"
+
 namespace cataloger::services::ingest {
 
 class IngestService {
 public:
   using PathList = std::vector<std::string>;
 
+  // How copyTo() decides a file already reached the destination, from the
+  // IngestStateIndex kept in the destination root.
+  enum class SkipPolicy {
+    kNone,         // copy everything
+    kStat,         // same volume, path, size and mtime
+    kFingerprint,  // also the same first and last 64 KiB
+  };
+
+  // Copies run on `scheduler`'s ingest lane; it must outlive the service.
+  // Without one, each copy engine owns its workers.
+  explicit IngestService(tasks::TaskScheduler* scheduler = nullptr);
+
   void queueSources(PathList paths);
   [[nodiscard]] const PathList& sources() const noexcept;
 
+  void setCopyOptions(CopyEngine::Options options);
+  [[nodiscard]] const CopyEngine::Options& copyOptions() const noexcept;
+  void setSkipPolicy(SkipPolicy policy);
+  [[nodiscard]] SkipPolicy skipPolicy() const noexcept;
+  // Folder and file name templates for planned copies; see IngestRenamer.
+  // Throws std::invalid_argument for a template that does not parse.
+  void setRenameOptions(IngestRenamer::Options options);
+  [[nodiscard]] const IngestRenamer::Options& renameOptions() const noexcept;
+
+  // One job per regular file under the queued sources. A folder's layout is
+  // kept below `destination_root`; a single file lands directly in it. A
+  // non-empty `mirror_root` gets the same layout as a second copy. With
+  // rename templates set, names are assigned in capture order, so sequence
+  // numbers follow the shooting order.
+  [[nodiscard]] std::vector<CopyJob> planCopy(const std::filesystem::path& destination_root,
+                                              const std::filesystem::path& mirror_root = {}) const;
+  // Copies the queued sources into `destination_root`; see CopyEngine::run.
+  CopyStats copyTo(const std::filesystem::path& destination_root,
+                   const CopyEngine::ResultSink& on_result = {});
+  // Same, also mirroring every file below `mirror_root` from one read.
+  // Unless the skip policy is kNone, files recorded as copied to
+  // `destination_root` are left out and the ones copied now are recorded.
+  CopyStats copyTo(const std::filesystem::path& destination_root,
+                   const std::filesystem::path& mirror_root,
+                   const CopyEngine::ResultSink& on_result = {});
+  // Journals the planned copy as an IngestJob in `catalog` and returns its
+  // id; run it with IngestJob, and again to resume it after a crash.
+  std::int64_t createJob(catalog::CatalogService& catalog,
+                         const std::filesystem::path& destination_root,
+                         const std::filesystem::path& mirror_root = {}) const;
+
 private:
+  // One job per queued file, its destination the layout relative to the
+  // source folder.
+  [[nodiscard]] std::vector<CopyJob> collectJobs() const;
+  // Applies the rename templates and roots to collectJobs()'s output.
+  void placeJobs(std::vector<CopyJob>& jobs,
+                 const std::filesystem::path& destination_root,
+                 const std::filesystem::path& mirror_root) const;
+
   PathList sources_;
+  tasks::TaskScheduler* scheduler_;
+  CopyEngine::Options copy_options_;
+  SkipPolicy skip_policy_{SkipPolicy::kNone};
+  IngestRenamer::Options rename_options_;
 };
 
 }  // namespace cataloger::services::ingest
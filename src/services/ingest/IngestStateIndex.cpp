@@ -0,0 +1,304 @@
+#include "IngestStateIndex.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "platform/io/BatchReader.h"
+#include "platform/io/ContentHash.h"
+#include "platform/io/FileCopy.h"
+
+namespace cataloger::services::ingest {
+
+namespace io = cataloger::platform::io;
+
+namespace {
+
+constexpr std::array<char, 8> kMagic{'C', 'T', 'G', 'I', 'N', 'G', '0', '2'};
+constexpr std::uint32_t kHasFingerprint = 1u << 0;
+constexpr std::uint32_t kHasContentHash = 1u << 1;
+constexpr std::size_t kFingerprintWindow = 64 * 1024;
+
+// Host byte order; the index stays with the destination it describes.
+// Each record is followed by `destination_length` bytes of the copy's name.
+struct DiskRecord {
+  std::uint64_t key;
+  std::uint64_t size;
+  std::int64_t mtime;
+  std::uint64_t fingerprint;
+  std::uint64_t content_hash;
+  std::uint32_t flags;
+  std::uint32_t destination_length;
+  std::uint32_t check;  // catches a record torn by a crash mid-append
+  std::uint32_t reserved;
+};
+static_assert(sizeof(DiskRecord) == 56);
+
+std::uint32_t checkOf(const DiskRecord& record, std::string_view destination) {
+  io::ContentHasher hasher;
+  hasher.update({reinterpret_cast<const std::uint8_t*>(&record), offsetof(DiskRecord, check)});
+  hasher.update({reinterpret_cast<const std::uint8_t*>(destination.data()), destination.size()});
+  return static_cast<std::uint32_t>(hasher.digest());
+}
+
+// Appends `record` and its destination to `out`, filling in the length and
+// check.
+void appendRecord(DiskRecord record,
+                  std::string_view destination,
+                  std::vector<std::uint8_t>& out) {
+  record.destination_length = static_cast<std::uint32_t>(destination.size());
+  record.check = checkOf(record, destination);
+  const auto* bytes = reinterpret_cast<const std::uint8_t*>(&record);
+  out.insert(out.end(), bytes, bytes + sizeof(record));
+  out.insert(out.end(), destination.begin(), destination.end());
+}
+
+}  // namespace
+
+IngestStateIndex::IngestStateIndex(std::filesystem::path file) : file_(std::move(file)) {
+  load();
+}
+
+IngestStateIndex::~IngestStateIndex() = default;
+
+bool IngestStateIndex::contains(const IngestStateKey& key,
+                                std::optional<std::uint64_t> fingerprint) const {
+  std::lock_guard lock(mutex_);
+  const auto it = entries_.find(hashKey(key));
+  if (it == entries_.end()) {
+    return false;
+  }
+  const auto& entry = it->second;
+  if (entry.size != key.size || entry.mtime != key.mtime) {
+    return false;
+  }
+  return !fingerprint || !entry.fingerprint || *entry.fingerprint == *fingerprint;
+}
+
+std::optional<std::uint64_t> IngestStateIndex::contentHash(const IngestStateKey& key) const {
+  std::lock_guard lock(mutex_);
+  const auto it = entries_.find(hashKey(key));
+  if (it == entries_.end() || it->second.size != key.size || it->second.mtime != key.mtime) {
+    return std::nullopt;
+  }
+  return it->second.content_hash;
+}
+
+std::optional<std::string> IngestStateIndex::destination(const IngestStateKey& key) const {
+  std::lock_guard lock(mutex_);
+  const auto it = entries_.find(hashKey(key));
+  if (it == entries_.end() || it->second.destination.empty()) {
+    return std::nullopt;
+  }
+  return it->second.destination;
+}
+
+std::size_t IngestStateIndex::size() const {
+  std::lock_guard lock(mutex_);
+  return entries_.size();
+}
+
+int IngestStateIndex::record(const IngestStateKey& key,
+                             std::optional<std::uint64_t> fingerprint,
+                             std::optional<std::uint64_t> content_hash,
+                             std::string destination) {
+  std::lock_guard lock(mutex_);
+  DiskRecord record{};
+  record.key = hashKey(key);
+  record.size = key.size;
+  record.mtime = key.mtime;
+  if (fingerprint) {
+    record.fingerprint = *fingerprint;
+    record.flags |= kHasFingerprint;
+  }
+  if (content_hash) {
+    record.content_hash = *content_hash;
+    record.flags |= kHasContentHash;
+  }
+  std::vector<std::uint8_t> bytes;
+  bytes.reserve(sizeof(record) + destination.size());
+  appendRecord(record, destination, bytes);
+
+  // Opening may rewrite the file from entries_, so add this one after.
+  const auto open_error = openForAppendLocked();
+  entries_[record.key] = Entry{key.size, key.mtime, fingerprint, content_hash,
+                               std::move(destination)};
+  if (open_error != 0) {
+    return open_error;
+  }
+  // One write, so a crash tears at most this record.
+  if (const auto error = append_.append(bytes)) {
+    return error;
+  }
+  ++records_on_disk_;
+  return 0;
+}
+
+int IngestStateIndex::flush() {
+  std::lock_guard lock(mutex_);
+  return append_.sync();
+}
+
+int IngestStateIndex::compact() {
+  std::lock_guard lock(mutex_);
+  return compactLocked();
+}
+
+std::optional<std::uint64_t> IngestStateIndex::fingerprint(const std::filesystem::path& source) {
+  io::FileHandle file(source);
+  if (!file.isOpen()) {
+    return std::nullopt;
+  }
+  const auto length = file.size();
+  std::vector<std::uint8_t> window(kFingerprintWindow);
+  io::ContentHasher hasher;
+  const auto hashRange = [&](std::uint64_t offset, std::size_t count) {
+    const auto read = io::ReadFully(file.fd(), {window.data(), count}, offset);
+    if (read.error != 0 || read.bytes_read != count) {
+      return false;
+    }
+    hasher.update({window.data(), count});
+    return true;
+  };
+
+  const auto head = static_cast<std::size_t>(std::min<std::uint64_t>(length, kFingerprintWindow));
+  if (!hashRange(0, head)) {
+    return std::nullopt;
+  }
+  if (length > head) {
+    const auto tail = static_cast<std::size_t>(
+        std::min<std::uint64_t>(length - head, kFingerprintWindow));
+    if (!hashRange(length - tail, tail)) {
+      return std::nullopt;
+    }
+  }
+  hasher.update({reinterpret_cast<const std::uint8_t*>(&length), sizeof(length)});
+  return hasher.digest();
+}
+
+std::uint64_t IngestStateIndex::hashKey(const IngestStateKey& key) {
+  io::ContentHasher hasher;
+  hasher.update({reinterpret_cast<const std::uint8_t*>(key.volume_id.data()),
+                 key.volume_id.size()});
+  const std::uint8_t separator = 0;
+  hasher.update({&separator, 1});
+  hasher.update({reinterpret_cast<const std::uint8_t*>(key.relative_path.data()),
+                 key.relative_path.size()});
+  return hasher.digest();
+}
+
+void IngestStateIndex::load() {
+  std::ifstream stream(file_, std::ios::binary | std::ios::ate);
+  if (!stream) {
+    return;
+  }
+  std::vector<char> bytes(static_cast<std::size_t>(stream.tellg()));
+  stream.seekg(0);
+  stream.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  bytes.resize(static_cast<std::size_t>(stream.gcount()));
+  if (bytes.size() < kMagic.size() ||
+      !std::equal(kMagic.begin(), kMagic.end(), bytes.begin())) {
+    needs_rewrite_ = !bytes.empty();
+    return;  // rewritten from scratch by the first record()
+  }
+
+  std::size_t offset = kMagic.size();
+  std::size_t count = 0;
+  bool clean = true;
+  while (offset < bytes.size()) {
+    DiskRecord record;
+    if (bytes.size() - offset < sizeof(record)) {
+      clean = false;
+      break;
+    }
+    std::memcpy(&record, bytes.data() + offset, sizeof(record));
+    const auto length = record.destination_length;
+    if (bytes.size() - offset - sizeof(record) < length) {
+      clean = false;
+      break;
+    }
+    const std::string_view destination(bytes.data() + offset + sizeof(record), length);
+    // A bad record's length cannot be trusted either, so nothing after it
+    // can be found; only a torn tail should ever get here.
+    if (record.check != checkOf(record, destination)) {
+      clean = false;
+      break;
+    }
+    offset += sizeof(record) + length;
+    ++count;
+    Entry entry{record.size, record.mtime, std::nullopt, std::nullopt, std::string(destination)};
+    if (record.flags & kHasFingerprint) {
+      entry.fingerprint = record.fingerprint;
+    }
+    if (record.flags & kHasContentHash) {
+      entry.content_hash = record.content_hash;
+    }
+    entries_[record.key] = std::move(entry);  // later records supersede earlier ones
+  }
+  records_on_disk_ = count;
+
+  // A torn tail would misalign later appends, and a file mostly made of
+  // superseded records wastes load time.
+  if (!clean || records_on_disk_ > 2 * entries_.size() + 64) {
+    needs_rewrite_ = true;
+    compactLocked();
+  }
+}
+
+int IngestStateIndex::compactLocked() {
+  append_.close();
+  std::error_code ec;
+  if (file_.has_parent_path()) {
+    std::filesystem::create_directories(file_.parent_path(), ec);
+  }
+
+  // PartialFile gives the same write-aside-then-rename safety as copies.
+  io::PartialFile rewritten(file_);
+  if (!rewritten.isOpen()) {
+    return rewritten.openError();
+  }
+  std::vector<std::uint8_t> buffer(kMagic.begin(), kMagic.end());
+  buffer.reserve(kMagic.size() + entries_.size() * (sizeof(DiskRecord) + 32));
+  for (const auto& [key, entry] : entries_) {
+    DiskRecord record{};
+    record.key = key;
+    record.size = entry.size;
+    record.mtime = entry.mtime;
+    if (entry.fingerprint) {
+      record.fingerprint = *entry.fingerprint;
+      record.flags |= kHasFingerprint;
+    }
+    if (entry.content_hash) {
+      record.content_hash = *entry.content_hash;
+      record.flags |= kHasContentHash;
+    }
+    appendRecord(record, entry.destination, buffer);
+  }
+  if (const auto error = io::WriteFully(rewritten.fd(), buffer.data(), buffer.size(), 0)) {
+    return error;
+  }
+  if (const auto error = rewritten.commit(true, true)) {
+    return error;
+  }
+  records_on_disk_ = entries_.size();
+  needs_rewrite_ = false;
+  return openForAppendLocked();
+}
+
+int IngestStateIndex::openForAppendLocked() {
+  if (append_.isOpen()) {
+    return 0;
+  }
+  std::error_code ec;
+  if (needs_rewrite_ || !std::filesystem::exists(file_, ec)) {
+    return compactLocked();  // writes the header
+  }
+  return append_.open(file_);
+}
+
+}  // namespace cataloger::services::ingest
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "platform/io/FileCopy.h"
+
+namespace cataloger::services::ingest {
+
+// One source file as it sits on a card.
+struct IngestStateKey {
+  std::string volume_id;      // platform::io::DescribeVolume
+  std::string relative_path;  // generic form, below the volume's mount root
+  std::uint64_t size{0};
+  std::int64_t mtime{0};  // file_time_type ticks
+};
+
+// Remembers which source files already reached a destination, so a card
+// put back in (or an ingest resumed after a break) only copies what is new.
+// Lives as a hidden file in the destination root. Records hold a 64-bit
+// hash of the source's volume and path rather than the strings, plus the
+// copy's name below the destination root, which rename templates make
+// impossible to work out again. The file is only appended to, and is
+// loaded once into a hash map so a lookup costs the same however many past
+// ingests it holds.
+class IngestStateIndex {
+public:
+  static constexpr const char* kFileName = ".cataloger-ingest-state";
+
+  // Loads `file` when it exists; it is created by the first record().
+  explicit IngestStateIndex(std::filesystem::path file);
+  ~IngestStateIndex();
+
+  IngestStateIndex(const IngestStateIndex&) = delete;
+  IngestStateIndex& operator=(const IngestStateIndex&) = delete;
+
+  // True when the same path on the same volume was recorded with the same
+  // size and mtime, and, if both sides have one, the same fingerprint.
+  [[nodiscard]] bool contains(const IngestStateKey& key,
+                              std::optional<std::uint64_t> fingerprint = {}) const;
+  [[nodiscard]] std::optional<std::uint64_t> contentHash(const IngestStateKey& key) const;
+  // The recorded copy's generic path below the destination root, when the
+  // record has one.
+  [[nodiscard]] std::optional<std::string> destination(const IngestStateKey& key) const;
+  [[nodiscard]] std::size_t size() const;
+
+  // Returns 0 or the errno value of the failed append.
+  int record(const IngestStateKey& key,
+             std::optional<std::uint64_t> fingerprint = {},
+             std::optional<std::uint64_t> content_hash = {},
+             std::string destination = {});
+  // fsyncs appended records. Returns 0 or the errno value.
+  int flush();
+  // Rewrites the file with one record per file. Also done on load once
+  // superseded records outnumber live ones.
+  int compact();
+
+  // XXH64 of the first and last 64 KiB and the size. Tells apart a card
+  // that was reformatted and refilled with same-named, same-sized frames
+  // without reading whole files.
+  static std::optional<std::uint64_t> fingerprint(const std::filesystem::path& source);
+
+private:
+  struct Entry {
+    std::uint64_t size{0};
+    std::int64_t mtime{0};
+    std::optional<std::uint64_t> fingerprint;
+    std::optional<std::uint64_t> content_hash;
+    std::string destination;
+  };
+
+  static std::uint64_t hashKey(const IngestStateKey& key);
+  void load();
+  int compactLocked();
+  int openForAppendLocked();
+
+  std::filesystem::path file_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::uint64_t, Entry> entries_;
+  std::size_t records_on_disk_{0};
+  bool needs_rewrite_{false};  // unreadable header or torn tail on disk
+  platform::io::AppendFile append_;
+};
+
+}  // namespace cataloger::services::ingest
@@ -0,0 +1,165 @@
+#include "MirrorWriter.h"
+
+#include <algorithm>
+#include <system_error>
+#include <utility>
+
+namespace cataloger::services::ingest {
+
+namespace io = cataloger::platform::io;
+
+ChunkPool::ChunkPool(std::size_t chunk_bytes, std::size_t max_free)
+    : chunk_bytes_(std::max<std::size_t>(1, chunk_bytes)), max_free_(max_free) {}
+
+std::shared_ptr<ChunkPool::Chunk> ChunkPool::acquire() {
+  std::unique_ptr<Chunk> chunk;
+  {
+    std::lock_guard lock(mutex_);
+    if (!free_.empty()) {
+      chunk = std::move(free_.back());
+      free_.pop_back();
+    }
+  }
+  if (!chunk) {
+    chunk = std::make_unique<Chunk>();
+    chunk->data = std::make_unique_for_overwrite<std::uint8_t[]>(chunk_bytes_);
+  }
+  chunk->size = 0;
+  return std::shared_ptr<Chunk>(chunk.release(), [this](Chunk* done) { release(done); });
+}
+
+void ChunkPool::release(Chunk* chunk) {
+  std::unique_ptr<Chunk> owned(chunk);
+  std::lock_guard lock(mutex_);
+  if (free_.size() < max_free_) {
+    free_.push_back(std::move(owned));
+  }
+}
+
+MirrorTarget::MirrorTarget(std::filesystem::path destination)
+    : destination_(std::move(destination)) {
+  std::error_code ec;
+  std::filesystem::create_directories(destination_.parent_path(), ec);
+  if (ec) {
+    error_ = "cannot create destination folder: " + ec.message();
+    return;
+  }
+  file_ = io::PartialFile(destination_);
+  if (!file_.isOpen()) {
+    error_ = "cannot create destination: " +
+             std::generic_category().message(file_.openError());
+  }
+}
+
+bool MirrorTarget::failed() const {
+  std::lock_guard lock(mutex_);
+  return !error_.empty();
+}
+
+std::string MirrorTarget::error() const {
+  std::lock_guard lock(mutex_);
+  return error_;
+}
+
+void MirrorTarget::fail(std::string message) {
+  std::lock_guard lock(mutex_);
+  if (error_.empty()) {
+    error_ = std::move(message);
+  }
+}
+
+void MirrorTarget::waitDone() {
+  std::unique_lock lock(mutex_);
+  done_cv_.wait(lock, [&] { return done_; });
+}
+
+DestinationWriter::DestinationWriter(std::size_t max_queued_chunks)
+    : max_queued_(std::max<std::size_t>(1, max_queued_chunks)),
+      thread_([this] { loop(); }) {}
+
+DestinationWriter::~DestinationWriter() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+  thread_ = {};  // joins once the queue is empty
+}
+
+void DestinationWriter::write(std::shared_ptr<MirrorTarget> target,
+                              std::shared_ptr<const ChunkPool::Chunk> chunk,
+                              std::uint64_t offset) {
+  push(Operation{std::move(target), std::move(chunk), offset});
+}
+
+void DestinationWriter::commit(std::shared_ptr<MirrorTarget> target, bool sync, bool overwrite) {
+  Operation operation;
+  operation.target = std::move(target);
+  operation.sync = sync;
+  operation.overwrite = overwrite;
+  push(std::move(operation));
+}
+
+std::uint64_t DestinationWriter::bytesWritten() const {
+  std::lock_guard lock(mutex_);
+  return bytes_written_;
+}
+
+void DestinationWriter::push(Operation operation) {
+  std::unique_lock lock(mutex_);
+  // Commits never wait: they carry no data, and a reader blocked behind
+  // its own commit would never get to wait for the file.
+  if (operation.chunk) {
+    space_cv_.wait(lock, [&] { return queue_.size() < max_queued_; });
+  }
+  queue_.push_back(std::move(operation));
+  work_cv_.notify_one();
+}
+
+void DestinationWriter::loop() {
+  while (true) {
+    Operation operation;
+    {
+      std::unique_lock lock(mutex_);
+      work_cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;  // stopping and drained
+      }
+      operation = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    space_cv_.notify_one();
+    apply(operation);
+  }
+}
+
+void DestinationWriter::apply(Operation& operation) {
+  auto& target = *operation.target;
+  if (operation.chunk) {
+    if (target.failed()) {
+      return;  // drop the rest of a failed copy
+    }
+    const auto error = io::WriteFully(target.file_.fd(), operation.chunk->data.get(),
+                                      operation.chunk->size, operation.offset);
+    if (error != 0) {
+      target.fail("write failed: " + std::generic_category().message(error));
+      return;
+    }
+    std::lock_guard lock(mutex_);
+    bytes_written_ += operation.chunk->size;
+    return;
+  }
+
+  if (target.failed()) {
+    target.file_.abandon();
+  } else if (const auto error = target.file_.commit(operation.sync, operation.overwrite)) {
+    target.fail("cannot move into place: " + std::generic_category().message(error));
+  }
+  {
+    std::lock_guard lock(target.mutex_);
+    target.done_ = true;
+  }
+  target.done_cv_.notify_all();
+}
+
+}  // namespace cataloger::services::ingest
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "platform/io/FileCopy.h"
+
+namespace cataloger::services::ingest {
+
+// Fixed-size read buffers. A chunk read from the source is shared by every
+// destination writer and goes back to the pool when the last one is done.
+class ChunkPool {
+public:
+  struct Chunk {
+    std::unique_ptr<std::uint8_t[]> data;
+    std::size_t size{0};  // bytes filled
+  };
+
+  ChunkPool(std::size_t chunk_bytes, std::size_t max_free);
+
+  [[nodiscard]] std::shared_ptr<Chunk> acquire();
+  [[nodiscard]] std::size_t chunkBytes() const noexcept { return chunk_bytes_; }
+
+private:
+  void release(Chunk* chunk);
+
+  std::size_t chunk_bytes_;
+  std::size_t max_free_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Chunk>> free_;
+};
+
+// One file being written at one destination. Failing it (on open, write,
+// or by the reader) only drops this copy; the other destinations go on.
+class MirrorTarget {
+public:
+  explicit MirrorTarget(std::filesystem::path destination);
+
+  [[nodiscard]] const std::filesystem::path& destination() const noexcept {
+    return destination_;
+  }
+  [[nodiscard]] bool failed() const;
+  [[nodiscard]] std::string error() const;
+  void fail(std::string message);
+  // Blocks until the writer has committed or abandoned the file.
+  void waitDone();
+
+private:
+  friend class DestinationWriter;
+
+  std::filesystem::path destination_;
+  cataloger::platform::io::PartialFile file_;
+  mutable std::mutex mutex_;
+  std::condition_variable done_cv_;
+  std::string error_;
+  bool done_{false};
+};
+
+// Writes queued chunks to one destination on its own thread, so a slow
+// or failing disk only holds up its own queue. The queue is bounded: a
+// reader that gets ahead of this destination blocks in write(). The
+// thread is not a scheduler task because the reading task waits on it.
+// CopyEngine starts no more writers than it has mirrored copies in flight,
+// which per_device_limit bounds, and reuses them from copy to copy.
+class DestinationWriter {
+public:
+  explicit DestinationWriter(std::size_t max_queued_chunks);
+  // Finishes queued work, then joins.
+  ~DestinationWriter();
+
+  DestinationWriter(const DestinationWriter&) = delete;
+  DestinationWriter& operator=(const DestinationWriter&) = delete;
+
+  void write(std::shared_ptr<MirrorTarget> target,
+             std::shared_ptr<const ChunkPool::Chunk> chunk,
+             std::uint64_t offset);
+  // Queued behind the target's writes; a failed target is abandoned instead.
+  void commit(std::shared_ptr<MirrorTarget> target, bool sync, bool overwrite);
+
+  [[nodiscard]] std::uint64_t bytesWritten() const;
+
+private:
+  struct Operation {
+    std::shared_ptr<MirrorTarget> target;
+    std::shared_ptr<const ChunkPool::Chunk> chunk;  // null: commit
+    std::uint64_t offset{0};
+    bool sync{false};
+    bool overwrite{false};
+  };
+
+  void push(Operation operation);
+  void loop();
+  void apply(Operation& operation);
+
+  std::size_t max_queued_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable space_cv_;
+  std::deque<Operation> queue_;
+  std::uint64_t bytes_written_{0};
+  bool stopping_{false};
+  std::jthread thread_;
+};
+
+}  // namespace cataloger::services::ingest
@@ -0,0 +1,288 @@
+#include "RenameTemplate.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <ctime>
+#include <stdexcept>
+#include <system_error>
+
+#include "platform/io/ContentHash.h"
+
+namespace cataloger::services::ingest {
+
+namespace io = cataloger::platform::io;
+
+namespace {
+
+constexpr std::uint8_t kDefaultSequenceWidth = 4;
+constexpr std::uint8_t kMaxSequenceWidth = 12;
+
+void appendNumber(std::uint64_t value, std::uint8_t width, std::string& out) {
+  std::array<char, 24> digits{};
+  const auto end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+  const auto length = static_cast<std::size_t>(end - digits.data());
+  if (length < width) {
+    out.append(width - length, '0');
+  }
+  out.append(digits.data(), length);
+}
+
+// Job names come from the user; keep them to one path component.
+std::string sanitizedJob(std::string_view job) {
+  std::string sanitized(job);
+  for (auto& c : sanitized) {
+    if (c == '/' || c == '\\' || c == ':') {
+      c = '_';
+    }
+  }
+  return sanitized;
+}
+
+struct LocalDate {
+  int year{0};
+  unsigned month{0};
+  unsigned day{0};
+};
+
+// Photographers file by the day they shot, so the date is local time.
+LocalDate localDate(std::filesystem::file_time_type time) {
+  const auto system = std::chrono::file_clock::to_sys(time);
+  const auto seconds = std::chrono::system_clock::to_time_t(
+      std::chrono::time_point_cast<std::chrono::system_clock::duration>(system));
+  std::tm parts{};
+#if defined(_WIN32)
+  if (::localtime_s(&parts, &seconds) != 0) {
+    return {};
+  }
+#else
+  if (::localtime_r(&seconds, &parts) == nullptr) {
+    return {};
+  }
+#endif
+  return {parts.tm_year + 1900, static_cast<unsigned>(parts.tm_mon + 1),
+          static_cast<unsigned>(parts.tm_mday)};
+}
+
+// The path as narrow bytes with '/' separators. POSIX paths already are, so
+// no copy is made there; Windows paths are UTF-16 and get converted.
+#if defined(_WIN32)
+std::string pathBytes(const std::filesystem::path& path) {
+  return path.generic_string();
+}
+#else
+const std::string& pathBytes(const std::filesystem::path& path) {
+  return path.native();
+}
+#endif
+
+}  // namespace
+
+RenameTemplate::RenameTemplate(std::string_view pattern, std::string_view job) {
+  const auto job_name = sanitizedJob(job);
+  std::size_t pos = 0;
+  while (pos < pattern.size()) {
+    const auto open = pattern.find('{', pos);
+    appendLiteral(pattern.substr(pos, open - pos));
+    if (open == std::string_view::npos) {
+      break;
+    }
+    const auto close = pattern.find('}', open);
+    if (close == std::string_view::npos) {
+      throw std::invalid_argument("unclosed token in template: " + std::string(pattern));
+    }
+    const auto token = pattern.substr(open + 1, close - open - 1);
+    pos = close + 1;
+
+    Instruction instruction;
+    if (token == "year" || token == "year4") {
+      instruction.op = Op::kYear;
+    } else if (token == "year2") {
+      instruction.op = Op::kYear2;
+    } else if (token == "month") {
+      instruction.op = Op::kMonth;
+    } else if (token == "day") {
+      instruction.op = Op::kDay;
+    } else if (token == "filenamebase") {
+      instruction.op = Op::kFilenameBase;
+    } else if (token == "job") {
+      appendLiteral(job_name);
+      continue;
+    } else if (token.starts_with("sequence")) {
+      instruction.op = Op::kSequence;
+      instruction.width = kDefaultSequenceWidth;
+      const auto spec = token.substr(8);
+      if (!spec.empty()) {
+        unsigned width = 0;
+        const auto* first = spec.data() + 1;
+        const auto* last = spec.data() + spec.size();
+        const auto parsed = std::from_chars(first, last, width);
+        if (spec[0] != ':' || parsed.ec != std::errc{} || parsed.ptr != last || width == 0 ||
+            width > kMaxSequenceWidth) {
+          throw std::invalid_argument("bad sequence token in template: {" +
+                                      std::string(token) + "}");
+        }
+        instruction.width = static_cast<std::uint8_t>(width);
+      }
+      uses_sequence_ = true;
+    } else {
+      throw std::invalid_argument("unknown token in template: {" + std::string(token) + "}");
+    }
+    program_.push_back(instruction);
+  }
+}
+
+void RenameTemplate::appendLiteral(std::string_view text) {
+  if (text.empty()) {
+    return;
+  }
+  // Adjacent literals (text around a {job}) become one instruction.
+  if (!program_.empty() && program_.back().op == Op::kLiteral) {
+    program_.back().length += static_cast<std::uint32_t>(text.size());
+  } else {
+    Instruction instruction;
+    instruction.offset = static_cast<std::uint32_t>(literals_.size());
+    instruction.length = static_cast<std::uint32_t>(text.size());
+    program_.push_back(instruction);
+  }
+  literals_.append(text);
+}
+
+void RenameTemplate::expandTo(const RenameFields& fields, std::string& out) const {
+  for (const auto& instruction : program_) {
+    switch (instruction.op) {
+      case Op::kLiteral:
+        out.append(literals_, instruction.offset, instruction.length);
+        break;
+      case Op::kYear:
+        appendNumber(static_cast<std::uint64_t>(fields.year), 4, out);
+        break;
+      case Op::kYear2:
+        appendNumber(static_cast<std::uint64_t>(fields.year % 100), 2, out);
+        break;
+      case Op::kMonth:
+        appendNumber(fields.month, 2, out);
+        break;
+      case Op::kDay:
+        appendNumber(fields.day, 2, out);
+        break;
+      case Op::kFilenameBase:
+        out.append(fields.filename_base);
+        break;
+      case Op::kSequence:
+        appendNumber(fields.sequence, instruction.width, out);
+        break;
+    }
+  }
+}
+
+IngestRenamer::IngestRenamer(const Options& options, std::filesystem::path destination_root)
+    : folder_(options.folder_template, options.job),
+      file_(options.file_template, options.job),
+      destination_root_(std::move(destination_root)),
+      next_sequence_(options.first_sequence) {}
+
+void IngestRenamer::assign(const std::filesystem::path& source,
+                           const std::filesystem::path& layout,
+                           std::filesystem::file_time_type capture_time,
+                           std::string& out) {
+  const auto& bytes = pathBytes(source);
+  const std::string_view path(bytes);
+  const auto slash = path.rfind('/');
+  const auto name = slash == std::string_view::npos ? path : path.substr(slash + 1);
+  const auto dot = name.rfind('.');
+  const auto base = dot == std::string_view::npos || dot == 0 ? name : name.substr(0, dot);
+  const auto extension = name.substr(base.size());
+
+  RenameFields fields;
+  fields.filename_base = base;
+  if (active()) {
+    const auto date = localDate(capture_time);
+    fields.year = date.year;
+    fields.month = date.month;
+    fields.day = date.day;
+  }
+  if (folder_.usesSequence() || file_.usesSequence()) {
+    fields.sequence = sequenceFor(source);
+  }
+
+  out.clear();
+  if (!folder_.empty()) {
+    folder_.expandTo(fields, out);
+  } else {
+    out.append(layout.parent_path().generic_string());
+  }
+  if (!out.empty() && out.back() != '/') {
+    out.push_back('/');
+  }
+  const auto folder_length = out.size();
+  if (!file_.empty()) {
+    file_.expandTo(fields, out);
+  } else {
+    out.append(base);
+  }
+  const auto stem_length = out.size();
+  out.append(extension);
+
+  std::lock_guard lock(mutex_);
+  seedFolderLocked(std::string_view(out).substr(0, folder_length));
+  for (std::uint64_t suffix = 1; !taken_.insert(nameKey(out)).second; ++suffix) {
+    out.resize(stem_length);
+    out.push_back('-');
+    appendNumber(suffix, 1, out);
+    out.append(extension);
+  }
+}
+
+std::uint64_t IngestRenamer::sequenceFor(const std::filesystem::path& source) {
+  // Everything up to the first dot of the name, so IMG_0001.CR3 and
+  // IMG_0001.JPG (or IMG_0001.CR3.xmp) share one number.
+  const auto& bytes = pathBytes(source);
+  const std::string_view path(bytes);
+  const auto slash = path.rfind('/');
+  const auto name_start = slash == std::string_view::npos ? 0 : slash + 1;
+  const auto stem_end = path.find('.', name_start + 1);
+  const auto key = io::HashBytes(
+      {reinterpret_cast<const std::uint8_t*>(path.data()),
+       stem_end == std::string_view::npos ? path.size() : stem_end});
+  std::lock_guard lock(mutex_);
+  const auto [it, inserted] = pair_sequence_.try_emplace(key, 0);
+  if (inserted) {
+    it->second = next_sequence_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return it->second;
+}
+
+void IngestRenamer::seedFolderLocked(std::string_view folder) {
+  if (!seeded_folders_.emplace(folder).second) {
+    return;
+  }
+  std::error_code ec;
+  const auto directory = destination_root_ / std::filesystem::path(folder);
+  for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    auto relative = std::string(folder);
+    relative.append(pathBytes(it->path().filename()));
+    taken_.insert(nameKey(relative));
+  }
+}
+
+// Destinations may be case-insensitive (APFS, exFAT cards), so names that
+// differ only in ASCII case count as the same name.
+std::uint64_t IngestRenamer::nameKey(std::string_view relative) {
+  io::ContentHasher hasher;
+  std::array<std::uint8_t, 64> folded{};
+  while (!relative.empty()) {
+    const auto count = std::min(relative.size(), folded.size());
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto c = static_cast<std::uint8_t>(relative[i]);
+      folded[i] = c >= 'A' && c <= 'Z' ? static_cast<std::uint8_t>(c + ('a' - 'A')) : c;
+    }
+    hasher.update({folded.data(), count});
+    relative.remove_prefix(count);
+  }
+  return hasher.digest();
+}
+
+}  // namespace cataloger::services::ingest
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace cataloger::services::ingest {
+
+// What one file contributes to a template's expansion.
+struct RenameFields {
+  std::string_view filename_base;  // source name without its extension
+  int year{0};
+  unsigned month{0};
+  unsigned day{0};
+  std::uint64_t sequence{0};
+};
+
+// A folder or file name template, parsed once into a short token program.
+// Tokens are `{year}` (also `{year4}`), `{year2}`, `{month}`, `{day}`,
+// `{job}`, `{filenamebase}` and `{sequence}`, zero-padded to four digits
+// or to N with `{sequence:N}`. `{job}` is fixed per template, so it is
+// folded into the literal text when compiling. Expanding appends to a
+// caller-owned string and allocates nothing once that string has grown.
+class RenameTemplate {
+public:
+  // Throws std::invalid_argument for an unknown token or an unclosed brace.
+  explicit RenameTemplate(std::string_view pattern = {}, std::string_view job = {});
+
+  void expandTo(const RenameFields& fields, std::string& out) const;
+
+  [[nodiscard]] bool empty() const noexcept { return program_.empty(); }
+  [[nodiscard]] bool usesSequence() const noexcept { return uses_sequence_; }
+
+private:
+  enum class Op : std::uint8_t {
+    kLiteral,
+    kYear,
+    kYear2,
+    kMonth,
+    kDay,
+    kFilenameBase,
+    kSequence,
+  };
+  struct Instruction {
+    Op op{Op::kLiteral};
+    std::uint8_t width{0};     // kSequence
+    std::uint32_t offset{0};   // kLiteral, into literals_
+    std::uint32_t length{0};
+  };
+
+  void appendLiteral(std::string_view text);
+
+  std::string literals_;
+  std::vector<Instruction> program_;
+  bool uses_sequence_{false};
+};
+
+// Names the destinations of one ingest job from its folder and file
+// templates. Safe to call from parallel copy workers: sequence numbers
+// come from an atomic counter, and names already handed out (or already
+// in a destination folder, read once per folder) are kept in an
+// in-memory set, so a clash gets a `-1`, `-2`, ... suffix without
+// touching the disk again.
+class IngestRenamer {
+public:
+  struct Options {
+    // Empty keeps the source's folder layout.
+    std::string folder_template;
+    // Empty keeps the source's name. The extension is always kept.
+    std::string file_template;
+    std::string job;
+    std::uint64_t first_sequence{1};
+  };
+
+  IngestRenamer(const Options& options, std::filesystem::path destination_root);
+
+  [[nodiscard]] bool active() const noexcept {
+    return !folder_.empty() || !file_.empty();
+  }
+
+  // Writes the generic relative destination of `source` into `out`.
+  // `layout` is its path below the ingested folder, used where a template
+  // is empty. Files sharing a folder and base name on the source, such as
+  // RAW+JPEG pairs, share a sequence number.
+  void assign(const std::filesystem::path& source,
+              const std::filesystem::path& layout,
+              std::filesystem::file_time_type capture_time,
+              std::string& out);
+
+  [[nodiscard]] std::uint64_t nextSequence() const noexcept {
+    return next_sequence_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::uint64_t sequenceFor(const std::filesystem::path& source);
+  // Requires mutex_.
+  void seedFolderLocked(std::string_view folder);
+  static std::uint64_t nameKey(std::string_view relative);
+
+  RenameTemplate folder_;
+  RenameTemplate file_;
+  std::filesystem::path destination_root_;
+  std::atomic<std::uint64_t> next_sequence_;
+  std::mutex mutex_;
+  std::unordered_map<std::uint64_t, std::uint64_t> pair_sequence_;
+  std::unordered_set<std::uint64_t> taken_;
+  std::unordered_set<std::string> seeded_folders_;
+};
+
+}  // namespace cataloger::services::ingest
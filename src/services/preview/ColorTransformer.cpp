@@ -81,11 +81,11 @@ ColorTransformResult ColorTransformer::apply(
     return result;
   }
 
-  std::vector<std::uint8_t> corrected(image.pixels.size());
+  PixelBuffer corrected(image.pixels.size());
   const auto pixel_count = static_cast<int>(image.pixels.size() / 3);
   cmsDoTransform(transform,
                  image.pixels.data(),
-                 corrected.data(),
+                 corrected.mutableData(),
                  pixel_count);
   cmsDeleteTransform(transform);
 
@@ -11,7 +11,7 @@
 namespace cataloger::services::preview {
 
 struct ColorTransformResult {
-  std::vector<std::uint8_t> pixels;
+  PixelBuffer pixels;
   std::string source_profile;
 };
 
@@ -12,26 +12,44 @@ std::vector<PreviewDescriptor> DirectoryScanner::scan(
   }
 
   std::vector<PreviewDescriptor> descriptors;
-  for (const auto& entry : std::filesystem::recursive_directory_iterator(root_path)) {
+  for (auto it = std::filesystem::recursive_directory_iterator(root_path);
+       it != std::filesystem::recursive_directory_iterator(); ++it) {
+    const auto& entry = *it;
+    // Hidden entries are bookkeeping (the ingest state index, partial
+    // copies), not photos; hidden folders are not entered.
+    if (entry.path().filename().string().starts_with('.')) {
+      if (entry.is_directory()) {
+        it.disable_recursion_pending();
+      }
+      continue;
+    }
     if (!entry.is_regular_file()) {
       continue;
     }
 
-    PreviewDescriptor descriptor;
-    descriptor.absolute_path = entry.path();
-    descriptor.relative_path =
-        std::filesystem::relative(entry.path(), root_path).generic_string();
-    descriptor.file_size = entry.file_size();
-    std::error_code ec;
-    const auto ts = std::filesystem::last_write_time(entry.path(), ec);
-    if (!ec) {
-      descriptor.capture_ts = std::chrono::duration_cast<std::chrono::seconds>(
-                                  ts.time_since_epoch())
-                                  .count();
-    }
-    descriptors.push_back(std::move(descriptor));
+    descriptors.push_back(describe(root_path, entry.path()));
   }
   return descriptors;
 }
 
+PreviewDescriptor DirectoryScanner::describe(const std::filesystem::path& root_path,
+                                             const std::filesystem::path& file) {
+  PreviewDescriptor descriptor;
+  descriptor.absolute_path = file;
+  descriptor.relative_path = std::filesystem::relative(file, root_path).generic_string();
+  std::error_code ec;
+  descriptor.file_size = std::filesystem::file_size(file, ec);
+  if (ec) {
+    descriptor.file_size = 0;
+  }
+  const auto ts = std::filesystem::last_write_time(file, ec);
+  if (!ec) {
+    descriptor.capture_ts = std::chrono::duration_cast<std::chrono::seconds>(
+                                ts.time_since_epoch())
+                                .count();
+    descriptor.mtime_ticks = static_cast<std::int64_t>(ts.time_since_epoch().count());
+  }
+  return descriptor;
+}
+
 }  // namespace cataloger::services::preview
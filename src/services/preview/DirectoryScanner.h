@@ -10,6 +10,9 @@ namespace cataloger::services::preview {
 class DirectoryScanner {
 public:
   std::vector<PreviewDescriptor> scan(const std::filesystem::path& root_path) const;
+  // The descriptor scan() would produce for one file below `root_path`.
+  static PreviewDescriptor describe(const std::filesystem::path& root_path,
+                                    const std::filesystem::path& file);
 };
 
 }  // namespace cataloger::services::preview
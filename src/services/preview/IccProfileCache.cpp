@@ -0,0 +1,111 @@
+#include "IccProfileCache.h"
+
+namespace cataloger::services::preview {
+
+std::optional<IccDiscovery> IccProfileCache::lookup(
+    const std::filesystem::path& path,
+    std::uintmax_t file_size,
+    std::int64_t mtime) const {
+  std::lock_guard lock(mutex_);
+  const auto it = entries_.find(path.string());
+  if (it == entries_.end()) {
+    return std::nullopt;
+  }
+  const auto& entry = it->second;
+  if (entry.file_size != file_size || entry.mtime != mtime) {
+    return std::nullopt;
+  }
+
+  IccDiscovery discovery;
+  discovery.source = entry.source;
+  discovery.profile_hash = entry.profile_hash;
+  if (entry.profile_hash.has_value()) {
+    if (const auto profile_it = profiles_.find(*entry.profile_hash);
+        profile_it != profiles_.end()) {
+      discovery.profile = profile_it->second;
+    }
+  }
+  return discovery;
+}
+
+IccDiscovery IccProfileCache::record(const std::filesystem::path& path,
+                                     std::uintmax_t file_size,
+                                     std::int64_t mtime,
+                                     IccSource source,
+                                     std::vector<std::uint8_t> profile_bytes) {
+  IccDiscovery discovery;
+  discovery.source = profile_bytes.empty() ? IccSource::kNone : source;
+
+  std::lock_guard lock(mutex_);
+  if (!profile_bytes.empty()) {
+    const auto hash = HashProfile(profile_bytes);
+    discovery.profile_hash = hash;
+    discovery.profile = internLocked(hash, std::move(profile_bytes));
+  }
+
+  auto& entry = entries_[path.string()];
+  entry.file_size = file_size;
+  entry.mtime = mtime;
+  entry.source = discovery.source;
+  entry.profile_hash = discovery.profile_hash;
+  return discovery;
+}
+
+void IccProfileCache::restore(const std::string& path,
+                              std::uintmax_t file_size,
+                              std::int64_t mtime,
+                              IccSource source,
+                              std::optional<std::uint64_t> profile_hash) {
+  std::lock_guard lock(mutex_);
+  auto& entry = entries_[path];
+  entry.file_size = file_size;
+  entry.mtime = mtime;
+  entry.source = source;
+  entry.profile_hash = profile_hash;
+}
+
+IccProfileBytes IccProfileCache::internProfile(
+    std::uint64_t profile_hash,
+    std::vector<std::uint8_t> profile_bytes) {
+  std::lock_guard lock(mutex_);
+  return internLocked(profile_hash, std::move(profile_bytes));
+}
+
+IccProfileBytes IccProfileCache::profile(std::uint64_t profile_hash) const {
+  std::lock_guard lock(mutex_);
+  const auto it = profiles_.find(profile_hash);
+  return it == profiles_.end() ? IccProfileBytes{} : it->second;
+}
+
+std::size_t IccProfileCache::entryCount() const {
+  std::lock_guard lock(mutex_);
+  return entries_.size();
+}
+
+std::size_t IccProfileCache::uniqueProfileCount() const {
+  std::lock_guard lock(mutex_);
+  return profiles_.size();
+}
+
+std::uint64_t IccProfileCache::HashProfile(const std::vector<std::uint8_t>& bytes) {
+  // FNV-1a; profiles are a few KB and hashed once per distinct file identity.
+  std::uint64_t hash = 14695981039346656037ull;
+  for (const auto byte : bytes) {
+    hash ^= byte;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+IccProfileBytes IccProfileCache::internLocked(
+    std::uint64_t profile_hash,
+    std::vector<std::uint8_t> profile_bytes) {
+  auto& slot = profiles_[profile_hash];
+  if (!slot) {
+    slot = std::make_shared<const std::vector<std::uint8_t>>(
+        std::move(profile_bytes));
+  }
+  return slot;
+}
+
+}  // namespace cataloger::services::preview
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cataloger::services::preview {
+
+enum class IccSource { kNone = 0, kEmbedded = 1, kSidecar = 2 };
+
+using IccProfileBytes = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+struct IccDiscovery {
+  IccSource source{IccSource::kNone};
+  std::optional<std::uint64_t> profile_hash;
+  IccProfileBytes profile;
+};
+
+// Remembers where (and whether) each file's ICC profile was found, keyed by
+// path + size + mtime (file_time_type ticks, so a rewrite within the same
+// second is noticed) so unchanged files never touch the disk again. Profile
+// bytes are interned by content hash, so a shoot sharing one camera profile
+// keeps a single copy in memory and in the catalog.
+class IccProfileCache {
+public:
+  [[nodiscard]] std::optional<IccDiscovery> lookup(
+      const std::filesystem::path& path,
+      std::uintmax_t file_size,
+      std::int64_t mtime) const;
+
+  IccDiscovery record(const std::filesystem::path& path,
+                      std::uintmax_t file_size,
+                      std::int64_t mtime,
+                      IccSource source,
+                      std::vector<std::uint8_t> profile_bytes);
+
+  // Seeds a discovery restored from persistent storage. The profile bytes
+  // may be attached later via internProfile().
+  void restore(const std::string& path,
+               std::uintmax_t file_size,
+               std::int64_t mtime,
+               IccSource source,
+               std::optional<std::uint64_t> profile_hash);
+
+  IccProfileBytes internProfile(std::uint64_t profile_hash,
+                                std::vector<std::uint8_t> profile_bytes);
+  [[nodiscard]] IccProfileBytes profile(std::uint64_t profile_hash) const;
+
+  [[nodiscard]] std::size_t entryCount() const;
+  [[nodiscard]] std::size_t uniqueProfileCount() const;
+
+  static std::uint64_t HashProfile(const std::vector<std::uint8_t>& bytes);
+
+private:
+  struct Entry {
+    std::uintmax_t file_size{};
+    std::int64_t mtime{};
+    IccSource source{IccSource::kNone};
+    std::optional<std::uint64_t> profile_hash;
+  };
+
+  IccProfileBytes internLocked(std::uint64_t profile_hash,
+                               std::vector<std::uint8_t> profile_bytes);
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+  std::unordered_map<std::uint64_t, IccProfileBytes> profiles_;
+};
+
+}  // namespace cataloger::services::preview
@@ -5,7 +5,8 @@
 
 namespace cataloger::services::preview::icc {
 
-// Attempts to extract an embedded ICC profile from a JPEG/RAW file.
+// Attempts to extract an embedded ICC profile from a JPEG/RAW file. RAW
+// containers are checked for TIFF tag 34675, then the embedded preview JPEG.
 // Returns the ICC bytes when found; otherwise an empty vector.
 std::vector<std::uint8_t> ExtractEmbeddedProfile(
     const std::filesystem::path& image_path);
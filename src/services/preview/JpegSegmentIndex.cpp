@@ -0,0 +1,237 @@
+#include "JpegSegmentIndex.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "TiffReader.h"
+
+namespace cataloger::services::preview::jpeg {
+
+namespace {
+
+constexpr std::size_t kMaxHeaderBytes = 16 * 1024 * 1024;
+constexpr char kIccSignature[] = "ICC_PROFILE";  // followed by NUL, seq, total
+constexpr std::size_t kIccHeaderLength = sizeof(kIccSignature) + 2;
+constexpr char kExifSignature[] = "Exif\0";  // followed by a pad byte
+constexpr std::size_t kExifHeaderLength = 6;
+
+std::uint16_t be16(const std::uint8_t* p) {
+  return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+}
+
+bool isStartOfFrame(std::uint8_t marker) {
+  // SOF0..SOF15 excluding DHT (C4), JPG (C8) and DAC (CC).
+  return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 &&
+         marker != 0xCC;
+}
+
+bool isStandalone(std::uint8_t marker) {
+  return marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8);
+}
+
+}  // namespace
+
+SegmentIndex IndexSegments(std::span<const std::uint8_t> bytes) {
+  SegmentIndex index;
+  if (bytes.size() < 2 || bytes[0] != 0xFF || bytes[1] != 0xD8) {
+    return index;
+  }
+  index.valid = true;
+
+  std::size_t pos = 2;
+  while (true) {
+    if (pos + 4 > bytes.size()) {
+      index.truncated = true;
+      index.required_bytes = pos + 4;
+      break;
+    }
+    if (bytes[pos] != 0xFF) {
+      ++pos;
+      continue;
+    }
+    const auto marker = bytes[pos + 1];
+    if (marker == 0xFF) {
+      ++pos;  // fill byte
+      continue;
+    }
+    if (isStandalone(marker)) {
+      pos += 2;
+      continue;
+    }
+    if (marker == 0xD9) {
+      break;  // EOI
+    }
+    if (marker == 0xDA) {
+      index.sos_offset = pos;
+      break;
+    }
+
+    const auto length = be16(bytes.data() + pos + 2);
+    if (length < 2) {
+      break;
+    }
+    const Segment segment{marker, pos + 4, static_cast<std::size_t>(length) - 2};
+    const auto end = segment.payload_offset + segment.payload_length;
+    if (end > bytes.size()) {
+      index.truncated = true;
+      index.required_bytes = end;
+      break;
+    }
+
+    if (marker == 0xE1) {
+      index.app1.push_back(segment);
+    } else if (marker == 0xE2) {
+      index.app2.push_back(segment);
+    } else if (isStartOfFrame(marker) && !index.sof && segment.payload_length >= 5) {
+      index.sof = segment;
+      const auto* p = bytes.data() + segment.payload_offset;
+      index.height = be16(p + 1);
+      index.width = be16(p + 3);
+    }
+    pos = end;
+  }
+  return index;
+}
+
+std::vector<std::uint8_t> AssembleIccProfile(std::span<const std::uint8_t> bytes,
+                                             const SegmentIndex& index) {
+  // Chunk sequence numbers are 1-based and fit in a byte.
+  std::array<std::span<const std::uint8_t>, 256> chunks{};
+  int chunk_total = -1;
+  int chunk_count = 0;
+  std::size_t profile_size = 0;
+
+  for (const auto& segment : index.app2) {
+    if (segment.payload_length < kIccHeaderLength) {
+      continue;
+    }
+    const auto* payload = bytes.data() + segment.payload_offset;
+    if (std::memcmp(payload, kIccSignature, sizeof(kIccSignature) - 1) != 0) {
+      continue;
+    }
+    const int chunk_number = payload[sizeof(kIccSignature)];
+    const int total_chunks = payload[sizeof(kIccSignature) + 1];
+    if (chunk_number <= 0 || total_chunks <= 0) {
+      continue;
+    }
+    chunk_total = std::max(chunk_total, total_chunks);
+    auto& slot = chunks[static_cast<std::size_t>(chunk_number)];
+    if (slot.empty()) {
+      ++chunk_count;
+    } else {
+      profile_size -= slot.size();
+    }
+    slot = std::span<const std::uint8_t>(payload + kIccHeaderLength,
+                                         segment.payload_length - kIccHeaderLength);
+    profile_size += slot.size();
+  }
+
+  if (chunk_count == 0) {
+    return {};
+  }
+  const int expected = chunk_total == -1 ? chunk_count : chunk_total;
+  std::vector<std::uint8_t> profile;
+  profile.reserve(profile_size);
+  for (int i = 1; i <= expected; ++i) {
+    const auto& chunk = chunks[static_cast<std::size_t>(i)];
+    if (chunk.empty()) {
+      return {};
+    }
+    profile.insert(profile.end(), chunk.begin(), chunk.end());
+  }
+  return profile;
+}
+
+ExifSummary ParseExif(std::span<const std::uint8_t> bytes, const SegmentIndex& index) {
+  ExifSummary summary;
+  for (const auto& segment : index.app1) {
+    if (segment.payload_length < kExifHeaderLength + 8) {
+      continue;
+    }
+    const auto* payload = bytes.data() + segment.payload_offset;
+    if (std::memcmp(payload, kExifSignature, sizeof(kExifSignature) - 1) != 0) {
+      continue;  // XMP or other APP1 payload
+    }
+
+    const tiff::SpanSource source(
+        bytes.subspan(segment.payload_offset + kExifHeaderLength,
+                      segment.payload_length - kExifHeaderLength));
+    const tiff::TiffReader reader(source);
+    if (!reader.valid()) {
+      continue;
+    }
+    const auto ifd0 = reader.readIfd(reader.firstIfdOffset());
+    if (const auto entry = tiff::TiffReader::find(ifd0, tiff::kTagOrientation)) {
+      if (const auto value = reader.readUnsigned(*entry); value && *value >= 1 && *value <= 8) {
+        summary.orientation = static_cast<int>(*value);
+      }
+    }
+    if (const auto pointer = tiff::TiffReader::find(ifd0, tiff::kTagExifIfd)) {
+      if (const auto offset = reader.readUnsigned(*pointer)) {
+        const auto exif_ifd = reader.readIfd(*offset);
+        if (const auto entry =
+                tiff::TiffReader::find(exif_ifd, tiff::kTagDateTimeOriginal)) {
+          if (const auto stamp = reader.readAscii(*entry)) {
+            summary.capture_ts = tiff::ParseExifDateTime(*stamp);
+          }
+        }
+      }
+    }
+    break;
+  }
+  return summary;
+}
+
+SegmentIndex ReadHeader(const std::filesystem::path& path,
+                        PixelBuffer& buffer,
+                        std::size_t initial_bytes) {
+  const tiff::FileSource source(path);
+  if (!source.isOpen()) {
+    buffer.clear();
+    return {};
+  }
+  return ReadHeader(source, 0, source.size(), buffer, initial_bytes);
+}
+
+SegmentIndex ReadHeader(const tiff::ByteSource& source,
+                        std::uint64_t offset,
+                        std::uint64_t length,
+                        PixelBuffer& buffer,
+                        std::size_t initial_bytes) {
+  buffer.clear();
+  if (offset > source.size()) {
+    return {};
+  }
+  const auto available = static_cast<std::size_t>(
+      std::min<std::uint64_t>(length, source.size() - offset));
+
+  auto read_to = [&](std::size_t target) {
+    target = std::min(target, available);
+    const auto have = buffer.size();
+    if (target <= have) {
+      return false;
+    }
+    buffer.resize(target);
+    if (!source.read(offset + have, target - have, buffer.mutableData() + have)) {
+      buffer.resize(have);
+      return false;
+    }
+    return true;
+  };
+
+  read_to(initial_bytes);
+  auto index = IndexSegments(buffer);
+  while (index.valid && index.truncated && index.required_bytes <= kMaxHeaderBytes &&
+         buffer.size() < index.required_bytes) {
+    // Grow to cover the segment in flight plus a little lookahead for the next.
+    if (!read_to(std::min(kMaxHeaderBytes, index.required_bytes + 64 * 1024)) ||
+        buffer.size() < index.required_bytes) {
+      break;
+    }
+    index = IndexSegments(buffer);
+  }
+  return index;
+}
+
+}  // namespace cataloger::services::preview::jpeg
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "PixelBuffer.h"
+#include "TiffReader.h"
+
+namespace cataloger::services::preview::jpeg {
+
+struct Segment {
+  std::uint8_t marker{};
+  std::size_t payload_offset{};  // first byte after the length field
+  std::size_t payload_length{};
+};
+
+// Offsets of the segments later stages care about, recorded in one pass
+// over the marker stream. Payloads are referenced in place, never copied.
+struct SegmentIndex {
+  bool valid{false};
+  std::vector<Segment> app1;  // EXIF / XMP
+  std::vector<Segment> app2;  // ICC_PROFILE chunks
+  std::optional<Segment> sof;
+  std::optional<std::size_t> sos_offset;
+  int width{};
+  int height{};
+  // Set when a segment header or payload extends past the indexed span;
+  // `required_bytes` is how much of the stream must be available to resume.
+  bool truncated{false};
+  std::size_t required_bytes{};
+};
+
+struct ExifSummary {
+  int orientation{1};
+  std::optional<std::int64_t> capture_ts;
+};
+
+SegmentIndex IndexSegments(std::span<const std::uint8_t> bytes);
+
+std::vector<std::uint8_t> AssembleIccProfile(std::span<const std::uint8_t> bytes,
+                                             const SegmentIndex& index);
+ExifSummary ParseExif(std::span<const std::uint8_t> bytes, const SegmentIndex& index);
+
+// Reads the JPEG header (everything before SOS) into `buffer`, starting with
+// `initial_bytes` and growing only when a segment runs past what was read.
+// Returns the index for the bytes held in `buffer`.
+SegmentIndex ReadHeader(const std::filesystem::path& path,
+                        PixelBuffer& buffer,
+                        std::size_t initial_bytes);
+
+// Same as above for a JPEG stream embedded at [offset, offset + length) of a
+// larger container, e.g. the preview inside a RAW file.
+SegmentIndex ReadHeader(const tiff::ByteSource& source,
+                        std::uint64_t offset,
+                        std::uint64_t length,
+                        PixelBuffer& buffer,
+                        std::size_t initial_bytes);
+
+}  // namespace cataloger::services::preview::jpeg
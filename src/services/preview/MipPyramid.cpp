@@ -0,0 +1,344 @@
+#include "MipPyramid.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#include "platform/gpu/Swizzle.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CATALOGER_MIP_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define CATALOGER_MIP_SSE2 1
+#endif
+
+namespace cataloger::services::preview {
+
+namespace {
+
+constexpr std::size_t kTexelBytes = 4;
+
+std::size_t rgbaBytes(int width, int height) {
+  return static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * kTexelBytes;
+}
+
+int tilesAlong(int extent) {
+  return (extent + kTileSize - 1) / kTileSize;
+}
+
+// Averages output pixels [x, out_width) of one row pair with edge clamping.
+void boxRowScalar(const std::uint8_t* row0,
+                  const std::uint8_t* row1,
+                  int width,
+                  int x,
+                  int out_width,
+                  std::uint8_t* out) {
+  for (; x < out_width; ++x) {
+    const auto left = static_cast<std::size_t>(2 * x) * kTexelBytes;
+    const auto right = static_cast<std::size_t>(std::min(2 * x + 1, width - 1)) * kTexelBytes;
+    for (std::size_t c = 0; c < kTexelBytes; ++c) {
+      const unsigned sum = row0[left + c] + row0[right + c] + row1[left + c] + row1[right + c];
+      out[static_cast<std::size_t>(x) * kTexelBytes + c] = static_cast<std::uint8_t>((sum + 2) >> 2);
+    }
+  }
+}
+
+// Returns the first output pixel left for the scalar tail.
+int boxRowSimd(const std::uint8_t* row0,
+               const std::uint8_t* row1,
+               int width,
+               int out_width,
+               std::uint8_t* out) {
+  int x = 0;
+#if defined(CATALOGER_MIP_NEON)
+  // Eight source pixels -> four outputs: de-interleave even/odd pixels,
+  // widen-add the 2x2 block, then rounding-narrow by four.
+  for (; x + 4 <= out_width && 2 * x + 8 <= width; x += 4) {
+    const auto offset = static_cast<std::size_t>(2 * x) * kTexelBytes;
+    const uint32x4x2_t a = vld2q_u32(reinterpret_cast<const std::uint32_t*>(row0 + offset));
+    const uint32x4x2_t b = vld2q_u32(reinterpret_cast<const std::uint32_t*>(row1 + offset));
+    const uint8x16_t a0 = vreinterpretq_u8_u32(a.val[0]);
+    const uint8x16_t a1 = vreinterpretq_u8_u32(a.val[1]);
+    const uint8x16_t b0 = vreinterpretq_u8_u32(b.val[0]);
+    const uint8x16_t b1 = vreinterpretq_u8_u32(b.val[1]);
+    uint16x8_t lo = vaddl_u8(vget_low_u8(a0), vget_low_u8(a1));
+    lo = vaddw_u8(lo, vget_low_u8(b0));
+    lo = vaddw_u8(lo, vget_low_u8(b1));
+    uint16x8_t hi = vaddl_u8(vget_high_u8(a0), vget_high_u8(a1));
+    hi = vaddw_u8(hi, vget_high_u8(b0));
+    hi = vaddw_u8(hi, vget_high_u8(b1));
+    vst1q_u8(out + static_cast<std::size_t>(x) * kTexelBytes,
+             vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+  }
+#elif defined(CATALOGER_MIP_SSE2)
+  // Four source pixels -> two outputs: widen to 16 bits, add the rows, add
+  // neighbouring pixels, then round, shift and pack back to bytes.
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i two = _mm_set1_epi16(2);
+  for (; x + 2 <= out_width && 2 * x + 4 <= width; x += 2) {
+    const auto offset = static_cast<std::size_t>(2 * x) * kTexelBytes;
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + offset));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + offset));
+    const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+    const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+    const __m128i left = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+    const __m128i right = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+    const __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(left, right), two), 2);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + static_cast<std::size_t>(x) * kTexelBytes),
+                     _mm_packus_epi16(sum, sum));
+  }
+#else
+  (void)row0;
+  (void)row1;
+  (void)width;
+  (void)out_width;
+  (void)out;
+#endif
+  return x;
+}
+
+// Lanczos-3 taps for an exact 2:1 reduction. Every output sits halfway
+// between two source pixels, so one normalized 12-tap table serves all.
+constexpr int kLanczosTaps = 12;
+
+std::array<float, kLanczosTaps> lanczosWeights() {
+  const auto sinc = [](double t) {
+    if (t == 0.0) {
+      return 1.0;
+    }
+    const double x = std::numbers::pi * t;
+    return std::sin(x) / x;
+  };
+  std::array<float, kLanczosTaps> weights{};
+  double total = 0.0;
+  std::array<double, kLanczosTaps> raw{};
+  for (int k = 0; k < kLanczosTaps; ++k) {
+    const double t = (k - 5.5) / 2.0;  // source distance in output pixels
+    raw[k] = sinc(t) * sinc(t / 3.0);
+    total += raw[k];
+  }
+  for (int k = 0; k < kLanczosTaps; ++k) {
+    weights[k] = static_cast<float>(raw[k] / total);
+  }
+  return weights;
+}
+
+}  // namespace
+
+TileGrid::TileGrid(int width, int height) {
+  width = std::max(width, 1);
+  height = std::max(height, 1);
+  levels_.emplace_back(width, height);
+  while (width > kTileSize || height > kTileSize) {
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+    levels_.emplace_back(width, height);
+  }
+}
+
+int TileGrid::tilesX(int level) const {
+  return tilesAlong(levelWidth(level));
+}
+
+int TileGrid::tilesY(int level) const {
+  return tilesAlong(levelHeight(level));
+}
+
+TileRect TileGrid::tileRect(const TileId& tile) const {
+  const int x = tile.x * kTileSize;
+  const int y = tile.y * kTileSize;
+  return TileRect{x, y, std::min(kTileSize, levelWidth(tile.level) - x),
+                  std::min(kTileSize, levelHeight(tile.level) - y)};
+}
+
+std::size_t TileGrid::tileBytes(const TileId& tile) const {
+  const auto rect = tileRect(tile);
+  return rgbaBytes(rect.width, rect.height);
+}
+
+std::size_t TileGrid::levelBytes(int level) const {
+  return rgbaBytes(levelWidth(level), levelHeight(level));
+}
+
+int TileGrid::levelForScale(double scale) const {
+  int level = 0;
+  while (level + 1 < levelCount() && std::ldexp(1.0, -(level + 1)) >= scale) {
+    ++level;
+  }
+  return level;
+}
+
+std::vector<TileId> TileGrid::visibleTiles(const Viewport& view) const {
+  std::vector<TileId> tiles;
+  if (view.width <= 0.0 || view.height <= 0.0) {
+    return tiles;
+  }
+  const int level = levelForScale(view.scale);
+  const double factor = std::ldexp(1.0, -level);
+  const double left = view.x * factor;
+  const double top = view.y * factor;
+  const double right = (view.x + view.width) * factor;
+  const double bottom = (view.y + view.height) * factor;
+  if (right <= 0.0 || bottom <= 0.0 || left >= levelWidth(level) || top >= levelHeight(level)) {
+    return tiles;
+  }
+  const auto first = [](double edge, int count) {
+    return std::clamp(static_cast<int>(std::floor(edge / kTileSize)), 0, count - 1);
+  };
+  const auto last = [](double edge, int count) {
+    return std::clamp(static_cast<int>(std::ceil(edge / kTileSize)) - 1, 0, count - 1);
+  };
+  const int x0 = first(left, tilesX(level));
+  const int x1 = last(right, tilesX(level));
+  const int y0 = first(top, tilesY(level));
+  const int y1 = last(bottom, tilesY(level));
+  tiles.reserve(static_cast<std::size_t>(x1 - x0 + 1) * static_cast<std::size_t>(y1 - y0 + 1));
+  for (int y = y0; y <= y1; ++y) {
+    for (int x = x0; x <= x1; ++x) {
+      tiles.push_back(TileId{level, x, y});
+    }
+  }
+  return tiles;
+}
+
+MipPyramid MipPyramid::Build(const PreviewImage& image, MipFilter filter) {
+  MipPyramid pyramid{TileGrid(image.width, image.height)};
+  const auto& grid = pyramid.grid_;
+  pyramid.levels_.reserve(static_cast<std::size_t>(grid.levelCount()));
+
+  const int width = grid.levelWidth(0);
+  const int height = grid.levelHeight(0);
+  PixelBuffer base(rgbaBytes(width, height));
+  auto* texels = base.mutableData();
+  const auto* source = image.pixels.data();
+  const auto source_size = image.pixels.size();
+  const auto source_bpp = static_cast<std::size_t>(BytesPerPixel(image.layout));
+  const auto row_bytes = static_cast<std::size_t>(width) * source_bpp;
+  for (int row = 0; row < height; ++row) {
+    auto* dst = texels + static_cast<std::size_t>(row) * width * kTexelBytes;
+    const auto offset = static_cast<std::size_t>(row) * row_bytes;
+    const auto available =
+        offset < source_size ? std::min<std::size_t>(width, (source_size - offset) / source_bpp)
+                             : 0;
+    if (available > 0 && source_bpp == kTexelBytes) {
+      std::memcpy(dst, source + offset, available * kTexelBytes);
+    } else if (available > 0) {
+      platform::gpu::SwizzleRgb(source + offset, dst, available, platform::gpu::PixelFormat::kRGBA8);
+    }
+    std::memset(dst + available * kTexelBytes, 0xFF,
+                (static_cast<std::size_t>(width) - available) * kTexelBytes);
+  }
+  pyramid.levels_.push_back(std::move(base));
+
+  for (int level = 1; level < grid.levelCount(); ++level) {
+    PixelBuffer next(grid.levelBytes(level));
+    const auto& previous = pyramid.levels_.back();
+    if (filter == MipFilter::kLanczos3) {
+      DownsampleLanczos3(previous.data(), grid.levelWidth(level - 1), grid.levelHeight(level - 1),
+                         next.mutableData());
+    } else {
+      DownsampleBox(previous.data(), grid.levelWidth(level - 1), grid.levelHeight(level - 1),
+                    next.mutableData());
+    }
+    pyramid.levels_.push_back(std::move(next));
+  }
+  return pyramid;
+}
+
+PreviewImage MipPyramid::levelImage(const std::string& cache_key, int level) const {
+  PreviewImage image;
+  image.cache_key = cache_key;
+  image.pixels = levels_[level];
+  image.layout = PixelLayout::kRgba8;
+  image.width = grid_.levelWidth(level);
+  image.height = grid_.levelHeight(level);
+  return image;
+}
+
+PreviewImage MipPyramid::tileImage(const std::string& cache_key, const TileId& tile) const {
+  const auto rect = grid_.tileRect(tile);
+  const auto level_row = static_cast<std::size_t>(grid_.levelWidth(tile.level)) * kTexelBytes;
+  const auto tile_row = static_cast<std::size_t>(rect.width) * kTexelBytes;
+  PixelBuffer texels(tile_row * static_cast<std::size_t>(rect.height));
+  auto* dst = texels.mutableData();
+  const auto* src = levels_[tile.level].data() + static_cast<std::size_t>(rect.y) * level_row +
+                    static_cast<std::size_t>(rect.x) * kTexelBytes;
+  for (int row = 0; row < rect.height; ++row) {
+    std::memcpy(dst + static_cast<std::size_t>(row) * tile_row,
+                src + static_cast<std::size_t>(row) * level_row, tile_row);
+  }
+
+  PreviewImage image;
+  image.cache_key = TileKey(cache_key, tile);
+  image.pixels = std::move(texels);
+  image.layout = PixelLayout::kRgba8;
+  image.width = rect.width;
+  image.height = rect.height;
+  return image;
+}
+
+std::string TileKey(const std::string& cache_key, const TileId& tile) {
+  return cache_key + "@" + std::to_string(tile.level) + "/" + std::to_string(tile.x) + "," +
+         std::to_string(tile.y);
+}
+
+void DownsampleBox(const std::uint8_t* src, int width, int height, std::uint8_t* dst) {
+  const int out_width = (width + 1) / 2;
+  const int out_height = (height + 1) / 2;
+  const auto row_bytes = static_cast<std::size_t>(width) * kTexelBytes;
+  for (int y = 0; y < out_height; ++y) {
+    const auto* row0 = src + static_cast<std::size_t>(2 * y) * row_bytes;
+    const auto* row1 = src + static_cast<std::size_t>(std::min(2 * y + 1, height - 1)) * row_bytes;
+    auto* out = dst + static_cast<std::size_t>(y) * out_width * kTexelBytes;
+    const int done = boxRowSimd(row0, row1, width, out_width, out);
+    boxRowScalar(row0, row1, width, done, out_width, out);
+  }
+}
+
+// Separable: a horizontal pass into float rows, then a vertical pass that
+// rounds back to bytes. Taps past the edges clamp to the border pixel.
+void DownsampleLanczos3(const std::uint8_t* src, int width, int height, std::uint8_t* dst) {
+  static const auto weights = lanczosWeights();
+  const int out_width = (width + 1) / 2;
+  const int out_height = (height + 1) / 2;
+  const auto out_row = static_cast<std::size_t>(out_width) * kTexelBytes;
+
+  std::vector<float> horizontal(out_row * static_cast<std::size_t>(height));
+  for (int y = 0; y < height; ++y) {
+    const auto* row = src + static_cast<std::size_t>(y) * width * kTexelBytes;
+    auto* out = horizontal.data() + static_cast<std::size_t>(y) * out_row;
+    for (int x = 0; x < out_width; ++x) {
+      std::array<float, kTexelBytes> sum{};
+      for (int k = 0; k < kLanczosTaps; ++k) {
+        const auto* texel =
+            row + static_cast<std::size_t>(std::clamp(2 * x - 5 + k, 0, width - 1)) * kTexelBytes;
+        for (std::size_t c = 0; c < kTexelBytes; ++c) {
+          sum[c] += weights[k] * texel[c];
+        }
+      }
+      std::copy(sum.begin(), sum.end(), out + static_cast<std::size_t>(x) * kTexelBytes);
+    }
+  }
+
+  std::vector<float> column(out_row);
+  for (int y = 0; y < out_height; ++y) {
+    std::fill(column.begin(), column.end(), 0.0f);
+    for (int k = 0; k < kLanczosTaps; ++k) {
+      const auto* row = horizontal.data() +
+                        static_cast<std::size_t>(std::clamp(2 * y - 5 + k, 0, height - 1)) * out_row;
+      for (std::size_t i = 0; i < out_row; ++i) {
+        column[i] += weights[k] * row[i];
+      }
+    }
+    auto* out = dst + static_cast<std::size_t>(y) * out_row;
+    for (std::size_t i = 0; i < out_row; ++i) {
+      out[i] = static_cast<std::uint8_t>(std::clamp(std::lround(column[i]), 0L, 255L));
+    }
+  }
+}
+
+}  // namespace cataloger::services::preview
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "PixelBuffer.h"
+#include "PreviewTypes.h"
+
+namespace cataloger::services::preview {
+
+// Side of a square texture tile in texels. Edge tiles are cropped to the
+// level bounds rather than padded.
+inline constexpr int kTileSize = 256;
+
+struct TileId {
+  int level{0};
+  int x{0};
+  int y{0};
+
+  friend bool operator==(const TileId&, const TileId&) = default;
+};
+
+struct TileRect {
+  int x{0};
+  int y{0};
+  int width{0};
+  int height{0};
+};
+
+// Part of the image on screen, in level-0 pixels. `scale` is display
+// pixels per level-0 pixel: 1.0 is 1:1, 0.25 a fit view of an image four
+// times wider than the window.
+struct Viewport {
+  double x{0.0};
+  double y{0.0};
+  double width{0.0};
+  double height{0.0};
+  double scale{1.0};
+};
+
+enum class MipFilter { kBox, kLanczos3 };
+
+// Level sizes and tile layout of a mip pyramid. Pure geometry, so a view
+// can be planned (and its upload cost known) before anything is built.
+// Each level halves the previous one, rounding up, until the whole level
+// fits in a single tile.
+class TileGrid {
+public:
+  TileGrid(int width, int height);
+
+  [[nodiscard]] int levelCount() const noexcept { return static_cast<int>(levels_.size()); }
+  [[nodiscard]] int levelWidth(int level) const { return levels_[level].first; }
+  [[nodiscard]] int levelHeight(int level) const { return levels_[level].second; }
+  [[nodiscard]] int tilesX(int level) const;
+  [[nodiscard]] int tilesY(int level) const;
+  [[nodiscard]] TileRect tileRect(const TileId& tile) const;
+  // RGBA8 bytes of one tile, or of a whole level.
+  [[nodiscard]] std::size_t tileBytes(const TileId& tile) const;
+  [[nodiscard]] std::size_t levelBytes(int level) const;
+
+  // Coarsest level that still has at least one texel per display pixel.
+  [[nodiscard]] int levelForScale(double scale) const;
+  // Tiles of levelForScale(view.scale) that intersect the view, row-major.
+  [[nodiscard]] std::vector<TileId> visibleTiles(const Viewport& view) const;
+
+private:
+  std::vector<std::pair<int, int>> levels_;
+};
+
+// RGBA8 mip chain of a decoded preview. Level 0 is the preview itself.
+class MipPyramid {
+public:
+  // Builds every level of `image` (RGB8 or RGBA8). Missing source rows are
+  // filled opaque white, as the GPU bridges do for short buffers.
+  static MipPyramid Build(const PreviewImage& image, MipFilter filter = MipFilter::kBox);
+
+  [[nodiscard]] const TileGrid& grid() const noexcept { return grid_; }
+  [[nodiscard]] const PixelBuffer& level(int index) const { return levels_[index]; }
+
+  // A whole level as an RGBA8 image under `cache_key`.
+  [[nodiscard]] PreviewImage levelImage(const std::string& cache_key, int level) const;
+  // One tile copied out as an RGBA8 image keyed by TileKey(cache_key, tile).
+  [[nodiscard]] PreviewImage tileImage(const std::string& cache_key, const TileId& tile) const;
+
+private:
+  explicit MipPyramid(TileGrid grid) : grid_(std::move(grid)) {}
+
+  TileGrid grid_;
+  std::vector<PixelBuffer> levels_;
+};
+
+// Texture key of a tile; distinct from the whole-preview key so both can
+// be resident at once.
+[[nodiscard]] std::string TileKey(const std::string& cache_key, const TileId& tile);
+
+// 2:1 reductions of tightly packed RGBA8 into ceil(width/2) x ceil(height/2).
+// An odd last row or column is paired with itself.
+void DownsampleBox(const std::uint8_t* src, int width, int height, std::uint8_t* dst);
+void DownsampleLanczos3(const std::uint8_t* src, int width, int height, std::uint8_t* dst);
+
+}  // namespace cataloger::services::preview
@@ -0,0 +1,81 @@
+#include "NavigationTracker.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace cataloger::services::preview {
+
+NavigationTracker::State NavigationTracker::record(int root_id,
+                                                   std::size_t index,
+                                                   Clock::time_point now) {
+  std::lock_guard lock(mutex_);
+  if (root_id != root_id_) {
+    history_.clear();
+    root_id_ = root_id;
+  }
+  if (!history_.empty()) {
+    const auto last = history_.back().index;
+    const auto step = index > last ? index - last : last - index;
+    if (step > kMaxStep) {
+      history_.clear();
+    }
+  }
+  history_.push_back({index, now});
+  while (history_.size() > kHistory ||
+         (history_.size() > 2 && now - history_.front().at > kVelocityHorizon)) {
+    history_.pop_front();
+  }
+  state_ = evaluate(root_id);
+  return state_;
+}
+
+NavigationTracker::State NavigationTracker::current() const {
+  std::lock_guard lock(mutex_);
+  return state_;
+}
+
+void NavigationTracker::reset() {
+  std::lock_guard lock(mutex_);
+  history_.clear();
+  root_id_ = -1;
+  state_ = {};
+}
+
+NavigationTracker::State NavigationTracker::evaluate(int root_id) const {
+  State state;
+  state.root_id = root_id;
+  state.index = history_.back().index;
+  if (history_.size() < 2) {
+    return state;
+  }
+
+  // Majority vote over the steps so one accidental back-tap does not flip
+  // direction mid-run.
+  int forward = 0;
+  int backward = 0;
+  for (std::size_t i = 1; i < history_.size(); ++i) {
+    if (history_[i].index > history_[i - 1].index) {
+      ++forward;
+    } else if (history_[i].index < history_[i - 1].index) {
+      ++backward;
+    }
+  }
+  if (forward > backward) {
+    state.direction = 1;
+  } else if (backward > forward) {
+    state.direction = -1;
+  }
+
+  const auto span = std::chrono::duration<double>(history_.back().at -
+                                                  history_.front().at)
+                        .count();
+  if (state.direction != 0 && span > 0.0) {
+    const auto travelled = static_cast<double>(
+        static_cast<std::int64_t>(history_.back().index) -
+        static_cast<std::int64_t>(history_.front().index));
+    state.velocity = std::max(0.0, travelled * state.direction / span);
+  }
+  return state;
+}
+
+}  // namespace cataloger::services::preview
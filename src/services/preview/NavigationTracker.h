@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace cataloger::services::preview {
+
+// Direction and speed of the user's walk through a root, derived from the
+// recent requestPreview indices. Large jumps (search results, clicking a
+// far thumbnail) restart the history instead of counting as velocity.
+class NavigationTracker {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct State {
+    int root_id{-1};
+    std::size_t index{0};
+    int direction{0};       // -1 backward, 0 unknown/random, +1 forward
+    double velocity{0.0};   // images per second along `direction`
+  };
+
+  State record(int root_id, std::size_t index, Clock::time_point now = Clock::now());
+  [[nodiscard]] State current() const;
+  void reset();
+
+  static constexpr std::size_t kHistory = 8;
+  static constexpr std::size_t kMaxStep = 8;
+  static constexpr std::chrono::milliseconds kVelocityHorizon{2000};
+
+private:
+  struct Sample {
+    std::size_t index;
+    Clock::time_point at;
+  };
+
+  State evaluate(int root_id) const;
+
+  mutable std::mutex mutex_;
+  int root_id_{-1};
+  std::deque<Sample> history_;
+  State state_;
+};
+
+}  // namespace cataloger::services::preview
@@ -0,0 +1,310 @@
+#include "PixelBuffer.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace cataloger::services::preview {
+
+namespace {
+
+// Quarter-power-of-two classes from 4 KB to 64 MB keep slack under 25%.
+constexpr std::size_t kMinShift = 12;
+constexpr std::size_t kMaxShift = 26;
+constexpr std::size_t kClassCount = (kMaxShift - kMinShift) * 4 + 1;
+constexpr std::uint32_t kUnpooled = 0xFFFFFFFFu;
+constexpr std::size_t kHeaderSize = PixelBufferPool::kBlockHeaderSize;
+constexpr std::align_val_t kAlignment{64};
+constexpr std::size_t kDefaultRetainLimit = 256u * 1024 * 1024;
+constexpr std::size_t kThreadSlots = 4;
+constexpr std::size_t kThreadCacheBytes = 32u * 1024 * 1024;
+
+std::size_t classCapacity(std::size_t size_class) {
+  const auto shift = kMinShift + size_class / 4;
+  const auto sub = size_class % 4;
+  return (std::size_t{1} << shift) + sub * (std::size_t{1} << (shift - 2));
+}
+
+std::uint32_t classFor(std::size_t bytes) {
+  if (bytes <= (std::size_t{1} << kMinShift)) {
+    return 0;
+  }
+  if (bytes > (std::size_t{1} << kMaxShift)) {
+    return kUnpooled;
+  }
+  auto shift = static_cast<std::size_t>(std::bit_width(bytes - 1)) - 1;
+  const auto base = std::size_t{1} << shift;
+  const auto step = base / 4;
+  auto sub = (bytes - base + step - 1) / step;
+  if (sub == 4) {
+    ++shift;
+    sub = 0;
+  }
+  return static_cast<std::uint32_t>((shift - kMinShift) * 4 + sub);
+}
+
+}  // namespace
+
+struct PixelBufferPool::Block {
+  std::atomic<std::uint32_t> refs{1};
+  std::uint32_t size_class{kUnpooled};
+  std::size_t capacity{0};
+
+  std::uint8_t* bytes() noexcept {
+    return reinterpret_cast<std::uint8_t*>(this) + kHeaderSize;
+  }
+};
+
+static_assert(sizeof(PixelBufferPool::Block) <= kHeaderSize);
+
+namespace {
+
+PixelBufferPool::Block* allocateBlock(std::uint32_t size_class, std::size_t capacity) {
+  void* memory = ::operator new(kHeaderSize + capacity, kAlignment);
+  auto* block = new (memory) PixelBufferPool::Block();
+  block->size_class = size_class;
+  block->capacity = capacity;
+  return block;
+}
+
+void freeBlock(PixelBufferPool::Block* block) noexcept {
+  block->~Block();
+  ::operator delete(static_cast<void*>(block), kAlignment);
+}
+
+}  // namespace
+
+struct ThreadCache {
+  std::array<std::array<PixelBufferPool::Block*, kThreadSlots>, kClassCount> slots{};
+  std::array<std::uint8_t, kClassCount> counts{};
+  std::size_t bytes{0};
+
+  PixelBufferPool::Block* take(std::uint32_t size_class) {
+    auto& count = counts[size_class];
+    if (count == 0) {
+      return nullptr;
+    }
+    auto* block = slots[size_class][--count];
+    bytes -= block->capacity;
+    return block;
+  }
+
+  bool put(PixelBufferPool::Block* block) {
+    auto& count = counts[block->size_class];
+    if (count == kThreadSlots || bytes + block->capacity > kThreadCacheBytes) {
+      return false;
+    }
+    slots[block->size_class][count++] = block;
+    bytes += block->capacity;
+    return true;
+  }
+
+  ~ThreadCache() {
+    auto& pool = PixelBufferPool::Shared();
+    for (std::size_t c = 0; c < kClassCount; ++c) {
+      while (auto* block = take(static_cast<std::uint32_t>(c))) {
+        pool.releaseToGlobal(block);
+      }
+    }
+  }
+};
+
+namespace {
+
+thread_local ThreadCache tls_cache;
+
+}  // namespace
+
+PixelBufferPool& PixelBufferPool::Shared() {
+  // Intentionally leaked so thread caches can drain into it during exit.
+  static auto* pool = new PixelBufferPool();
+  return *pool;
+}
+
+PixelBufferPool::PixelBufferPool()
+    : free_lists_(kClassCount), retain_limit_(kDefaultRetainLimit) {
+  for (auto& list : free_lists_) {
+    list.reserve(16);
+  }
+}
+
+PixelBufferPool::Block* PixelBufferPool::acquire(std::size_t bytes) {
+  const auto size_class = classFor(bytes);
+  if (size_class == kUnpooled) {
+    heap_allocations_.fetch_add(1, std::memory_order_relaxed);
+    return allocateBlock(kUnpooled, bytes);
+  }
+
+  Block* block = tls_cache.take(size_class);
+  if (!block) {
+    std::lock_guard lock(mutex_);
+    auto& list = free_lists_[size_class];
+    if (!list.empty()) {
+      block = list.back();
+      list.pop_back();
+      retained_bytes_ -= block->capacity;
+    }
+  }
+  if (block) {
+    reused_blocks_.fetch_add(1, std::memory_order_relaxed);
+    block->refs.store(1, std::memory_order_relaxed);
+    return block;
+  }
+
+  heap_allocations_.fetch_add(1, std::memory_order_relaxed);
+  return allocateBlock(size_class, classCapacity(size_class));
+}
+
+void PixelBufferPool::release(Block* block) noexcept {
+  if (block->size_class == kUnpooled) {
+    freeBlock(block);
+    return;
+  }
+  if (tls_cache.put(block)) {
+    return;
+  }
+  releaseToGlobal(block);
+}
+
+void PixelBufferPool::releaseToGlobal(Block* block) noexcept {
+  {
+    std::lock_guard lock(mutex_);
+    if (retained_bytes_ + block->capacity <= retain_limit_) {
+      auto& list = free_lists_[block->size_class];
+      if (list.size() < list.capacity()) {
+        list.push_back(block);
+        retained_bytes_ += block->capacity;
+        return;
+      }
+    }
+  }
+  freeBlock(block);
+}
+
+void PixelBufferPool::setRetainLimit(std::size_t bytes) {
+  std::lock_guard lock(mutex_);
+  retain_limit_ = bytes;
+}
+
+PixelBufferPool::Stats PixelBufferPool::stats() const {
+  Stats stats;
+  stats.heap_allocations = heap_allocations_.load(std::memory_order_relaxed);
+  stats.reused_blocks = reused_blocks_.load(std::memory_order_relaxed);
+  std::lock_guard lock(mutex_);
+  stats.retained_bytes = retained_bytes_;
+  return stats;
+}
+
+void PixelBufferPool::trim() {
+  std::vector<Block*> doomed;
+  {
+    std::lock_guard lock(mutex_);
+    for (auto& list : free_lists_) {
+      doomed.insert(doomed.end(), list.begin(), list.end());
+      list.clear();
+    }
+    retained_bytes_ = 0;
+  }
+  for (auto* block : doomed) {
+    freeBlock(block);
+  }
+}
+
+std::size_t PixelBufferPool::CapacityFor(std::size_t bytes) {
+  const auto size_class = classFor(bytes);
+  return size_class == kUnpooled ? bytes : classCapacity(size_class);
+}
+
+PixelBuffer::PixelBuffer(std::size_t size) : size_(size) {
+  if (size_ > 0) {
+    block_ = PixelBufferPool::Shared().acquire(size_);
+  }
+}
+
+PixelBuffer::PixelBuffer(const std::uint8_t* data, std::size_t size)
+    : PixelBuffer(size) {
+  if (size_ > 0) {
+    std::memcpy(block_->bytes(), data, size_);
+  }
+}
+
+PixelBuffer::PixelBuffer(const PixelBuffer& other) noexcept
+    : block_(other.block_), size_(other.size_) {
+  if (block_) {
+    block_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+PixelBuffer::PixelBuffer(PixelBuffer&& other) noexcept
+    : block_(std::exchange(other.block_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+PixelBuffer& PixelBuffer::operator=(const PixelBuffer& other) noexcept {
+  if (this != &other) {
+    PixelBuffer copy(other);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+PixelBuffer& PixelBuffer::operator=(PixelBuffer&& other) noexcept {
+  if (this != &other) {
+    clear();
+    block_ = std::exchange(other.block_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+PixelBuffer::~PixelBuffer() {
+  clear();
+}
+
+std::size_t PixelBuffer::capacity() const noexcept {
+  return block_ ? block_->capacity : 0;
+}
+
+bool PixelBuffer::shared() const noexcept {
+  return block_ && block_->refs.load(std::memory_order_acquire) > 1;
+}
+
+std::uint8_t* PixelBuffer::mutableData() {
+  if (shared()) {
+    reallocate(size_, size_);
+  }
+  return block_ ? block_->bytes() : nullptr;
+}
+
+void PixelBuffer::resize(std::size_t new_size) {
+  if (new_size == 0) {
+    clear();
+    return;
+  }
+  if (!block_ || shared() || new_size > block_->capacity) {
+    reallocate(new_size, std::min(size_, new_size));
+  }
+  size_ = new_size;
+}
+
+void PixelBuffer::clear() noexcept {
+  if (block_ && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    PixelBufferPool::Shared().release(block_);
+  }
+  block_ = nullptr;
+  size_ = 0;
+}
+
+void PixelBuffer::reallocate(std::size_t new_size, std::size_t keep) {
+  auto* fresh = PixelBufferPool::Shared().acquire(new_size);
+  if (keep > 0 && block_) {
+    std::memcpy(fresh->bytes(), block_->bytes(), keep);
+  }
+  clear();
+  block_ = fresh;
+  size_ = new_size;
+}
+
+}  // namespace cataloger::services::preview
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace cataloger::services::preview {
+
+// Size-classed allocator for preview pixel/byte buffers. Freed blocks are
+// kept in a small per-thread cache first and a bounded global free list
+// second, so steady-state preview traffic recycles memory instead of going
+// back to the heap (and taking fresh page faults) for every image.
+class PixelBufferPool {
+public:
+  struct Block;
+
+  struct Stats {
+    std::size_t heap_allocations{0};  // blocks obtained from operator new
+    std::size_t reused_blocks{0};     // blocks served from a free list
+    std::size_t retained_bytes{0};    // bytes parked in the global free lists
+  };
+
+  static PixelBufferPool& Shared();
+
+  Block* acquire(std::size_t bytes);
+  void release(Block* block) noexcept;
+
+  void setRetainLimit(std::size_t bytes);
+  [[nodiscard]] Stats stats() const;
+  // Returns every globally retained block to the heap.
+  void trim();
+
+  static std::size_t CapacityFor(std::size_t bytes);
+
+  // Bytes reserved in front of every block's payload for the refcount and
+  // size class; keeps the payload cache-line aligned.
+  static constexpr std::size_t kBlockHeaderSize = 64;
+
+private:
+  PixelBufferPool();
+
+  friend struct ThreadCache;
+  void releaseToGlobal(Block* block) noexcept;
+
+  mutable std::mutex mutex_;
+  std::vector<std::vector<Block*>> free_lists_;
+  std::size_t retained_bytes_{0};
+  std::size_t retain_limit_;
+  std::atomic<std::size_t> heap_allocations_{0};
+  std::atomic<std::size_t> reused_blocks_{0};
+};
+
+// Reference-counted handle to a pooled block with value (copy-on-write)
+// semantics: copies share the bytes, writers detach first, and the last
+// handle returns the block to the pool.
+class PixelBuffer {
+public:
+  PixelBuffer() noexcept = default;
+  // Allocates `size` bytes; contents are uninitialized.
+  explicit PixelBuffer(std::size_t size);
+  PixelBuffer(const std::uint8_t* data, std::size_t size);
+  PixelBuffer(const PixelBuffer& other) noexcept;
+  PixelBuffer(PixelBuffer&& other) noexcept;
+  PixelBuffer& operator=(const PixelBuffer& other) noexcept;
+  PixelBuffer& operator=(PixelBuffer&& other) noexcept;
+  ~PixelBuffer();
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] std::size_t capacity() const noexcept;
+  [[nodiscard]] bool shared() const noexcept;
+
+  // Inline so code outside the preview library (e.g. GPU bridges) can read
+  // pixels without a link-time dependency on it.
+  [[nodiscard]] const std::uint8_t* data() const noexcept {
+    return block_ ? reinterpret_cast<const std::uint8_t*>(block_) +
+                        PixelBufferPool::kBlockHeaderSize
+                  : nullptr;
+  }
+  // Detaches from other handles before handing out write access.
+  std::uint8_t* mutableData();
+
+  // Keeps the first min(size, new_size) bytes; new bytes are uninitialized.
+  void resize(std::size_t new_size);
+  void clear() noexcept;
+
+  [[nodiscard]] const std::uint8_t* begin() const noexcept { return data(); }
+  [[nodiscard]] const std::uint8_t* end() const noexcept { return data() + size_; }
+  [[nodiscard]] std::uint8_t operator[](std::size_t index) const noexcept {
+    return data()[index];
+  }
+  operator std::span<const std::uint8_t>() const noexcept { return {data(), size_}; }
+
+private:
+  void reallocate(std::size_t new_size, std::size_t keep);
+
+  PixelBufferPool::Block* block_{nullptr};
+  std::size_t size_{0};
+};
+
+}  // namespace cataloger::services::preview
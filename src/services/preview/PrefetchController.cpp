@@ -0,0 +1,62 @@
+#include "PrefetchController.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cataloger::services::preview {
+
+PrefetchController::PrefetchController(std::size_t base_window)
+    : base_window_(base_window) {}
+
+void PrefetchController::setBaseWindow(std::size_t window) {
+  std::lock_guard lock(mutex_);
+  base_window_ = window;
+  boost_ = 0;
+}
+
+std::size_t PrefetchController::baseWindow() const {
+  std::lock_guard lock(mutex_);
+  return base_window_;
+}
+
+PrefetchPlan PrefetchController::plan(const NavigationTracker::State& navigation,
+                                      bool anchor_hit,
+                                      double ready_latency_ms,
+                                      std::size_t cache_capacity) {
+  std::lock_guard lock(mutex_);
+  PrefetchPlan plan;
+  if (base_window_ == 0) {
+    return plan;  // prefetch disabled
+  }
+
+  if (anchor_hit) {
+    if (++hit_streak_ % kHitsPerShrink == 0 && boost_ > 0) {
+      --boost_;
+    }
+  } else if (navigation.direction != 0) {
+    // Only misses on a steady walk say the window is too short; misses
+    // after a jump say nothing about it.
+    hit_streak_ = 0;
+    boost_ = std::min(boost_ + 1, kMaxBoost);
+  }
+
+  if (navigation.direction == 0) {
+    plan.ahead = base_window_;
+    plan.behind = base_window_;
+  } else {
+    plan.direction = navigation.direction;
+    const auto lead_seconds =
+        std::max(ready_latency_ms, kMinLatencyMs) * kLeadMargin / 1000.0;
+    const auto travel =
+        static_cast<std::size_t>(std::ceil(navigation.velocity * lead_seconds));
+    plan.ahead = std::max(base_window_, travel + 1) + boost_;
+    plan.behind = 1;
+  }
+
+  const auto budget = std::max<std::size_t>(2, cache_capacity / 2);
+  plan.behind = std::min(plan.behind, budget / 2);
+  plan.ahead = std::min({plan.ahead, budget - plan.behind, kMaxAhead});
+  return plan;
+}
+
+}  // namespace cataloger::services::preview
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+
+#include "NavigationTracker.h"
+
+namespace cataloger::services::preview {
+
+// Neighbour window to decode around a requested preview. `ahead` runs in
+// `direction`, `behind` the opposite way.
+struct PrefetchPlan {
+  int direction{1};
+  std::size_t ahead{0};
+  std::size_t behind{0};
+};
+
+// Sizes the decode-ahead window from how the user is moving. With no
+// direction yet the window is the symmetric base set by primeCaches(). Once
+// there is a direction, the window reaches far enough ahead to cover the
+// pipeline latency at the observed speed. Each miss on a requested preview
+// widens it until hits come back. The backward side shrinks to a single
+// image, and the total never exceeds half the RAM cache, so prefetching
+// cannot evict what the user just looked at.
+class PrefetchController {
+public:
+  explicit PrefetchController(std::size_t base_window = 2);
+
+  void setBaseWindow(std::size_t window);
+  [[nodiscard]] std::size_t baseWindow() const;
+
+  // `anchor_hit` says whether the requested preview was already cached;
+  // `ready_latency_ms` is how long a miss currently takes to become ready.
+  PrefetchPlan plan(const NavigationTracker::State& navigation,
+                    bool anchor_hit,
+                    double ready_latency_ms,
+                    std::size_t cache_capacity);
+
+  static constexpr std::size_t kMaxAhead = 32;
+  // Lead time is the latency times this margin, so a fresh job is ready
+  // a little before the user reaches it.
+  static constexpr double kLeadMargin = 1.5;
+  static constexpr double kMinLatencyMs = 50.0;
+  static constexpr std::size_t kHitsPerShrink = 4;
+  static constexpr std::size_t kMaxBoost = 8;
+
+private:
+  mutable std::mutex mutex_;
+  std::size_t base_window_;
+  std::size_t boost_{0};
+  std::size_t hit_streak_{0};
+};
+
+}  // namespace cataloger::services::preview
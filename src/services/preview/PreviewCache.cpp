@@ -38,14 +38,33 @@ std::optional<PreviewImage> PreviewCache::LruCache::get(
   return it->second.first;
 }
 
+bool PreviewCache::LruCache::contains(const std::string& key) const {
+  return entries_.contains(key);
+}
+
+bool PreviewCache::LruCache::erase(const std::string& key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  order_.erase(it->second.second);
+  entries_.erase(it);
+  return true;
+}
+
 std::size_t PreviewCache::LruCache::size() const {
   return entries_.size();
 }
 
+std::size_t PreviewCache::LruCache::capacity() const {
+  return capacity_;
+}
+
 PreviewCache::PreviewCache(std::size_t ram_capacity, std::size_t preload_capacity)
     : ram_cache_(ram_capacity), preload_cache_(preload_capacity) {}
 
 void PreviewCache::put(const PreviewImage& image, CacheTier tier) {
+  std::lock_guard lock(mutex_);
   if (tier == CacheTier::kRam) {
     ram_cache_.store(image);
   } else {
@@ -54,17 +73,37 @@ void PreviewCache::put(const PreviewImage& image, CacheTier tier) {
 }
 
 std::optional<PreviewImage> PreviewCache::get(const std::string& key) const {
+  std::lock_guard lock(mutex_);
   if (auto ram = ram_cache_.get(key)) {
     return ram;
   }
   return preload_cache_.get(key);
 }
 
+bool PreviewCache::contains(const std::string& key) const {
+  std::lock_guard lock(mutex_);
+  return ram_cache_.contains(key) || preload_cache_.contains(key);
+}
+
+bool PreviewCache::erase(const std::string& key) {
+  std::lock_guard lock(mutex_);
+  const bool in_ram = ram_cache_.erase(key);
+  const bool preloaded = preload_cache_.erase(key);
+  return in_ram || preloaded;
+}
+
 std::size_t PreviewCache::ramSize() const {
+  std::lock_guard lock(mutex_);
   return ram_cache_.size();
 }
 
+std::size_t PreviewCache::ramCapacity() const {
+  std::lock_guard lock(mutex_);
+  return ram_cache_.capacity();
+}
+
 std::size_t PreviewCache::preloadSize() const {
+  std::lock_guard lock(mutex_);
   return preload_cache_.size();
 }
 
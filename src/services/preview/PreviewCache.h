@@ -1,6 +1,7 @@
 #pragma once
 
 #include <list>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -15,7 +16,12 @@ public:
 
   void put(const PreviewImage& image, CacheTier tier);
   [[nodiscard]] std::optional<PreviewImage> get(const std::string& key) const;
+  // Membership test that leaves the LRU order alone.
+  [[nodiscard]] bool contains(const std::string& key) const;
+  // Drops `key` from both tiers; false when neither held it.
+  bool erase(const std::string& key);
   [[nodiscard]] std::size_t ramSize() const;
+  [[nodiscard]] std::size_t ramCapacity() const;
   [[nodiscard]] std::size_t preloadSize() const;
 
 private:
@@ -25,7 +31,10 @@ private:
 
     void store(const PreviewImage& image);
     [[nodiscard]] std::optional<PreviewImage> get(const std::string& key) const;
+    [[nodiscard]] bool contains(const std::string& key) const;
+    bool erase(const std::string& key);
     [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] std::size_t capacity() const;
 
   private:
     std::size_t capacity_;
@@ -35,6 +44,8 @@ private:
         entries_;
   };
 
+  // Stage workers read and fill the cache concurrently.
+  mutable std::mutex mutex_;
   LruCache ram_cache_;
   LruCache preload_cache_;
 };
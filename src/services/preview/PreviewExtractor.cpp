@@ -1,12 +1,46 @@
 #include "PreviewExtractor.h"
 
 #include <algorithm>
-#include <fstream>
+#include <array>
+#include <optional>
+
+#include "JpegSegmentIndex.h"
+#include "RawContainer.h"
+#include "TiffReader.h"
 
 namespace cataloger::services::preview {
 
 namespace {
-constexpr std::size_t kMaxReadBytes = 256 * 1024;
+constexpr std::size_t kMaxReadBytes = PreviewExtractor::kLeadingBytes;
+
+// Serves reads from an already-fetched file prefix and only opens the file
+// for the rare IFD that lives past it.
+class PrefixSource : public tiff::ByteSource {
+public:
+  PrefixSource(std::span<const std::uint8_t> prefix,
+               std::uint64_t size,
+               const std::filesystem::path& path)
+      : prefix_(prefix), size_(size), path_(path) {}
+
+  bool read(std::uint64_t offset, std::size_t length, std::uint8_t* out) const override {
+    if (offset <= prefix_.size() && length <= prefix_.size() - offset) {
+      std::copy_n(prefix_.begin() + static_cast<std::ptrdiff_t>(offset), length, out);
+      return true;
+    }
+    if (!file_) {
+      file_.emplace(path_);
+    }
+    return file_->isOpen() && file_->read(offset, length, out);
+  }
+
+  [[nodiscard]] std::uint64_t size() const override { return size_; }
+
+private:
+  std::span<const std::uint8_t> prefix_;
+  std::uint64_t size_;
+  const std::filesystem::path& path_;
+  mutable std::optional<tiff::FileSource> file_;
+};
 
 int pseudoDimension(std::uintmax_t file_size, int base) {
   const auto span = static_cast<int>(file_size % 2048);
@@ -15,34 +49,175 @@ int pseudoDimension(std::uintmax_t file_size, int base) {
 
 }  // namespace
 
-PreviewImage PreviewExtractor::extract(const PreviewDescriptor& descriptor) const {
-  return readPreviewBytes(descriptor);
+PreviewImage PreviewExtractor::extract(const PreviewDescriptor& descriptor,
+                                       ContainerMetadata* metadata) const {
+  return readPreviewBytes(descriptor, metadata);
 }
 
 PreviewImage PreviewExtractor::readPreviewBytes(
-    const PreviewDescriptor& descriptor) {
+    const PreviewDescriptor& descriptor,
+    ContainerMetadata* metadata) {
   PreviewImage image;
   image.cache_key = descriptor.cacheKey();
   image.source_path = descriptor.absolute_path;
 
-  std::ifstream stream(descriptor.absolute_path, std::ios::binary);
-  if (!stream) {
-    image.pixels = {0};
-  } else {
-    std::vector<std::uint8_t> data;
-    data.resize(kMaxReadBytes);
-    stream.read(reinterpret_cast<char*>(data.data()), kMaxReadBytes);
-    const auto read_bytes = static_cast<std::size_t>(stream.gcount());
-    data.resize(read_bytes);
-    if (data.empty()) {
-      data.push_back(0);
+  PixelBuffer data;
+  jpeg::SegmentIndex index;
+  ContainerMetadata scratch;
+  auto& container = metadata ? *metadata : scratch;
+  image.capture_ts = descriptor.capture_ts;
+
+  const tiff::FileSource source(descriptor.absolute_path);
+  if (source.isOpen()) {
+    std::array<std::uint8_t, 2> soi{};
+    const bool bare_jpeg = source.read(0, soi.size(), soi.data()) &&
+                           soi[0] == 0xFF && soi[1] == 0xD8;
+    std::optional<raw::ByteRange> preview_range;
+    if (!bare_jpeg) {
+      // Locate the camera preview inside a RAW container.
+      auto raw_info = raw::Inspect(source, false);
+      container.icc_profile = std::move(raw_info.icc_profile);
+      image.orientation = raw_info.orientation;
+      image.capture_ts = raw_info.capture_ts.value_or(image.capture_ts);
+      preview_range = raw_info.preview;
     }
-    image.pixels = std::move(data);
+    const auto range = preview_range.value_or(raw::ByteRange{0, source.size()});
+    index = jpeg::ReadHeader(source, range.offset, range.length, data, kMaxReadBytes);
+    container.preview_offset = range.offset;
+    container.preview_length = range.length;
+    container.icc_scanned = true;
   }
 
-  image.width = pseudoDimension(descriptor.file_size, 512);
-  image.height = pseudoDimension(descriptor.file_size / 2, 256);
+  finishImage(descriptor, image, std::move(data), index, container);
   return image;
 }
 
+void PreviewExtractor::finishImage(const PreviewDescriptor& descriptor,
+                                   PreviewImage& image,
+                                   PixelBuffer data,
+                                   const jpeg::SegmentIndex& index,
+                                   ContainerMetadata& container) {
+  if (index.valid) {
+    const auto exif = jpeg::ParseExif(data, index);
+    if (!index.app1.empty() && exif.orientation != 1) {
+      image.orientation = exif.orientation;
+    }
+    image.capture_ts = exif.capture_ts.value_or(image.capture_ts);
+    if (container.icc_profile.empty()) {
+      container.icc_profile = jpeg::AssembleIccProfile(data, index);
+    }
+  }
+
+  if (data.empty()) {
+    data.resize(1);
+    data.mutableData()[0] = 0;
+  }
+  image.pixels = std::move(data);
+
+  if (index.width > 0 && index.height > 0) {
+    image.width = index.width;
+    image.height = index.height;
+  } else {
+    image.width = pseudoDimension(descriptor.file_size, 512);
+    image.height = pseudoDimension(descriptor.file_size / 2, 256);
+  }
+}
+
+std::vector<PreviewImage> PreviewExtractor::extractBatch(
+    platform::io::BatchReader& reader,
+    std::span<const PreviewDescriptor> descriptors,
+    std::vector<ContainerMetadata>& metadata) const {
+  const auto count = descriptors.size();
+  metadata.assign(count, ContainerMetadata{});
+  std::vector<PreviewImage> images(count);
+  std::vector<platform::io::FileHandle> files;
+  files.reserve(count);
+  std::vector<PixelBuffer> buffers(count);
+  std::vector<platform::io::ReadRequest> requests;
+  std::vector<std::size_t> owners;
+
+  auto collect = [&](const std::vector<platform::io::ReadResult>& results) {
+    for (std::size_t r = 0; r < owners.size(); ++r) {
+      buffers[owners[r]].resize(results[r].error == 0 ? results[r].bytes_read : 0);
+    }
+    requests.clear();
+    owners.clear();
+  };
+
+  // Batch 1: the leading bytes of every file. For JPEGs that is the header;
+  // for RAW containers it covers the TIFF IFDs in the common layouts.
+  for (std::size_t i = 0; i < count; ++i) {
+    auto& image = images[i];
+    image.cache_key = descriptors[i].cacheKey();
+    image.source_path = descriptors[i].absolute_path;
+    image.capture_ts = descriptors[i].capture_ts;
+    const auto& file = files.emplace_back(descriptors[i].absolute_path);
+    if (!file.isOpen() || file.size() == 0) {
+      continue;
+    }
+    const auto leading =
+        static_cast<std::size_t>(std::min<std::uint64_t>(file.size(), kMaxReadBytes));
+    buffers[i] = PixelBuffer(leading);
+    if (const auto& head = descriptors[i].head; head && head->size() >= leading) {
+      std::copy_n(head->data(), leading, buffers[i].mutableData());
+      continue;
+    }
+    requests.push_back({file.fd(), 0, {buffers[i].mutableData(), buffers[i].size()}});
+    owners.push_back(i);
+  }
+  collect(reader.readBatch(requests));
+
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto& file = files[i];
+    auto& container = metadata[i];
+    auto& buffer = buffers[i];
+    if (buffer.size() < 2) {
+      continue;
+    }
+    container.icc_scanned = true;
+    container.preview_length = file.size();
+    if (buffer[0] == 0xFF && buffer[1] == 0xD8) {
+      continue;
+    }
+
+    // Locate the camera preview; IFDs past the prefix are read on demand.
+    const PrefixSource source(buffer, file.size(), descriptors[i].absolute_path);
+    auto raw_info = raw::Inspect(source, false);
+    container.icc_profile = std::move(raw_info.icc_profile);
+    images[i].orientation = raw_info.orientation;
+    images[i].capture_ts = raw_info.capture_ts.value_or(images[i].capture_ts);
+    if (!raw_info.preview || raw_info.preview->offset == 0) {
+      continue;
+    }
+    container.preview_offset = raw_info.preview->offset;
+    container.preview_length = raw_info.preview->length;
+    buffer = PixelBuffer(static_cast<std::size_t>(
+        std::min<std::uint64_t>(container.preview_length, kMaxReadBytes)));
+    requests.push_back(
+        {file.fd(), container.preview_offset, {buffer.mutableData(), buffer.size()}});
+    owners.push_back(i);
+  }
+
+  // Batch 2: embedded preview JPEG headers inside RAW containers.
+  collect(reader.readBatch(requests));
+
+  for (std::size_t i = 0; i < count; ++i) {
+    auto& buffer = buffers[i];
+    auto& container = metadata[i];
+    jpeg::SegmentIndex index;
+    if (container.icc_scanned) {
+      index = jpeg::IndexSegments(buffer);
+      if (index.valid && index.truncated && buffer.size() < index.required_bytes &&
+          buffer.size() < container.preview_length) {
+        // Rare: APP segments larger than the first read (huge ICC/XMP).
+        const tiff::FileSource source(descriptors[i].absolute_path);
+        index = jpeg::ReadHeader(source, container.preview_offset,
+                                 container.preview_length, buffer, kMaxReadBytes);
+      }
+    }
+    finishImage(descriptors[i], images[i], std::move(buffer), index, container);
+  }
+  return images;
+}
+
 }  // namespace cataloger::services::preview
@@ -1,15 +1,52 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "JpegSegmentIndex.h"
 #include "PreviewTypes.h"
+#include "platform/io/BatchReader.h"
 
 namespace cataloger::services::preview {
 
+// Container metadata gathered during the same read that produced the preview
+// bytes, so later stages need not reopen the file.
+struct ContainerMetadata {
+  bool icc_scanned{false};  // true when the container was walked for ICC data
+  std::vector<std::uint8_t> icc_profile;
+  // Location of the JPEG the preview bytes came from (whole file for JPEGs).
+  std::uint64_t preview_offset{};
+  std::uint64_t preview_length{};
+};
+
 class PreviewExtractor {
 public:
-  PreviewImage extract(const PreviewDescriptor& descriptor) const;
+  // The first read of every file; PreviewDescriptor::head of at least
+  // this much (or the whole file) replaces it.
+  static constexpr std::size_t kLeadingBytes = 256 * 1024;
+
+  PreviewImage extract(const PreviewDescriptor& descriptor,
+                       ContainerMetadata* metadata = nullptr) const;
+
+  // Extracts many previews with two batched submissions: the leading bytes
+  // of every file, then the embedded JPEG headers of RAW containers. Only
+  // headers that overflow the first read fall back to per-file reads.
+  // `metadata` is resized to match `descriptors`.
+  std::vector<PreviewImage> extractBatch(
+      platform::io::BatchReader& reader,
+      std::span<const PreviewDescriptor> descriptors,
+      std::vector<ContainerMetadata>& metadata) const;
 
 private:
-  static PreviewImage readPreviewBytes(const PreviewDescriptor& descriptor);
+  static PreviewImage readPreviewBytes(const PreviewDescriptor& descriptor,
+                                       ContainerMetadata* metadata);
+  static void finishImage(const PreviewDescriptor& descriptor,
+                          PreviewImage& image,
+                          PixelBuffer data,
+                          const jpeg::SegmentIndex& index,
+                          ContainerMetadata& container);
 };
 
 }  // namespace cataloger::services::preview
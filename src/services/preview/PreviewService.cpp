@@ -3,7 +3,9 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <exception>
 #include <fstream>
+#include <iostream>
 #include <iterator>
 #include <unordered_set>
 
@@ -11,30 +13,75 @@ namespace cataloger::services::preview {
 
 namespace {
 
-std::size_t resolveWorkerCount(std::size_t requested) {
-  if (requested != 0) {
-    return requested;
-  }
+constexpr std::size_t kInitialIoWorkers = 4;
+constexpr std::size_t kMaxUnpersistedIcc = 4096;
+
+std::size_t coreCount() {
   const auto hw = std::thread::hardware_concurrency();
   return std::max<std::size_t>(2, hw == 0 ? 2 : hw);
 }
 
+// Message of the exception being handled, for a failed-preview event.
+std::string currentExceptionMessage() {
+  try {
+    throw;
+  } catch (const std::exception& error) {
+    return error.what();
+  } catch (...) {
+    return "preview stage failed";
+  }
+}
+
+StageTuner makeIoTuner(std::size_t pinned) {
+  if (pinned != 0) {
+    return StageTuner(pinned, pinned, pinned);
+  }
+  return StageTuner(1, PreviewService::kMaxIoWorkers, kInitialIoWorkers);
+}
+
+StageTuner makeCpuTuner(std::size_t pinned) {
+  if (pinned != 0) {
+    return StageTuner(pinned, pinned, pinned);
+  }
+  const auto cores = coreCount();
+  return StageTuner(1, cores, cores);
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                   start)
+      .count();
+}
+
 }  // namespace
 
 PreviewService::PreviewService(std::size_t ram_capacity,
                                std::size_t preload_capacity,
-                               std::size_t worker_count)
+                               std::size_t worker_count,
+                               tasks::TaskScheduler* scheduler)
     : catalog_service_(nullptr),
       cache_(ram_capacity, preload_capacity),
-      gpu_bridge_(cataloger::platform::gpu::CreateBridge()),
+      batch_reader_(cataloger::platform::io::CreateBatchReader()),
+      io_tuner_(makeIoTuner(worker_count)),
+      cpu_tuner_(makeCpuTuner(worker_count)),
+      scheduler_(scheduler),
       stop_(false),
-      neighbor_window_(2),
       pending_jobs_(0) {
-  const auto worker_total = resolveWorkerCount(worker_count);
-  workers_.reserve(worker_total);
-  for (std::size_t i = 0; i < worker_total; ++i) {
-    workers_.emplace_back([this](std::stop_token token) { workerLoop(token); });
+  installGpuBridge(cataloger::platform::gpu::CreateBridge());
+  // Two decoded previews per CPU worker keeps the CPU stage fed without
+  // letting the I/O stage race arbitrarily far ahead.
+  cpu_queue_capacity_ = cpu_tuner_.maxLimit() * 2;
+  if (!scheduler_) {
+    // Standalone: one worker per core, as a shared scheduler would have.
+    // The tuners already cap how many stage tasks are in flight, and
+    // reads are batched, so more workers would only oversubscribe.
+    tasks::TaskScheduler::Options options;
+    options.interactive_reserve = 0;
+    owned_scheduler_ = std::make_unique<tasks::TaskScheduler>(options);
+    scheduler_ = owned_scheduler_.get();
   }
+  preview_executor_ =
+      std::make_unique<tasks::SchedulerExecutor>(*scheduler_, tasks::Lane::kPreview);
 }
 
 PreviewService::~PreviewService() {
@@ -42,19 +89,36 @@ PreviewService::~PreviewService() {
 }
 
 void PreviewService::shutdown() {
+  std::vector<tasks::TaskHandle> stage_tasks;
   {
     std::lock_guard lock(queue_mutex_);
     stop_ = true;
+    stage_tasks.swap(stage_tasks_);
+  }
+  // Tasks that have not started are dropped; running ones see stop_ and
+  // return after their current batch or job.
+  for (auto& task : stage_tasks) {
+    task.cancel();
   }
-  queue_cv_.notify_all();
-  for (auto& worker : workers_) {
-    worker.request_stop();
+  for (const auto& task : stage_tasks) {
+    task.wait();
   }
-  workers_.clear();
+  upload_queue_.reset();  // drains uploads already handed over
+  owned_scheduler_.reset();
 }
 
 void PreviewService::setCatalogService(services::catalog::CatalogService* catalog) {
   catalog_service_ = catalog;
+  if (!catalog_service_) {
+    return;
+  }
+  for (const auto& record : catalog_service_->loadIccDiscoveries()) {
+    icc_cache_.restore(record.absolute_path,
+                       record.file_size,
+                       record.mtime,
+                       static_cast<IccSource>(record.source),
+                       record.profile_hash);
+  }
 }
 
 void PreviewService::setEventSink(CacheEventSink sink) {
@@ -63,7 +127,28 @@ void PreviewService::setEventSink(CacheEventSink sink) {
 
 void PreviewService::setGpuBridgeForTesting(
     std::unique_ptr<cataloger::platform::gpu::GpuBridge> bridge) {
+  installGpuBridge(std::move(bridge));
+}
+
+void PreviewService::installGpuBridge(
+    std::unique_ptr<cataloger::platform::gpu::GpuBridge> bridge) {
+  upload_queue_.reset();
   gpu_bridge_ = std::move(bridge);
+  {
+    std::lock_guard lock(residency_mutex_);
+    resident_files_.clear();
+  }
+  {
+    std::lock_guard lock(pyramid_mutex_);
+    for (auto& entry : pyramids_) {
+      entry.tiles.clear();
+    }
+  }
+  if (gpu_bridge_) {
+    gpu_bridge_->setEvictionHandler(
+        [this](const std::string& cache_key) { onTextureEvicted(cache_key); });
+    upload_queue_ = std::make_unique<cataloger::platform::gpu::UploadQueue>(*gpu_bridge_);
+  }
 }
 
 void PreviewService::warmRoot(int root_id, const std::filesystem::path& root_path) {
@@ -85,6 +170,12 @@ void PreviewService::warmRoot(int root_id, const std::filesystem::path& root_pat
     }
   }
 
+  // Directory iteration order is arbitrary; navigation direction and
+  // read-ahead need the browse order to be stable.
+  std::sort(descriptors.begin(), descriptors.end(),
+            [](const PreviewDescriptor& lhs, const PreviewDescriptor& rhs) {
+              return lhs.relative_path < rhs.relative_path;
+            });
   storeDescriptorCache(root_id, descriptors);
   for (const auto& descriptor : descriptors) {
     scheduleJob(descriptor);
@@ -102,48 +193,194 @@ void PreviewService::storeDescriptorCache(
   root_descriptors_[root_id] = std::move(descriptors);
 }
 
-void PreviewService::requestPreview(int root_id, const std::string& relative_path) {
+void PreviewService::publishFiles(int root_id, std::vector<PreviewDescriptor> descriptors) {
+  if (descriptors.empty()) {
+    return;
+  }
+  const auto by_path = [](const PreviewDescriptor& lhs, const PreviewDescriptor& rhs) {
+    return lhs.relative_path < rhs.relative_path;
+  };
+  {
+    std::lock_guard lock(descriptor_mutex_);
+    auto& known = root_descriptors_[root_id];
+    auto& index = descriptor_index_[root_id];
+    std::vector<PreviewDescriptor> added;
+    for (auto& descriptor : descriptors) {
+      descriptor.root_id = root_id;
+      auto stored = descriptor;
+      stored.head.reset();  // only the queued job needs the bytes
+      if (const auto it = index.find(stored.relative_path); it != index.end()) {
+        known[it->second] = std::move(stored);
+      } else {
+        added.push_back(std::move(stored));
+      }
+    }
+    if (!added.empty()) {
+      // Keep browse order. Cameras number frames in capture order, so new
+      // files usually land at the end and nothing moves.
+      std::sort(added.begin(), added.end(), by_path);
+      const auto old_size = known.size();
+      const auto first_changed = static_cast<std::size_t>(
+          std::upper_bound(known.begin(), known.end(), added.front(), by_path) - known.begin());
+      known.insert(known.end(), std::make_move_iterator(added.begin()),
+                   std::make_move_iterator(added.end()));
+      std::inplace_merge(known.begin(), known.begin() + static_cast<std::ptrdiff_t>(old_size),
+                         known.end(), by_path);
+      for (auto i = first_changed; i < known.size(); ++i) {
+        index[known[i].relative_path] = i;
+      }
+      if (first_changed < old_size && advised_root_ == root_id) {
+        advised_indices_.clear();  // positions moved
+        advised_root_ = -1;
+      }
+    }
+  }
+
+  std::lock_guard lock(queue_mutex_);
+  for (auto& descriptor : descriptors) {
+    jobs_.insert(jobs_.begin() + static_cast<std::ptrdiff_t>(priority_jobs_),
+                 std::move(descriptor));
+    ++priority_jobs_;
+    ++pending_jobs_;
+  }
+  startStageTasksLocked();
+}
+
+bool PreviewService::requestPreview(int root_id, const std::string& relative_path) {
   PreviewDescriptor descriptor;
   std::size_t anchor = 0;
   {
     std::lock_guard lock(descriptor_mutex_);
     const auto root_it = root_descriptors_.find(root_id);
     if (root_it == root_descriptors_.end()) {
-      return;
+      return false;
     }
     const auto index_it = descriptor_index_[root_id].find(relative_path);
     if (index_it == descriptor_index_[root_id].end()) {
-      return;
+      return false;
     }
     anchor = index_it->second;
     descriptor = root_it->second[anchor];
   }
 
+  const auto navigation = navigation_.record(root_id, anchor);
+  const bool anchor_hit = cache_.contains(descriptor.cacheKey());
+  if (gpu_bridge_) {
+    gpu_bridge_->touch(descriptor.cacheKey());  // on screen: evicted last
+  }
+  double ready_latency_ms = 0.0;
+  {
+    std::lock_guard lock(queue_mutex_);
+    ready_latency_ms = io_tuner_.lastLatencyMs() + cpu_tuner_.lastLatencyMs();
+  }
+  const auto plan = prefetch_.plan(navigation, anchor_hit, ready_latency_ms,
+                                   cache_.ramCapacity());
+
   scheduleJob(descriptor);
-  scheduleNeighbors(root_id, anchor);
+  scheduleNeighbors(root_id, anchor, plan);
+  scheduleReadAhead(root_id, anchor, navigation);
+  return true;
 }
 
-void PreviewService::scheduleNeighbors(int root_id, std::size_t anchor_index) {
-  if (neighbor_window_ == 0) {
-    return;
+tasks::Task<void> PreviewService::warmRootAsync(int root_id, std::filesystem::path root_path) {
+  co_await tasks::ResumeOn(*preview_executor_);
+  warmRoot(root_id, root_path);
+}
+
+tasks::Task<std::optional<PreviewImage>> PreviewService::requestPreviewAsync(
+    int root_id,
+    std::string relative_path) {
+  const auto cache_key = relative_path + "#" + std::to_string(root_id);
+  // Named rather than a temporary: GCC 12 mishandles the lifetime of
+  // non-trivial temporaries inside a co_await expression.
+  PreviewReadyAwaiter ready{this, root_id, std::move(relative_path)};
+  if (!co_await ready) {
+    co_return std::nullopt;
+  }
+  co_return cache_.get(cache_key);
+}
+
+bool PreviewService::PreviewReadyAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  // Registered before the request so a fast cache hit cannot slip past.
+  const auto cache_key = relative_path + "#" + std::to_string(root_id);
+  auto* owner = service;
+  const auto id = owner->addPreviewWaiter(cache_key, [owner, handle] {
+    owner->preview_executor_->post([handle] { handle.resume(); });
+  });
+  if (owner->requestPreview(root_id, relative_path)) {
+    return true;  // the coroutine may already be running again: touch nothing
+  }
+  if (!owner->removePreviewWaiter(cache_key, id)) {
+    return true;  // an earlier request for the same file resolved it
+  }
+  known = false;
+  return false;
+}
+
+std::uint64_t PreviewService::addPreviewWaiter(const std::string& cache_key,
+                                               std::function<void()> resume) {
+  std::lock_guard lock(waiter_mutex_);
+  const auto id = next_waiter_id_++;
+  preview_waiters_[cache_key].emplace_back(id, std::move(resume));
+  return id;
+}
+
+bool PreviewService::removePreviewWaiter(const std::string& cache_key, std::uint64_t id) {
+  std::lock_guard lock(waiter_mutex_);
+  const auto it = preview_waiters_.find(cache_key);
+  if (it == preview_waiters_.end()) {
+    return false;
+  }
+  const auto erased = std::erase_if(it->second, [&](const auto& waiter) { return waiter.first == id; });
+  if (it->second.empty()) {
+    preview_waiters_.erase(it);
+  }
+  return erased > 0;
+}
+
+void PreviewService::resolvePreviewWaiters(const std::string& cache_key) {
+  std::vector<std::pair<std::uint64_t, std::function<void()>>> waiters;
+  {
+    std::lock_guard lock(waiter_mutex_);
+    const auto it = preview_waiters_.find(cache_key);
+    if (it == preview_waiters_.end()) {
+      return;
+    }
+    waiters = std::move(it->second);
+    preview_waiters_.erase(it);
+  }
+  for (auto& waiter : waiters) {
+    waiter.second();
   }
+}
 
+void PreviewService::scheduleNeighbors(int root_id,
+                                       std::size_t anchor_index,
+                                       const PrefetchPlan& plan) {
   std::vector<PreviewDescriptor> neighbor_jobs;
   {
     std::lock_guard lock(descriptor_mutex_);
+    last_plan_ = plan;
     const auto root_it = root_descriptors_.find(root_id);
     if (root_it == root_descriptors_.end()) {
       return;
     }
-    const auto start =
-        (anchor_index > neighbor_window_) ? anchor_index - neighbor_window_ : 0;
-    const auto end =
-        std::min(root_it->second.size(), anchor_index + neighbor_window_ + 1);
-    for (std::size_t i = start; i < end; ++i) {
-      if (i == anchor_index) {
-        continue;
+    const auto& descriptors = root_it->second;
+    auto queue = [&](std::size_t distance, int sign) {
+      const auto index = static_cast<std::ptrdiff_t>(anchor_index) +
+                         static_cast<std::ptrdiff_t>(distance) * sign;
+      if (index >= 0 && index < static_cast<std::ptrdiff_t>(descriptors.size())) {
+        neighbor_jobs.push_back(descriptors[static_cast<std::size_t>(index)]);
+      }
+    };
+    // Nearest first on both sides, so the next image is decoded first.
+    for (std::size_t d = 1; d <= std::max(plan.ahead, plan.behind); ++d) {
+      if (d <= plan.ahead) {
+        queue(d, plan.direction);
+      }
+      if (d <= plan.behind) {
+        queue(d, -plan.direction);
       }
-      neighbor_jobs.push_back(root_it->second[i]);
     }
   }
 
@@ -152,8 +389,93 @@ void PreviewService::scheduleNeighbors(int root_id, std::size_t anchor_index) {
   }
 }
 
+void PreviewService::scheduleReadAhead(int root_id,
+                                       std::size_t anchor_index,
+                                       const NavigationTracker::State& navigation) {
+  const auto distance = std::clamp<std::size_t>(
+      static_cast<std::size_t>(navigation.velocity * kReadAheadSeconds),
+      kMinReadAhead,
+      kMaxReadAhead);
+  // Without a direction yet, split the budget across both sides.
+  const auto forward = navigation.direction == 0 ? distance / 2 : distance;
+  const auto backward = navigation.direction == 0 ? distance / 2 : 0;
+  const auto keep_behind = std::max<std::size_t>(prefetch_.baseWindow(), 4);
+
+  std::vector<ReadAheadHint> hints;
+  {
+    std::lock_guard lock(descriptor_mutex_);
+    const auto root_it = root_descriptors_.find(root_id);
+    if (root_it == root_descriptors_.end()) {
+      return;
+    }
+    const auto& descriptors = root_it->second;
+    if (advised_root_ != root_id) {
+      advised_indices_.clear();
+      advised_root_ = root_id;
+    }
+
+    const auto step = navigation.direction < 0 ? -1 : 1;
+    auto advise = [&](std::size_t distance_out, int sign) {
+      const auto offset = static_cast<std::ptrdiff_t>(distance_out) * sign;
+      const auto index = static_cast<std::ptrdiff_t>(anchor_index) + offset;
+      if (index < 0 || index >= static_cast<std::ptrdiff_t>(descriptors.size())) {
+        return;
+      }
+      if (advised_indices_.insert(static_cast<std::size_t>(index)).second) {
+        appendReadAheadHints(descriptors[static_cast<std::size_t>(index)], hints);
+      }
+    };
+    // Nearest first, so the files needed soonest are requested first.
+    for (std::size_t d = 1; d <= std::max(forward, backward); ++d) {
+      if (d <= forward) {
+        advise(d, step);
+      }
+      if (d <= backward) {
+        advise(d, -step);
+      }
+    }
+
+    // Release pages the user has moved past.
+    if (navigation.direction != 0) {
+      for (auto it = advised_indices_.begin(); it != advised_indices_.end();) {
+        const bool behind = navigation.direction > 0
+                                ? *it + keep_behind < anchor_index
+                                : *it > anchor_index + keep_behind;
+        if (!behind) {
+          ++it;
+          continue;
+        }
+        const auto& descriptor = descriptors[*it];
+        hints.push_back({descriptor.absolute_path, 0, descriptor.file_size,
+                         platform::io::PageCacheAdvice::kDontNeed});
+        it = advised_indices_.erase(it);
+      }
+    }
+  }
+
+  if (!hints.empty()) {
+    read_ahead_.submit(std::move(hints));
+  }
+}
+
+void PreviewService::appendReadAheadHints(const PreviewDescriptor& descriptor,
+                                          std::vector<ReadAheadHint>& hints) const {
+  // The same spans the I/O stage reads: the file head (JPEG header or TIFF
+  // IFDs) and, once known, the embedded preview JPEG header.
+  constexpr std::uint64_t kHintBytes = 256 * 1024;
+  hints.push_back({descriptor.absolute_path, 0,
+                   std::min<std::uint64_t>(descriptor.file_size, kHintBytes),
+                   platform::io::PageCacheAdvice::kWillNeed});
+  const auto range = preview_ranges_.find(descriptor.cacheKey());
+  if (range != preview_ranges_.end() && range->second.first > 0) {
+    hints.push_back({descriptor.absolute_path, range->second.first,
+                     std::min(range->second.second, kHintBytes),
+                     platform::io::PageCacheAdvice::kWillNeed});
+  }
+}
+
 void PreviewService::primeCaches(std::size_t neighborCount) {
-  neighbor_window_ = neighborCount;
+  prefetch_.setBaseWindow(neighborCount);
 }
 
 std::optional<PreviewImage> PreviewService::cachedPreview(
@@ -161,101 +483,295 @@ std::optional<PreviewImage> PreviewService::cachedPreview(
   return cache_.get(cache_key);
 }
 
+std::size_t PreviewService::invalidatePreviews(int root_id,
+                                              const std::vector<std::string>& relative_paths) {
+  std::size_t dropped = 0;
+  for (const auto& relative_path : relative_paths) {
+    const auto cache_key = relative_path + "#" + std::to_string(root_id);
+    if (cache_.erase(cache_key)) {
+      ++dropped;
+    }
+    {
+      std::lock_guard lock(descriptor_mutex_);
+      preview_ranges_.erase(cache_key);
+    }
+    {
+      std::lock_guard lock(pyramid_mutex_);
+      std::erase_if(pyramids_,
+                    [&](const PyramidEntry& entry) { return entry.cache_key == cache_key; });
+    }
+    {
+      // Forgotten before the eviction, which would otherwise write kCached
+      // over the catalog row.
+      std::lock_guard lock(residency_mutex_);
+      resident_files_.erase(cache_key);
+    }
+    evictTexture(cache_key);
+  }
+  return dropped;
+}
+
 void PreviewService::waitUntilIdle() const {
-  std::unique_lock lock(queue_mutex_);
-  idle_cv_.wait(lock, [&] {
-    return jobs_.empty() && pending_jobs_ == 0;
-  });
+  {
+    std::unique_lock lock(queue_mutex_);
+    idle_cv_.wait(lock, [&] {
+      return jobs_.empty() && pending_jobs_ == 0;
+    });
+  }
+  if (upload_queue_) {
+    upload_queue_->flush();
+  }
+  read_ahead_.waitUntilIdle();
+}
+
+PrefetchPlan PreviewService::lastPrefetchPlan() const {
+  std::lock_guard lock(descriptor_mutex_);
+  return last_plan_;
+}
+
+NavigationTracker::State PreviewService::navigationState() const {
+  return navigation_.current();
+}
+
+std::size_t PreviewService::readAheadHintsIssued() const {
+  return read_ahead_.issuedCount();
+}
+
+PipelineStageStats PreviewService::stageStats() const {
+  std::lock_guard lock(queue_mutex_);
+  PipelineStageStats stats;
+  stats.io_limit = io_tuner_.limit();
+  stats.io_workers = io_tuner_.maxLimit();
+  stats.io_latency_ms = io_tuner_.lastLatencyMs();
+  stats.io_backend = cataloger::platform::io::BackendName(batch_reader_->backend());
+  stats.cpu_limit = cpu_tuner_.limit();
+  stats.cpu_workers = cpu_tuner_.maxLimit();
+  stats.cpu_latency_ms = cpu_tuner_.lastLatencyMs();
+  stats.cpu_queue_capacity = cpu_queue_capacity_;
+  if (upload_queue_) {
+    const auto uploads = upload_queue_->stats();
+    stats.upload_batches = uploads.batches;
+    stats.largest_upload_batch = uploads.largest_batch;
+  }
+  return stats;
 }
 
 void PreviewService::scheduleJob(const PreviewDescriptor& descriptor) {
+  std::lock_guard lock(queue_mutex_);
+  jobs_.push_back(descriptor);
+  ++pending_jobs_;
+  startStageTasksLocked();
+}
+
+void PreviewService::startStageTasksLocked() {
+  if (stop_) {
+    return;
+  }
+  std::erase_if(stage_tasks_, [](const tasks::TaskHandle& task) {
+    const auto status = task.status();
+    return status != tasks::TaskStatus::kQueued && status != tasks::TaskStatus::kRunning;
+  });
+  // Each I/O task claims up to a batch; none start while the CPU stage is
+  // backed up, which is what keeps the I/O stage from racing ahead.
+  while (io_waiting_ + io_active_ < io_tuner_.limit() &&
+         io_waiting_ * kIoBatchSize < jobs_.size() &&
+         cpu_jobs_.size() < cpu_queue_capacity_) {
+    ++io_waiting_;
+    stage_tasks_.push_back(scheduler_->submit(
+        tasks::Lane::kPreview, [this](std::stop_token) { runIoTask(); }, {.name = "preview-io"}));
+  }
+  while (cpu_waiting_ + cpu_active_ < cpu_tuner_.limit() && cpu_waiting_ < cpu_jobs_.size()) {
+    ++cpu_waiting_;
+    stage_tasks_.push_back(scheduler_->submit(
+        tasks::Lane::kPreview, [this](std::stop_token) { runCpuTask(); }, {.name = "preview-cpu"}));
+  }
+}
+
+void PreviewService::runIoTask() {
+  std::vector<PreviewDescriptor> batch;
   {
     std::lock_guard lock(queue_mutex_);
-    jobs_.push(descriptor);
-    ++pending_jobs_;
+    --io_waiting_;
+    if (stop_) {
+      return;
+    }
+    while (!jobs_.empty() && batch.size() < kIoBatchSize) {
+      batch.push_back(std::move(jobs_.front()));
+      jobs_.pop_front();
+      if (priority_jobs_ > 0) {
+        --priority_jobs_;
+      }
+    }
+    if (batch.empty()) {
+      return;
+    }
+    ++io_active_;
   }
-  queue_cv_.notify_one();
-}
 
-void PreviewService::workerLoop(std::stop_token stop_token) {
-  while (!stop_token.stop_requested()) {
-    PreviewDescriptor descriptor;
-    {
-      std::unique_lock lock(queue_mutex_);
-      queue_cv_.wait(lock, [&] { return stop_ || !jobs_.empty(); });
-      if ((stop_ && jobs_.empty()) || stop_token.stop_requested()) {
-        return;
+  // The counters above are settled below however the stage ends, or
+  // waitUntilIdle() would never return; a batch that throws is reported
+  // as failed.
+  const auto claimed = batch.size();
+  std::vector<StagedJob> staged;
+  try {
+    staged = runIoStage(batch);
+  } catch (...) {
+    staged.clear();
+    const auto message = currentExceptionMessage();
+    for (const auto& descriptor : batch) {
+      if (!cache_.contains(descriptor.cacheKey())) {
+        emitEvent(descriptor, CacheTier::kRam, false, true, message);
       }
-      descriptor = jobs_.front();
-      jobs_.pop();
     }
+  }
 
-    processJob(descriptor);
+  std::lock_guard lock(queue_mutex_);
+  for (std::size_t i = staged.size(); i < claimed; ++i) {
+    finishJobLocked();  // served from cache
+  }
+  for (auto& job : staged) {
+    io_tuner_.recordLatency(job.io_ms);
+    cpu_jobs_.push_back(std::move(job));
+  }
+  --io_active_;
+  startStageTasksLocked();
+}
 
-    {
-      std::lock_guard lock(queue_mutex_);
-      if (pending_jobs_ > 0) {
-        --pending_jobs_;
-      }
-      if (pending_jobs_ == 0 && jobs_.empty()) {
-        idle_cv_.notify_all();
-      }
+void PreviewService::runCpuTask() {
+  StagedJob job;
+  {
+    std::lock_guard lock(queue_mutex_);
+    --cpu_waiting_;
+    if (stop_ || cpu_jobs_.empty()) {
+      return;
     }
+    job = std::move(cpu_jobs_.front());
+    cpu_jobs_.pop_front();
+    ++cpu_active_;
+  }
+
+  const auto cpu_start = std::chrono::steady_clock::now();
+  try {
+    runCpuStage(job);
+  } catch (...) {
+    emitEvent(job.descriptor, CacheTier::kRam, false, true, currentExceptionMessage());
   }
+  const auto cpu_ms = elapsedMs(cpu_start);
+
+  std::lock_guard lock(queue_mutex_);
+  --cpu_active_;
+  cpu_tuner_.recordLatency(cpu_ms);
+  finishJobLocked();
+  startStageTasksLocked();
 }
 
-void PreviewService::processJob(const PreviewDescriptor& descriptor) {
-  const auto key = descriptor.cacheKey();
-  if (auto cached = cache_.get(key)) {
+void PreviewService::finishJobLocked() {
+  if (pending_jobs_ > 0) {
+    --pending_jobs_;
+  }
+  if (pending_jobs_ == 0 && jobs_.empty()) {
+    idle_cv_.notify_all();
+  }
+}
+
+std::vector<PreviewService::StagedJob> PreviewService::runIoStage(
+    std::vector<PreviewDescriptor> descriptors) {
+  std::erase_if(descriptors, [&](const PreviewDescriptor& descriptor) {
+    if (!cache_.get(descriptor.cacheKey())) {
+      return false;
+    }
     emitEvent(descriptor, CacheTier::kRam, true, false, {}, "cache");
-    return;
+    return true;
+  });
+
+  const auto io_start = std::chrono::steady_clock::now();
+  std::vector<ContainerMetadata> metadata;
+  auto images = extractor_.extractBatch(*batch_reader_, descriptors, metadata);
+  {
+    std::lock_guard lock(descriptor_mutex_);
+    for (std::size_t i = 0; i < descriptors.size(); ++i) {
+      if (metadata[i].icc_scanned) {
+        preview_ranges_[descriptors[i].cacheKey()] = {metadata[i].preview_offset,
+                                                      metadata[i].preview_length};
+      }
+    }
+  }
+  std::vector<StagedJob> jobs(descriptors.size());
+  std::vector<PendingDiscovery> discoveries;
+  for (std::size_t i = 0; i < jobs.size(); ++i) {
+    jobs[i].descriptor = std::move(descriptors[i]);
+    jobs[i].image = std::move(images[i]);
+    jobs[i].profile = loadEmbeddedProfile(jobs[i].descriptor, metadata[i], discoveries);
   }
+  persistIccDiscoveries(std::move(discoveries));
+  // Each job is charged its share of the batch, which is what the tuner's
+  // throughput estimate needs.
+  const auto per_job_ms = jobs.empty() ? 0.0 : elapsedMs(io_start) / jobs.size();
+  for (auto& job : jobs) {
+    job.io_ms = per_job_ms;
+  }
+  return jobs;
+}
+
+void PreviewService::runCpuStage(StagedJob& job) {
+  const auto& descriptor = job.descriptor;
+  auto& image = job.image;
 
   const auto transform_start = std::chrono::steady_clock::now();
-  auto image = extractor_.extract(descriptor);
-  const auto profile_bytes = loadEmbeddedProfile(descriptor);
-  auto transform_result = color_transformer_.apply(image, profile_bytes);
+  static const std::vector<std::uint8_t> kNoProfile;
+  auto transform_result =
+      color_transformer_.apply(image, job.profile ? *job.profile : kNoProfile);
   image.pixels = std::move(transform_result.pixels);
   image.color_managed = true;
   image.color_profile = transform_result.source_profile + " -> " +
                         color_transformer_.targetProfileName();
   cache_.put(image, CacheTier::kRam);
-  const auto transform_duration =
-      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
-                                                transform_start)
-          .count();
-
-  bool gpu_ok = true;
-  std::string gpu_error;
-  std::string backend_name = backendLabel(gpu_bridge_.get());
-  double gpu_duration_ms = 0.0;
-  if (gpu_bridge_) {
-    const auto gpu_start = std::chrono::steady_clock::now();
-    gpu_ok = gpu_bridge_->upload(image, gpu_error);
-    gpu_duration_ms =
-        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
-                                                  gpu_start)
-            .count();
-  } else {
-    gpu_ok = false;
-    gpu_error = "GPU bridge unavailable.";
+  // Reported as before: extraction plus colour management.
+  const auto transform_duration = job.io_ms + elapsedMs(transform_start);
+
+  // Larger than the window: upload only the mip level that fits it and
+  // keep the pyramid for tile requests when the view zooms in.
+  std::shared_ptr<const MipPyramid> pyramid;
+  double fit_scale = 1.0;
+  {
+    std::lock_guard lock(pyramid_mutex_);
+    if (display_width_ > 0 && display_height_ > 0 &&
+        (image.width > display_width_ || image.height > display_height_)) {
+      fit_scale = std::min(static_cast<double>(display_width_) / image.width,
+                           static_cast<double>(display_height_) / image.height);
+    }
+  }
+  if (fit_scale < 1.0) {
+    pyramid = std::make_shared<const MipPyramid>(MipPyramid::Build(image));
+    image = pyramid->levelImage(image.cache_key, pyramid->grid().levelForScale(fit_scale));
+    std::lock_guard lock(pyramid_mutex_);
+    storePyramidLocked(image.cache_key, pyramid);
   }
 
-  if (catalog_service_ && descriptor.file_id.has_value()) {
-    const auto state =
-        gpu_ok ? PreviewState::kGpuResident : PreviewState::kCached;
-    catalog_service_->updatePreviewState(*descriptor.file_id,
-                                         static_cast<int>(state));
+  auto backend_name = backendLabel(gpu_bridge_.get());
+  if (!upload_queue_) {
+    recordGpuResidency(descriptor, false);
+    emitEvent(descriptor, CacheTier::kRam, false, true, "GPU bridge unavailable.",
+              backend_name, 0.0, transform_duration);
+    return;
   }
 
-  emitEvent(descriptor,
-            CacheTier::kRam,
-            false,
-            !gpu_ok,
-            gpu_error,
-            backend_name,
-            gpu_duration_ms,
-            transform_duration);
+  // The upload completes on the queue's thread; the worker moves on to the
+  // next job and the event goes out once the texture is on the device.
+  upload_queue_->submit(
+      std::move(image),
+      [this, descriptor, backend_name = std::move(backend_name), transform_duration](
+          const cataloger::platform::gpu::UploadResult& result) {
+        recordGpuResidency(descriptor, result.ok);
+        emitEvent(descriptor,
+                  CacheTier::kRam,
+                  false,
+                  !result.ok,
+                  result.error,
+                  backend_name,
+                  result.upload_ms,
+                  transform_duration);
+      });
 }
 
 void PreviewService::emitEvent(const PreviewDescriptor& descriptor,
@@ -267,6 +783,7 @@ void PreviewService::emitEvent(const PreviewDescriptor& descriptor,
                                double gpu_ms,
                                double transform_ms) {
   if (!event_sink_) {
+    resolvePreviewWaiters(descriptor.cacheKey());
     return;
   }
   CacheEvent event;
@@ -279,34 +796,219 @@ void PreviewService::emitEvent(const PreviewDescriptor& descriptor,
   event.backend = backend;
   event.gpu_upload_ms = gpu_ms;
   event.color_transform_ms = transform_ms;
-  event_sink_(event);
+  {
+    std::lock_guard lock(event_mutex_);
+    event_sink_(event);
+  }
+  resolvePreviewWaiters(descriptor.cacheKey());
 }
 
-std::vector<std::uint8_t> PreviewService::loadEmbeddedProfile(
-    const PreviewDescriptor& descriptor) const {
-  if (const auto embedded =
-          icc::ExtractEmbeddedProfile(descriptor.absolute_path);
-      !embedded.empty()) {
-    return embedded;
+IccProfileBytes PreviewService::loadEmbeddedProfile(
+    const PreviewDescriptor& descriptor,
+    ContainerMetadata& metadata,
+    std::vector<PendingDiscovery>& discoveries) {
+  if (const auto cached = icc_cache_.lookup(descriptor.absolute_path,
+                                            descriptor.file_size,
+                                            descriptor.mtime_ticks)) {
+    if (cached->profile || !cached->profile_hash.has_value()) {
+      return cached->profile;
+    }
+    // Restored from the catalog; the bytes live there, not on disk.
+    if (catalog_service_) {
+      if (auto bytes = catalog_service_->loadIccProfile(*cached->profile_hash)) {
+        return icc_cache_.internProfile(*cached->profile_hash, std::move(*bytes));
+      }
+    }
   }
 
-  static const std::array<const char*, 3> extensions{".icc", ".ICM", ".profile"};
-  for (const auto* ext : extensions) {
-    auto candidate = descriptor.absolute_path;
-    candidate.replace_extension(ext);
-    if (std::filesystem::exists(candidate)) {
+  auto source = IccSource::kEmbedded;
+  auto bytes = metadata.icc_scanned
+                   ? std::move(metadata.icc_profile)
+                   : icc::ExtractEmbeddedProfile(descriptor.absolute_path);
+  if (bytes.empty()) {
+    source = IccSource::kSidecar;
+    static const std::array<const char*, 3> extensions{".icc", ".ICM", ".profile"};
+    for (const auto* ext : extensions) {
+      auto candidate = descriptor.absolute_path;
+      candidate.replace_extension(ext);
+      if (!std::filesystem::exists(candidate)) {
+        continue;
+      }
       std::ifstream stream(candidate, std::ios::binary);
       if (!stream) {
         continue;
       }
-      std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(stream)),
-                                      std::istreambuf_iterator<char>());
+      bytes.assign(std::istreambuf_iterator<char>(stream),
+                   std::istreambuf_iterator<char>());
       if (!bytes.empty()) {
-        return bytes;
+        break;
+      }
+    }
+  }
+
+  const auto discovery = icc_cache_.record(descriptor.absolute_path,
+                                           descriptor.file_size,
+                                           descriptor.mtime_ticks,
+                                           source,
+                                           std::move(bytes));
+  if (catalog_service_) {
+    PendingDiscovery pending;
+    pending.record.absolute_path = descriptor.absolute_path.string();
+    pending.record.file_size = descriptor.file_size;
+    pending.record.mtime = descriptor.mtime_ticks;
+    pending.record.source = static_cast<int>(discovery.source);
+    pending.record.profile_hash = discovery.profile_hash;
+    pending.profile = discovery.profile;
+    discoveries.push_back(std::move(pending));
+  }
+  return discovery.profile;
+}
+
+void PreviewService::persistIccDiscoveries(std::vector<PendingDiscovery> discoveries) {
+  if (!catalog_service_) {
+    return;
+  }
+  std::lock_guard lock(icc_persist_mutex_);
+  std::move(discoveries.begin(), discoveries.end(), std::back_inserter(unpersisted_icc_));
+  if (unpersisted_icc_.empty()) {
+    return;
+  }
+  // Past this, the oldest are dropped; the next session rediscovers them.
+  if (unpersisted_icc_.size() > kMaxUnpersistedIcc) {
+    unpersisted_icc_.erase(unpersisted_icc_.begin(),
+                           unpersisted_icc_.end() - static_cast<std::ptrdiff_t>(kMaxUnpersistedIcc));
+  }
+  std::vector<std::pair<services::catalog::IccDiscoveryRecord, const std::vector<std::uint8_t>*>>
+      batch;
+  batch.reserve(unpersisted_icc_.size());
+  for (const auto& pending : unpersisted_icc_) {
+    batch.emplace_back(pending.record, pending.profile.get());
+  }
+  try {
+    catalog_service_->storeIccDiscoveries(batch);
+    unpersisted_icc_.clear();
+  } catch (const std::exception& error) {
+    // The profiles are already in icc_cache_, so the previews are fine.
+    std::cerr << "[PreviewService] could not store ICC discoveries: " << error.what()
+              << std::endl;
+  }
+}
+
+bool PreviewService::isGpuResident(const std::string& cache_key) const {
+  return gpu_bridge_ && gpu_bridge_->isResident(cache_key);
+}
+
+bool PreviewService::evictTexture(const std::string& cache_key) {
+  return gpu_bridge_ && gpu_bridge_->evict(cache_key);
+}
+
+void PreviewService::setGpuBudget(std::size_t bytes) {
+  if (gpu_bridge_) {
+    gpu_bridge_->setBudget(bytes);
+  }
+}
+
+cataloger::platform::gpu::ResidencyStats PreviewService::gpuResidency() const {
+  return gpu_bridge_ ? gpu_bridge_->residency() : cataloger::platform::gpu::ResidencyStats{};
+}
+
+void PreviewService::setDisplaySize(int width, int height) {
+  std::lock_guard lock(pyramid_mutex_);
+  display_width_ = std::max(width, 0);
+  display_height_ = std::max(height, 0);
+}
+
+ViewportUpload PreviewService::presentViewport(const std::string& cache_key,
+                                               const Viewport& view) {
+  ViewportUpload result;
+  std::lock_guard lock(pyramid_mutex_);
+  auto entry = std::find_if(pyramids_.begin(), pyramids_.end(),
+                            [&](const PyramidEntry& candidate) {
+                              return candidate.cache_key == cache_key;
+                            });
+  if (entry == pyramids_.end()) {
+    const auto cached = cache_.get(cache_key);
+    if (!cached) {
+      return result;
+    }
+    storePyramidLocked(cache_key, std::make_shared<const MipPyramid>(MipPyramid::Build(*cached)));
+    entry = pyramids_.begin();
+  } else {
+    pyramids_.splice(pyramids_.begin(), pyramids_, entry);
+  }
+
+  const auto& pyramid = *entry->pyramid;
+  result.level = pyramid.grid().levelForScale(view.scale);
+  result.tiles = pyramid.grid().visibleTiles(view);
+  if (!upload_queue_) {
+    return result;
+  }
+  gpu_bridge_->touch(cache_key);
+  // Tiles stay in the queue while this lock is held; completions never take
+  // it, so a full queue cannot deadlock here.
+  const bool tracks = gpu_bridge_->tracksResidency();
+  for (const auto& tile : result.tiles) {
+    const auto key = TileKey(cache_key, tile);
+    if (const auto it = entry->tiles.find(key); it != entry->tiles.end()) {
+      const auto& fence = it->second;
+      if (fence.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        continue;  // in flight
+      }
+      if (fence.get().ok && (!tracks || gpu_bridge_->isResident(key))) {
+        gpu_bridge_->touch(key);
+        continue;
       }
     }
+    result.upload_bytes += pyramid.grid().tileBytes(tile);
+    auto fence = upload_queue_->submit(pyramid.tileImage(cache_key, tile));
+    entry->tiles[key] = fence;
+    result.fences.push_back(std::move(fence));
+  }
+  return result;
+}
+
+PreviewService::PyramidEntry& PreviewService::storePyramidLocked(
+    const std::string& cache_key,
+    std::shared_ptr<const MipPyramid> pyramid) {
+  std::erase_if(pyramids_, [&](const PyramidEntry& entry) { return entry.cache_key == cache_key; });
+  pyramids_.push_front(PyramidEntry{cache_key, std::move(pyramid), {}});
+  while (pyramids_.size() > kMaxPyramids) {
+    pyramids_.pop_back();
+  }
+  return pyramids_.front();
+}
+
+void PreviewService::recordGpuResidency(const PreviewDescriptor& descriptor,
+                                        bool uploaded) {
+  if (!catalog_service_ || !descriptor.file_id.has_value()) {
+    return;
+  }
+  std::lock_guard lock(residency_mutex_);
+  const auto key = descriptor.cacheKey();
+  // Another upload may already have evicted this texture; its notification
+  // found no file id, so residency is re-checked here under the lock.
+  const bool resident =
+      uploaded && (!gpu_bridge_->tracksResidency() || gpu_bridge_->isResident(key));
+  if (resident) {
+    resident_files_[key] = *descriptor.file_id;
+  } else {
+    resident_files_.erase(key);
+  }
+  const auto state = resident ? PreviewState::kGpuResident : PreviewState::kCached;
+  catalog_service_->updatePreviewState(*descriptor.file_id, static_cast<int>(state));
+}
+
+void PreviewService::onTextureEvicted(const std::string& cache_key) {
+  std::lock_guard lock(residency_mutex_);
+  const auto it = resident_files_.find(cache_key);
+  if (it == resident_files_.end()) {
+    return;
+  }
+  if (catalog_service_) {
+    catalog_service_->updatePreviewState(it->second,
+                                         static_cast<int>(PreviewState::kCached));
   }
-  return {};
+  resident_files_.erase(it);
 }
 
 std::string PreviewService::backendLabel(
@@ -317,6 +1019,8 @@ std::string PreviewService::backendLabel(
   switch (bridge->backend()) {
     case cataloger::platform::gpu::Backend::kMetal:
       return "Metal";
+    case cataloger::platform::gpu::Backend::kSoftware:
+      return "Software";
     default:
       return "Stub";
   }
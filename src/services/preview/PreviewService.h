@@ -3,14 +3,17 @@
 #include <atomic>
 #include <array>
 #include <condition_variable>
+#include <coroutine>
 #include <cstddef>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <optional>
-#include <queue>
+#include <set>
 #include <stop_token>
 #include <string>
 #include <thread>
@@ -19,22 +22,59 @@
 
 #include "ColorTransformer.h"
 #include "DirectoryScanner.h"
+#include "IccProfileCache.h"
 #include "IccProfileExtractor.h"
+#include "MipPyramid.h"
+#include "NavigationTracker.h"
 #include "PreviewCache.h"
 #include "PreviewExtractor.h"
+#include "PrefetchController.h"
 #include "PreviewTypes.h"
+#include "ReadAheadScheduler.h"
+#include "StageTuner.h"
 #include "platform/gpu/GpuBridge.h"
+#include "platform/gpu/UploadQueue.h"
+#include "platform/io/BatchReader.h"
 #include "services/catalog/CatalogService.h"
+#include "services/tasks/Task.h"
+#include "services/tasks/TaskScheduler.h"
 
 namespace cataloger::services::preview {
 
 using CacheEventSink = std::function<void(const CacheEvent&)>;
 
+struct PipelineStageStats {
+  std::size_t io_limit{};
+  std::size_t io_workers{};
+  double io_latency_ms{};
+  const char* io_backend{""};
+  std::size_t cpu_limit{};
+  std::size_t cpu_workers{};
+  double cpu_latency_ms{};
+  std::size_t cpu_queue_capacity{};
+  std::uint64_t upload_batches{};
+  std::size_t largest_upload_batch{};
+};
+
+// Result of PreviewService::presentViewport().
+struct ViewportUpload {
+  int level{0};
+  std::vector<TileId> tiles;  // every tile the view needs, row-major
+  std::size_t upload_bytes{0};  // submitted by this call; resident tiles cost nothing
+  std::vector<cataloger::platform::gpu::UploadFence> fences;
+};
+
 class PreviewService {
 public:
+  // `worker_count` pins both pipeline stages to that many workers; 0 lets
+  // the I/O stage tune itself between 1 and kMaxIoWorkers and the CPU stage
+  // between 1 and the core count. Stage work runs as kPreview tasks on
+  // `scheduler`, which must outlive the service; without one the service
+  // owns a scheduler sized for both stages.
   PreviewService(std::size_t ram_capacity = 64,
                  std::size_t preload_capacity = 8,
-                 std::size_t worker_count = 0);
+                 std::size_t worker_count = 0,
+                 tasks::TaskScheduler* scheduler = nullptr);
   ~PreviewService();
 
   void setCatalogService(services::catalog::CatalogService* catalog);
@@ -43,16 +83,105 @@ public:
       std::unique_ptr<cataloger::platform::gpu::GpuBridge> bridge);
 
   void warmRoot(int root_id, const std::filesystem::path& root_path);
-  void requestPreview(int root_id, const std::string& relative_path);
+  // Returns false when the root has not been warmed or does not hold
+  // `relative_path`; nothing is scheduled then.
+  bool requestPreview(int root_id, const std::string& relative_path);
+  // Adds files that just landed in `root_id` (warm or not) and decodes
+  // them ahead of all other queued work, in the order given. Live ingest
+  // calls this per catalog batch so the destination fills while the card
+  // is still copying; a descriptor's `head` saves re-reading the file.
+  void publishFiles(int root_id, std::vector<PreviewDescriptor> descriptors);
   void primeCaches(std::size_t neighborCount);
   [[nodiscard]] std::optional<PreviewImage> cachedPreview(
       const std::string& cache_key) const;
+  // Forgets everything held for these files of `root_id`: cached previews,
+  // mip pyramids, texture residency and embedded preview locations. Call
+  // when the files changed or went away on disk. Returns the number of
+  // cached previews dropped.
+  std::size_t invalidatePreviews(int root_id, const std::vector<std::string>& relative_paths);
   void waitUntilIdle() const;
+  [[nodiscard]] PipelineStageStats stageStats() const;
+
+  // Awaitable forms for UI code. Both run on the service's scheduler and
+  // the awaiting coroutine continues on a scheduler worker; hop back with
+  // tasks::ResumeOn(). Must not be awaited past the service's lifetime.
+  tasks::Task<void> warmRootAsync(int root_id, std::filesystem::path root_path);
+  // Requests the preview and completes once it is decoded (or failed),
+  // yielding the cached image; std::nullopt if the file is unknown or could
+  // not be decoded.
+  tasks::Task<std::optional<PreviewImage>> requestPreviewAsync(int root_id,
+                                                               std::string relative_path);
+  [[nodiscard]] NavigationTracker::State navigationState() const;
+  [[nodiscard]] PrefetchPlan lastPrefetchPlan() const;
+  // Page-cache hints issued so far by the read-ahead tier.
+  [[nodiscard]] std::size_t readAheadHintsIssued() const;
+
+  // GPU texture residency. Textures the bridge drops, for budget or on
+  // request, are written back to the catalog as kCached.
+  [[nodiscard]] bool isGpuResident(const std::string& cache_key) const;
+  bool evictTexture(const std::string& cache_key);
+  void setGpuBudget(std::size_t bytes);
+  [[nodiscard]] cataloger::platform::gpu::ResidencyStats gpuResidency() const;
+
+  // Window size in pixels; 0x0 (the default) uploads every preview whole.
+  // Previews larger than the window get a mip pyramid at decode time and
+  // only the level that fits the window is uploaded, under the preview's
+  // own cache key.
+  void setDisplaySize(int width, int height);
+  // Uploads the tiles `view` needs that are not resident or in flight yet.
+  // Falls back to building the pyramid from the preview cache.
+  ViewportUpload presentViewport(const std::string& cache_key, const Viewport& view);
+
+  static constexpr std::size_t kMaxIoWorkers = 32;
+  // Descriptors an I/O worker claims at once and reads as one batch.
+  static constexpr std::size_t kIoBatchSize = 32;
+  // Read-ahead covers this many seconds of travel at the observed speed,
+  // clamped to [kMinReadAhead, kMaxReadAhead] files.
+  static constexpr double kReadAheadSeconds = 3.0;
+  static constexpr std::size_t kMinReadAhead = 8;
+  static constexpr std::size_t kMaxReadAhead = 64;
+  // Mip pyramids kept for tile requests, most recently decoded first.
+  static constexpr std::size_t kMaxPyramids = 8;
 
 private:
+  // Output of the I/O stage, queued for the CPU stage.
+  struct StagedJob {
+    PreviewDescriptor descriptor;
+    PreviewImage image;
+    IccProfileBytes profile;
+    double io_ms{0.0};
+  };
+
+  // Suspends until the next cache event for the file, then resumes on the
+  // preview executor.
+  struct PreviewReadyAwaiter {
+    PreviewService* service;
+    int root_id;
+    std::string relative_path;
+    bool known{true};
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    bool await_resume() const noexcept { return known; }
+  };
+
+  struct PyramidEntry {
+    std::string cache_key;
+    std::shared_ptr<const MipPyramid> pyramid;
+    std::unordered_map<std::string, cataloger::platform::gpu::UploadFence> tiles;
+  };
+
   void scheduleJob(const PreviewDescriptor& descriptor);
-  void workerLoop(std::stop_token stop_token);
-  void processJob(const PreviewDescriptor& descriptor);
+  // Submits stage tasks while a stage has queued work and spare slots.
+  void startStageTasksLocked();
+  void runIoTask();
+  void runCpuTask();
+  std::vector<StagedJob> runIoStage(std::vector<PreviewDescriptor> descriptors);
+  void runCpuStage(StagedJob& job);
+  void finishJobLocked();
+  std::uint64_t addPreviewWaiter(const std::string& cache_key, std::function<void()> resume);
+  bool removePreviewWaiter(const std::string& cache_key, std::uint64_t id);
+  void resolvePreviewWaiters(const std::string& cache_key);
   void emitEvent(const PreviewDescriptor& descriptor,
                  CacheTier tier,
                  bool hit,
@@ -63,35 +192,107 @@ private:
                  double transform_ms = 0.0);
   void storeDescriptorCache(int root_id,
                             std::vector<PreviewDescriptor> descriptors);
-  void scheduleNeighbors(int root_id, std::size_t anchor_index);
-  std::vector<std::uint8_t> loadEmbeddedProfile(
-      const PreviewDescriptor& descriptor) const;
+  void scheduleNeighbors(int root_id,
+                         std::size_t anchor_index,
+                         const PrefetchPlan& plan);
+  void scheduleReadAhead(int root_id,
+                         std::size_t anchor_index,
+                         const NavigationTracker::State& navigation);
+  void appendReadAheadHints(const PreviewDescriptor& descriptor,
+                            std::vector<ReadAheadHint>& hints) const;
+  // A discovery made by the I/O stage, written with the rest of its batch.
+  struct PendingDiscovery {
+    services::catalog::IccDiscoveryRecord record;
+    IccProfileBytes profile;
+  };
+
+  IccProfileBytes loadEmbeddedProfile(const PreviewDescriptor& descriptor,
+                                      ContainerMetadata& metadata,
+                                      std::vector<PendingDiscovery>& discoveries);
+  // Writes `discoveries` and any an earlier batch failed to write. A
+  // failure is logged and keeps them for the next batch; it never fails
+  // the previews.
+  void persistIccDiscoveries(std::vector<PendingDiscovery> discoveries);
+  void installGpuBridge(std::unique_ptr<cataloger::platform::gpu::GpuBridge> bridge);
+  void recordGpuResidency(const PreviewDescriptor& descriptor, bool uploaded);
+  void onTextureEvicted(const std::string& cache_key);
+  PyramidEntry& storePyramidLocked(const std::string& cache_key,
+                                   std::shared_ptr<const MipPyramid> pyramid);
   static std::string backendLabel(
       const cataloger::platform::gpu::GpuBridge* bridge);
   void shutdown();
 
   services::catalog::CatalogService* catalog_service_;
   CacheEventSink event_sink_;
+  // Both stages emit events; the sink is invoked one event at a time.
+  std::mutex event_mutex_;
 
   DirectoryScanner scanner_;
   PreviewExtractor extractor_;
   ColorTransformer color_transformer_;
   PreviewCache cache_;
+  IccProfileCache icc_cache_;
+  std::mutex icc_persist_mutex_;
+  std::vector<PendingDiscovery> unpersisted_icc_;
   std::unique_ptr<cataloger::platform::gpu::GpuBridge> gpu_bridge_;
+  // Catalog file ids of resident textures, by cache key. Catalog writes for
+  // residency happen under this mutex so an eviction cannot be overwritten
+  // by a late kGpuResident.
+  mutable std::mutex residency_mutex_;
+  std::unordered_map<std::string, std::int64_t> resident_files_;
+  // Uploads run here, off the CPU workers; declared after the bridge so it
+  // is torn down first.
+  std::unique_ptr<cataloger::platform::gpu::UploadQueue> upload_queue_;
+  std::unique_ptr<cataloger::platform::io::BatchReader> batch_reader_;
+
+  mutable std::mutex pyramid_mutex_;
+  int display_width_{0};
+  int display_height_{0};
+  std::list<PyramidEntry> pyramids_;
 
   mutable std::mutex queue_mutex_;
-  mutable std::condition_variable queue_cv_;
   mutable std::condition_variable idle_cv_;
-  std::queue<PreviewDescriptor> jobs_;
-  std::vector<std::jthread> workers_;
+  std::deque<PreviewDescriptor> jobs_;
+  // The first priority_jobs_ entries of jobs_ are published files.
+  std::size_t priority_jobs_{0};
+  // Soft bound: no I/O task starts while it is full.
+  std::deque<StagedJob> cpu_jobs_;
+  std::size_t cpu_queue_capacity_;
+  StageTuner io_tuner_;
+  StageTuner cpu_tuner_;
+  // Stage tasks submitted but not started (waiting) and running (active);
+  // their sum per stage never exceeds that stage's tuner limit.
+  std::size_t io_waiting_{0};
+  std::size_t io_active_{0};
+  std::size_t cpu_waiting_{0};
+  std::size_t cpu_active_{0};
+  std::unique_ptr<tasks::TaskScheduler> owned_scheduler_;
+  tasks::TaskScheduler* scheduler_;
+  std::vector<tasks::TaskHandle> stage_tasks_;
+  std::unique_ptr<tasks::SchedulerExecutor> preview_executor_;
+
+  // Coroutines waiting in requestPreviewAsync(), by cache key.
+  std::mutex waiter_mutex_;
+  std::uint64_t next_waiter_id_{1};
+  std::unordered_map<std::string, std::vector<std::pair<std::uint64_t, std::function<void()>>>>
+      preview_waiters_;
   bool stop_;
-  std::size_t neighbor_window_;
   mutable std::size_t pending_jobs_;
 
   mutable std::mutex descriptor_mutex_;
   std::unordered_map<int, std::vector<PreviewDescriptor>> root_descriptors_;
   std::unordered_map<int, std::unordered_map<std::string, std::size_t>>
       descriptor_index_;
+  // Embedded JPEG locations learned during extraction, by cache key.
+  std::unordered_map<std::string, std::pair<std::uint64_t, std::uint64_t>>
+      preview_ranges_;
+  PrefetchPlan last_plan_;
+  int advised_root_{-1};
+  std::set<std::size_t> advised_indices_;
+
+  NavigationTracker navigation_;
+  PrefetchController prefetch_;
+  ReadAheadScheduler read_ahead_;
 };
 
 }  // namespace cataloger::services::preview
@@ -3,11 +3,14 @@
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "PixelBuffer.h"
+
 namespace cataloger::services::preview {
 
 enum class CacheTier { kRam, kPreload };
@@ -19,20 +22,35 @@ struct PreviewDescriptor {
   std::string relative_path;
   std::uintmax_t file_size{};
   std::int64_t capture_ts{};
+  std::int64_t mtime_ticks{};  // file_time_type ticks; capture_ts is whole seconds
+  // Leading bytes already in memory, e.g. kept from an ingest copy. Used
+  // instead of the first read when they cover it.
+  std::shared_ptr<const std::vector<std::uint8_t>> head;
 
   [[nodiscard]] std::string cacheKey() const {
     return relative_path + "#" + std::to_string(root_id);
   }
 };
 
+// Byte layout of PreviewImage::pixels. Decoded previews are packed RGB;
+// mip levels and tiles are RGBA so they can be filtered four bytes at a time.
+enum class PixelLayout { kRgb8, kRgba8 };
+
+[[nodiscard]] constexpr int BytesPerPixel(PixelLayout layout) {
+  return layout == PixelLayout::kRgba8 ? 4 : 3;
+}
+
 struct PreviewImage {
   std::string cache_key;
   std::filesystem::path source_path;
-  std::vector<std::uint8_t> pixels;
+  PixelBuffer pixels;  // pooled; copies share bytes
+  PixelLayout layout{PixelLayout::kRgb8};
   bool color_managed{false};
   std::string color_profile;
   int width{};
   int height{};
+  int orientation{1};  // EXIF orientation (1-8)
+  std::int64_t capture_ts{};
 };
 
 struct CacheEvent {
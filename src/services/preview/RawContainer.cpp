@@ -0,0 +1,177 @@
+#include "RawContainer.h"
+
+#include <array>
+#include <cstring>
+#include <unordered_set>
+
+#include "JpegSegmentIndex.h"
+
+namespace cataloger::services::preview::raw {
+
+namespace {
+
+constexpr std::size_t kMaxVisitedIfds = 32;
+constexpr std::size_t kIccHeaderProbeBytes = 64 * 1024;
+constexpr std::uint32_t kCompressionOldJpeg = 6;
+constexpr std::uint32_t kCompressionJpeg = 7;
+constexpr char kRafMagic[] = "FUJIFILMCCD-RAW";
+
+std::uint32_t be32(const std::uint8_t* p) {
+  return (static_cast<std::uint32_t>(p[0]) << 24) |
+         (static_cast<std::uint32_t>(p[1]) << 16) |
+         (static_cast<std::uint32_t>(p[2]) << 8) | static_cast<std::uint32_t>(p[3]);
+}
+
+void considerPreview(ContainerInfo& info,
+                     const tiff::ByteSource& source,
+                     std::uint64_t offset,
+                     std::uint64_t length) {
+  if (length < 4 || offset >= source.size() || length > source.size() - offset) {
+    return;
+  }
+  std::array<std::uint8_t, 2> soi{};
+  if (!source.read(offset, soi.size(), soi.data()) || soi[0] != 0xFF ||
+      soi[1] != 0xD8) {
+    return;
+  }
+  if (!info.preview || length > info.preview->length) {
+    info.preview = ByteRange{offset, length};
+  }
+}
+
+void inspectIfd(ContainerInfo& info,
+                const tiff::ByteSource& source,
+                const tiff::TiffReader& reader,
+                std::uint32_t ifd_offset,
+                bool is_ifd0,
+                std::vector<std::uint32_t>& pending,
+                std::unordered_set<std::uint32_t>& visited) {
+  using tiff::TiffReader;
+  std::uint32_t next = 0;
+  const auto entries = reader.readIfd(ifd_offset, &next);
+  if (next != 0 && !visited.contains(next)) {
+    pending.push_back(next);
+  }
+
+  if (info.icc_profile.empty()) {
+    if (const auto icc = TiffReader::find(entries, tiff::kTagIccProfile)) {
+      reader.readBytes(*icc, info.icc_profile);
+    }
+  }
+
+  if (is_ifd0) {
+    if (const auto entry = TiffReader::find(entries, tiff::kTagOrientation)) {
+      if (const auto value = reader.readUnsigned(*entry); value && *value >= 1 && *value <= 8) {
+        info.orientation = static_cast<int>(*value);
+      }
+    }
+    if (const auto pointer = TiffReader::find(entries, tiff::kTagExifIfd)) {
+      if (const auto offset = reader.readUnsigned(*pointer)) {
+        const auto exif = reader.readIfd(*offset);
+        if (const auto stamp = TiffReader::find(exif, tiff::kTagDateTimeOriginal)) {
+          if (const auto text = reader.readAscii(*stamp)) {
+            info.capture_ts = tiff::ParseExifDateTime(*text);
+          }
+        }
+      }
+    }
+  }
+
+  if (const auto sub_ifds = TiffReader::find(entries, tiff::kTagSubIfds)) {
+    for (std::size_t i = 0; i < sub_ifds->count && i < kMaxVisitedIfds; ++i) {
+      if (const auto offset = reader.readUnsigned(*sub_ifds, i);
+          offset && !visited.contains(*offset)) {
+        pending.push_back(*offset);
+      }
+    }
+  }
+
+  // Classic thumbnail/preview pointer (CR2 IFD0/IFD1, NEF/ARW/ORF IFD1).
+  const auto jpeg_offset = TiffReader::find(entries, tiff::kTagJpegInterchangeFormat);
+  const auto jpeg_length =
+      TiffReader::find(entries, tiff::kTagJpegInterchangeFormatLength);
+  if (jpeg_offset && jpeg_length) {
+    const auto offset = reader.readUnsigned(*jpeg_offset);
+    const auto length = reader.readUnsigned(*jpeg_length);
+    if (offset && length) {
+      considerPreview(info, source, reader.absolute(*offset), *length);
+    }
+  }
+
+  // Single-strip JPEG-compressed images (DNG/NEF preview SubIFDs).
+  const auto compression = TiffReader::find(entries, tiff::kTagCompression);
+  const auto strip_offsets = TiffReader::find(entries, tiff::kTagStripOffsets);
+  const auto strip_counts = TiffReader::find(entries, tiff::kTagStripByteCounts);
+  if (compression && strip_offsets && strip_counts && strip_offsets->count == 1) {
+    const auto scheme = reader.readUnsigned(*compression);
+    if (scheme && (*scheme == kCompressionJpeg || *scheme == kCompressionOldJpeg)) {
+      const auto offset = reader.readUnsigned(*strip_offsets);
+      const auto length = reader.readUnsigned(*strip_counts);
+      if (offset && length) {
+        considerPreview(info, source, reader.absolute(*offset), *length);
+      }
+    }
+  }
+}
+
+bool inspectRaf(ContainerInfo& info, const tiff::ByteSource& source) {
+  std::array<std::uint8_t, 92> header{};
+  if (!source.read(0, header.size(), header.data()) ||
+      std::memcmp(header.data(), kRafMagic, sizeof(kRafMagic) - 1) != 0) {
+    return false;
+  }
+  info.recognized = true;
+  considerPreview(info, source, be32(header.data() + 84), be32(header.data() + 88));
+  return true;
+}
+
+void inspectTiff(ContainerInfo& info, const tiff::ByteSource& source) {
+  const tiff::TiffReader reader(source);
+  if (!reader.valid()) {
+    return;
+  }
+  info.recognized = true;
+
+  std::vector<std::uint32_t> pending{reader.firstIfdOffset()};
+  std::unordered_set<std::uint32_t> visited;
+  bool is_ifd0 = true;
+  while (!pending.empty() && visited.size() < kMaxVisitedIfds) {
+    const auto offset = pending.back();
+    pending.pop_back();
+    if (offset == 0 || !visited.insert(offset).second) {
+      continue;
+    }
+    inspectIfd(info, source, reader, offset, is_ifd0, pending, visited);
+    is_ifd0 = false;
+  }
+}
+
+}  // namespace
+
+ContainerInfo Inspect(const tiff::ByteSource& source, bool probe_preview_icc) {
+  ContainerInfo info;
+  if (!inspectRaf(info, source)) {
+    inspectTiff(info, source);
+  }
+
+  if (probe_preview_icc && info.icc_profile.empty() && info.preview) {
+    PixelBuffer header;
+    const auto index = jpeg::ReadHeader(source, info.preview->offset,
+                                        info.preview->length, header,
+                                        kIccHeaderProbeBytes);
+    if (index.valid) {
+      info.icc_profile = jpeg::AssembleIccProfile(header, index);
+    }
+  }
+  return info;
+}
+
+ContainerInfo Inspect(const std::filesystem::path& path) {
+  const tiff::FileSource source(path);
+  if (!source.isOpen()) {
+    return {};
+  }
+  return Inspect(source);
+}
+
+}  // namespace cataloger::services::preview::raw
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "TiffReader.h"
+
+namespace cataloger::services::preview::raw {
+
+struct ByteRange {
+  std::uint64_t offset{};
+  std::uint64_t length{};
+};
+
+struct ContainerInfo {
+  bool recognized{false};
+  std::vector<std::uint8_t> icc_profile;
+  std::optional<ByteRange> preview;  // largest embedded JPEG
+  int orientation{1};
+  std::optional<std::int64_t> capture_ts;
+};
+
+// Walks TIFF-based RAW containers (CR2, NEF, ARW, DNG, ORF, RW2, TIFF) and
+// Fuji RAF headers with positional reads only. The ICC profile comes from
+// tag 34675 when present, otherwise from APP2 segments of the embedded
+// preview JPEG. ISO-BMFF containers (CR3) are not recognized.
+// Pass `probe_preview_icc = false` when the caller reads the preview header
+// itself and will assemble the ICC chunks from it.
+ContainerInfo Inspect(const tiff::ByteSource& source, bool probe_preview_icc = true);
+ContainerInfo Inspect(const std::filesystem::path& path);
+
+}  // namespace cataloger::services::preview::raw
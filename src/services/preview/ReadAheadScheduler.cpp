@@ -0,0 +1,55 @@
+#include "ReadAheadScheduler.h"
+
+#include <utility>
+
+namespace cataloger::services::preview {
+
+ReadAheadScheduler::ReadAheadScheduler()
+    : worker_([this](std::stop_token token) { run(token); }) {}
+
+ReadAheadScheduler::~ReadAheadScheduler() {
+  worker_.request_stop();
+  work_cv_.notify_all();
+}
+
+void ReadAheadScheduler::submit(std::vector<ReadAheadHint> hints) {
+  {
+    std::lock_guard lock(mutex_);
+    pending_ = std::move(hints);
+  }
+  work_cv_.notify_one();
+}
+
+void ReadAheadScheduler::waitUntilIdle() const {
+  std::unique_lock lock(mutex_);
+  idle_cv_.wait(lock, [&] { return pending_.empty() && !busy_; });
+}
+
+std::size_t ReadAheadScheduler::issuedCount() const {
+  std::lock_guard lock(mutex_);
+  return issued_;
+}
+
+void ReadAheadScheduler::run(std::stop_token stop_token) {
+  std::unique_lock lock(mutex_);
+  while (!stop_token.stop_requested()) {
+    if (!work_cv_.wait(lock, stop_token, [&] { return !pending_.empty(); })) {
+      return;
+    }
+    // Hints are issued nearest-first; take one at a time so a newer plan
+    // can pre-empt the tail of this one.
+    auto hint = std::move(pending_.front());
+    pending_.erase(pending_.begin());
+    busy_ = true;
+    lock.unlock();
+    platform::io::AdviseRange(hint.path, hint.offset, hint.length, hint.advice);
+    lock.lock();
+    busy_ = false;
+    ++issued_;
+    if (pending_.empty()) {
+      idle_cv_.notify_all();
+    }
+  }
+}
+
+}  // namespace cataloger::services::preview
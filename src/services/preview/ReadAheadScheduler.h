@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "platform/io/PageCacheHints.h"
+
+namespace cataloger::services::preview {
+
+struct ReadAheadHint {
+  std::filesystem::path path;
+  std::uint64_t offset{};
+  std::uint64_t length{};
+  platform::io::PageCacheAdvice advice{platform::io::PageCacheAdvice::kWillNeed};
+};
+
+// Issues page-cache hints on its own thread so a slow network volume never
+// stalls requestPreview. Each submit() replaces the hints still waiting:
+// when the user outruns the volume, only the newest plan matters.
+class ReadAheadScheduler {
+public:
+  ReadAheadScheduler();
+  ~ReadAheadScheduler();
+
+  void submit(std::vector<ReadAheadHint> hints);
+  void waitUntilIdle() const;
+  [[nodiscard]] std::size_t issuedCount() const;
+
+private:
+  void run(std::stop_token stop_token);
+
+  mutable std::mutex mutex_;
+  std::condition_variable_any work_cv_;
+  mutable std::condition_variable idle_cv_;
+  std::vector<ReadAheadHint> pending_;
+  bool busy_{false};
+  std::size_t issued_{0};
+  std::jthread worker_;
+};
+
+}  // namespace cataloger::services::preview
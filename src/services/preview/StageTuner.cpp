@@ -0,0 +1,58 @@
+#include "StageTuner.h"
+
+#include <algorithm>
+
+namespace cataloger::services::preview {
+
+namespace {
+
+// Fraction of the ideal (linear) throughput change a step must show.
+constexpr double kRequiredEfficiency = 0.5;
+// Floor for latency samples so zero-cost jobs do not divide by zero.
+constexpr double kMinLatencyMs = 1e-3;
+
+}  // namespace
+
+StageTuner::StageTuner(std::size_t min_limit,
+                       std::size_t max_limit,
+                       std::size_t initial_limit)
+    : min_limit_(std::max<std::size_t>(1, min_limit)),
+      max_limit_(std::max(min_limit_, max_limit)),
+      limit_(std::clamp(initial_limit, min_limit_, max_limit_)) {}
+
+bool StageTuner::recordLatency(double latency_ms) {
+  window_sum_ms_ += std::max(latency_ms, kMinLatencyMs);
+  if (++window_count_ < kSampleWindow) {
+    return false;
+  }
+
+  last_latency_ms_ = window_sum_ms_ / static_cast<double>(window_count_);
+  window_sum_ms_ = 0.0;
+  window_count_ = 0;
+  if (min_limit_ == max_limit_) {
+    return false;
+  }
+
+  const auto throughput = static_cast<double>(limit_) / last_latency_ms_;
+  if (previous_limit_ != 0 && previous_limit_ != limit_) {
+    const auto ideal = static_cast<double>(limit_) / static_cast<double>(previous_limit_);
+    const auto observed = throughput / previous_throughput_;
+    const auto required = 1.0 + kRequiredEfficiency * (ideal - 1.0);
+    // Stepping up must earn its keep; stepping down must not hurt.
+    if (observed < required) {
+      direction_ = -direction_;
+    }
+  }
+  if (limit_ == max_limit_) {
+    direction_ = -1;
+  } else if (limit_ == min_limit_) {
+    direction_ = 1;
+  }
+
+  previous_limit_ = limit_;
+  previous_throughput_ = throughput;
+  limit_ = direction_ > 0 ? limit_ + 1 : limit_ - 1;
+  return true;
+}
+
+}  // namespace cataloger::services::preview
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+namespace cataloger::services::preview {
+
+// Latency-driven concurrency limit for one pipeline stage. Each window of
+// completed jobs yields a throughput estimate (limit / mean latency, by
+// Little's law). The tuner hill-climbs one slot at a time: a step up is
+// kept only if it bought at least half of its proportional throughput gain,
+// and a step down is kept unless it cost more than half. On a single
+// spindle extra readers only add queueing, so the limit walks down to one
+// or two; on NVMe it climbs until the device stops absorbing requests.
+// Not thread-safe; callers serialize access.
+class StageTuner {
+public:
+  StageTuner(std::size_t min_limit, std::size_t max_limit, std::size_t initial_limit);
+
+  [[nodiscard]] std::size_t limit() const { return limit_; }
+  [[nodiscard]] std::size_t minLimit() const { return min_limit_; }
+  [[nodiscard]] std::size_t maxLimit() const { return max_limit_; }
+  [[nodiscard]] double lastLatencyMs() const { return last_latency_ms_; }
+
+  // Records one job latency. Returns true when the limit changed.
+  bool recordLatency(double latency_ms);
+
+  static constexpr std::size_t kSampleWindow = 8;
+
+private:
+  std::size_t min_limit_;
+  std::size_t max_limit_;
+  std::size_t limit_;
+  std::size_t previous_limit_{0};
+  double previous_throughput_{0.0};
+  int direction_{1};
+  double window_sum_ms_{0.0};
+  std::size_t window_count_{0};
+  double last_latency_ms_{0.0};
+};
+
+}  // namespace cataloger::services::preview
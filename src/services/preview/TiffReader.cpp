@@ -0,0 +1,247 @@
+#include "TiffReader.h"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace cataloger::services::preview::tiff {
+
+namespace {
+
+constexpr std::size_t kMaxIfdEntries = 1024;
+
+std::size_t typeSize(std::uint16_t type) {
+  switch (type) {
+    case 1:   // BYTE
+    case 2:   // ASCII
+    case 6:   // SBYTE
+    case 7:   // UNDEFINED
+      return 1;
+    case 3:   // SHORT
+    case 8:   // SSHORT
+      return 2;
+    case 4:   // LONG
+    case 9:   // SLONG
+    case 11:  // FLOAT
+    case 13:  // IFD
+      return 4;
+    case 5:   // RATIONAL
+    case 10:  // SRATIONAL
+    case 12:  // DOUBLE
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+// Howard Hinnant's days_from_civil.
+std::int64_t daysFromCivil(std::int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const auto yoe = static_cast<unsigned>(y - era * 400);
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+}  // namespace
+
+bool SpanSource::read(std::uint64_t offset, std::size_t length, std::uint8_t* out) const {
+  if (offset > bytes_.size() || length > bytes_.size() - offset) {
+    return false;
+  }
+  std::memcpy(out, bytes_.data() + offset, length);
+  return true;
+}
+
+FileSource::FileSource(const std::filesystem::path& path)
+    : stream_(path, std::ios::binary) {
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(path, ec);
+  open_ = static_cast<bool>(stream_) && !ec;
+  size_ = open_ ? static_cast<std::uint64_t>(size) : 0;
+}
+
+bool FileSource::read(std::uint64_t offset, std::size_t length, std::uint8_t* out) const {
+  if (!open_ || offset > size_ || length > size_ - offset) {
+    return false;
+  }
+  stream_.clear();
+  stream_.seekg(static_cast<std::streamoff>(offset));
+  stream_.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(length));
+  return static_cast<std::size_t>(stream_.gcount()) == length;
+}
+
+std::size_t IfdEntry::byteLength() const {
+  return typeSize(type) * static_cast<std::size_t>(count);
+}
+
+TiffReader::TiffReader(const ByteSource& source, std::uint64_t base)
+    : source_(source), base_(base) {
+  std::array<std::uint8_t, 8> header{};
+  if (!source_.read(base_, header.size(), header.data())) {
+    return;
+  }
+  if (header[0] == 'I' && header[1] == 'I') {
+    little_endian_ = true;
+  } else if (header[0] == 'M' && header[1] == 'M') {
+    little_endian_ = false;
+  } else {
+    return;
+  }
+  // Accept classic TIFF (42) plus the ORF/RW2 magic variants.
+  const auto magic = u16(header.data() + 2);
+  if (magic != 42 && magic != 0x4F52 && magic != 0x5352 && magic != 0x0055) {
+    return;
+  }
+  first_ifd_ = u32(header.data() + 4);
+  valid_ = true;
+}
+
+std::vector<IfdEntry> TiffReader::readIfd(std::uint32_t offset,
+                                          std::uint32_t* next_ifd) const {
+  std::vector<IfdEntry> entries;
+  if (next_ifd) {
+    *next_ifd = 0;
+  }
+  if (!valid_ || offset == 0) {
+    return entries;
+  }
+
+  std::array<std::uint8_t, 2> count_bytes{};
+  if (!source_.read(absolute(offset), count_bytes.size(), count_bytes.data())) {
+    return entries;
+  }
+  const auto count = u16(count_bytes.data());
+  if (count == 0 || count > kMaxIfdEntries) {
+    return entries;
+  }
+
+  std::vector<std::uint8_t> table(static_cast<std::size_t>(count) * 12 + 4);
+  if (!source_.read(absolute(offset) + 2, table.size(), table.data())) {
+    // The trailing next-IFD pointer is optional at the end of a short buffer.
+    table.resize(table.size() - 4);
+    if (!source_.read(absolute(offset) + 2, table.size(), table.data())) {
+      return entries;
+    }
+  }
+
+  entries.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto* raw = table.data() + i * 12;
+    IfdEntry entry;
+    entry.tag = u16(raw);
+    entry.type = u16(raw + 2);
+    entry.count = u32(raw + 4);
+    const auto length = entry.byteLength();
+    entry.value_position = length <= 4 ? absolute(offset) + 2 + i * 12 + 8
+                                       : absolute(u32(raw + 8));
+    entries.push_back(entry);
+  }
+  if (next_ifd && table.size() == static_cast<std::size_t>(count) * 12 + 4) {
+    *next_ifd = u32(table.data() + static_cast<std::size_t>(count) * 12);
+  }
+  return entries;
+}
+
+std::optional<IfdEntry> TiffReader::find(const std::vector<IfdEntry>& entries,
+                                         std::uint16_t tag) {
+  for (const auto& entry : entries) {
+    if (entry.tag == tag) {
+      return entry;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::uint32_t> TiffReader::readUnsigned(const IfdEntry& entry,
+                                                      std::size_t index) const {
+  if (index >= entry.count) {
+    return std::nullopt;
+  }
+  const auto width = typeSize(entry.type);
+  std::array<std::uint8_t, 4> value{};
+  switch (entry.type) {
+    case 1:
+    case 7:
+      if (!source_.read(entry.value_position + index, 1, value.data())) {
+        return std::nullopt;
+      }
+      return value[0];
+    case 3:
+      if (!source_.read(entry.value_position + index * width, 2, value.data())) {
+        return std::nullopt;
+      }
+      return u16(value.data());
+    case 4:
+    case 13:
+      if (!source_.read(entry.value_position + index * width, 4, value.data())) {
+        return std::nullopt;
+      }
+      return u32(value.data());
+    default:
+      return std::nullopt;
+  }
+}
+
+std::optional<std::string> TiffReader::readAscii(const IfdEntry& entry) const {
+  if (entry.type != 2 || entry.count == 0) {
+    return std::nullopt;
+  }
+  std::string value(entry.count, '\0');
+  if (!source_.read(entry.value_position, value.size(),
+                    reinterpret_cast<std::uint8_t*>(value.data()))) {
+    return std::nullopt;
+  }
+  if (const auto nul = value.find('\0'); nul != std::string::npos) {
+    value.resize(nul);
+  }
+  return value;
+}
+
+bool TiffReader::readBytes(const IfdEntry& entry, std::vector<std::uint8_t>& out) const {
+  const auto length = entry.byteLength();
+  if (length == 0 || length > source_.size()) {
+    return false;
+  }
+  out.resize(length);
+  return source_.read(entry.value_position, length, out.data());
+}
+
+std::uint16_t TiffReader::u16(const std::uint8_t* p) const {
+  return little_endian_ ? static_cast<std::uint16_t>(p[0] | (p[1] << 8))
+                        : static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+}
+
+std::uint32_t TiffReader::u32(const std::uint8_t* p) const {
+  return little_endian_
+             ? static_cast<std::uint32_t>(p[0]) |
+                   (static_cast<std::uint32_t>(p[1]) << 8) |
+                   (static_cast<std::uint32_t>(p[2]) << 16) |
+                   (static_cast<std::uint32_t>(p[3]) << 24)
+             : (static_cast<std::uint32_t>(p[0]) << 24) |
+                   (static_cast<std::uint32_t>(p[1]) << 16) |
+                   (static_cast<std::uint32_t>(p[2]) << 8) |
+                   static_cast<std::uint32_t>(p[3]);
+}
+
+std::optional<std::int64_t> ParseExifDateTime(const std::string& value) {
+  int year = 0;
+  unsigned month = 0;
+  unsigned day = 0;
+  int hour = 0;
+  int minute = 0;
+  int second = 0;
+  if (value.size() < 19 ||
+      std::sscanf(value.c_str(), "%4d:%2u:%2u %2d:%2d:%2d", &year, &month, &day,
+                  &hour, &minute, &second) != 6) {
+    return std::nullopt;
+  }
+  if (year <= 0 || month < 1 || month > 12 || day < 1 || day > 31) {
+    return std::nullopt;
+  }
+  return daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 +
+         second;
+}
+
+}  // namespace cataloger::services::preview::tiff
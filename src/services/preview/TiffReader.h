@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cataloger::services::preview::tiff {
+
+// Random-access byte provider so the same IFD walker can run over an
+// in-memory EXIF block or positional reads into a large RAW file.
+class ByteSource {
+public:
+  virtual ~ByteSource() = default;
+  virtual bool read(std::uint64_t offset, std::size_t length, std::uint8_t* out) const = 0;
+  [[nodiscard]] virtual std::uint64_t size() const = 0;
+};
+
+class SpanSource : public ByteSource {
+public:
+  explicit SpanSource(std::span<const std::uint8_t> bytes) : bytes_(bytes) {}
+
+  bool read(std::uint64_t offset, std::size_t length, std::uint8_t* out) const override;
+  [[nodiscard]] std::uint64_t size() const override { return bytes_.size(); }
+
+private:
+  std::span<const std::uint8_t> bytes_;
+};
+
+// Positional reads into a file on disk; only the bytes asked for are read.
+class FileSource : public ByteSource {
+public:
+  explicit FileSource(const std::filesystem::path& path);
+
+  [[nodiscard]] bool isOpen() const noexcept { return open_; }
+  bool read(std::uint64_t offset, std::size_t length, std::uint8_t* out) const override;
+  [[nodiscard]] std::uint64_t size() const override { return size_; }
+
+private:
+  mutable std::ifstream stream_;
+  std::uint64_t size_{0};
+  bool open_{false};
+};
+
+enum Tag : std::uint16_t {
+  kTagCompression = 0x0103,
+  kTagStripOffsets = 0x0111,
+  kTagStripByteCounts = 0x0117,
+  kTagSubIfds = 0x014A,
+  kTagJpegInterchangeFormat = 0x0201,
+  kTagJpegInterchangeFormatLength = 0x0202,
+  kTagOrientation = 0x0112,
+  kTagExifIfd = 0x8769,
+  kTagIccProfile = 0x8773,  // 34675, InterColorProfile
+  kTagDateTimeOriginal = 0x9003,
+};
+
+struct IfdEntry {
+  std::uint16_t tag{};
+  std::uint16_t type{};
+  std::uint32_t count{};
+  // Absolute position of the value bytes (inline values point into the entry).
+  std::uint64_t value_position{};
+
+  [[nodiscard]] std::size_t byteLength() const;
+};
+
+class TiffReader {
+public:
+  // `base` is the position of the TIFF header ("II*\0" / "MM\0*") inside the
+  // source; IFD offsets are relative to it.
+  explicit TiffReader(const ByteSource& source, std::uint64_t base = 0);
+
+  [[nodiscard]] bool valid() const noexcept { return valid_; }
+  [[nodiscard]] std::uint32_t firstIfdOffset() const noexcept { return first_ifd_; }
+
+  std::vector<IfdEntry> readIfd(std::uint32_t offset,
+                                std::uint32_t* next_ifd = nullptr) const;
+  static std::optional<IfdEntry> find(const std::vector<IfdEntry>& entries,
+                                      std::uint16_t tag);
+
+  [[nodiscard]] std::optional<std::uint32_t> readUnsigned(const IfdEntry& entry,
+                                                          std::size_t index = 0) const;
+  [[nodiscard]] std::optional<std::string> readAscii(const IfdEntry& entry) const;
+  bool readBytes(const IfdEntry& entry, std::vector<std::uint8_t>& out) const;
+
+  // Converts an IFD-relative offset into an absolute source position.
+  [[nodiscard]] std::uint64_t absolute(std::uint32_t offset) const noexcept {
+    return base_ + offset;
+  }
+
+private:
+  [[nodiscard]] std::uint16_t u16(const std::uint8_t* p) const;
+  [[nodiscard]] std::uint32_t u32(const std::uint8_t* p) const;
+
+  const ByteSource& source_;
+  std::uint64_t base_;
+  bool little_endian_{true};
+  bool valid_{false};
+  std::uint32_t first_ifd_{0};
+};
+
+// Parses an EXIF "YYYY:MM:DD HH:MM:SS" stamp as UTC seconds since epoch.
+std::optional<std::int64_t> ParseExifDateTime(const std::string& value);
+
+}  // namespace cataloger::services::preview::tiff
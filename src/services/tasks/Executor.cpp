@@ -0,0 +1,12 @@
+#include "Executor.h"
+
+#include <utility>
+
+namespace cataloger::services::tasks {
+
+void SchedulerExecutor::post(std::function<void()> work) {
+  scheduler_.submit(lane_, [work = std::move(work)](std::stop_token) { work(); },
+                    {.name = "continuation"});
+}
+
+}  // namespace cataloger::services::tasks
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <functional>
+
+#include "TaskScheduler.h"
+
+namespace cataloger::services::tasks {
+
+// Where coroutine continuations run. A UI toolkit plugs in its main-loop
+// executor; services resume on the shared TaskScheduler.
+class Executor {
+public:
+  virtual ~Executor() = default;
+  virtual void post(std::function<void()> work) = 0;
+};
+
+// Runs work on the calling thread before post() returns.
+class InlineExecutor final : public Executor {
+public:
+  void post(std::function<void()> work) override { work(); }
+};
+
+// Runs work as a task on one lane of a scheduler, which must outlive every
+// coroutine resumed through it.
+class SchedulerExecutor final : public Executor {
+public:
+  SchedulerExecutor(TaskScheduler& scheduler, Lane lane) : scheduler_(scheduler), lane_(lane) {}
+
+  void post(std::function<void()> work) override;
+
+  [[nodiscard]] Lane lane() const noexcept { return lane_; }
+
+private:
+  TaskScheduler& scheduler_;
+  Lane lane_;
+};
+
+}  // namespace cataloger::services::tasks
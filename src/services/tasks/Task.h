@@ -0,0 +1,205 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "Executor.h"
+
+namespace cataloger::services::tasks {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+  // Resumed when the task finishes: whoever co_awaited it.
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> self) noexcept {
+      const auto next = self.promise().continuation;
+      return next ? next : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+  std::optional<T> value;
+
+  Task<T> get_return_object() noexcept;
+  template <typename U>
+  void return_value(U&& result) {
+    value.emplace(std::forward<U>(result));
+  }
+  T result() {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+    return std::move(*value);
+  }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+  Task<void> get_return_object() noexcept;
+  void return_void() const noexcept {}
+  void result() const {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+};
+
+// Starts on creation and frees itself on completion; the body must not
+// let exceptions escape.
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+}  // namespace detail
+
+// Lazily started coroutine: nothing runs until it is co_awaited (or handed
+// to SyncWait / Detach), and the awaiting coroutine resumes on whichever
+// thread finishes it. Use ResumeOn() to pick the thread explicitly.
+template <typename T>
+class [[nodiscard]] Task {
+public:
+  using promise_type = detail::Promise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Task() = default;
+  explicit Task(Handle handle) noexcept : handle_(handle) {}
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      reset();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  ~Task() { reset(); }
+
+  [[nodiscard]] bool valid() const noexcept { return static_cast<bool>(handle_); }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      Handle handle;
+      bool await_ready() const noexcept { return !handle || handle.done(); }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+      }
+      T await_resume() { return handle.promise().result(); }
+    };
+    return Awaiter{handle_};
+  }
+
+private:
+  void reset() noexcept {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = {};
+    }
+  }
+
+  Handle handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+  return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+template <typename T>
+struct SyncState {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done{false};
+  std::exception_ptr exception;
+  std::optional<std::conditional_t<std::is_void_v<T>, bool, T>> value;
+};
+
+template <typename T>
+Detached RunAndSignal(Task<T> task, SyncState<T>* state) {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await std::move(task);
+      state->value.emplace(true);
+    } else {
+      state->value.emplace(co_await std::move(task));
+    }
+  } catch (...) {
+    state->exception = std::current_exception();
+  }
+  std::lock_guard lock(state->mutex);
+  state->done = true;
+  state->cv.notify_all();
+}
+
+}  // namespace detail
+
+// Continues the awaiting coroutine as work posted to `executor`.
+inline auto ResumeOn(Executor& executor) noexcept {
+  struct Awaiter {
+    Executor& executor;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const {
+      executor.post([handle] { handle.resume(); });
+    }
+    void await_resume() const noexcept {}
+  };
+  return Awaiter{executor};
+}
+
+// Blocks the calling thread until `task` finishes. For tests, tools and
+// shutdown paths; never call it on a thread the task needs to resume on.
+template <typename T>
+T SyncWait(Task<T> task) {
+  detail::SyncState<T> state;
+  detail::RunAndSignal(std::move(task), &state);
+  std::unique_lock lock(state.mutex);
+  state.cv.wait(lock, [&] { return state.done; });
+  if (state.exception) {
+    std::rethrow_exception(state.exception);
+  }
+  if constexpr (!std::is_void_v<T>) {
+    return std::move(*state.value);
+  }
+}
+
+// Runs `task` to completion without waiting for it; it starts on the
+// calling thread. Exceptions must be handled inside the task.
+inline void Detach(Task<void> task) {
+  [](Task<void> owned) -> detail::Detached { co_await std::move(owned); }(std::move(task));
+}
+
+}  // namespace cataloger::services::tasks
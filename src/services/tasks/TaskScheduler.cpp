@@ -1,17 +1,482 @@
 #include "TaskScheduler.h"
 
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
 namespace cataloger::services::tasks {
 
-void TaskScheduler::schedule(std::string taskName) {
-  tasks_.push(std::move(taskName));
+struct TaskState {
+  TaskScheduler* owner{nullptr};
+  std::uint64_t id{0};
+  std::size_t lane{0};
+  std::string name;
+  TaskScheduler::Task fn;
+  std::stop_source stop;
+  std::atomic<TaskStatus> status{TaskStatus::kWaiting};
+  // Guarded by the owner's mutex.
+  std::size_t unmet{0};
+  std::vector<std::shared_ptr<TaskState>> dependents;
+  std::chrono::steady_clock::time_point ready_at;
+
+  std::mutex done_mutex;
+  std::condition_variable done_cv;
+};
+
+namespace {
+
+// Set on scheduler worker threads so nested submissions stay local.
+thread_local const TaskScheduler* tls_scheduler = nullptr;
+thread_local std::size_t tls_worker = 0;
+
+bool IsTerminal(TaskStatus status) {
+  return status == TaskStatus::kCompleted || status == TaskStatus::kFailed ||
+         status == TaskStatus::kCancelled;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+std::size_t defaultLimit(Lane lane, std::size_t workers) {
+  switch (lane) {
+    case Lane::kInteractive:
+    case Lane::kPreview:
+      return workers;
+    case Lane::kIngest:
+      return std::max<std::size_t>(1, workers / 2);
+    case Lane::kMetadata:
+    case Lane::kDelivery:
+      return std::max<std::size_t>(1, workers / 4);
+    case Lane::kMaintenance:
+      return 1;
+  }
+  return 1;
+}
+
+}  // namespace
+
+const char* LaneName(Lane lane) {
+  switch (lane) {
+    case Lane::kInteractive:
+      return "interactive";
+    case Lane::kPreview:
+      return "preview";
+    case Lane::kIngest:
+      return "ingest";
+    case Lane::kMetadata:
+      return "metadata";
+    case Lane::kDelivery:
+      return "delivery";
+    case Lane::kMaintenance:
+      return "maintenance";
+  }
+  return "unknown";
+}
+
+std::uint64_t TaskHandle::id() const {
+  return state_ ? state_->id : 0;
+}
+
+TaskStatus TaskHandle::status() const {
+  return state_ ? state_->status.load() : TaskStatus::kCancelled;
+}
+
+bool TaskHandle::cancel() {
+  // Once terminal the scheduler may be gone; never touch it then.
+  if (!state_ || IsTerminal(state_->status.load())) {
+    return false;
+  }
+  return state_->owner->cancel(state_);
+}
+
+void TaskHandle::wait() const {
+  if (!state_) {
+    return;
+  }
+  std::unique_lock lock(state_->done_mutex);
+  state_->done_cv.wait(lock, [&] { return IsTerminal(state_->status.load()); });
+}
+
+TaskScheduler::TaskScheduler(Options options) : options_(options) {
+  auto workers = options_.worker_count;
+  if (workers == 0) {
+    workers = std::max<std::size_t>(2, std::thread::hardware_concurrency());
+  }
+  for (std::size_t lane = 0; lane < kLaneCount; ++lane) {
+    const auto limit = options_.lane_limits[lane];
+    limits_[lane] = limit != 0 ? limit : defaultLimit(static_cast<Lane>(lane), workers);
+  }
+  background_limit_ = workers > options_.interactive_reserve
+                          ? workers - options_.interactive_reserve
+                          : 1;
+
+  workers_.reserve(workers);
+  for (std::size_t i = 0; i < workers; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  // Started only once every worker exists, since workers steal from each other.
+  for (std::size_t i = 0; i < workers; ++i) {
+    workers_[i]->thread =
+        std::jthread([this, i](std::stop_token token) { workerLoop(i, std::move(token)); });
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+    const auto drop = [&](std::deque<StatePtr>& queue) {
+      for (auto& state : queue) {
+        auto expected = TaskStatus::kQueued;
+        if (state->status.compare_exchange_strong(expected, TaskStatus::kCancelled)) {
+          --lanes_[state->lane].queued;
+          finishLocked(state, TaskStatus::kCancelled);
+        }
+      }
+      queue.clear();
+    };
+    for (auto& queue : injector_) {
+      drop(queue);
+    }
+    for (auto& worker : workers_) {
+      std::lock_guard worker_lock(worker->mutex);
+      for (auto& queue : worker->local) {
+        drop(queue);
+      }
+      if (worker->current) {
+        worker->current->stop.request_stop();
+      }
+    }
+    work_cv_.notify_all();
+  }
+  // Join every thread before any Worker goes away: idle workers may still
+  // be probing the others' deques.
+  for (auto& worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.request_stop();
+      worker->thread.join();
+    }
+  }
+  workers_.clear();
+}
+
+TaskHandle TaskScheduler::submit(Lane lane, Task task, TaskOptions options) {
+  auto state = std::make_shared<TaskState>();
+  state->owner = this;
+  state->lane = static_cast<std::size_t>(lane);
+  state->name = std::move(options.name);
+  state->fn = std::move(task);
+
+  std::lock_guard lock(mutex_);
+  state->id = next_id_++;
+  ++outstanding_;
+  bool dependency_failed = stopping_;
+  for (const auto& dependency : options.after) {
+    if (!dependency.state_ || dependency.state_->owner != this) {
+      continue;
+    }
+    const auto status = dependency.state_->status.load();
+    if (status == TaskStatus::kCompleted) {
+      continue;
+    }
+    if (IsTerminal(status)) {
+      dependency_failed = true;
+      break;
+    }
+    dependency.state_->dependents.push_back(state);
+    ++state->unmet;
+  }
+
+  if (dependency_failed) {
+    finishLocked(state, TaskStatus::kCancelled);
+  } else if (state->unmet > 0) {
+    ++lanes_[state->lane].waiting;
+  } else {
+    enqueueLocked(state, true);
+  }
+  return TaskHandle(state);
+}
+
+void TaskScheduler::setLaneLimit(Lane lane, std::size_t limit) {
+  limits_[static_cast<std::size_t>(lane)] = std::max<std::size_t>(1, limit);
+  std::lock_guard lock(mutex_);
+  ++epoch_;
+  work_cv_.notify_all();
+}
+
+void TaskScheduler::waitIdle() const {
+  std::unique_lock lock(mutex_);
+  idle_cv_.wait(lock, [&] { return outstanding_ == 0; });
+}
+
+LaneStats TaskScheduler::laneStats(Lane lane) const {
+  const auto index = static_cast<std::size_t>(lane);
+  std::lock_guard lock(mutex_);
+  const auto& counters = lanes_[index];
+  LaneStats stats;
+  stats.limit = limits_[index];
+  stats.queued = counters.queued;
+  stats.running = running_[index];
+  stats.waiting = counters.waiting;
+  stats.completed = counters.completed;
+  stats.failed = counters.failed;
+  stats.cancelled = counters.cancelled;
+  stats.stolen = counters.stolen;
+  if (counters.started > 0) {
+    stats.mean_queue_ms = counters.queue_ms_total / static_cast<double>(counters.started);
+  }
+  stats.max_queue_ms = counters.queue_ms_max;
+  const auto finished = counters.completed + counters.failed;
+  if (finished > 0) {
+    stats.mean_run_ms = counters.run_ms_total / static_cast<double>(finished);
+  }
+  return stats;
+}
+
+void TaskScheduler::workerLoop(std::size_t index, std::stop_token token) {
+  tls_scheduler = this;
+  tls_worker = index;
+  auto& worker = *workers_[index];
+  while (!token.stop_requested()) {
+    std::uint64_t seen = 0;
+    {
+      std::lock_guard lock(mutex_);
+      if (stopping_) {
+        return;
+      }
+      seen = epoch_;
+    }
+
+    bool stolen = false;
+    if (auto state = nextTask(index, stolen)) {
+      {
+        std::lock_guard lock(worker.mutex);
+        worker.current = state;
+      }
+      run(state, stolen);
+      std::lock_guard lock(worker.mutex);
+      worker.current.reset();
+      continue;
+    }
+
+    std::unique_lock lock(mutex_);
+    work_cv_.wait(lock, [&] { return stopping_ || epoch_ != seen; });
+  }
+}
+
+// Highest lane first; a lane is skipped while it is at its cap.
+TaskScheduler::StatePtr TaskScheduler::nextTask(std::size_t index, bool& stolen) {
+  for (std::size_t lane = 0; lane < kLaneCount; ++lane) {
+    if (!reserveSlot(lane)) {
+      continue;
+    }
+    if (auto state = takeFrom(index, lane, stolen)) {
+      return state;
+    }
+    releaseSlot(lane);
+  }
+  return nullptr;
+}
+
+// Own deque newest-first, then the shared injector, then the oldest task of
+// another worker. Cancelled entries are dropped on the way.
+TaskScheduler::StatePtr TaskScheduler::takeFrom(std::size_t index,
+                                                std::size_t lane,
+                                                bool& stolen) {
+  const auto claim = [](const StatePtr& state) {
+    auto expected = TaskStatus::kQueued;
+    return state->status.compare_exchange_strong(expected, TaskStatus::kRunning);
+  };
+
+  {
+    auto& own = workers_[index];
+    std::lock_guard lock(own->mutex);
+    auto& queue = own->local[lane];
+    while (!queue.empty()) {
+      auto state = std::move(queue.back());
+      queue.pop_back();
+      if (claim(state)) {
+        stolen = false;
+        return state;
+      }
+    }
+  }
+  {
+    std::lock_guard lock(mutex_);
+    auto& queue = injector_[lane];
+    while (!queue.empty()) {
+      auto state = std::move(queue.front());
+      queue.pop_front();
+      if (claim(state)) {
+        stolen = false;
+        return state;
+      }
+    }
+  }
+  for (std::size_t offset = 1; offset < workers_.size(); ++offset) {
+    auto& victim = workers_[(index + offset) % workers_.size()];
+    std::lock_guard lock(victim->mutex);
+    auto& queue = victim->local[lane];
+    while (!queue.empty()) {
+      auto state = std::move(queue.front());
+      queue.pop_front();
+      if (claim(state)) {
+        stolen = true;
+        return state;
+      }
+    }
+  }
+  return nullptr;
+}
+
+bool TaskScheduler::reserveSlot(std::size_t lane) {
+  auto& running = running_[lane];
+  auto current = running.load();
+  do {
+    if (current >= limits_[lane].load()) {
+      return false;
+    }
+  } while (!running.compare_exchange_weak(current, current + 1));
+
+  if (lane != static_cast<std::size_t>(Lane::kInteractive)) {
+    auto background = background_running_.load();
+    do {
+      if (background >= background_limit_) {
+        running.fetch_sub(1);
+        return false;
+      }
+    } while (!background_running_.compare_exchange_weak(background, background + 1));
+  }
+  return true;
+}
+
+void TaskScheduler::releaseSlot(std::size_t lane) {
+  running_[lane].fetch_sub(1);
+  if (lane != static_cast<std::size_t>(Lane::kInteractive)) {
+    background_running_.fetch_sub(1);
+  }
+}
+
+void TaskScheduler::run(const StatePtr& state, bool stolen) {
+  {
+    std::lock_guard lock(mutex_);
+    auto& counters = lanes_[state->lane];
+    --counters.queued;
+    ++counters.started;
+    if (stolen) {
+      ++counters.stolen;
+    }
+    const auto queued_ms = elapsedMs(state->ready_at);
+    counters.queue_ms_total += queued_ms;
+    counters.queue_ms_max = std::max(counters.queue_ms_max, queued_ms);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto outcome = TaskStatus::kCompleted;
+  try {
+    state->fn(state->stop.get_token());
+  } catch (...) {
+    outcome = TaskStatus::kFailed;
+  }
+  if (outcome == TaskStatus::kCompleted && state->stop.stop_requested()) {
+    outcome = TaskStatus::kCancelled;
+  }
+  const auto run_ms = elapsedMs(start);
+  state->fn = nullptr;  // drop captures before waking waiters
+  releaseSlot(state->lane);
+
+  std::lock_guard lock(mutex_);
+  lanes_[state->lane].run_ms_total += run_ms;
+  finishLocked(state, outcome);
+}
+
+void TaskScheduler::enqueueLocked(const StatePtr& state, bool prefer_local) {
+  if (stopping_) {
+    finishLocked(state, TaskStatus::kCancelled);
+    return;
+  }
+  state->status = TaskStatus::kQueued;
+  state->ready_at = std::chrono::steady_clock::now();
+  ++lanes_[state->lane].queued;
+  if (prefer_local && tls_scheduler == this) {
+    auto& own = workers_[tls_worker];
+    std::lock_guard lock(own->mutex);
+    own->local[state->lane].push_back(state);
+  } else {
+    injector_[state->lane].push_back(state);
+  }
+  wakeLocked();
+}
+
+void TaskScheduler::finishLocked(const StatePtr& state, TaskStatus status) {
+  auto& counters = lanes_[state->lane];
+  switch (status) {
+    case TaskStatus::kCompleted:
+      ++counters.completed;
+      break;
+    case TaskStatus::kFailed:
+      ++counters.failed;
+      break;
+    default:
+      ++counters.cancelled;
+      break;
+  }
+  state->fn = nullptr;
+  {
+    std::lock_guard lock(state->done_mutex);
+    state->status = status;
+  }
+  state->done_cv.notify_all();
+  --outstanding_;
+
+  auto dependents = std::move(state->dependents);
+  for (const auto& dependent : dependents) {
+    if (dependent->status.load() != TaskStatus::kWaiting) {
+      continue;  // cancelled on its own already
+    }
+    if (status == TaskStatus::kCompleted && --dependent->unmet > 0) {
+      continue;
+    }
+    --lanes_[dependent->lane].waiting;
+    if (status == TaskStatus::kCompleted) {
+      enqueueLocked(dependent, false);
+    } else {
+      finishLocked(dependent, TaskStatus::kCancelled);
+    }
+  }
+
+  wakeLocked();
+  if (outstanding_ == 0) {
+    idle_cv_.notify_all();
+  }
 }
 
-bool TaskScheduler::empty() const noexcept {
-  return tasks_.empty();
+bool TaskScheduler::cancel(const StatePtr& state) {
+  std::lock_guard lock(mutex_);
+  auto status = state->status.load();
+  if (status == TaskStatus::kWaiting) {
+    --lanes_[state->lane].waiting;
+    finishLocked(state, TaskStatus::kCancelled);
+    return true;
+  }
+  if (status == TaskStatus::kQueued &&
+      state->status.compare_exchange_strong(status, TaskStatus::kCancelled)) {
+    --lanes_[state->lane].queued;
+    finishLocked(state, TaskStatus::kCancelled);
+    return true;
+  }
+  if (status == TaskStatus::kRunning) {
+    state->stop.request_stop();
+    return true;
+  }
+  return false;
 }
 
-std::size_t TaskScheduler::size() const noexcept {
-  return tasks_.size();
+void TaskScheduler::wakeLocked() {
+  ++epoch_;
+  work_cv_.notify_one();
 }
 
 }  // namespace cataloger::services::tasks
@@ -1,19 +1,167 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
-#include <queue>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace cataloger::services::tasks {
 
+// Work lanes in priority order: a free worker always takes the highest
+// lane that has runnable work and spare capacity.
+enum class Lane : std::uint8_t {
+  kInteractive,
+  kPreview,
+  kIngest,
+  kMetadata,
+  kDelivery,
+  kMaintenance,
+};
+
+inline constexpr std::size_t kLaneCount = 6;
+
+[[nodiscard]] const char* LaneName(Lane lane);
+
+enum class TaskStatus { kWaiting, kQueued, kRunning, kCompleted, kFailed, kCancelled };
+
+struct TaskState;
+
+class TaskHandle {
+public:
+  TaskHandle() = default;
+
+  [[nodiscard]] bool valid() const noexcept { return state_ != nullptr; }
+  [[nodiscard]] std::uint64_t id() const;
+  [[nodiscard]] TaskStatus status() const;
+  // A task that has not started is dropped (and so are its dependents); a
+  // running one sees stop requested on its stop_token. Returns false once
+  // the task has finished.
+  bool cancel();
+  // Blocks until the task completes, fails or is cancelled.
+  void wait() const;
+
+private:
+  friend class TaskScheduler;
+  explicit TaskHandle(std::shared_ptr<TaskState> state) : state_(std::move(state)) {}
+
+  std::shared_ptr<TaskState> state_;
+};
+
+struct TaskOptions {
+  std::string name;
+  // Runs only after all of these complete; if any fails or is cancelled,
+  // this task is cancelled too.
+  std::vector<TaskHandle> after{};
+};
+
+struct LaneStats {
+  std::size_t limit{0};
+  std::size_t queued{0};
+  std::size_t running{0};
+  std::size_t waiting{0};  // blocked on dependencies
+  std::uint64_t completed{0};
+  std::uint64_t failed{0};
+  std::uint64_t cancelled{0};
+  std::uint64_t stolen{0};
+  double mean_queue_ms{0.0};  // submit (or release) to start
+  double max_queue_ms{0.0};
+  double mean_run_ms{0.0};
+};
+
+// Process-wide worker pool shared by the services, so the total thread
+// count stays bounded. Tasks are cooperative: priority decides which task
+// a free worker starts next, and a share of the workers is held back from
+// background lanes so interactive work never queues behind them. Tasks
+// submitted from a worker go to that worker's own deque (newest first);
+// idle workers steal the oldest from other workers' deques.
 class TaskScheduler {
 public:
-  void schedule(std::string taskName);
-  [[nodiscard]] bool empty() const noexcept;
-  [[nodiscard]] std::size_t size() const noexcept;
+  using Task = std::function<void(std::stop_token)>;
+
+  struct Options {
+    std::size_t worker_count{0};  // 0: hardware concurrency, at least 2
+    // Per-lane concurrency caps; 0 picks a default from worker_count.
+    std::array<std::size_t, kLaneCount> lane_limits{};
+    // Workers that lanes below kInteractive may never occupy together.
+    std::size_t interactive_reserve{1};
+  };
+
+  explicit TaskScheduler(Options options);
+  TaskScheduler() : TaskScheduler(Options{}) {}
+  // Cancels queued and waiting tasks, stops running ones and joins.
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler&) = delete;
+  TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+  TaskHandle submit(Lane lane, Task task, TaskOptions options = {});
+  void setLaneLimit(Lane lane, std::size_t limit);
+  // Blocks until nothing is queued, waiting or running.
+  void waitIdle() const;
+
+  [[nodiscard]] std::size_t workerCount() const noexcept { return workers_.size(); }
+  [[nodiscard]] LaneStats laneStats(Lane lane) const;
 
 private:
-  std::queue<std::string> tasks_;
+  friend class TaskHandle;
+  using StatePtr = std::shared_ptr<TaskState>;
+
+  struct Worker {
+    std::mutex mutex;
+    std::array<std::deque<StatePtr>, kLaneCount> local;
+    StatePtr current;
+    std::jthread thread;
+  };
+
+  struct LaneCounters {
+    std::size_t queued{0};
+    std::size_t waiting{0};
+    std::uint64_t completed{0};
+    std::uint64_t failed{0};
+    std::uint64_t cancelled{0};
+    std::uint64_t stolen{0};
+    std::uint64_t started{0};
+    double queue_ms_total{0.0};
+    double queue_ms_max{0.0};
+    double run_ms_total{0.0};
+  };
+
+  void workerLoop(std::size_t index, std::stop_token token);
+  StatePtr nextTask(std::size_t index, bool& stolen);
+  StatePtr takeFrom(std::size_t index, std::size_t lane, bool& stolen);
+  bool reserveSlot(std::size_t lane);
+  void releaseSlot(std::size_t lane);
+  void run(const StatePtr& state, bool stolen);
+  void enqueueLocked(const StatePtr& state, bool prefer_local);
+  void finishLocked(const StatePtr& state, TaskStatus status);
+  bool cancel(const StatePtr& state);
+  void wakeLocked();
+
+  Options options_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  mutable std::condition_variable idle_cv_;
+  std::uint64_t epoch_{0};  // bumped whenever work or capacity appears
+  bool stopping_{false};
+  std::uint64_t next_id_{1};
+  std::array<std::deque<StatePtr>, kLaneCount> injector_;
+  std::array<LaneCounters, kLaneCount> lanes_;
+  std::array<std::atomic<std::size_t>, kLaneCount> limits_{};
+  std::array<std::atomic<std::size_t>, kLaneCount> running_{};
+  std::atomic<std::size_t> background_running_{0};
+  std::size_t background_limit_{1};
+  std::size_t outstanding_{0};  // queued + waiting + running
+  std::vector<std::unique_ptr<Worker>> workers_;
 };
 
 }  // namespace cataloger::services::tasks
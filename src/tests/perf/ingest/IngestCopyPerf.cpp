@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "services/ingest/CopyEngine.h"
+
+using cataloger::platform::io::CopyMethodName;
+using cataloger::services::ingest::CopyEngine;
+using cataloger::services::ingest::CopyJob;
+using cataloger::services::ingest::CopyResult;
+
+namespace {
+
+std::string uniqueSuffix() {
+  const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::to_string(ticks);
+}
+
+std::size_t envCount(const char* name, std::size_t fallback) {
+  if (const char* env = std::getenv(name)) {
+    return static_cast<std::size_t>(std::strtoul(env, nullptr, 10));
+  }
+  return fallback;
+}
+
+}  // namespace
+
+// Copies a synthetic card between two local folders with the kernel copy
+// path and with the pread/pwrite fallback, and reports MB/s. The source is
+// freshly written, so it mostly comes from the page cache: this measures
+// the engine's overhead and the destination side, not the card reader.
+// Point CATALOGER_PERF_INGEST_SOURCE_DIR at a mounted card to measure one.
+TEST(IngestCopyPerf, ReportsThroughputForLocalFolders) {
+  const auto file_count = envCount("CATALOGER_PERF_INGEST_FILES", 48);
+  const auto file_mb = envCount("CATALOGER_PERF_INGEST_MB", 4);
+
+  const auto suffix = uniqueSuffix();
+  const auto scratch = std::filesystem::temp_directory_path() / ("ingest_perf_" + suffix);
+  auto source_root = scratch / "card";
+  if (const char* card = std::getenv("CATALOGER_PERF_INGEST_SOURCE_DIR")) {
+    source_root = card;
+  } else {
+    std::filesystem::create_directories(source_root);
+    std::vector<char> payload(file_mb * 1024 * 1024);
+    for (std::size_t i = 0; i < payload.size(); ++i) {
+      payload[i] = static_cast<char>((i * 131) >> 7);
+    }
+    for (std::size_t i = 0; i < file_count; ++i) {
+      char name[32];
+      std::snprintf(name, sizeof(name), "IMG_%04zu.CR3", i);
+      std::ofstream stream(source_root / name, std::ios::binary);
+      stream.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    }
+  }
+
+  std::vector<CopyJob> sources;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(source_root)) {
+    if (entry.is_regular_file()) {
+      sources.push_back({.source = entry.path(), .capture_time = entry.last_write_time()});
+    }
+  }
+  ASSERT_FALSE(sources.empty());
+
+  struct Mode {
+    const char* folder;
+    bool kernel_copy;
+    bool hash;
+  };
+  // The hashed run shows what inline XXH64 adds on top of pread/pwrite.
+  for (const auto& mode : {Mode{"kernel", true, false}, Mode{"userspace", false, false},
+                           Mode{"hashed", false, true}}) {
+    const auto destination = scratch / mode.folder;
+    auto jobs = sources;
+    for (auto& job : jobs) {
+      job.destination = destination / std::filesystem::relative(job.source, source_root);
+    }
+    CopyEngine::Options options;
+    options.kernel_copy = mode.kernel_copy;
+    options.hash = mode.hash;
+    options.sync = false;  // fsync cost depends on the disk, not the engine
+    CopyEngine engine(options);
+    const char* method = "";
+    const auto stats = engine.run(std::move(jobs), [&](const CopyResult& result) {
+      method = CopyMethodName(result.method);
+    });
+
+    std::cout << "[perf] ingest copy method=" << method << " hash=" << mode.hash
+              << " files=" << stats.files
+              << " bytes=" << stats.bytes << " elapsed_ms=" << stats.elapsed_ms
+              << " MB/s=" << stats.megabytesPerSecond()
+              << " peak_in_flight=" << stats.peak_in_flight << "\n";
+    EXPECT_EQ(stats.failed, 0u);
+    EXPECT_EQ(stats.files, sources.size());
+    EXPECT_GT(stats.megabytesPerSecond(), 0.0);
+  }
+
+  std::error_code ec;
+  std::filesystem::remove_all(scratch, ec);
+}
+
+// Copies the same card to two folders at once and then to one folder with
+// the userspace path, which mirrored copies always use. With the source read
+// once and both sides written concurrently, a disk-bound mirror costs about
+// one copy. Into the page cache on a single core the second memcpy pushes
+// it towards two. The mirrored run goes first so it does not benefit from
+// the single run warming the allocator.
+TEST(IngestCopyPerf, MirroredCopyCostsAboutOneCopy) {
+  const auto file_count = envCount("CATALOGER_PERF_INGEST_FILES", 48);
+  const auto file_mb = envCount("CATALOGER_PERF_INGEST_MB", 4);
+
+  const auto scratch = std::filesystem::temp_directory_path() / ("ingest_mirror_perf_" + uniqueSuffix());
+  const auto source_root = scratch / "card";
+  std::filesystem::create_directories(source_root);
+  std::vector<char> payload(file_mb * 1024 * 1024);
+  for (std::size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<char>((i * 131) >> 7);
+  }
+  std::vector<CopyJob> sources;
+  for (std::size_t i = 0; i < file_count; ++i) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "IMG_%04zu.CR3", i);
+    std::ofstream stream(source_root / name, std::ios::binary);
+    stream.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    stream.close();
+    sources.push_back({.source = source_root / name,
+                       .capture_time = std::filesystem::last_write_time(source_root / name)});
+  }
+
+  CopyEngine::Options options;
+  options.kernel_copy = false;
+  options.sync = false;
+
+  double single_ms = 0.0;
+  double mirrored_ms = 0.0;
+  for (const bool mirrored : {true, false}) {
+    auto jobs = sources;
+    for (auto& job : jobs) {
+      const auto name = job.source.filename();
+      job.destination = scratch / (mirrored ? "primary" : "single") / name;
+      if (mirrored) {
+        job.mirror = scratch / "mirror" / name;
+      }
+    }
+    CopyEngine engine(options);
+    const auto stats = engine.run(std::move(jobs));
+    (mirrored ? mirrored_ms : single_ms) = stats.elapsed_ms;
+
+    std::cout << "[perf] ingest copy destinations=" << (mirrored ? 2 : 1)
+              << " files=" << stats.files << " bytes=" << stats.bytes
+              << " elapsed_ms=" << stats.elapsed_ms << " MB/s=" << stats.megabytesPerSecond()
+              << "\n";
+    EXPECT_EQ(stats.failed, 0u);
+    EXPECT_EQ(stats.mirror_failed, 0u);
+  }
+  std::cout << "[perf] ingest mirror cost ratio=" << (single_ms > 0.0 ? mirrored_ms / single_ms : 0.0)
+            << "\n";
+
+  std::error_code ec;
+  std::filesystem::remove_all(scratch, ec);
+}
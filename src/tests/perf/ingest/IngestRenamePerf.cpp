@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "services/ingest/RenameTemplate.h"
+
+using cataloger::services::ingest::IngestRenamer;
+
+namespace {
+
+std::size_t envCount(const char* name, std::size_t fallback) {
+  if (const char* env = std::getenv(name)) {
+    return static_cast<std::size_t>(std::strtoul(env, nullptr, 10));
+  }
+  return fallback;
+}
+
+}  // namespace
+
+// Names a 10k-frame card of RAW+JPEG pairs through dated folder and job
+// file templates, collision checks included. Templates are compiled once
+// per job, so a name should cost a few microseconds at most.
+TEST(IngestRenamePerf, NamesTenThousandFilesInMicrosecondsEach) {
+  constexpr std::size_t kFiles = 10000;
+  std::vector<std::filesystem::path> sources;
+  std::vector<std::filesystem::path> layouts;
+  sources.reserve(kFiles);
+  layouts.reserve(kFiles);
+  for (std::size_t i = 0; i < kFiles; ++i) {
+    char layout[48];
+    std::snprintf(layout, sizeof(layout), "%03zuCANON/IMG_%04zu.%s", 100 + i / 2 / 9999,
+                  i / 2 % 9999, i % 2 == 0 ? "CR3" : "JPG");
+    layouts.emplace_back(layout);
+    sources.push_back(std::filesystem::path("/media/card/DCIM") / layouts.back());
+  }
+
+  IngestRenamer::Options options;
+  options.folder_template = "{year}/{year}-{month}-{day}_{job}";
+  options.file_template = "{job}_{year2}{month}{day}_{sequence:5}";
+  options.job = "Smith Wedding";
+  IngestRenamer renamer(options, std::filesystem::temp_directory_path() / "ingest_rename_perf");
+  const auto capture = std::filesystem::file_time_type::clock::now();
+
+  std::string out;
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < kFiles; ++i) {
+    renamer.assign(sources[i], layouts[i], capture, out);
+  }
+  const auto per_file_us =
+      std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+          .count() /
+      kFiles;
+
+  std::cout << "[IngestRenamePerf] files=" << kFiles << " per_file_us=" << per_file_us
+            << " last=" << out << std::endl;
+  EXPECT_EQ(renamer.nextSequence(), kFiles / 2 + 1);
+  EXPECT_TRUE(out.ends_with("_05000.JPG")) << out;
+  // Timing only holds on a quiet machine; shared CI runners just report it.
+  if (envCount("CATALOGER_PERF_INGEST_STRICT", 0) != 0) {
+    EXPECT_LT(per_file_us, 20.0);
+  }
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "services/ingest/IngestStateIndex.h"
+
+using cataloger::services::ingest::IngestStateIndex;
+using cataloger::services::ingest::IngestStateKey;
+
+namespace {
+
+std::size_t envCount(const char* name, std::size_t fallback) {
+  if (const char* env = std::getenv(name)) {
+    return static_cast<std::size_t>(std::strtoul(env, nullptr, 10));
+  }
+  return fallback;
+}
+
+IngestStateKey frameKey(std::size_t card, std::size_t frame) {
+  char path[48];
+  std::snprintf(path, sizeof(path), "DCIM/%03zuCANON/IMG_%04zu.CR3", 100 + frame / 9999,
+                frame % 9999);
+  return {"uuid:" + std::to_string(card), path, 25u * 1024 * 1024 + frame, 1700000000};
+}
+
+}  // namespace
+
+// Fills indexes with a season's worth of cards and times the stat-only
+// check for a full re-inserted card. The per-lookup cost should not grow
+// with the number of past ingests; only loading the file does.
+TEST(IngestStatePerf, LookupCostIsIndependentOfHistory) {
+  constexpr std::size_t kFramesPerCard = 2000;
+  const auto scratch =
+      std::filesystem::temp_directory_path() /
+      ("ingest_state_perf_" +
+       std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  std::filesystem::create_directories(scratch);
+
+  double small_ns = 0.0;
+  double large_ns = 0.0;
+  for (const std::size_t cards : {5u, 250u}) {
+    const auto file = scratch / (std::to_string(cards) + IngestStateIndex::kFileName);
+    {
+      IngestStateIndex index(file);
+      for (std::size_t card = 0; card < cards; ++card) {
+        for (std::size_t frame = 0; frame < kFramesPerCard; ++frame) {
+          index.record(frameKey(card, frame));
+        }
+      }
+    }
+
+    const auto load_start = std::chrono::steady_clock::now();
+    IngestStateIndex index(file);
+    const auto load_ms = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - load_start)
+                             .count();
+
+    const auto start = std::chrono::steady_clock::now();
+    std::size_t hits = 0;
+    for (std::size_t frame = 0; frame < kFramesPerCard; ++frame) {
+      hits += index.contains(frameKey(cards / 2, frame)) ? 1 : 0;
+    }
+    const auto per_lookup_ns = std::chrono::duration<double, std::nano>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count() /
+                               kFramesPerCard;
+    (cards == 5 ? small_ns : large_ns) = per_lookup_ns;
+
+    std::cout << "[perf] ingest state entries=" << index.size()
+              << " file_bytes=" << std::filesystem::file_size(file) << " load_ms=" << load_ms
+              << " lookup_ns=" << per_lookup_ns << "\n";
+    EXPECT_EQ(hits, kFramesPerCard);
+  }
+  // Generous: caches and allocator noise, not a complexity change. Still a
+  // timing, so shared CI runners just report it.
+  if (envCount("CATALOGER_PERF_INGEST_STRICT", 0) != 0) {
+    EXPECT_LT(large_ns, small_ns * 4.0);
+  }
+
+  std::error_code ec;
+  std::filesystem::remove_all(scratch, ec);
+}
@@ -1,12 +1,14 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <vector>
 
 #include "services/catalog/CatalogService.h"
+#include "services/preview/PreviewExtractor.h"
 #include "services/preview/PreviewService.h"
 
 using cataloger::services::catalog::CatalogService;
@@ -102,3 +104,51 @@ TEST(PreviewPipelinePerf, WarmRootUnderBudget) {
   std::filesystem::remove(db_path, ec);
   std::filesystem::remove_all(root_path, ec);
 }
+
+TEST(PreviewPipelinePerf, BatchedHeaderReads) {
+  // Override with CATALOGER_PERF_FILE_COUNT=10000 for a full-folder run.
+  std::size_t file_count = 1000;
+  if (const char* env = std::getenv("CATALOGER_PERF_FILE_COUNT")) {
+    file_count = static_cast<std::size_t>(std::strtoul(env, nullptr, 10));
+  }
+  constexpr std::size_t kFileBytes = 96 * 1024;
+  const auto root_path =
+      std::filesystem::temp_directory_path() / ("preview_batch_perf_" + uniqueSuffix());
+  std::filesystem::create_directories(root_path);
+
+  std::vector<cataloger::services::preview::PreviewDescriptor> descriptors(file_count);
+  for (std::size_t i = 0; i < file_count; ++i) {
+    auto& descriptor = descriptors[i];
+    descriptor.relative_path = "SHOT_" + std::to_string(i) + ".JPG";
+    descriptor.absolute_path = root_path / descriptor.relative_path;
+    descriptor.file_size = kFileBytes;
+    writeFile(descriptor.absolute_path, kFileBytes);
+  }
+
+  const cataloger::services::preview::PreviewExtractor extractor;
+  const auto reader = cataloger::platform::io::CreateBatchReader();
+  std::vector<cataloger::services::preview::ContainerMetadata> metadata;
+  std::size_t bytes = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t first = 0; first < file_count; first += PreviewService::kIoBatchSize) {
+    const auto count = std::min(PreviewService::kIoBatchSize, file_count - first);
+    const auto images = extractor.extractBatch(
+        *reader,
+        std::span<const cataloger::services::preview::PreviewDescriptor>(
+            descriptors.data() + first, count),
+        metadata);
+    for (const auto& image : images) {
+      bytes += image.pixels.size();
+    }
+  }
+  const auto seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "[perf] batched header reads backend="
+            << cataloger::platform::io::BackendName(reader->backend())
+            << " files=" << file_count << " MB/s="
+            << (static_cast<double>(bytes) / (1024.0 * 1024.0)) / seconds << "\n";
+  EXPECT_EQ(bytes, file_count * kFileBytes);
+
+  std::error_code ec;
+  std::filesystem::remove_all(root_path, ec);
+}
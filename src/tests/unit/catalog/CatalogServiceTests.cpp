@@ -3,9 +3,15 @@
 #include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <set>
 #include <sstream>
 
+#include <sqlite3.h>
+
 #include "services/catalog/CatalogService.h"
+#include "services/catalog/SyncReconciler.h"
+#include "services/catalog/SyncWatcher.h"
 
 namespace {
 
@@ -76,6 +82,18 @@ TEST_F(CatalogServiceTest, ScanAndIngestBuildsStacks) {
   EXPECT_EQ(stacked, 2);
 }
 
+TEST_F(CatalogServiceTest, ScanSkipsHiddenBookkeeping) {
+  std::filesystem::create_directories(root_path_ / ".trash");
+  writeFile(root_path_ / "IMG_0001.JPG");
+  writeFile(root_path_ / ".cataloger-ingest-state");
+  writeFile(root_path_ / ".IMG_0002.JPG.cataloger-partial");
+  writeFile(root_path_ / ".trash" / "IMG_0003.JPG");
+
+  const auto records = service_.scanRoot(root_path_);
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records.front().relative_path, "IMG_0001.JPG");
+}
+
 TEST_F(CatalogServiceTest, SyncQueuePersistsEvents) {
   const auto root_id = service_.registerRoot(root_path_);
   service_.enqueueSyncEvent(root_id, "IMG_0001.CR3", "created", "{}");
@@ -86,3 +104,324 @@ TEST_F(CatalogServiceTest, SyncQueuePersistsEvents) {
   events = service_.pendingSyncEvents();
   EXPECT_TRUE(events.empty());
 }
+
+#if defined(__linux__)
+TEST_F(CatalogServiceTest, SyncWatcherQueuesChangesInBatches) {
+  writeFile(root_path_ / "IMG_0001.CR3");
+  const auto root_id = service_.registerRoot(root_path_);
+  cataloger::platform::io::FileWatcher::Options options;
+  options.debounce = std::chrono::milliseconds(20);
+  cataloger::services::catalog::SyncWatcher watcher(service_, root_id, root_path_, options);
+  ASSERT_EQ(watcher.start(), 0);
+  writeFile(root_path_ / "IMG_0002.CR3");
+  std::filesystem::remove(root_path_ / "IMG_0001.CR3");
+  std::filesystem::create_directories(root_path_ / "day2");
+  watcher.stop();
+
+  EXPECT_EQ(watcher.queuedEvents(), 3u);
+  EXPECT_EQ(watcher.failedBatches(), 0u);
+  std::map<std::string, std::string> types;
+  for (const auto& event : service_.pendingSyncEvents()) {
+    EXPECT_EQ(event.root_id, root_id);
+    types[event.relative_path] = event.event_type;
+  }
+  EXPECT_EQ(types["IMG_0002.CR3"], cataloger::services::catalog::kSyncChanged);
+  EXPECT_EQ(types["IMG_0001.CR3"], cataloger::services::catalog::kSyncRemoved);
+  EXPECT_EQ(types["day2"], cataloger::services::catalog::kSyncRescan);
+}
+#endif
+
+TEST_F(CatalogServiceTest, SyncEventsAreClaimedOnceAndReleasable) {
+  namespace catalog = cataloger::services::catalog;
+  const auto root_id = service_.registerRoot(root_path_);
+  service_.enqueueSyncEvent(root_id, "", "bootstrap", "{}");
+  service_.enqueueSyncEvent(root_id, "IMG_0001.CR3", catalog::kSyncChanged, "{}");
+  service_.enqueueSyncEvent(root_id, "IMG_0002.CR3", catalog::kSyncRemoved, "{}");
+
+  const auto claimed = service_.claimSyncEvents(root_id, 8);
+  ASSERT_EQ(claimed.size(), 2u);  // app-defined events are not the reconciler's
+  EXPECT_EQ(claimed[0].relative_path, "IMG_0001.CR3");
+  EXPECT_TRUE(service_.claimSyncEvents(root_id, 8).empty());
+  EXPECT_EQ(service_.pendingSyncEvents().size(), 1u);
+
+  EXPECT_EQ(service_.releaseSyncEvents(root_id), 2u);
+  EXPECT_EQ(service_.claimSyncEvents(root_id, 1).size(), 1u);
+}
+
+TEST_F(CatalogServiceTest, SyncReconcilerAppliesOnlyWhatChanged) {
+  using cataloger::services::catalog::SyncOutcome;
+  using cataloger::services::catalog::SyncReconciler;
+  namespace catalog = cataloger::services::catalog;
+
+  std::filesystem::create_directories(root_path_ / "day1");
+  for (const char* name : {"IMG_0001.CR3", "IMG_0001.JPG", "IMG_0002.CR3", "IMG_0002.XMP",
+                           "day1/IMG_0003.JPG", "day1/IMG_0004.JPG"}) {
+    writeFile(root_path_ / name);
+  }
+  const auto root_id = service_.registerRoot(root_path_);
+  service_.ingestRecords(root_id, service_.scanRoot(root_path_));
+
+  // A sidecar rewritten in place: same size, new mtime.
+  const auto sidecar = root_path_ / "IMG_0002.XMP";
+  const auto before = std::filesystem::last_write_time(sidecar);
+  {
+    std::ofstream stream(sidecar, std::ios::trunc);
+    stream << "catalog-TEST";
+  }
+  std::filesystem::last_write_time(sidecar, before + std::chrono::seconds(1));
+  writeFile(root_path_ / "IMG_0005.CR3");
+  writeFile(root_path_ / "IMG_0005.JPG");
+  std::filesystem::remove(root_path_ / "IMG_0001.CR3");
+  std::filesystem::remove_all(root_path_ / "day1");
+
+  for (const char* name : {"IMG_0002.XMP", "IMG_0002.CR3", "IMG_0005.CR3", "IMG_0005.JPG"}) {
+    service_.enqueueSyncEvent(root_id, name, catalog::kSyncChanged, "{}");
+  }
+  service_.enqueueSyncEvent(root_id, "IMG_0001.CR3", catalog::kSyncRemoved, "{}");
+  service_.enqueueSyncEvent(root_id, "day1", catalog::kSyncRemoved, "{}");
+  service_.enqueueSyncEvent(root_id, "", "bootstrap", "{}");
+
+  SyncReconciler::Options options;
+  options.batch_size = 4;
+  SyncReconciler reconciler(service_, root_id, root_path_, options);
+  std::vector<SyncOutcome> outcomes;
+  reconciler.setChangeSink([&](int id, const SyncOutcome& outcome) {
+    EXPECT_EQ(id, root_id);
+    outcomes.push_back(outcome);
+  });
+  EXPECT_EQ(reconciler.drain(), 6u);
+  EXPECT_EQ(reconciler.reconciledEvents(), 6u);
+
+  std::set<std::string> changed;
+  std::set<std::string> removed;
+  std::size_t unchanged = 0;
+  for (const auto& outcome : outcomes) {
+    changed.insert(outcome.changed.begin(), outcome.changed.end());
+    removed.insert(outcome.removed.begin(), outcome.removed.end());
+    unchanged += outcome.unchanged;
+  }
+  EXPECT_EQ(changed, (std::set<std::string>{"IMG_0002.XMP", "IMG_0005.CR3", "IMG_0005.JPG"}));
+  EXPECT_EQ(removed, (std::set<std::string>{"IMG_0001.CR3", "day1/IMG_0003.JPG",
+                                            "day1/IMG_0004.JPG"}));
+  EXPECT_EQ(unchanged, 1u);  // IMG_0002.CR3
+
+  std::map<std::string, std::optional<std::int64_t>> stacks;
+  for (const auto& file : service_.listFiles(root_id)) {
+    stacks[file.relative_path] = file.stack_group_id;
+  }
+  ASSERT_EQ(stacks.size(), 5u);
+  EXPECT_FALSE(stacks["IMG_0001.JPG"].has_value());  // its RAW is gone
+  ASSERT_TRUE(stacks["IMG_0005.CR3"].has_value());
+  EXPECT_EQ(stacks["IMG_0005.CR3"], stacks["IMG_0005.JPG"]);
+  EXPECT_EQ(stacks["IMG_0002.CR3"], stacks["IMG_0002.XMP"]);
+
+  const auto pending = service_.pendingSyncEvents();
+  ASSERT_EQ(pending.size(), 1u);
+  EXPECT_EQ(pending.front().event_type, "bootstrap");
+}
+
+TEST_F(CatalogServiceTest, SyncReconcilerRescansOneFolderInTheBackground) {
+  using cataloger::services::catalog::SyncReconciler;
+  namespace catalog = cataloger::services::catalog;
+
+  std::filesystem::create_directories(root_path_ / "day1" / "selects");
+  for (const char* name : {"day1/IMG_0001.JPG", "day1/IMG_0002.JPG",
+                           "day1/selects/IMG_0001.JPG", "IMG_0009.JPG"}) {
+    writeFile(root_path_ / name);
+  }
+  const auto root_id = service_.registerRoot(root_path_);
+  service_.ingestRecords(root_id, service_.scanRoot(root_path_));
+
+  // Changes whose events were lost, e.g. to a watcher queue overflow.
+  std::filesystem::remove(root_path_ / "day1" / "IMG_0002.JPG");
+  std::filesystem::remove_all(root_path_ / "day1" / "selects");
+  writeFile(root_path_ / "day1" / "IMG_0003.JPG");
+  writeFile(root_path_ / "day1" / ".IMG_0004.JPG.cataloger-partial");
+  std::filesystem::remove(root_path_ / "IMG_0009.JPG");  // outside the folder
+
+  SyncReconciler reconciler(service_, root_id, root_path_, {});
+  service_.enqueueSyncEvent(root_id, "day1", catalog::kSyncRescan, "{}");
+  reconciler.wake();
+  reconciler.waitIdle();
+  EXPECT_EQ(reconciler.reconciledEvents(), 1u);
+  EXPECT_EQ(reconciler.failedBatches(), 0u);
+
+  std::set<std::string> paths;
+  for (const auto& file : service_.listFiles(root_id)) {
+    paths.insert(file.relative_path);
+  }
+  EXPECT_EQ(paths, (std::set<std::string>{"IMG_0009.JPG", "day1/IMG_0001.JPG",
+                                          "day1/IMG_0003.JPG"}));
+  EXPECT_TRUE(service_.pendingSyncEvents().empty());
+}
+
+TEST_F(CatalogServiceTest, SyncReconcilerLeavesAnUnreachableRootAlone) {
+  namespace catalog = cataloger::services::catalog;
+  writeFile(root_path_ / "IMG_0001.JPG");
+  const auto root_id = service_.registerRoot(root_path_);
+  service_.ingestRecords(root_id, service_.scanRoot(root_path_));
+  service_.enqueueSyncEvent(root_id, "IMG_0001.JPG", catalog::kSyncRemoved, "{}");
+
+  // The volume went away: nothing is deleted and the event stays queued.
+  catalog::SyncReconciler reconciler(service_, root_id, root_path_ / "unmounted", {});
+  EXPECT_THROW(reconciler.reconcileBatch(), std::runtime_error);
+  EXPECT_EQ(reconciler.failedBatches(), 1u);
+  EXPECT_EQ(service_.listFiles(root_id).size(), 1u);
+  EXPECT_EQ(service_.pendingSyncEvents().size(), 1u);
+}
+
+TEST_F(CatalogServiceTest, ContentHashRoundTripsThroughFiles) {
+  writeFile(root_path_ / "IMG_0001.CR3");
+  writeFile(root_path_ / "IMG_0002.CR3");
+  const auto root_id = service_.registerRoot(root_path_);
+  auto records = service_.scanRoot(root_path_);
+  ASSERT_EQ(records.size(), 2);
+  for (auto& record : records) {
+    if (record.filename == "IMG_0001.CR3") {
+      record.content_hash = 0xfedcba9876543210ull;  // above INT64_MAX
+    }
+  }
+  service_.ingestRecords(root_id, records);
+
+  auto stored = service_.listFiles(root_id);
+  ASSERT_EQ(stored.size(), 2);
+  for (const auto& file : stored) {
+    if (file.relative_path == "IMG_0001.CR3") {
+      ASSERT_TRUE(file.content_hash.has_value());
+      EXPECT_EQ(*file.content_hash, 0xfedcba9876543210ull);
+    } else {
+      EXPECT_FALSE(file.content_hash.has_value());
+      service_.updateContentHash(file.id, 42);
+    }
+  }
+  stored = service_.listFiles(root_id);
+  for (const auto& file : stored) {
+    EXPECT_TRUE(file.content_hash.has_value()) << file.relative_path;
+  }
+}
+
+TEST_F(CatalogServiceTest, InitializeSchemaAddsContentHashToOlderCatalogs) {
+  const auto old_db = std::filesystem::temp_directory_path() /
+                      ("cataloger_old_db_" + uniqueSuffix() + ".db");
+  {
+    sqlite3* db = nullptr;
+    ASSERT_EQ(sqlite3_open(old_db.string().c_str(), &db), SQLITE_OK);
+    const char* sql =
+        "CREATE TABLE root_folders (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "path TEXT UNIQUE NOT NULL, created_at INTEGER NOT NULL);"
+        "CREATE TABLE files (id INTEGER PRIMARY KEY AUTOINCREMENT, root_id INTEGER NOT NULL, "
+        "relative_path TEXT NOT NULL, filename TEXT NOT NULL, extension TEXT NOT NULL, "
+        "capture_ts INTEGER, rating INTEGER DEFAULT 0, color INTEGER DEFAULT 0, "
+        "ingest_seq INTEGER DEFAULT 0, file_size INTEGER, stack_group_id INTEGER, "
+        "metadata_rev INTEGER DEFAULT 0, preview_state INTEGER DEFAULT 0, "
+        "UNIQUE(root_id, relative_path));";
+    EXPECT_EQ(sqlite3_exec(db, sql, nullptr, nullptr, nullptr), SQLITE_OK);
+    sqlite3_close(db);
+  }
+
+  cataloger::services::catalog::CatalogService service;
+  service.configureDatabase(old_db);
+  service.initializeSchema();
+  service.initializeSchema();  // a second run finds the column and moves on
+  writeFile(root_path_ / "IMG_0001.CR3");
+  const auto root_id = service.registerRoot(root_path_);
+  auto records = service.scanRoot(root_path_);
+  records.front().content_hash = 7;
+  service.ingestRecords(root_id, records);
+  const auto stored = service.listFiles(root_id);
+  ASSERT_EQ(stored.size(), 1);
+  EXPECT_EQ(stored.front().content_hash, 7u);
+
+  std::error_code ec;
+  std::filesystem::remove(old_db, ec);
+}
+
+TEST_F(CatalogServiceTest, IngestJournalTracksFilesUntilCataloged) {
+  using cataloger::services::catalog::CatalogService;
+  using cataloger::services::catalog::IngestFileState;
+  using cataloger::services::catalog::IngestJobFile;
+
+  std::vector<IngestJobFile> planned(2);
+  planned[0].seq = 0;
+  planned[0].source = "/card/DCIM/IMG_0001.CR3";
+  planned[0].destination = (root_path_ / "IMG_0001.CR3").string();
+  planned[1].seq = 1;
+  planned[1].source = "/card/DCIM/IMG_0001.JPG";
+  planned[1].destination = (root_path_ / "IMG_0001.JPG").string();
+  const auto job_id = service_.createIngestJob(root_path_.string(), "", planned);
+  ASSERT_EQ(service_.unfinishedIngestJobs().size(), 1);
+
+  service_.updateIngestFiles(job_id, {{0, IngestFileState::kCopying, std::nullopt, {}},
+                                      {0, IngestFileState::kCopied, 0xfedcba9876543210ull, {}},
+                                      {1, IngestFileState::kFailed, std::nullopt, "EIO"}});
+  // Later updates without a hash keep the one already stored.
+  service_.updateIngestFiles(job_id, {{0, IngestFileState::kCopied, std::nullopt, {}}});
+  auto files = service_.loadIngestJobFiles(job_id);
+  ASSERT_EQ(files.size(), 2);
+  EXPECT_EQ(files[0].state, IngestFileState::kCopied);
+  EXPECT_EQ(files[0].content_hash, 0xfedcba9876543210ull);
+  EXPECT_EQ(files[1].state, IngestFileState::kFailed);
+  EXPECT_EQ(files[1].error, "EIO");
+
+  writeFile(root_path_ / "IMG_0001.CR3");
+  writeFile(root_path_ / "IMG_0001.JPG");
+  service_.updateIngestFiles(job_id, {{1, IngestFileState::kCopied, std::nullopt, {}}});
+  const auto root_id = service_.registerRoot(root_path_);
+  std::vector<std::pair<std::int64_t, cataloger::services::catalog::FileRecord>> copied;
+  for (const auto& file : planned) {
+    copied.emplace_back(file.seq, CatalogService::describeFile(root_path_, file.destination));
+  }
+  copied[0].second.content_hash = 0xfedcba9876543210ull;
+  service_.catalogIngestedFiles(job_id, root_id, copied);
+  // A resumed job may repeat a batch; the files are not added twice.
+  service_.catalogIngestedFiles(job_id, root_id, copied);
+
+  const auto stored = service_.listFiles(root_id);
+  ASSERT_EQ(stored.size(), 2);
+  EXPECT_TRUE(stored[0].stack_group_id.has_value());
+  EXPECT_EQ(stored[0].stack_group_id, stored[1].stack_group_id);
+  for (const auto& file : service_.loadIngestJobFiles(job_id)) {
+    EXPECT_EQ(file.state, IngestFileState::kCataloged);
+    EXPECT_TRUE(file.error.empty());
+  }
+  service_.finishIngestJob(job_id);
+  EXPECT_TRUE(service_.unfinishedIngestJobs().empty());
+  const auto job = service_.loadIngestJob(job_id);
+  ASSERT_TRUE(job.has_value());
+  EXPECT_TRUE(job->finished);
+}
+
+TEST_F(CatalogServiceTest, IngestedPairsStackAcrossBatches) {
+  using cataloger::services::catalog::CatalogService;
+  using cataloger::services::catalog::IngestJobFile;
+
+  std::vector<IngestJobFile> planned(3);
+  const char* names[] = {"IMG_0001.CR3", "IMG_0002.CR3", "IMG_0001.JPG"};
+  for (std::int64_t i = 0; i < 3; ++i) {
+    planned[i].seq = i;
+    planned[i].destination = (root_path_ / names[i]).string();
+    writeFile(planned[i].destination);
+  }
+  const auto job_id = service_.createIngestJob(root_path_.string(), "", planned);
+  const auto root_id = service_.registerRoot(root_path_);
+  for (const auto& file : planned) {
+    const auto ids = service_.catalogIngestedFiles(
+        job_id, root_id, {{file.seq, CatalogService::describeFile(root_path_, file.destination)}});
+    ASSERT_EQ(ids.size(), 1);
+    EXPECT_GT(ids.front(), 0);
+  }
+
+  std::optional<std::int64_t> raw_stack;
+  std::optional<std::int64_t> jpeg_stack;
+  for (const auto& file : service_.listFiles(root_id)) {
+    if (file.relative_path == "IMG_0001.CR3") {
+      raw_stack = file.stack_group_id;
+    } else if (file.relative_path == "IMG_0001.JPG") {
+      jpeg_stack = file.stack_group_id;
+    } else {
+      EXPECT_FALSE(file.stack_group_id.has_value());
+    }
+  }
+  ASSERT_TRUE(raw_stack.has_value());
+  EXPECT_EQ(raw_stack, jpeg_stack);
+}
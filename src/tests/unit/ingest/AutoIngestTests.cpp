@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "services/catalog/CatalogService.h"
+#include "services/ingest/AutoIngest.h"
+
+using cataloger::platform::io::MountEntry;
+using cataloger::services::catalog::CatalogService;
+using cataloger::services::ingest::AutoIngest;
+using cataloger::services::ingest::IngestJobStats;
+using cataloger::services::ingest::IngestPreset;
+
+namespace {
+
+std::string uniqueSuffix() {
+  const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::to_string(ticks);
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& contents) {
+  std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+  stream << contents;
+}
+
+constexpr const char* kRootLine = "22 1 259:2 / / rw,relatime shared:1 - ext4 /dev/nvme0n1p2 rw\n";
+
+}  // namespace
+
+class AutoIngestTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    scratch_ = std::filesystem::temp_directory_path() / ("auto_ingest_" + uniqueSuffix());
+    card_ = scratch_ / "card";
+    std::filesystem::create_directories(card_);
+    table_ = scratch_ / "mountinfo";
+    writeFile(table_, kRootLine);
+    catalog_.configureDatabase(scratch_ / "catalog.db");
+    catalog_.initializeSchema();
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    std::filesystem::remove_all(scratch_, ec);
+  }
+
+  void fillCard() {
+    const auto folder = card_ / "DCIM" / "100CANON";
+    std::filesystem::create_directories(folder);
+    for (int i = 0; i < 4; ++i) {
+      writeFile(folder / ("IMG_" + std::to_string(1000 + i) + ".JPG"), std::string(4096, 'a' + i));
+    }
+  }
+
+  std::string cardLine() const {
+    return "583 22 8:33 / " + card_.string() + " rw,relatime shared:301 - vfat /dev/sdc1 rw\n";
+  }
+
+  MountEntry cardMount() const {
+    MountEntry mount;
+    mount.mount_id = 583;
+    mount.mount_point = card_;
+    mount.fs_type = "vfat";
+    mount.source = "/dev/sdc1";
+    return mount;
+  }
+
+  IngestPreset preset() const {
+    IngestPreset preset;
+    preset.name = "Card to archive";
+    preset.destination_root = scratch_ / "archive";
+    preset.rename.folder_template = "{job}";
+    preset.rename.job = "Auto";
+    return preset;
+  }
+
+  AutoIngest::Options options() const {
+    AutoIngest::Options options;
+    options.watcher.mountinfo = table_;
+    options.watcher.rescan_interval = std::chrono::milliseconds(10);
+    options.settle_time = std::chrono::seconds(5);
+    options.settle_poll = std::chrono::milliseconds(10);
+    return options;
+  }
+
+  // Records finished ingests from `auto_ingest`.
+  void track(AutoIngest& auto_ingest) {
+    auto_ingest.setFinishSink(
+        [this](const std::filesystem::path&, std::int64_t, const IngestJobStats& stats) {
+          std::lock_guard lock(mutex_);
+          results_.push_back(stats);
+          finished_.notify_all();
+        });
+  }
+
+  bool waitForResults(std::size_t count) {
+    std::unique_lock lock(mutex_);
+    return finished_.wait_for(lock, std::chrono::seconds(10),
+                              [&] { return results_.size() >= count; });
+  }
+
+  std::filesystem::path scratch_;
+  std::filesystem::path card_;
+  std::filesystem::path table_;
+  CatalogService catalog_;
+  std::mutex mutex_;
+  std::condition_variable finished_;
+  std::vector<IngestJobStats> results_;
+};
+
+TEST_F(AutoIngestTest, IngestsACardTheMomentItIsMounted) {
+#if defined(_WIN32)
+  GTEST_SKIP() << "MountWatcher has no mount table to watch on Windows";
+#endif
+  fillCard();
+  AutoIngest auto_ingest(catalog_, preset(), options());
+  std::filesystem::path started_card;
+  auto_ingest.setStartSink(
+      [&](const std::filesystem::path& card, std::int64_t) { started_card = card; });
+  track(auto_ingest);
+  ASSERT_EQ(auto_ingest.start(), 0);
+
+  writeFile(table_, std::string(kRootLine) + cardLine());
+  ASSERT_TRUE(waitForResults(1));
+  EXPECT_EQ(started_card, card_);
+  EXPECT_EQ(results_[0].copy.files, 4u);
+  EXPECT_EQ(results_[0].cataloged, 4u);
+  EXPECT_TRUE(results_[0].finished);
+  EXPECT_TRUE(std::filesystem::exists(scratch_ / "archive" / "Auto" / "IMG_1000.JPG"));
+  EXPECT_TRUE(catalog_.unfinishedIngestJobs().empty());
+
+  // Pulled and put back: already ingested, so left alone.
+  writeFile(table_, kRootLine);
+  writeFile(table_, std::string(kRootLine) + cardLine());
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  auto_ingest.stop();
+  EXPECT_EQ(results_.size(), 1u);
+  EXPECT_FALSE(std::filesystem::exists(scratch_ / "archive" / "Auto" / "IMG_1000-1.JPG"));
+}
+
+TEST_F(AutoIngestTest, WaitsForTheCardToSettle) {
+  AutoIngest auto_ingest(catalog_, preset(), options());
+  track(auto_ingest);
+  // Mounted before its DCIM folder can be read.
+  auto_ingest.handle({{cardMount()}, {}});
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  fillCard();
+  ASSERT_TRUE(waitForResults(1));
+  auto_ingest.stop();
+  EXPECT_TRUE(results_[0].finished);
+  EXPECT_EQ(catalog_.listFiles(catalog_.registerRoot(scratch_ / "archive")).size(), 4u);
+}
+
+TEST_F(AutoIngestTest, IgnoresMountsThatAreNotCards) {
+  fillCard();
+  AutoIngest auto_ingest(catalog_, preset(), options());
+  track(auto_ingest);
+  auto internal = cardMount();
+  internal.fs_type = "ext4";  // and not under a media folder
+  auto_ingest.handle({{internal}, {}});
+  auto_ingest.stop();
+  EXPECT_TRUE(results_.empty());
+  EXPECT_TRUE(catalog_.unfinishedIngestJobs().empty());
+}
+
+TEST_F(AutoIngestTest, ResumesTheCardsUnfinishedJob) {
+  fillCard();
+  // A run that stopped before copying anything.
+  cataloger::services::ingest::IngestService ingest;
+  ingest.setRenameOptions(preset().rename);
+  ingest.queueSources({(card_ / "DCIM").string()});
+  const auto job_id = ingest.createJob(catalog_, scratch_ / "archive");
+
+  std::int64_t started_job = 0;
+  AutoIngest auto_ingest(catalog_, preset(), options());
+  auto_ingest.setStartSink(
+      [&](const std::filesystem::path&, std::int64_t id) { started_job = id; });
+  track(auto_ingest);
+  auto_ingest.handle({{cardMount()}, {}});
+  ASSERT_TRUE(waitForResults(1));
+  auto_ingest.stop();
+  EXPECT_EQ(started_job, job_id);
+  EXPECT_EQ(results_[0].copy.files, 4u);
+  EXPECT_TRUE(catalog_.unfinishedIngestJobs().empty());
+}
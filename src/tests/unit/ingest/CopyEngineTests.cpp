@@ -0,0 +1,286 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "platform/io/ContentHash.h"
+#include "services/ingest/CopyEngine.h"
+#include "services/ingest/IngestService.h"
+
+using cataloger::platform::io::CopyMethod;
+using cataloger::services::ingest::CopyEngine;
+using cataloger::services::ingest::CopyJob;
+using cataloger::services::ingest::CopyResult;
+using cataloger::services::ingest::IngestService;
+
+namespace {
+
+std::string uniqueSuffix() {
+  const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::to_string(ticks);
+}
+
+std::string readAll(const std::filesystem::path& path) {
+  std::ifstream stream(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+}  // namespace
+
+class CopyEngineTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    const auto suffix = uniqueSuffix();
+    source_ = std::filesystem::temp_directory_path() / ("copy_engine_src_" + suffix);
+    destination_ = std::filesystem::temp_directory_path() / ("copy_engine_dst_" + suffix);
+    std::filesystem::create_directories(source_ / "DCIM" / "100CANON");
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    std::filesystem::remove_all(source_, ec);
+    std::filesystem::remove_all(destination_, ec);
+  }
+
+  // Sizes vary so small late files finish before large early ones.
+  std::vector<CopyJob> writeCard(std::size_t count) {
+    std::vector<CopyJob> jobs;
+    const auto base = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto name = "IMG_" + std::to_string(1000 + i) + ".CR3";
+      const auto path = source_ / "DCIM" / "100CANON" / name;
+      std::ofstream stream(path, std::ios::binary);
+      const std::size_t size = (count - i) * 64 * 1024 + i;
+      std::string payload(size, static_cast<char>('a' + i % 26));
+      stream.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+      stream.close();
+      // Capture order runs opposite to the names.
+      std::filesystem::last_write_time(path, base + std::chrono::seconds(count - i));
+      jobs.push_back({.source = path,
+                      .destination = destination_ / name,
+                      .capture_time = std::filesystem::last_write_time(path)});
+    }
+    return jobs;
+  }
+
+  std::filesystem::path source_;
+  std::filesystem::path destination_;
+};
+
+TEST_F(CopyEngineTest, CopiesBytesAndHandsOffInCaptureOrder) {
+  auto jobs = writeCard(12);
+  CopyEngine engine;
+  std::vector<CopyResult> results;
+  const auto stats = engine.run(jobs, [&](const CopyResult& result) { results.push_back(result); });
+
+  EXPECT_EQ(stats.files, 12u);
+  EXPECT_EQ(stats.failed, 0u);
+  ASSERT_EQ(results.size(), 12u);
+  for (std::size_t i = 1; i < results.size(); ++i) {
+    EXPECT_LT(results[i - 1].job.capture_time, results[i].job.capture_time);
+  }
+  for (const auto& job : jobs) {
+    EXPECT_EQ(readAll(job.source), readAll(job.destination)) << job.destination;
+    EXPECT_EQ(std::filesystem::last_write_time(job.source),
+              std::filesystem::last_write_time(job.destination));
+  }
+  // Nothing but the copies themselves: no temporaries left behind.
+  EXPECT_EQ(std::distance(std::filesystem::directory_iterator(destination_),
+                          std::filesystem::directory_iterator()),
+            12);
+}
+
+TEST_F(CopyEngineTest, PerDeviceLimitBoundsCopiesInFlight) {
+  auto jobs = writeCard(8);
+  CopyEngine::Options options;
+  options.per_device_limit = 1;
+  CopyEngine engine(options);
+  const auto stats = engine.run(jobs);
+  EXPECT_EQ(stats.failed, 0u);
+  EXPECT_EQ(stats.peak_in_flight, 1u);
+  EXPECT_GT(stats.megabytesPerSecond(), 0.0);
+}
+
+TEST_F(CopyEngineTest, UserspaceFallbackCopiesIdentically) {
+  auto jobs = writeCard(3);
+  CopyEngine::Options options;
+  options.kernel_copy = false;
+  options.buffer_bytes = 64 * 1024;  // several chunks per file
+  CopyEngine engine(options);
+  std::vector<CopyResult> results;
+  engine.run(jobs, [&](const CopyResult& result) { results.push_back(result); });
+
+  ASSERT_EQ(results.size(), 3u);
+  for (const auto& result : results) {
+    EXPECT_TRUE(result.ok) << result.error;
+    EXPECT_EQ(result.method, CopyMethod::kReadWrite);
+    EXPECT_EQ(readAll(result.job.source), readAll(result.job.destination));
+  }
+}
+
+TEST_F(CopyEngineTest, RefusesToReplaceExistingFiles) {
+  auto jobs = writeCard(2);
+  std::filesystem::create_directories(destination_);
+  {
+    std::ofstream existing(jobs[0].destination, std::ios::binary);
+    existing << "keep me";
+  }
+  CopyEngine engine;
+  std::vector<CopyResult> results;
+  const auto stats = engine.run(jobs, [&](const CopyResult& result) { results.push_back(result); });
+
+  EXPECT_EQ(stats.failed, 1u);
+  EXPECT_EQ(readAll(jobs[0].destination), "keep me");
+  EXPECT_EQ(readAll(jobs[1].source), readAll(jobs[1].destination));
+  for (const auto& entry : std::filesystem::directory_iterator(destination_)) {
+    EXPECT_EQ(entry.path().filename().string().rfind('.', 0), std::string::npos)
+        << entry.path();
+  }
+}
+
+TEST_F(CopyEngineTest, IngestServiceKeepsFolderLayout) {
+  writeCard(4);
+  IngestService ingest;
+  ingest.queueSources({source_.string()});
+  const auto stats = ingest.copyTo(destination_);
+  EXPECT_EQ(stats.files, 4u);
+  EXPECT_EQ(stats.failed, 0u);
+  EXPECT_TRUE(std::filesystem::exists(destination_ / "DCIM" / "100CANON" / "IMG_1000.CR3"));
+}
+
+TEST_F(CopyEngineTest, MirrorsEveryFileFromOneRead) {
+  auto jobs = writeCard(6);
+  for (auto& job : jobs) {
+    job.mirror = destination_ / "mirror" / job.destination.filename();
+    job.destination = destination_ / "primary" / job.destination.filename();
+  }
+  CopyEngine::Options options;
+  options.buffer_bytes = 64 * 1024;  // several chunks per file
+  options.mirror_queue_chunks = 1;
+  CopyEngine engine(options);
+  std::vector<CopyResult> results;
+  const auto stats = engine.run(jobs, [&](const CopyResult& result) { results.push_back(result); });
+
+  EXPECT_EQ(stats.failed, 0u);
+  EXPECT_EQ(stats.mirror_failed, 0u);
+  ASSERT_EQ(results.size(), 6u);
+  for (const auto& result : results) {
+    EXPECT_TRUE(result.ok) << result.error;
+    EXPECT_TRUE(result.mirror_ok) << result.mirror_error;
+    const auto original = readAll(result.job.source);
+    EXPECT_EQ(readAll(result.job.destination), original);
+    EXPECT_EQ(readAll(result.job.mirror), original);
+    EXPECT_EQ(std::filesystem::last_write_time(result.job.source),
+              std::filesystem::last_write_time(result.job.mirror));
+  }
+  for (const auto* folder : {"primary", "mirror"}) {
+    EXPECT_EQ(std::distance(std::filesystem::directory_iterator(destination_ / folder),
+                            std::filesystem::directory_iterator()),
+              6);
+  }
+}
+
+TEST_F(CopyEngineTest, FailedMirrorLeavesPrimaryCopies) {
+  auto jobs = writeCard(3);
+  // A plain file where the mirror folder should be: every mirror fails.
+  std::filesystem::create_directories(destination_);
+  {
+    std::ofstream blocker(destination_ / "mirror", std::ios::binary);
+    blocker << "not a folder";
+  }
+  for (auto& job : jobs) {
+    job.mirror = destination_ / "mirror" / job.destination.filename();
+  }
+  CopyEngine engine;
+  std::vector<CopyResult> results;
+  const auto stats = engine.run(jobs, [&](const CopyResult& result) { results.push_back(result); });
+
+  EXPECT_EQ(stats.failed, 0u);
+  EXPECT_EQ(stats.mirror_failed, 3u);
+  ASSERT_EQ(results.size(), 3u);
+  for (const auto& result : results) {
+    EXPECT_TRUE(result.ok) << result.error;
+    EXPECT_FALSE(result.mirror_ok);
+    EXPECT_FALSE(result.mirror_error.empty());
+    EXPECT_EQ(readAll(result.job.source), readAll(result.job.destination));
+  }
+}
+
+TEST_F(CopyEngineTest, ThrowingSinksStillFinishTheRun) {
+  auto jobs = writeCard(6);
+  const auto doomed = jobs[2].source;
+  CopyEngine engine;
+  std::vector<CopyResult> results;
+  const auto on_result = [&](const CopyResult& result) {
+    results.push_back(result);
+    if (results.size() == 1) {
+      throw std::runtime_error("catalog unavailable");
+    }
+  };
+  const auto on_start = [&](const CopyJob& job) {
+    if (job.source == doomed) {
+      throw std::runtime_error("journal unavailable");
+    }
+  };
+  // Returned at all: the run used to wait forever for the failed copy.
+  EXPECT_THROW(engine.run(jobs, on_result, on_start), std::runtime_error);
+
+  ASSERT_EQ(results.size(), 6u);
+  for (const auto& result : results) {
+    if (result.job.source == doomed) {
+      EXPECT_FALSE(result.ok);
+      EXPECT_EQ(result.error, "journal unavailable");
+    } else {
+      EXPECT_TRUE(result.ok) << result.error;
+    }
+  }
+}
+
+TEST_F(CopyEngineTest, IngestServiceMirrorsFolderLayout) {
+  writeCard(2);
+  IngestService ingest;
+  ingest.queueSources({source_.string()});
+  const auto stats = ingest.copyTo(destination_ / "primary", destination_ / "mirror");
+  EXPECT_EQ(stats.failed, 0u);
+  EXPECT_EQ(stats.mirror_failed, 0u);
+  EXPECT_TRUE(std::filesystem::exists(destination_ / "mirror" / "DCIM" / "100CANON" / "IMG_1001.CR3"));
+}
+
+TEST_F(CopyEngineTest, HashesInFlightAndVerifiesEveryCopy) {
+  auto jobs = writeCard(4);
+  jobs[0].mirror = destination_ / "mirror" / jobs[0].destination.filename();
+  CopyEngine::Options options;
+  options.buffer_bytes = 64 * 1024;
+  options.verify = true;
+  CopyEngine engine(options);
+  std::vector<CopyResult> results;
+  const auto stats = engine.run(jobs, [&](const CopyResult& result) { results.push_back(result); });
+
+  EXPECT_EQ(stats.failed, 0u);
+  ASSERT_EQ(results.size(), 4u);
+  for (const auto& result : results) {
+    EXPECT_TRUE(result.ok) << result.error;
+    EXPECT_TRUE(result.verified);
+    EXPECT_EQ(result.method, CopyMethod::kReadWrite);
+    const auto bytes = readAll(result.job.source);
+    ASSERT_TRUE(result.content_hash.has_value());
+    EXPECT_EQ(*result.content_hash,
+              cataloger::platform::io::HashBytes(
+                  {reinterpret_cast<const std::uint8_t*>(bytes.data()), bytes.size()}));
+  }
+}
+
+TEST_F(CopyEngineTest, HashingIsOffByDefault) {
+  auto jobs = writeCard(1);
+  CopyEngine engine;
+  std::vector<CopyResult> results;
+  engine.run(jobs, [&](const CopyResult& result) { results.push_back(result); });
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_FALSE(results.front().content_hash.has_value());
+  EXPECT_FALSE(results.front().verified);
+}
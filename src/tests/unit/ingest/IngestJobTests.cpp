@@ -0,0 +1,309 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "services/catalog/CatalogService.h"
+#include "services/ingest/CopyEngine.h"
+#include "services/ingest/IngestJob.h"
+#include "services/ingest/IngestService.h"
+
+using cataloger::services::catalog::CatalogService;
+using cataloger::services::catalog::IngestFileState;
+using cataloger::services::catalog::IngestFileUpdate;
+using cataloger::services::ingest::CatalogedFile;
+using cataloger::services::ingest::CopyEngine;
+using cataloger::services::ingest::CopyJob;
+using cataloger::services::ingest::IngestJob;
+using cataloger::services::ingest::IngestService;
+
+namespace {
+
+std::string uniqueSuffix() {
+  const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::to_string(ticks);
+}
+
+std::string readAll(const std::filesystem::path& path) {
+  std::ifstream stream(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& contents) {
+  std::ofstream stream(path, std::ios::binary);
+  stream << contents;
+}
+
+std::size_t countTemporaries(const std::filesystem::path& root) {
+  std::size_t count = 0;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+    if (entry.path().filename().string().ends_with(".cataloger-partial")) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+class IngestJobTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    scratch_ = std::filesystem::temp_directory_path() / ("ingest_job_" + uniqueSuffix());
+    card_ = scratch_ / "card" / "DCIM" / "100CANON";
+    destination_ = scratch_ / "destination";
+    std::filesystem::create_directories(card_);
+    catalog_.configureDatabase(scratch_ / "catalog.db");
+    catalog_.initializeSchema();
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    std::filesystem::remove_all(scratch_, ec);
+  }
+
+  void writeCard(std::size_t count) {
+    const auto base = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto path = card_ / ("IMG_" + std::to_string(1000 + i) + ".CR3");
+      writeFile(path, std::string(32 * 1024 + i, static_cast<char>('a' + i % 26)));
+      std::filesystem::last_write_time(path, base + std::chrono::seconds(i));
+    }
+  }
+
+  std::int64_t createJob(const std::filesystem::path& mirror_root = {}) {
+    IngestService ingest;
+    ingest.queueSources({(scratch_ / "card").string()});
+    return ingest.createJob(catalog_, destination_, mirror_root);
+  }
+
+  std::filesystem::path scratch_;
+  std::filesystem::path card_;
+  std::filesystem::path destination_;
+  CatalogService catalog_;
+};
+
+TEST_F(IngestJobTest, CopiesCatalogsAndFinishes) {
+  writeCard(8);
+  const auto job_id = createJob();
+  ASSERT_EQ(catalog_.unfinishedIngestJobs().size(), 1u);
+
+  IngestJob::Options options;
+  options.copy.hash = true;
+  options.batch_files = 3;
+  IngestJob job(catalog_, job_id, options);
+  const auto stats = job.run();
+
+  EXPECT_EQ(stats.copy.files, 8u);
+  EXPECT_EQ(stats.already_done, 0u);
+  EXPECT_EQ(stats.cataloged, 8u);
+  EXPECT_EQ(stats.failed, 0u);
+  EXPECT_TRUE(stats.finished);
+  EXPECT_TRUE(catalog_.unfinishedIngestJobs().empty());
+  for (const auto& file : catalog_.loadIngestJobFiles(job_id)) {
+    EXPECT_EQ(file.state, IngestFileState::kCataloged) << file.source;
+    EXPECT_TRUE(file.content_hash.has_value()) << file.source;
+  }
+  const auto stored = catalog_.listFiles(catalog_.registerRoot(destination_));
+  ASSERT_EQ(stored.size(), 8u);
+  for (const auto& file : stored) {
+    EXPECT_TRUE(file.content_hash.has_value()) << file.relative_path;
+  }
+}
+
+TEST_F(IngestJobTest, ResumesFromTheLastDurableFile) {
+  writeCard(20);
+  const auto job_id = createJob();
+  const auto planned = catalog_.loadIngestJobFiles(job_id);
+  ASSERT_EQ(planned.size(), 20u);
+
+  // Reproduce what a crash leaves behind: the first 12 files journaled as
+  // copied, two more renamed into place before their batch committed, one
+  // half-written temporary, and the rest never started.
+  std::vector<CopyJob> done_before_crash;
+  std::vector<IngestFileUpdate> journaled;
+  for (std::size_t i = 0; i < 14; ++i) {
+    done_before_crash.push_back(
+        {.source = planned[i].source, .destination = planned[i].destination});
+    journaled.push_back({planned[i].seq,
+                         i < 12 ? IngestFileState::kCopied : IngestFileState::kCopying,
+                         std::nullopt,
+                         {}});
+  }
+  CopyEngine(CopyEngine::Options{}).run(done_before_crash);
+  catalog_.updateIngestFiles(job_id, journaled);
+  const std::filesystem::path torn(planned[14].destination);
+  writeFile(torn.parent_path() / ("." + torn.filename().string() + ".cataloger-partial"),
+            "only the first few bytes");
+
+  IngestJob job(catalog_, job_id);
+  const auto stats = job.run();
+  EXPECT_EQ(stats.already_done, 12u);
+  EXPECT_EQ(stats.recovered, 2u);
+  EXPECT_EQ(stats.copy.files, 6u);
+  EXPECT_EQ(stats.copy.failed, 0u);
+  EXPECT_EQ(stats.cataloged, 20u);
+  EXPECT_TRUE(stats.finished);
+
+  for (const auto& file : planned) {
+    EXPECT_EQ(readAll(file.destination), readAll(file.source)) << file.destination;
+  }
+  EXPECT_EQ(countTemporaries(destination_), 0u);
+  EXPECT_EQ(catalog_.listFiles(catalog_.registerRoot(destination_)).size(), 20u);
+
+  // Running a finished job again changes nothing.
+  const auto again = IngestJob(catalog_, job_id).run();
+  EXPECT_EQ(again.already_done, 20u);
+  EXPECT_EQ(again.copy.files, 0u);
+  EXPECT_EQ(catalog_.listFiles(catalog_.registerRoot(destination_)).size(), 20u);
+}
+
+TEST_F(IngestJobTest, ResumeCopiesAgainWhatWentMissingSinceItWasJournaled) {
+  writeCard(4);
+  const auto job_id = createJob();
+  const auto planned = catalog_.loadIngestJobFiles(job_id);
+  ASSERT_EQ(planned.size(), 4u);
+  CopyEngine(CopyEngine::Options{})
+      .run({{.source = planned[0].source, .destination = planned[0].destination},
+            {.source = planned[1].source, .destination = planned[1].destination}});
+  catalog_.updateIngestFiles(job_id,
+                             {{planned[0].seq, IngestFileState::kCopied, std::nullopt, {}},
+                              {planned[1].seq, IngestFileState::kCopied, std::nullopt, {}}});
+  // Someone tidied up the destination before the job was resumed.
+  std::filesystem::remove(planned[0].destination);
+
+  const auto stats = IngestJob(catalog_, job_id).run();
+  EXPECT_EQ(stats.already_done, 1u);
+  EXPECT_EQ(stats.copy.files, 3u);
+  EXPECT_EQ(stats.copy.failed, 0u);
+  EXPECT_EQ(stats.cataloged, 4u);
+  EXPECT_TRUE(stats.finished);
+  for (const auto& file : planned) {
+    EXPECT_EQ(readAll(file.destination), readAll(file.source)) << file.destination;
+  }
+
+  // Cataloged files are checked too.
+  std::filesystem::remove(planned[3].destination);
+  const auto again = IngestJob(catalog_, job_id).run();
+  EXPECT_EQ(again.already_done, 3u);
+  EXPECT_EQ(again.copy.files, 1u);
+  EXPECT_EQ(readAll(planned[3].destination), readAll(planned[3].source));
+  EXPECT_EQ(catalog_.listFiles(catalog_.registerRoot(destination_)).size(), 4u);
+}
+
+TEST_F(IngestJobTest, ResumeCopiesOnlyTheMissingHalfOfAMirror) {
+  writeCard(3);
+  const auto mirror = scratch_ / "mirror";
+  const auto job_id = createJob(mirror);
+  const auto planned = catalog_.loadIngestJobFiles(job_id);
+  ASSERT_EQ(planned.size(), 3u);
+  // The primary copy of the first file landed; its mirror did not.
+  catalog_.updateIngestFiles(job_id,
+                             {{planned[0].seq, IngestFileState::kCopying, std::nullopt, {}}});
+  CopyEngine(CopyEngine::Options{})
+      .run({{.source = planned[0].source, .destination = planned[0].destination}});
+
+  IngestJob::Options options;
+  options.copy.verify = true;
+  const auto stats = IngestJob(catalog_, job_id, options).run();
+  EXPECT_EQ(stats.copy.files, 3u);
+  EXPECT_EQ(stats.copy.failed, 0u);
+  EXPECT_EQ(stats.copy.mirror_failed, 0u);
+  EXPECT_TRUE(stats.finished);
+  for (const auto& file : planned) {
+    EXPECT_EQ(readAll(file.destination), readAll(file.source));
+    EXPECT_EQ(readAll(file.mirror), readAll(file.source));
+  }
+}
+
+TEST_F(IngestJobTest, AnotherFileAtTheDestinationIsNotTakenForTheCopy) {
+  writeCard(3);
+  const auto job_id = createJob();
+  const auto planned = catalog_.loadIngestJobFiles(job_id);
+  ASSERT_EQ(planned.size(), 3u);
+  // A frame from another body with the same name and size got there first.
+  const std::filesystem::path taken(planned[1].destination);
+  std::filesystem::create_directories(taken.parent_path());
+  const std::string other(planned[1].file_size, 'z');
+  writeFile(taken, other);
+
+  const auto stats = IngestJob(catalog_, job_id).run();
+  EXPECT_EQ(stats.recovered, 0u);
+  EXPECT_EQ(stats.failed, 1u);
+  EXPECT_EQ(stats.cataloged, 2u);
+  EXPECT_FALSE(stats.finished);
+  EXPECT_EQ(readAll(taken), other);
+  const auto files = catalog_.loadIngestJobFiles(job_id);
+  EXPECT_EQ(files[1].state, IngestFileState::kFailed);
+  EXPECT_NE(files[1].error.find(std::generic_category().message(EEXIST)), std::string::npos)
+      << files[1].error;
+}
+
+TEST_F(IngestJobTest, FailedFilesLeaveTheJobResumable) {
+  writeCard(4);
+  const auto job_id = createJob();
+  const auto planned = catalog_.loadIngestJobFiles(job_id);
+  const auto moved_aside = scratch_ / "aside.CR3";
+  std::filesystem::rename(planned[2].source, moved_aside);
+
+  auto stats = IngestJob(catalog_, job_id).run();
+  EXPECT_EQ(stats.copy.failed, 1u);
+  EXPECT_EQ(stats.failed, 1u);
+  EXPECT_EQ(stats.cataloged, 3u);
+  EXPECT_FALSE(stats.finished);
+  ASSERT_EQ(catalog_.unfinishedIngestJobs().size(), 1u);
+  EXPECT_EQ(catalog_.loadIngestJobFiles(job_id)[2].state, IngestFileState::kFailed);
+  EXPECT_FALSE(catalog_.loadIngestJobFiles(job_id)[2].error.empty());
+
+  // The card comes back: only the failed file is copied.
+  std::filesystem::rename(moved_aside, planned[2].source);
+  stats = IngestJob(catalog_, job_id).run();
+  EXPECT_EQ(stats.already_done, 3u);
+  EXPECT_EQ(stats.copy.files, 1u);
+  EXPECT_EQ(stats.cataloged, 1u);
+  EXPECT_TRUE(stats.finished);
+  EXPECT_TRUE(catalog_.unfinishedIngestJobs().empty());
+}
+
+TEST_F(IngestJobTest, CatalogsLiveInBatchesWithTheCopiedHead) {
+  writeCard(10);
+  const auto job_id = createJob();
+  IngestJob::Options options;
+  options.batch_files = 3;
+  options.copy.head_bytes = 4096;
+  std::vector<std::size_t> batch_sizes;
+  std::vector<std::filesystem::path> cataloged;
+  const auto stats = IngestJob(catalog_, job_id, options)
+                         .run({}, [&](int root_id, const std::vector<CatalogedFile>& files) {
+                           batch_sizes.push_back(files.size());
+                           // Already committed when the callback runs.
+                           EXPECT_EQ(catalog_.listFiles(root_id).size(), cataloged.size() +
+                                                                         files.size());
+                           for (const auto& file : files) {
+                             EXPECT_GT(file.file_id, 0);
+                             ASSERT_TRUE(file.head);
+                             EXPECT_EQ(file.head->size(), 4096u);
+                             EXPECT_EQ(std::string(file.head->begin(), file.head->end()),
+                                       readAll(file.record.absolute_path).substr(0, 4096));
+                             cataloged.push_back(file.record.absolute_path);
+                           }
+                         });
+  EXPECT_EQ(stats.cataloged, 10u);
+  ASSERT_EQ(cataloged.size(), 10u);
+  for (const auto size : batch_sizes) {
+    EXPECT_LE(size, 3u);
+  }
+  // Capture order, which writeCard makes the name order.
+  EXPECT_TRUE(std::is_sorted(cataloged.begin(), cataloged.end()));
+}
+
+TEST_F(IngestJobTest, UnknownJobThrows) {
+  EXPECT_THROW(IngestJob(catalog_, 999).run(), std::runtime_error);
+}
@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "services/ingest/IngestService.h"
+#include "services/ingest/IngestStateIndex.h"
+
+using cataloger::services::ingest::CopyResult;
+using cataloger::services::ingest::IngestService;
+using cataloger::services::ingest::IngestStateIndex;
+using cataloger::services::ingest::IngestStateKey;
+
+namespace {
+
+std::string uniqueSuffix() {
+  const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::to_string(ticks);
+}
+
+IngestStateKey keyFor(std::string path, std::uint64_t size = 1000, std::int64_t mtime = 42) {
+  return {"uuid:1234-ABCD", std::move(path), size, mtime};
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& contents) {
+  std::ofstream stream(path, std::ios::binary);
+  stream << contents;
+}
+
+}  // namespace
+
+class IngestStateIndexTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    scratch_ = std::filesystem::temp_directory_path() / ("ingest_state_" + uniqueSuffix());
+    std::filesystem::create_directories(scratch_);
+    file_ = scratch_ / IngestStateIndex::kFileName;
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    std::filesystem::remove_all(scratch_, ec);
+  }
+
+  std::filesystem::path scratch_;
+  std::filesystem::path file_;
+};
+
+TEST_F(IngestStateIndexTest, RecordsSurviveReopening) {
+  {
+    IngestStateIndex index(file_);
+    EXPECT_EQ(index.size(), 0u);
+    EXPECT_EQ(index.record(keyFor("DCIM/100CANON/IMG_0001.CR3"), {}, 0xabcdefull), 0);
+    EXPECT_EQ(index.record(keyFor("DCIM/100CANON/IMG_0002.CR3"), {}, {}, "2024/IMG_0002.CR3"), 0);
+    EXPECT_EQ(index.flush(), 0);
+  }
+  IngestStateIndex index(file_);
+  EXPECT_EQ(index.size(), 2u);
+  EXPECT_TRUE(index.contains(keyFor("DCIM/100CANON/IMG_0001.CR3")));
+  EXPECT_EQ(index.contentHash(keyFor("DCIM/100CANON/IMG_0001.CR3")), 0xabcdefull);
+  EXPECT_FALSE(index.contentHash(keyFor("DCIM/100CANON/IMG_0002.CR3")).has_value());
+  EXPECT_FALSE(index.destination(keyFor("DCIM/100CANON/IMG_0001.CR3")).has_value());
+  EXPECT_EQ(index.destination(keyFor("DCIM/100CANON/IMG_0002.CR3")), "2024/IMG_0002.CR3");
+
+  // Any change to what identifies the frame means it was not copied.
+  EXPECT_FALSE(index.contains(keyFor("DCIM/100CANON/IMG_0003.CR3")));
+  EXPECT_FALSE(index.contains(keyFor("DCIM/100CANON/IMG_0001.CR3", 1001)));
+  EXPECT_FALSE(index.contains(keyFor("DCIM/100CANON/IMG_0001.CR3", 1000, 43)));
+  auto other_card = keyFor("DCIM/100CANON/IMG_0001.CR3");
+  other_card.volume_id = "uuid:5678-EF01";
+  EXPECT_FALSE(index.contains(other_card));
+}
+
+TEST_F(IngestStateIndexTest, FingerprintsMustAgreeWhenBothExist) {
+  IngestStateIndex index(file_);
+  index.record(keyFor("IMG_0001.CR3"), 7);
+  index.record(keyFor("IMG_0002.CR3"));
+  EXPECT_TRUE(index.contains(keyFor("IMG_0001.CR3"), 7));
+  EXPECT_FALSE(index.contains(keyFor("IMG_0001.CR3"), 8));
+  EXPECT_TRUE(index.contains(keyFor("IMG_0001.CR3")));
+  EXPECT_TRUE(index.contains(keyFor("IMG_0002.CR3"), 8));
+}
+
+TEST_F(IngestStateIndexTest, TornTailIsDroppedAndRepaired) {
+  {
+    IngestStateIndex index(file_);
+    index.record(keyFor("IMG_0001.CR3"));
+    index.record(keyFor("IMG_0002.CR3"));
+  }
+  const auto intact_size = std::filesystem::file_size(file_);
+  {
+    std::ofstream stream(file_, std::ios::binary | std::ios::app);
+    stream << "half a record";
+  }
+  IngestStateIndex index(file_);
+  EXPECT_EQ(index.size(), 2u);
+  EXPECT_EQ(std::filesystem::file_size(file_), intact_size);
+  index.record(keyFor("IMG_0003.CR3"));
+  IngestStateIndex reloaded(file_);
+  EXPECT_EQ(reloaded.size(), 3u);
+}
+
+TEST_F(IngestStateIndexTest, UnreadableFileStartsOver) {
+  writeFile(file_, "not an index at all, just some bytes that are long enough");
+  IngestStateIndex index(file_);
+  EXPECT_EQ(index.size(), 0u);
+  EXPECT_EQ(index.record(keyFor("IMG_0001.CR3")), 0);
+  IngestStateIndex reloaded(file_);
+  EXPECT_EQ(reloaded.size(), 1u);
+  EXPECT_TRUE(reloaded.contains(keyFor("IMG_0001.CR3")));
+}
+
+TEST_F(IngestStateIndexTest, SupersededRecordsAreCompactedOnLoad) {
+  {
+    IngestStateIndex index(file_);
+    for (std::int64_t mtime = 0; mtime < 500; ++mtime) {
+      index.record(keyFor("IMG_0001.CR3", 1000, mtime));
+    }
+  }
+  const auto grown = std::filesystem::file_size(file_);
+  IngestStateIndex index(file_);
+  EXPECT_EQ(index.size(), 1u);
+  EXPECT_TRUE(index.contains(keyFor("IMG_0001.CR3", 1000, 499)));
+  EXPECT_LT(std::filesystem::file_size(file_), grown / 100);
+}
+
+TEST_F(IngestStateIndexTest, FingerprintCoversHeadTailAndSize) {
+  const std::string head(70 * 1024, 'h');
+  const std::string middle(200 * 1024, 'm');
+  writeFile(scratch_ / "a.CR3", head + middle + head);
+  writeFile(scratch_ / "b.CR3", head + std::string(middle.size(), 'x') + head);
+  writeFile(scratch_ / "c.CR3", head + middle + head + "!");
+  const auto a = IngestStateIndex::fingerprint(scratch_ / "a.CR3");
+  ASSERT_TRUE(a.has_value());
+  // Only the middle differs: deliberately the same; that is what the
+  // full content hash is for.
+  EXPECT_EQ(a, IngestStateIndex::fingerprint(scratch_ / "b.CR3"));
+  EXPECT_NE(a, IngestStateIndex::fingerprint(scratch_ / "c.CR3"));
+  EXPECT_FALSE(IngestStateIndex::fingerprint(scratch_ / "missing.CR3").has_value());
+}
+
+TEST_F(IngestStateIndexTest, ReinsertedCardOnlyCopiesNewFrames) {
+  const auto card = scratch_ / "card" / "DCIM" / "100CANON";
+  const auto destination = scratch_ / "destination";
+  std::filesystem::create_directories(card);
+  for (int i = 0; i < 5; ++i) {
+    writeFile(card / ("IMG_000" + std::to_string(i) + ".CR3"), std::string(4096, 'a' + i));
+  }
+
+  for (const auto policy : {IngestService::SkipPolicy::kStat,
+                            IngestService::SkipPolicy::kFingerprint}) {
+    SCOPED_TRACE(static_cast<int>(policy));
+    std::error_code ec;
+    std::filesystem::remove_all(destination, ec);
+    IngestService ingest;
+    ingest.setSkipPolicy(policy);
+    ingest.queueSources({(scratch_ / "card").string()});
+
+    auto stats = ingest.copyTo(destination);
+    EXPECT_EQ(stats.files, 5u);
+    EXPECT_EQ(stats.skipped, 0u);
+    EXPECT_EQ(stats.failed, 0u);
+
+    writeFile(card / "IMG_0009.CR3", "shot after the first ingest");
+    std::vector<std::string> copied;
+    stats = ingest.copyTo(destination, [&](const CopyResult& result) {
+      copied.push_back(result.job.source.filename().string());
+    });
+    EXPECT_EQ(stats.skipped, 5u);
+    EXPECT_EQ(stats.failed, 0u);
+    EXPECT_EQ(copied, std::vector<std::string>{"IMG_0009.CR3"});
+    std::filesystem::remove(card / "IMG_0009.CR3");
+  }
+
+  // A copy deleted from the destination is made again.
+  std::filesystem::remove(destination / "DCIM" / "100CANON" / "IMG_0002.CR3");
+  IngestService again;
+  again.setSkipPolicy(IngestService::SkipPolicy::kStat);
+  again.queueSources({(scratch_ / "card").string()});
+  auto recopied = again.copyTo(destination);
+  EXPECT_EQ(recopied.skipped, 4u);
+  EXPECT_EQ(recopied.files, 1u);
+  EXPECT_EQ(recopied.failed, 0u);
+
+  // Without a skip policy everything is attempted again, and the existing
+  // copies are refused.
+  IngestService plain;
+  plain.queueSources({(scratch_ / "card").string()});
+  const auto stats = plain.copyTo(destination);
+  EXPECT_EQ(stats.skipped, 0u);
+  EXPECT_EQ(stats.failed, 5u);
+}
+
+TEST_F(IngestStateIndexTest, RenamedCopiesAreFoundUnderTheirNewNames) {
+  const auto card = scratch_ / "card" / "DCIM" / "100CANON";
+  const auto destination = scratch_ / "destination";
+  const auto mirror = scratch_ / "mirror";
+  std::filesystem::create_directories(card);
+  const auto base = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+  for (int i = 0; i < 4; ++i) {
+    const auto path = card / ("IMG_000" + std::to_string(i) + ".JPG");
+    writeFile(path, std::string(4096, 'a' + i));
+    std::filesystem::last_write_time(path, base + std::chrono::seconds(i));
+  }
+  const auto countCopies = [&] {
+    std::size_t count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(destination / "Event")) {
+      count += entry.path().extension() == ".JPG" ? 1 : 0;
+    }
+    return count;
+  };
+
+  IngestService ingest;
+  ingest.setSkipPolicy(IngestService::SkipPolicy::kStat);
+  ingest.setRenameOptions({"{job}", "{job}-{sequence:2}", "Event", 1});
+  ingest.queueSources({(scratch_ / "card").string()});
+  auto stats = ingest.copyTo(destination, mirror, {});
+  EXPECT_EQ(stats.files, 4u);
+  ASSERT_EQ(countCopies(), 4u);
+
+  // Nothing is copied again under a fresh sequence number.
+  stats = ingest.copyTo(destination, mirror, {});
+  EXPECT_EQ(stats.skipped, 4u);
+  EXPECT_EQ(stats.files, 0u);
+  EXPECT_EQ(countCopies(), 4u);
+
+  // A renamed copy deleted from the destination is made again.
+  std::filesystem::remove(destination / "Event" / "Event-03.JPG");
+  stats = ingest.copyTo(destination, mirror, {});
+  EXPECT_EQ(stats.skipped, 3u);
+  EXPECT_EQ(stats.files, 1u);
+  EXPECT_EQ(stats.failed, 0u);
+  EXPECT_EQ(countCopies(), 4u);
+}
+
+TEST_F(IngestStateIndexTest, FailedMirrorCopiesAreNotRecorded) {
+  const auto card = scratch_ / "card";
+  std::filesystem::create_directories(card);
+  writeFile(card / "IMG_0001.CR3", std::string(4096, 'a'));
+  // A file where the mirror folder should be: every mirror copy fails.
+  writeFile(scratch_ / "mirror", "not a folder");
+
+  IngestService ingest;
+  ingest.setSkipPolicy(IngestService::SkipPolicy::kStat);
+  ingest.queueSources({card.string()});
+  auto stats = ingest.copyTo(scratch_ / "destination", scratch_ / "mirror", {});
+  EXPECT_EQ(stats.files, 1u);
+  EXPECT_EQ(stats.mirror_failed, 1u);
+
+  stats = ingest.copyTo(scratch_ / "destination", scratch_ / "mirror", {});
+  EXPECT_EQ(stats.skipped, 0u);
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "services/ingest/IngestService.h"
+#include "services/ingest/RenameTemplate.h"
+
+using cataloger::services::ingest::IngestRenamer;
+using cataloger::services::ingest::IngestService;
+using cataloger::services::ingest::RenameFields;
+using cataloger::services::ingest::RenameTemplate;
+
+namespace {
+
+std::string uniqueSuffix() {
+  const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::to_string(ticks);
+}
+
+std::string expand(const RenameTemplate& compiled, const RenameFields& fields) {
+  std::string out;
+  compiled.expandTo(fields, out);
+  return out;
+}
+
+}  // namespace
+
+TEST(RenameTemplateTests, ExpandsEveryToken) {
+  RenameFields fields;
+  fields.filename_base = "IMG_0042";
+  fields.year = 2024;
+  fields.month = 3;
+  fields.day = 9;
+  fields.sequence = 17;
+
+  EXPECT_EQ(expand(RenameTemplate("{year}/{month}-{day}/{job}", "Smith Wedding"), fields),
+            "2024/03-09/Smith Wedding");
+  EXPECT_EQ(expand(RenameTemplate("{year4}{year2}_{filenamebase}"), fields), "202424_IMG_0042");
+  EXPECT_EQ(expand(RenameTemplate("{job}_{sequence}", "a/b"), fields), "a_b_0017");
+  EXPECT_EQ(expand(RenameTemplate("{sequence:6}"), fields), "000017");
+  EXPECT_EQ(expand(RenameTemplate("no tokens"), fields), "no tokens");
+  EXPECT_TRUE(RenameTemplate("").empty());
+  EXPECT_TRUE(RenameTemplate("{sequence:2}").usesSequence());
+  EXPECT_FALSE(RenameTemplate("{year}").usesSequence());
+}
+
+TEST(RenameTemplateTests, ExpandingReusesTheBuffer) {
+  const RenameTemplate compiled("{job}_{year}{month}{day}_{sequence:5}_{filenamebase}", "Job");
+  RenameFields fields;
+  fields.filename_base = "DSC01234";
+  fields.year = 2023;
+  fields.month = 12;
+  fields.day = 31;
+  std::string out;
+  out.reserve(64);
+  const auto* storage = out.data();
+  for (std::uint64_t i = 0; i < 1000; ++i) {
+    fields.sequence = i;
+    out.clear();
+    compiled.expandTo(fields, out);
+  }
+  EXPECT_EQ(out, "Job_20231231_00999_DSC01234");
+  EXPECT_EQ(out.data(), storage);
+}
+
+TEST(RenameTemplateTests, RejectsMalformedTemplates) {
+  EXPECT_THROW(RenameTemplate("{year"), std::invalid_argument);
+  EXPECT_THROW(RenameTemplate("{camera}"), std::invalid_argument);
+  EXPECT_THROW(RenameTemplate("{sequence:0}"), std::invalid_argument);
+  EXPECT_THROW(RenameTemplate("{sequence:x}"), std::invalid_argument);
+  EXPECT_THROW(RenameTemplate("{sequences}"), std::invalid_argument);
+  IngestService ingest;
+  EXPECT_THROW(ingest.setRenameOptions({"{nope}", {}, {}, 1}), std::invalid_argument);
+}
+
+class IngestRenamerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    scratch_ = std::filesystem::temp_directory_path() / ("rename_template_" + uniqueSuffix());
+    std::filesystem::create_directories(scratch_);
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    std::filesystem::remove_all(scratch_, ec);
+  }
+
+  std::filesystem::path scratch_;
+};
+
+TEST_F(IngestRenamerTest, PairsShareASequenceAndClashesGetASuffix) {
+  IngestRenamer::Options options;
+  options.folder_template = "{job}";
+  options.file_template = "{job}_{sequence:3}";
+  options.job = "Shoot";
+  options.first_sequence = 7;
+  IngestRenamer renamer(options, scratch_ / "destination");
+  const auto now = std::filesystem::file_time_type::clock::now();
+  std::string out;
+
+  renamer.assign("/card/DCIM/100CANON/IMG_0001.CR3", "100CANON/IMG_0001.CR3", now, out);
+  EXPECT_EQ(out, "Shoot/Shoot_007.CR3");
+  renamer.assign("/card/DCIM/100CANON/IMG_0001.JPG", "100CANON/IMG_0001.JPG", now, out);
+  EXPECT_EQ(out, "Shoot/Shoot_007.JPG");
+  renamer.assign("/card/DCIM/100CANON/IMG_0002.CR3", "100CANON/IMG_0002.CR3", now, out);
+  EXPECT_EQ(out, "Shoot/Shoot_008.CR3");
+  // Same name on a second folder of the card: a new number.
+  renamer.assign("/card/DCIM/101CANON/IMG_0001.CR3", "101CANON/IMG_0001.CR3", now, out);
+  EXPECT_EQ(out, "Shoot/Shoot_009.CR3");
+  EXPECT_EQ(renamer.nextSequence(), 10u);
+
+  IngestRenamer::Options keep_names;
+  keep_names.folder_template = "{job}";
+  keep_names.job = "Shoot";
+  IngestRenamer flat(keep_names, scratch_ / "destination");
+  flat.assign("/card/DCIM/100CANON/IMG_0001.CR3", "100CANON/IMG_0001.CR3", now, out);
+  EXPECT_EQ(out, "Shoot/IMG_0001.CR3");
+  flat.assign("/card/DCIM/101CANON/IMG_0001.CR3", "101CANON/IMG_0001.CR3", now, out);
+  EXPECT_EQ(out, "Shoot/IMG_0001-1.CR3");
+  flat.assign("/card/DCIM/102CANON/img_0001.cr3", "102CANON/img_0001.cr3", now, out);
+  EXPECT_EQ(out, "Shoot/img_0001-2.cr3");
+}
+
+TEST_F(IngestRenamerTest, FilesAlreadyInTheDestinationAreAvoided) {
+  const auto destination = scratch_ / "destination";
+  std::filesystem::create_directories(destination / "Shoot");
+  std::ofstream(destination / "Shoot" / "IMG_0001.CR3") << "earlier ingest";
+
+  IngestRenamer::Options options;
+  options.folder_template = "{job}";
+  options.job = "Shoot";
+  IngestRenamer renamer(options, destination);
+  std::string out;
+  renamer.assign("/card/IMG_0001.CR3", "IMG_0001.CR3", {}, out);
+  EXPECT_EQ(out, "Shoot/IMG_0001-1.CR3");
+}
+
+TEST_F(IngestRenamerTest, ParallelWorkersGetDistinctSequences) {
+  IngestRenamer::Options options;
+  options.file_template = "{sequence:5}";
+  IngestRenamer renamer(options, scratch_ / "destination");
+  constexpr std::size_t kThreads = 4;
+  constexpr std::size_t kPerThread = 500;
+  std::vector<std::vector<std::string>> names(kThreads);
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < kThreads; ++t) {
+    workers.emplace_back([&, t] {
+      std::string out;
+      for (std::size_t i = 0; i < kPerThread; ++i) {
+        const auto name = "IMG_" + std::to_string(t * kPerThread + i) + ".JPG";
+        renamer.assign("/card/" + name, name, {}, out);
+        names[t].push_back(out);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  std::set<std::string> unique;
+  for (const auto& batch : names) {
+    unique.insert(batch.begin(), batch.end());
+  }
+  EXPECT_EQ(unique.size(), kThreads * kPerThread);
+  EXPECT_EQ(*unique.begin(), "00001.JPG");
+  EXPECT_EQ(*unique.rbegin(), "02000.JPG");
+  EXPECT_EQ(renamer.nextSequence(), kThreads * kPerThread + 1);
+}
+
+TEST_F(IngestRenamerTest, PlannedCopiesAreNamedInCaptureOrder) {
+  const auto card = scratch_ / "card" / "DCIM" / "100CANON";
+  std::filesystem::create_directories(card);
+  const auto base = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+  // Names run against capture order.
+  for (int i = 0; i < 3; ++i) {
+    const auto path = card / ("IMG_" + std::to_string(9 - i) + ".JPG");
+    std::ofstream(path) << i;
+    std::filesystem::last_write_time(path, base + std::chrono::seconds(i));
+  }
+
+  IngestService ingest;
+  ingest.queueSources({(scratch_ / "card").string()});
+  ingest.setRenameOptions({"{job}", "{job}-{sequence:2}", "Event", 1});
+  const auto destination = scratch_ / "destination";
+  const auto mirror = scratch_ / "mirror";
+  const auto jobs = ingest.planCopy(destination, mirror);
+  ASSERT_EQ(jobs.size(), 3u);
+  for (std::size_t i = 0; i < jobs.size(); ++i) {
+    const auto expected = "Event-0" + std::to_string(i + 1) + ".JPG";
+    EXPECT_EQ(jobs[i].source.filename(), "IMG_" + std::to_string(9 - i) + ".JPG");
+    EXPECT_EQ(jobs[i].destination, destination / "Event" / expected);
+    EXPECT_EQ(jobs[i].mirror, mirror / "Event" / expected);
+  }
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "platform/io/BatchReader.h"
+
+namespace {
+
+using cataloger::platform::io::BatchReader;
+using cataloger::platform::io::FileHandle;
+using cataloger::platform::io::ReadRequest;
+
+std::string uniqueSuffix() {
+  return std::to_string(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+class BatchReaderTest : public ::testing::TestWithParam<bool> {
+protected:
+  void SetUp() override {
+    root_ = std::filesystem::temp_directory_path() /
+            ("cataloger_batch_reader_" + uniqueSuffix());
+    std::filesystem::create_directories(root_);
+    for (int f = 0; f < 8; ++f) {
+      std::vector<char> bytes(10000 + f * 1000);
+      for (std::size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<char>((i * 7 + f) & 0xFF);
+      }
+      const auto path = root_ / ("file" + std::to_string(f) + ".bin");
+      std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size());
+      paths_.push_back(path);
+    }
+    reader_ = GetParam() ? cataloger::platform::io::CreateBatchReader(4)
+                         : cataloger::platform::io::CreateThreadPoolReader(3);
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    std::filesystem::remove_all(root_, ec);
+  }
+
+  std::filesystem::path root_;
+  std::vector<std::filesystem::path> paths_;
+  std::unique_ptr<BatchReader> reader_;
+};
+
+}  // namespace
+
+TEST_P(BatchReaderTest, ReadsEveryRequestInOneBatch) {
+  std::vector<FileHandle> files;
+  for (const auto& path : paths_) {
+    files.emplace_back(path);
+    ASSERT_TRUE(files.back().isOpen());
+  }
+
+  // More requests than the queue depth, with offsets into the middle.
+  std::vector<std::vector<std::uint8_t>> buffers(files.size() * 2,
+                                                 std::vector<std::uint8_t>(2000));
+  std::vector<ReadRequest> requests;
+  std::size_t b = 0;
+  for (std::size_t f = 0; f < files.size(); ++f) {
+    for (std::uint64_t offset : {0u, 4096u}) {
+      requests.push_back({files[f].fd(), offset, buffers[b++]});
+    }
+  }
+
+  const auto results = reader_->readBatch(requests);
+  ASSERT_EQ(results.size(), requests.size());
+  RecordProperty("backend", cataloger::platform::io::BackendName(reader_->backend()));
+  b = 0;
+  for (std::size_t f = 0; f < files.size(); ++f) {
+    for (std::uint64_t offset : {0u, 4096u}) {
+      const auto& result = results[b];
+      EXPECT_EQ(result.error, 0);
+      ASSERT_EQ(result.bytes_read, 2000u);
+      for (std::size_t i = 0; i < 2000; i += 97) {
+        EXPECT_EQ(buffers[b][i], static_cast<std::uint8_t>(((offset + i) * 7 + f) & 0xFF));
+      }
+      ++b;
+    }
+  }
+}
+
+TEST_P(BatchReaderTest, ShortReadAtEndOfFileIsNotAnError) {
+  FileHandle file(paths_.front());
+  ASSERT_TRUE(file.isOpen());
+  EXPECT_EQ(file.size(), 10000u);
+
+  std::vector<std::uint8_t> tail(4096);
+  const std::vector<ReadRequest> requests{{file.fd(), 8000, tail}};
+  const auto results = reader_->readBatch(requests);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0].error, 0);
+  EXPECT_EQ(results[0].bytes_read, 2000u);
+}
+
+TEST_P(BatchReaderTest, ReportsErrorsPerRequest) {
+  FileHandle file(paths_.front());
+  std::vector<std::uint8_t> good(16);
+  std::vector<std::uint8_t> bad(16);
+  const std::vector<ReadRequest> requests{{file.fd(), 0, good}, {-1, 0, bad}};
+  const auto results = reader_->readBatch(requests);
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_EQ(results[0].bytes_read, 16u);
+  EXPECT_NE(results[1].error, 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends,
+                         BatchReaderTest,
+                         ::testing::Values(true, false),
+                         [](const ::testing::TestParamInfo<bool>& info) {
+                           return info.param ? "Default" : "ThreadPool";
+                         });
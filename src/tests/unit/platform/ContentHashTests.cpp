@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "platform/io/ContentHash.h"
+
+using cataloger::platform::io::ContentHasher;
+using cataloger::platform::io::HashBytes;
+using cataloger::platform::io::HashFileUncached;
+
+namespace {
+
+std::uint64_t hashText(std::string_view text) {
+  return HashBytes({reinterpret_cast<const std::uint8_t*>(text.data()), text.size()});
+}
+
+std::vector<std::uint8_t> pattern(std::size_t size) {
+  std::vector<std::uint8_t> bytes(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    bytes[i] = static_cast<std::uint8_t>((i * 2654435761u) >> 13);
+  }
+  return bytes;
+}
+
+}  // namespace
+
+// Reference values from the XXH64 specification's implementation.
+TEST(ContentHashTests, MatchesReferenceXxh64) {
+  EXPECT_EQ(hashText(""), 0xef46db3751d8e999ull);
+  EXPECT_EQ(hashText("a"), 0xd24ec4f1a98c6e5bull);
+  EXPECT_EQ(hashText("abc"), 0x44bc2cf5ad770999ull);
+  EXPECT_EQ(hashText("Nobody inspects the spammish repetition"), 0xfbcea83c8a378bf1ull);
+}
+
+TEST(ContentHashTests, StreamingMatchesOneShotForAnySplit) {
+  const auto bytes = pattern(1000);
+  const auto expected = HashBytes(bytes);
+  for (const std::size_t step : {1u, 3u, 7u, 31u, 32u, 33u, 64u, 999u}) {
+    ContentHasher hasher;
+    for (std::size_t offset = 0; offset < bytes.size(); offset += step) {
+      const auto take = std::min(step, bytes.size() - offset);
+      hasher.update({bytes.data() + offset, take});
+    }
+    EXPECT_EQ(hasher.digest(), expected) << "step " << step;
+  }
+  ContentHasher reused;
+  reused.update(bytes);
+  reused.reset();
+  EXPECT_EQ(reused.digest(), hashText(""));
+}
+
+TEST(ContentHashTests, ReadBackHashesWhatIsOnDisk) {
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("content_hash_" +
+                     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  // Not a multiple of the direct-I/O block size, and several buffers long.
+  const auto bytes = pattern(3 * 4096 + 123);
+  {
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(bytes.data()),
+                 static_cast<std::streamsize>(bytes.size()));
+  }
+  const auto read_back = HashFileUncached(path, 4096);
+  EXPECT_EQ(read_back.error, 0);
+  EXPECT_EQ(read_back.bytes, bytes.size());
+  EXPECT_EQ(read_back.hash, HashBytes(bytes));
+
+  EXPECT_NE(HashFileUncached(path.string() + ".missing").error, 0);
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "platform/io/FileWatcher.h"
+
+using cataloger::platform::io::FileChange;
+using cataloger::platform::io::FileChangeKind;
+using cataloger::platform::io::FileWatcher;
+
+namespace {
+
+std::string uniqueSuffix() {
+  const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::to_string(ticks);
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& contents) {
+  std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+  stream << contents;
+}
+
+std::size_t openDescriptors() {
+  const auto fds = std::filesystem::directory_iterator("/proc/self/fd");
+  return static_cast<std::size_t>(
+      std::distance(std::filesystem::begin(fds), std::filesystem::end(fds)));
+}
+
+}  // namespace
+
+class FileWatcherTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+#if !defined(__linux__)
+    GTEST_SKIP() << "FileWatcher is inotify-based";
+#endif
+    root_ = std::filesystem::temp_directory_path() / ("file_watcher_" + uniqueSuffix());
+    std::filesystem::create_directories(root_ / "2024" / "shoot");
+    writeFile(root_ / "2024" / "shoot" / "IMG_0001.JPG", "old");
+    writeFile(root_ / "2024" / "shoot" / "IMG_0002.JPG", "old");
+  }
+
+  void TearDown() override {
+    watcher_.reset();
+    std::error_code ec;
+    std::filesystem::remove_all(root_, ec);
+  }
+
+  void startWatcher(FileWatcher::Options options = {}) {
+    options.debounce = std::chrono::milliseconds(50);
+    watcher_ =
+        std::make_unique<FileWatcher>(root_, options, [this](std::vector<FileChange> batch) {
+          std::lock_guard lock(mutex_);
+          batch_sizes_.push_back(batch.size());
+          for (auto& change : batch) {
+            changes_[change.relative_path].push_back(change.kind);
+          }
+          arrived_.notify_all();
+        });
+    ASSERT_EQ(watcher_->start(), 0);
+  }
+
+  // Waits until `path` has been reported.
+  bool waitFor(const std::string& path) {
+    std::unique_lock lock(mutex_);
+    return arrived_.wait_for(lock, std::chrono::seconds(5),
+                             [&] { return changes_.contains(path); });
+  }
+
+  std::filesystem::path root_;
+  std::unique_ptr<FileWatcher> watcher_;
+  std::mutex mutex_;
+  std::condition_variable arrived_;
+  std::map<std::string, std::vector<FileChangeKind>> changes_;
+  std::vector<std::size_t> batch_sizes_;
+};
+
+TEST_F(FileWatcherTest, CoalescesABurstIntoOneChange) {
+  startWatcher();
+  EXPECT_EQ(watcher_->watchedDirectories(), 3u);
+
+  // create + modify + close_write, several times over.
+  for (int i = 0; i < 5; ++i) {
+    writeFile(root_ / "2024" / "shoot" / "IMG_0003.JPG", std::string(100 * (i + 1), 'x'));
+  }
+  writeFile(root_ / "2024" / "shoot" / "IMG_0001.JPG", "edited");
+  std::filesystem::remove(root_ / "2024" / "shoot" / "IMG_0002.JPG");
+  // Created and deleted before the window closed: nothing to report.
+  writeFile(root_ / "2024" / "shoot" / "scratch.tmp", "x");
+  std::filesystem::remove(root_ / "2024" / "shoot" / "scratch.tmp");
+  // Hidden temporaries are skipped.
+  writeFile(root_ / "2024" / "shoot" / ".IMG_0004.JPG.cataloger-partial", "x");
+
+  ASSERT_TRUE(waitFor("2024/shoot/IMG_0003.JPG"));
+  watcher_->stop();
+  std::lock_guard lock(mutex_);
+  EXPECT_EQ(changes_["2024/shoot/IMG_0003.JPG"],
+            std::vector<FileChangeKind>{FileChangeKind::kChanged});
+  EXPECT_EQ(changes_["2024/shoot/IMG_0001.JPG"],
+            std::vector<FileChangeKind>{FileChangeKind::kChanged});
+  EXPECT_EQ(changes_["2024/shoot/IMG_0002.JPG"],
+            std::vector<FileChangeKind>{FileChangeKind::kRemoved});
+  EXPECT_FALSE(changes_.contains("2024/shoot/scratch.tmp"));
+  EXPECT_FALSE(changes_.contains("2024/shoot/.IMG_0004.JPG.cataloger-partial"));
+  EXPECT_EQ(changes_.size(), 3u);
+}
+
+TEST_F(FileWatcherTest, WatchesNewFoldersAndReportsRemovedOnes) {
+  startWatcher();
+  std::filesystem::create_directories(root_ / "2025" / "trip");
+  // Whether or not the file beat its folder's watch, the folder's rescan
+  // covers it.
+  writeFile(root_ / "2025" / "trip" / "IMG_0100.JPG", "new");
+  ASSERT_TRUE(waitFor("2025/trip"));
+  EXPECT_EQ(watcher_->watchedDirectories(), 5u);
+
+  std::filesystem::remove_all(root_ / "2024");
+  ASSERT_TRUE(waitFor("2024"));
+  watcher_->stop();
+
+  std::lock_guard lock(mutex_);
+  EXPECT_EQ(changes_["2025"], std::vector<FileChangeKind>{FileChangeKind::kRescan});
+  EXPECT_EQ(changes_["2025/trip"], std::vector<FileChangeKind>{FileChangeKind::kRescan});
+  EXPECT_EQ(changes_["2024"], std::vector<FileChangeKind>{FileChangeKind::kRemoved});
+}
+
+TEST_F(FileWatcherTest, OverflowRescansOnlyTheFoldersThatMoved) {
+  std::filesystem::create_directories(root_ / "2023" / "quiet");
+  startWatcher();
+  // Stand in for events the kernel dropped: a file appears in one folder
+  // and the overflow is handled before its event is read.
+  writeFile(root_ / "2024" / "shoot" / "IMG_0009.JPG", "lost");
+  watcher_->recoverFromOverflow();
+  watcher_->stop();
+
+  std::lock_guard lock(mutex_);
+  EXPECT_EQ(changes_["2024/shoot"], std::vector<FileChangeKind>{FileChangeKind::kRescan});
+  EXPECT_FALSE(changes_.contains("2023/quiet"));
+  EXPECT_FALSE(changes_.contains("2023"));
+  EXPECT_FALSE(changes_.contains(""));
+}
+
+TEST_F(FileWatcherTest, OverflowRescansFoldersWithFilesWrittenInPlace) {
+  std::filesystem::create_directories(root_ / "2023" / "quiet");
+  writeFile(root_ / "2023" / "quiet" / "IMG_0100.JPG", "old");
+  const auto now = std::filesystem::file_time_type::clock::now();
+  std::filesystem::last_write_time(root_ / "2023" / "quiet" / "IMG_0100.JPG",
+                                   now - std::chrono::hours(1));
+  std::filesystem::last_write_time(root_ / "2024" / "shoot" / "IMG_0002.JPG",
+                                   now - std::chrono::hours(1));
+  // Stands in for an in-place write whose events were dropped: the file's
+  // mtime is past the watch, its folder's mtime is not.
+  std::filesystem::last_write_time(root_ / "2024" / "shoot" / "IMG_0001.JPG",
+                                   now + std::chrono::hours(1));
+  startWatcher();
+  watcher_->recoverFromOverflow();
+  watcher_->stop();
+
+  std::lock_guard lock(mutex_);
+  EXPECT_EQ(changes_["2024/shoot"], std::vector<FileChangeKind>{FileChangeKind::kRescan});
+  EXPECT_FALSE(changes_.contains("2023/quiet"));
+  EXPECT_FALSE(changes_.contains(""));
+}
+
+TEST_F(FileWatcherTest, StartFailsCleanlyWithoutTheRoot) {
+  watcher_ = std::make_unique<FileWatcher>(root_ / "missing", FileWatcher::Options{},
+                                           [](std::vector<FileChange>) {});
+  const auto open_before = openDescriptors();
+  EXPECT_EQ(watcher_->start(), ENOENT);
+  EXPECT_EQ(openDescriptors(), open_before);
+  std::filesystem::create_directories(root_ / "missing");
+  EXPECT_EQ(watcher_->start(), 0);
+}
+
+TEST_F(FileWatcherTest, ReportsInBatches) {
+  FileWatcher::Options options;
+  options.max_batch = 4;
+  startWatcher(options);
+  for (int i = 0; i < 10; ++i) {
+    writeFile(root_ / ("IMG_" + std::to_string(1000 + i) + ".JPG"), "x");
+  }
+  watcher_->stop();
+  std::lock_guard lock(mutex_);
+  EXPECT_EQ(changes_.size(), 10u);
+  for (const auto size : batch_sizes_) {
+    EXPECT_LE(size, 4u);
+  }
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "platform/io/MountWatcher.h"
+
+using cataloger::platform::io::FindCameraFolder;
+using cataloger::platform::io::IsRemovableMediaCandidate;
+using cataloger::platform::io::MountChange;
+using cataloger::platform::io::MountEntry;
+using cataloger::platform::io::MountWatcher;
+using cataloger::platform::io::ParseMountInfo;
+
+namespace {
+
+constexpr const char* kRootLine =
+    "22 1 259:2 / / rw,relatime shared:1 - ext4 /dev/nvme0n1p2 rw\n";
+constexpr const char* kCardLine =
+    "583 22 8:33 / /media/alex/EOS\\040DIGITAL rw,nosuid,nodev,relatime shared:301 - exfat "
+    "/dev/sdc1 rw,fmask=0022\n";
+
+std::string uniqueSuffix() {
+  const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::to_string(ticks);
+}
+
+void writeTable(const std::filesystem::path& path, const std::string& text) {
+  std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+  stream << text;
+}
+
+}  // namespace
+
+TEST(MountWatcherTests, ParsesMountInfoLines) {
+  const auto mounts = ParseMountInfo(std::string(kRootLine) + "garbage\n" + kCardLine);
+  ASSERT_EQ(mounts.size(), 2u);
+  EXPECT_EQ(mounts[0].mount_id, 22);
+  EXPECT_EQ(mounts[0].mount_point, "/");
+  EXPECT_EQ(mounts[0].fs_type, "ext4");
+  EXPECT_FALSE(IsRemovableMediaCandidate(mounts[0]));
+
+  EXPECT_EQ(mounts[1].mount_id, 583);
+  EXPECT_EQ(mounts[1].device, "8:33");
+  EXPECT_EQ(mounts[1].mount_point, "/media/alex/EOS DIGITAL");
+  EXPECT_EQ(mounts[1].fs_type, "exfat");
+  EXPECT_EQ(mounts[1].source, "/dev/sdc1");
+  EXPECT_TRUE(IsRemovableMediaCandidate(mounts[1]));
+
+  MountEntry usb_stick;
+  usb_stick.mount_point = "/run/media/alex/STICK";
+  usb_stick.fs_type = "ext4";
+  EXPECT_TRUE(IsRemovableMediaCandidate(usb_stick));
+}
+
+TEST(MountWatcherTests, FindsTheCameraFolderWithoutWalking) {
+  const auto card = std::filesystem::temp_directory_path() / ("mount_card_" + uniqueSuffix());
+  std::filesystem::create_directories(card);
+  EXPECT_FALSE(FindCameraFolder(card));
+  std::filesystem::create_directories(card / "DCIM" / "100CANON");
+  const auto folder = FindCameraFolder(card);
+  ASSERT_TRUE(folder);
+  EXPECT_EQ(*folder, card / "DCIM");
+  std::filesystem::remove_all(card);
+}
+
+TEST(MountWatcherTests, ReportsMountsFromAFakeTable) {
+#if defined(_WIN32)
+  GTEST_SKIP() << "MountWatcher has no mount table to watch on Windows";
+#endif
+  const auto table =
+      std::filesystem::temp_directory_path() / ("mountinfo_" + uniqueSuffix());
+  writeTable(table, kRootLine);
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<MountChange> changes;
+  MountWatcher::Options options;
+  options.mountinfo = table;
+  options.rescan_interval = std::chrono::milliseconds(10);
+  MountWatcher watcher(options, [&](const MountChange& change) {
+    std::lock_guard lock(mutex);
+    changes.push_back(change);
+    changed.notify_all();
+  });
+  ASSERT_EQ(watcher.start(), 0);
+  EXPECT_EQ(watcher.mounts().size(), 1u);
+
+  const auto wait_for = [&](std::size_t count) {
+    std::unique_lock lock(mutex);
+    return changed.wait_for(lock, std::chrono::seconds(5),
+                            [&] { return changes.size() >= count; });
+  };
+  writeTable(table, std::string(kRootLine) + kCardLine);
+  ASSERT_TRUE(wait_for(1));
+  writeTable(table, kRootLine);
+  ASSERT_TRUE(wait_for(2));
+  watcher.stop();
+
+  ASSERT_EQ(changes.size(), 2u);
+  ASSERT_EQ(changes[0].added.size(), 1u);
+  EXPECT_TRUE(changes[0].removed.empty());
+  EXPECT_EQ(changes[0].added[0].mount_point, "/media/alex/EOS DIGITAL");
+  EXPECT_TRUE(changes[1].added.empty());
+  ASSERT_EQ(changes[1].removed.size(), 1u);
+  EXPECT_EQ(changes[1].removed[0].source, "/dev/sdc1");
+  // Nothing changed since: no report.
+  EXPECT_FALSE(watcher.refresh());
+  std::filesystem::remove(table);
+}
+
+#if defined(__linux__)
+TEST(MountWatcherTests, WatchesTheRealMountTable) {
+  MountWatcher watcher({}, {});
+  ASSERT_EQ(watcher.start(), 0);
+  const auto mounts = watcher.mounts();
+  EXPECT_FALSE(mounts.empty());
+  EXPECT_FALSE(watcher.refresh());
+  watcher.stop();
+}
+#endif
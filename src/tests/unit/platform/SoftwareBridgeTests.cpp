@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "platform/gpu/SoftwareBridge.h"
+
+namespace {
+
+using cataloger::platform::gpu::PixelFormat;
+using cataloger::platform::gpu::SoftwareBridge;
+using cataloger::services::preview::PixelBuffer;
+using cataloger::services::preview::PreviewImage;
+
+PreviewImage makeImage(const std::string& key, int width, int height, std::uint8_t seed) {
+  PreviewImage image;
+  image.cache_key = key;
+  image.width = width;
+  image.height = height;
+  std::vector<std::uint8_t> rgb(static_cast<std::size_t>(width) * height * 3);
+  for (std::size_t i = 0; i < rgb.size(); ++i) {
+    rgb[i] = static_cast<std::uint8_t>(i * 31 + seed);
+  }
+  image.pixels = PixelBuffer(rgb.data(), rgb.size());
+  return image;
+}
+
+SoftwareBridge::Options smallAtlas(std::size_t pages, std::size_t spares) {
+  SoftwareBridge::Options options;
+  options.page_extent = 64;
+  options.budget_bytes = pages * 64 * 64 * 4;
+  options.spare_pages = spares;
+  return options;
+}
+
+}  // namespace
+
+TEST(SoftwareBridgeTests, SwizzleMatchesScalarAtEveryLength) {
+  std::mt19937 rng(7);
+  std::vector<std::uint8_t> rgb(3 * 67);
+  for (auto& byte : rgb) {
+    byte = static_cast<std::uint8_t>(rng());
+  }
+  for (const auto format : {PixelFormat::kBGRA8, PixelFormat::kRGBA8}) {
+    for (std::size_t count = 0; count <= 67; ++count) {
+      std::vector<std::uint8_t> out(count * 4 + 4, 0x11);
+      cataloger::platform::gpu::SwizzleRgb(rgb.data(), out.data(), count, format);
+      for (std::size_t j = 0; j < count; ++j) {
+        const auto* px = &rgb[j * 3];
+        const std::uint8_t first = format == PixelFormat::kBGRA8 ? px[2] : px[0];
+        const std::uint8_t third = format == PixelFormat::kBGRA8 ? px[0] : px[2];
+        ASSERT_EQ(out[j * 4 + 0], first) << count << " " << j;
+        ASSERT_EQ(out[j * 4 + 1], px[1]) << count << " " << j;
+        ASSERT_EQ(out[j * 4 + 2], third) << count << " " << j;
+        ASSERT_EQ(out[j * 4 + 3], 255) << count << " " << j;
+      }
+      // Nothing written past the last texel.
+      EXPECT_EQ(out[count * 4], 0x11);
+    }
+  }
+}
+
+TEST(SoftwareBridgeTests, UploadStoresBgraTexelsAndPadsShortSources) {
+  SoftwareBridge bridge;
+  auto image = makeImage("a", 3, 2, 1);
+  image.pixels.resize(4 * 3);  // the second row is missing two pixels
+
+  std::string error;
+  ASSERT_TRUE(bridge.upload(image, error)) << error;
+  EXPECT_EQ(bridge.backend(), cataloger::platform::gpu::Backend::kSoftware);
+
+  const auto texels = bridge.readTexels("a");
+  ASSERT_EQ(texels.size(), 3u * 2u * 4u);
+  for (std::size_t j = 0; j < 4; ++j) {
+    EXPECT_EQ(texels[j * 4 + 0], image.pixels[j * 3 + 2]);
+    EXPECT_EQ(texels[j * 4 + 1], image.pixels[j * 3 + 1]);
+    EXPECT_EQ(texels[j * 4 + 2], image.pixels[j * 3 + 0]);
+    EXPECT_EQ(texels[j * 4 + 3], 255);
+  }
+  for (std::size_t i = 16; i < texels.size(); ++i) {
+    EXPECT_EQ(texels[i], 255);
+  }
+
+  const auto stats = bridge.residency();
+  EXPECT_EQ(stats.resident_textures, 1u);
+  EXPECT_EQ(stats.resident_bytes, 24u);
+  EXPECT_EQ(bridge.atlasPages(), 1u);
+}
+
+TEST(SoftwareBridgeTests, PacksSeveralTexturesPerPage) {
+  SoftwareBridge bridge(smallAtlas(4, 0));
+  std::string error;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(bridge.upload(makeImage("t" + std::to_string(i), 32, 32, 3), error));
+  }
+  EXPECT_EQ(bridge.atlasPages(), 1u);
+  const auto a = bridge.lookup("t0");
+  const auto b = bridge.lookup("t3");
+  ASSERT_TRUE(a && b);
+  EXPECT_EQ(a->page, b->page);
+  EXPECT_NE(a->x + a->y * 64, b->x + b->y * 64);
+  EXPECT_EQ(bridge.readTexels("t3"), [&] {
+    SoftwareBridge reference;
+    reference.upload(makeImage("t3", 32, 32, 3), error);
+    return reference.readTexels("t3");
+  }());
+}
+
+TEST(SoftwareBridgeTests, EvictsLeastRecentlyUploadedOverBudget) {
+  SoftwareBridge bridge(smallAtlas(2, 0));
+  std::string error;
+  ASSERT_TRUE(bridge.upload(makeImage("a", 64, 64, 1), error));
+  ASSERT_TRUE(bridge.upload(makeImage("b", 64, 64, 2), error));
+  ASSERT_TRUE(bridge.upload(makeImage("c", 64, 64, 3), error));
+  EXPECT_FALSE(bridge.lookup("a").has_value());
+  EXPECT_TRUE(bridge.lookup("b").has_value());
+
+  // Re-uploading b makes c the oldest.
+  ASSERT_TRUE(bridge.upload(makeImage("b", 64, 64, 4), error));
+  ASSERT_TRUE(bridge.upload(makeImage("d", 64, 64, 5), error));
+  EXPECT_FALSE(bridge.lookup("c").has_value());
+  EXPECT_TRUE(bridge.lookup("b").has_value());
+
+  const auto stats = bridge.residency();
+  EXPECT_EQ(stats.resident_textures, 2u);
+  EXPECT_LE(stats.allocated_bytes, 2u * 64 * 64 * 4);
+  EXPECT_EQ(stats.evictions, 2u);
+  EXPECT_EQ(stats.uploads, 5u);
+}
+
+TEST(SoftwareBridgeTests, TouchedTexturesAreEvictedLast) {
+  SoftwareBridge bridge(smallAtlas(2, 0));
+  std::string error;
+  ASSERT_TRUE(bridge.upload(makeImage("a", 64, 64, 1), error));
+  ASSERT_TRUE(bridge.upload(makeImage("b", 64, 64, 2), error));
+  // Shown again: a outlives b although it was uploaded first.
+  bridge.touch("a");
+  bridge.touch("missing");
+  ASSERT_TRUE(bridge.upload(makeImage("c", 64, 64, 3), error));
+  EXPECT_TRUE(bridge.isResident("a"));
+  EXPECT_FALSE(bridge.isResident("b"));
+  EXPECT_TRUE(bridge.isResident("c"));
+  EXPECT_EQ(bridge.residency().uploads, 3u);
+}
+
+TEST(SoftwareBridgeTests, RecyclesEmptyPagesAndRejectsOversizedTextures) {
+  SoftwareBridge bridge(smallAtlas(2, 1));
+  std::string error;
+  ASSERT_TRUE(bridge.upload(makeImage("a", 64, 64, 1), error));
+  ASSERT_TRUE(bridge.upload(makeImage("a", 64, 64, 2), error));
+  auto stats = bridge.residency();
+  EXPECT_EQ(stats.reuses, 1u);
+  EXPECT_EQ(stats.allocated_bytes, 64u * 64 * 4);
+
+  // Larger than a page: gets its own page, which still has to fit the budget.
+  ASSERT_TRUE(bridge.upload(makeImage("wide", 128, 32, 3), error));
+  EXPECT_FALSE(bridge.upload(makeImage("huge", 256, 256, 4), error));
+  EXPECT_FALSE(error.empty());
+  EXPECT_TRUE(bridge.lookup("wide").has_value());
+}
+
+TEST(SoftwareBridgeTests, ReusesBucketSlotsAndReportsEvictions) {
+  SoftwareBridge bridge(smallAtlas(1, 0));
+  std::vector<std::string> evicted;
+  bridge.setEvictionHandler([&](const std::string& key) { evicted.push_back(key); });
+
+  std::string error;
+  // Two 32x32-bucket slots side by side keep the page open.
+  ASSERT_TRUE(bridge.upload(makeImage("a", 30, 20, 1), error));
+  ASSERT_TRUE(bridge.upload(makeImage("b", 32, 32, 2), error));
+  const auto slot = bridge.lookup("a");
+  ASSERT_TRUE(slot.has_value());
+
+  EXPECT_TRUE(bridge.evict("a"));
+  EXPECT_FALSE(bridge.isResident("a"));
+  EXPECT_EQ(evicted, std::vector<std::string>{"a"});
+
+  // A different size in the same bucket lands in the freed slot.
+  ASSERT_TRUE(bridge.upload(makeImage("c", 25, 31, 3), error));
+  const auto reused = bridge.lookup("c");
+  ASSERT_TRUE(reused.has_value());
+  EXPECT_EQ(reused->x, slot->x);
+  EXPECT_EQ(reused->y, slot->y);
+  EXPECT_EQ(bridge.residency().reuses, 1u);
+
+  // Shrinking the budget evicts everything and notifies for each texture.
+  bridge.setBudget(0);
+  EXPECT_EQ(bridge.residency().resident_textures, 0u);
+  EXPECT_EQ(bridge.residency().allocated_bytes, 0u);
+  EXPECT_EQ(evicted.size(), 3u);
+}
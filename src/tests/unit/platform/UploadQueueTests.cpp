@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "platform/gpu/UploadQueue.h"
+
+namespace {
+
+using cataloger::platform::gpu::UploadOutcome;
+using cataloger::platform::gpu::UploadQueue;
+using cataloger::services::preview::PreviewImage;
+
+// Acts like a device with a fixed per-submission latency.
+class SlowBridge : public cataloger::platform::gpu::GpuBridge {
+public:
+  explicit SlowBridge(std::chrono::milliseconds latency) : latency_(latency) {}
+
+  bool upload(const PreviewImage& image, std::string& error) override {
+    if (image.width <= 0) {
+      error = "bad image";
+      return false;
+    }
+    return true;
+  }
+
+  std::vector<UploadOutcome> uploadBatch(
+      std::span<const PreviewImage* const> images) override {
+    std::this_thread::sleep_for(latency_);
+    {
+      std::lock_guard lock(mutex_);
+      batch_sizes_.push_back(images.size());
+    }
+    return GpuBridge::uploadBatch(images);
+  }
+
+  cataloger::platform::gpu::Backend backend() const noexcept override {
+    return cataloger::platform::gpu::Backend::kSoftware;
+  }
+
+  std::vector<std::size_t> batchSizes() const {
+    std::lock_guard lock(mutex_);
+    return batch_sizes_;
+  }
+
+private:
+  std::chrono::milliseconds latency_;
+  mutable std::mutex mutex_;
+  std::vector<std::size_t> batch_sizes_;
+};
+
+PreviewImage makeImage(int index) {
+  PreviewImage image;
+  image.cache_key = "img" + std::to_string(index);
+  image.width = index == 3 ? 0 : 16;
+  image.height = 16;
+  return image;
+}
+
+}  // namespace
+
+TEST(UploadQueueTests, SubmitReturnsBeforeTheDeviceFinishes) {
+  SlowBridge bridge(std::chrono::milliseconds(40));
+  UploadQueue queue(bridge);
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<cataloger::platform::gpu::UploadFence> fences;
+  for (int i = 0; i < 8; ++i) {
+    fences.push_back(queue.submit(makeImage(i)));
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(30));
+  EXPECT_NE(fences.back().wait_for(std::chrono::seconds(0)), std::future_status::ready);
+
+  for (int i = 0; i < 8; ++i) {
+    const auto& result = fences[i].get();
+    EXPECT_EQ(result.ok, i != 3) << i;
+    EXPECT_EQ(result.error.empty(), i != 3) << i;
+    EXPECT_GE(result.batch_ms, 40.0);
+  }
+}
+
+TEST(UploadQueueTests, CollectsOneBatchPerFrameAndCompletesInOrder) {
+  SlowBridge bridge(std::chrono::milliseconds(5));
+  UploadQueue::Options options;
+  options.frame_interval = std::chrono::milliseconds(50);
+  options.max_batch = 4;
+  UploadQueue queue(bridge, options);
+
+  std::vector<std::string> completed;
+  std::mutex mutex;
+  for (int i = 0; i < 10; ++i) {
+    queue.submit(makeImage(i), [&, i](const cataloger::platform::gpu::UploadResult& result) {
+      std::lock_guard lock(mutex);
+      completed.push_back("img" + std::to_string(i));
+      EXPECT_GE(result.batch_size, 1u);
+      EXPECT_LE(result.batch_size, 4u);
+    });
+  }
+  queue.flush();
+
+  ASSERT_EQ(completed.size(), 10u);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(completed[i], "img" + std::to_string(i));
+  }
+  // Full batches go out immediately; only the remainder waits for the frame.
+  EXPECT_EQ(bridge.batchSizes(), (std::vector<std::size_t>{4, 4, 2}));
+  EXPECT_EQ(queue.stats().batches, 3u);
+  EXPECT_EQ(queue.stats().largest_batch, 4u);
+}
+
+TEST(UploadQueueTests, DestructionDrainsPendingUploads) {
+  SlowBridge bridge(std::chrono::milliseconds(10));
+  std::atomic<int> completed{0};
+  {
+    UploadQueue queue(bridge);
+    for (int i = 0; i < 5; ++i) {
+      queue.submit(makeImage(i), [&](const auto&) { ++completed; });
+    }
+  }
+  EXPECT_EQ(completed.load(), 5);
+}
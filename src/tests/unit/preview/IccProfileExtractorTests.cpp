@@ -1,8 +1,16 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
 
 #include "services/preview/IccProfileExtractor.h"
+#include "services/preview/JpegSegmentIndex.h"
+#include "services/preview/PreviewExtractor.h"
 
 namespace {
 
@@ -14,8 +22,236 @@ std::filesystem::path sourceRoot() {
 #endif
 }
 
+using Bytes = std::vector<std::uint8_t>;
+
+void appendSegment(Bytes& out, std::uint8_t marker, const Bytes& payload) {
+  const auto length = static_cast<std::uint16_t>(payload.size() + 2);
+  out.insert(out.end(), {0xFF, marker, static_cast<std::uint8_t>(length >> 8),
+                         static_cast<std::uint8_t>(length & 0xFF)});
+  out.insert(out.end(), payload.begin(), payload.end());
+}
+
+Bytes iccChunk(int sequence, int total, const Bytes& data) {
+  const std::string signature = "ICC_PROFILE";
+  Bytes payload(signature.begin(), signature.end());
+  payload.push_back(0);
+  payload.push_back(static_cast<std::uint8_t>(sequence));
+  payload.push_back(static_cast<std::uint8_t>(total));
+  payload.insert(payload.end(), data.begin(), data.end());
+  return payload;
+}
+
+// Little-endian EXIF block: IFD0 {Orientation=6, ExifIFD}, ExifIFD
+// {DateTimeOriginal="2024:05:01 12:30:00"}.
+Bytes exifPayload() {
+  Bytes tiff{'I', 'I', 42, 0, 8, 0, 0, 0};
+  auto u16 = [&](std::uint16_t v) {
+    tiff.push_back(static_cast<std::uint8_t>(v & 0xFF));
+    tiff.push_back(static_cast<std::uint8_t>(v >> 8));
+  };
+  auto u32 = [&](std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+      tiff.push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFF));
+    }
+  };
+  // IFD0 at 8: 2 entries -> 2 + 24 + 4 = 30 bytes, Exif IFD at 38.
+  u16(2);
+  u16(0x0112); u16(3); u32(1); u16(6); u16(0);
+  u16(0x8769); u16(4); u32(1); u32(38);
+  u32(0);
+  // Exif IFD at 38: 1 entry -> 2 + 12 + 4 = 18 bytes, string at 56.
+  u16(1);
+  u16(0x9003); u16(2); u32(20); u32(56);
+  u32(0);
+  const std::string stamp = "2024:05:01 12:30:00";
+  tiff.insert(tiff.end(), stamp.begin(), stamp.end());
+  tiff.push_back(0);
+
+  Bytes payload{'E', 'x', 'i', 'f', 0, 0};
+  payload.insert(payload.end(), tiff.begin(), tiff.end());
+  return payload;
+}
+
+Bytes syntheticJpeg(const Bytes& profile) {
+  Bytes jpeg{0xFF, 0xD8};
+  appendSegment(jpeg, 0xE1, exifPayload());
+  const auto split = profile.size() / 2;
+  // Chunks deliberately out of order.
+  appendSegment(jpeg, 0xE2,
+                iccChunk(2, 2, Bytes(profile.begin() + split, profile.end())));
+  appendSegment(jpeg, 0xE2,
+                iccChunk(1, 2, Bytes(profile.begin(), profile.begin() + split)));
+  appendSegment(jpeg, 0xC0, {8, 0x0B, 0xB8, 0x0F, 0xA0, 3});  // 3000 x 4000
+  appendSegment(jpeg, 0xDA, {1, 2, 3});
+  jpeg.insert(jpeg.end(), {0x12, 0x34, 0xFF, 0xD9});
+  return jpeg;
+}
+
+struct IfdField {
+  std::uint16_t tag;
+  std::uint16_t type;
+  std::uint32_t count;
+  std::uint32_t value;
+};
+
+// Minimal little-endian TIFF: header, one IFD at offset 8, then `tail`
+// appended at the offset returned by tailOffset().
+Bytes tiffContainer(const std::vector<IfdField>& fields, const Bytes& tail) {
+  Bytes out{'I', 'I', 42, 0, 8, 0, 0, 0};
+  auto put = [&](std::uint32_t v, int width) {
+    for (int i = 0; i < width; ++i) {
+      out.push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFF));
+    }
+  };
+  put(static_cast<std::uint32_t>(fields.size()), 2);
+  for (const auto& field : fields) {
+    put(field.tag, 2);
+    put(field.type, 2);
+    put(field.count, 4);
+    put(field.value, 4);
+  }
+  put(0, 4);
+  out.insert(out.end(), tail.begin(), tail.end());
+  return out;
+}
+
+std::uint32_t tailOffset(std::size_t field_count) {
+  return static_cast<std::uint32_t>(8 + 2 + field_count * 12 + 4);
+}
+
+std::filesystem::path writeTemp(const std::string& name, const Bytes& bytes) {
+  const auto path =
+      std::filesystem::temp_directory_path() /
+      (std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+       "_" + name);
+  std::ofstream stream(path, std::ios::binary);
+  stream.write(reinterpret_cast<const char*>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+  return path;
+}
+
 }  // namespace
 
+TEST(IccProfileExtractorTests, ReadsIccTagFromTiffRaw) {
+  const Bytes profile(200, 0x42);
+  const auto raw = tiffContainer(
+      {{0x0112, 3, 1, 8},
+       {0x8773, 7, static_cast<std::uint32_t>(profile.size()), tailOffset(2)}},
+      profile);
+  const auto path = writeTemp("tag.DNG", raw);
+
+  EXPECT_EQ(cataloger::services::preview::icc::ExtractEmbeddedProfile(path), profile);
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+}
+
+TEST(IccProfileExtractorTests, FallsBackToEmbeddedPreviewApp2) {
+  const Bytes profile{'n', 'e', 'f', '-', 'i', 'c', 'c'};
+  const auto preview = syntheticJpeg(profile);
+  const auto raw = tiffContainer(
+      {{0x0201, 4, 1, tailOffset(2)},
+       {0x0202, 4, 1, static_cast<std::uint32_t>(preview.size())}},
+      preview);
+  const auto path = writeTemp("preview.NEF", raw);
+
+  EXPECT_EQ(cataloger::services::preview::icc::ExtractEmbeddedProfile(path), profile);
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+}
+
+TEST(IccProfileExtractorTests, BatchExtractionMatchesPerFileExtraction) {
+  namespace preview = cataloger::services::preview;
+  const Bytes profile{'b', 'a', 't', 'c', 'h'};
+  const auto jpeg = syntheticJpeg(profile);
+  const auto raw = tiffContainer(
+      {{0x0201, 4, 1, tailOffset(2)},
+       {0x0202, 4, 1, static_cast<std::uint32_t>(jpeg.size())}},
+      jpeg);
+
+  std::vector<preview::PreviewDescriptor> descriptors(3);
+  descriptors[0].absolute_path = writeTemp("batch.jpg", jpeg);
+  descriptors[1].absolute_path = writeTemp("batch.NEF", raw);
+  descriptors[2].absolute_path = descriptors[0].absolute_path.string() + ".missing";
+  for (std::size_t i = 0; i < descriptors.size(); ++i) {
+    descriptors[i].relative_path = "f" + std::to_string(i);
+    descriptors[i].file_size = i == 1 ? raw.size() : jpeg.size();
+  }
+
+  const preview::PreviewExtractor extractor;
+  const auto reader = cataloger::platform::io::CreateBatchReader(8);
+  std::vector<preview::ContainerMetadata> metadata;
+  const auto batch = extractor.extractBatch(*reader, descriptors, metadata);
+  ASSERT_EQ(batch.size(), descriptors.size());
+  ASSERT_EQ(metadata.size(), descriptors.size());
+
+  for (std::size_t i = 0; i < descriptors.size(); ++i) {
+    preview::ContainerMetadata single_metadata;
+    const auto single = extractor.extract(descriptors[i], &single_metadata);
+    EXPECT_EQ(batch[i].width, single.width) << i;
+    EXPECT_EQ(batch[i].height, single.height) << i;
+    EXPECT_EQ(batch[i].orientation, single.orientation) << i;
+    EXPECT_EQ(batch[i].capture_ts, single.capture_ts) << i;
+    EXPECT_TRUE(std::equal(batch[i].pixels.begin(), batch[i].pixels.end(),
+                           single.pixels.begin(), single.pixels.end()))
+        << i;
+    EXPECT_EQ(metadata[i].icc_scanned, single_metadata.icc_scanned) << i;
+    EXPECT_EQ(metadata[i].icc_profile, single_metadata.icc_profile) << i;
+    EXPECT_EQ(metadata[i].preview_offset, single_metadata.preview_offset) << i;
+  }
+  EXPECT_EQ(metadata[0].icc_profile, profile);
+  EXPECT_EQ(metadata[1].icc_profile, profile);
+  EXPECT_EQ(batch[1].orientation, 6);
+
+  std::error_code ec;
+  std::filesystem::remove(descriptors[0].absolute_path, ec);
+  std::filesystem::remove(descriptors[1].absolute_path, ec);
+}
+
+TEST(IccProfileExtractorTests, IndexesSegmentsInOnePass) {
+  const Bytes profile{'a', 'b', 'c', 'd', 'e', 'f', 'g'};
+  const auto jpeg = syntheticJpeg(profile);
+  namespace jpeg_ns = cataloger::services::preview::jpeg;
+
+  const auto index = jpeg_ns::IndexSegments(jpeg);
+  ASSERT_TRUE(index.valid);
+  EXPECT_FALSE(index.truncated);
+  EXPECT_EQ(index.app1.size(), 1u);
+  EXPECT_EQ(index.app2.size(), 2u);
+  ASSERT_TRUE(index.sos_offset.has_value());
+  EXPECT_EQ(index.width, 4000);
+  EXPECT_EQ(index.height, 3000);
+
+  EXPECT_EQ(jpeg_ns::AssembleIccProfile(jpeg, index), profile);
+  const auto exif = jpeg_ns::ParseExif(jpeg, index);
+  EXPECT_EQ(exif.orientation, 6);
+  ASSERT_TRUE(exif.capture_ts.has_value());
+  EXPECT_EQ(*exif.capture_ts, 1714566600);
+
+  const auto partial = jpeg_ns::IndexSegments(
+      std::span<const std::uint8_t>(jpeg.data(), 40));
+  EXPECT_TRUE(partial.truncated);
+  EXPECT_GT(partial.required_bytes, 40u);
+}
+
+TEST(IccProfileExtractorTests, ExtractsProfileFromSyntheticJpeg) {
+  const Bytes profile(3000, 0x5A);
+  const auto path =
+      std::filesystem::temp_directory_path() /
+      ("icc_synthetic_" +
+       std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+       ".jpg");
+  {
+    const auto jpeg = syntheticJpeg(profile);
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(jpeg.data()),
+                 static_cast<std::streamsize>(jpeg.size()));
+  }
+
+  EXPECT_EQ(cataloger::services::preview::icc::ExtractEmbeddedProfile(path), profile);
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+}
+
 TEST(IccProfileExtractorTests, ExtractsProfileFromJpegWhenPresent) {
   const auto root = sourceRoot();
   const auto path = root / "test_images" /
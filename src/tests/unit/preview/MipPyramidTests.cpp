@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "services/preview/MipPyramid.h"
+#include "services/preview/PreviewTypes.h"
+
+namespace {
+
+using cataloger::services::preview::DownsampleBox;
+using cataloger::services::preview::DownsampleLanczos3;
+using cataloger::services::preview::kTileSize;
+using cataloger::services::preview::MipFilter;
+using cataloger::services::preview::MipPyramid;
+using cataloger::services::preview::PixelBuffer;
+using cataloger::services::preview::PixelLayout;
+using cataloger::services::preview::PreviewImage;
+using cataloger::services::preview::TileGrid;
+using cataloger::services::preview::TileId;
+using cataloger::services::preview::Viewport;
+
+std::vector<std::uint8_t> noiseRgba(int width, int height) {
+  std::vector<std::uint8_t> texels(static_cast<std::size_t>(width) * height * 4);
+  std::uint32_t state = 12345;
+  for (auto& value : texels) {
+    state = state * 1664525u + 1013904223u;
+    value = static_cast<std::uint8_t>(state >> 24);
+  }
+  return texels;
+}
+
+// Straight from the definition, for comparison with the SIMD rows.
+std::vector<std::uint8_t> referenceBox(const std::vector<std::uint8_t>& src,
+                                       int width,
+                                       int height) {
+  const int out_width = (width + 1) / 2;
+  const int out_height = (height + 1) / 2;
+  std::vector<std::uint8_t> out(static_cast<std::size_t>(out_width) * out_height * 4);
+  const auto at = [&](int x, int y, int c) {
+    x = std::min(x, width - 1);
+    y = std::min(y, height - 1);
+    return static_cast<unsigned>(src[(static_cast<std::size_t>(y) * width + x) * 4 + c]);
+  };
+  for (int y = 0; y < out_height; ++y) {
+    for (int x = 0; x < out_width; ++x) {
+      for (int c = 0; c < 4; ++c) {
+        const unsigned sum = at(2 * x, 2 * y, c) + at(2 * x + 1, 2 * y, c) +
+                             at(2 * x, 2 * y + 1, c) + at(2 * x + 1, 2 * y + 1, c);
+        out[(static_cast<std::size_t>(y) * out_width + x) * 4 + c] =
+            static_cast<std::uint8_t>((sum + 2) / 4);
+      }
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(MipPyramidTests, BoxDownsampleMatchesReferenceOnOddSizes) {
+  for (const auto& [width, height] : {std::pair{64, 32}, std::pair{37, 19}, std::pair{1, 5},
+                                      std::pair{9, 1}}) {
+    const auto src = noiseRgba(width, height);
+    std::vector<std::uint8_t> out(static_cast<std::size_t>((width + 1) / 2) *
+                                  ((height + 1) / 2) * 4);
+    DownsampleBox(src.data(), width, height, out.data());
+    EXPECT_EQ(out, referenceBox(src, width, height)) << width << "x" << height;
+  }
+}
+
+TEST(MipPyramidTests, LanczosKeepsFlatImagesFlat) {
+  const int width = 41;
+  const int height = 23;
+  std::vector<std::uint8_t> src(static_cast<std::size_t>(width) * height * 4);
+  for (std::size_t i = 0; i < src.size(); i += 4) {
+    src[i] = 200;
+    src[i + 1] = 100;
+    src[i + 2] = 17;
+    src[i + 3] = 255;
+  }
+  std::vector<std::uint8_t> out(static_cast<std::size_t>(21) * 12 * 4);
+  DownsampleLanczos3(src.data(), width, height, out.data());
+  for (std::size_t i = 0; i < out.size(); i += 4) {
+    ASSERT_EQ(out[i], 200);
+    ASSERT_EQ(out[i + 1], 100);
+    ASSERT_EQ(out[i + 2], 17);
+    ASSERT_EQ(out[i + 3], 255);
+  }
+}
+
+TEST(MipPyramidTests, BuildsLevelsDownToOneTile) {
+  PreviewImage image;
+  image.cache_key = "IMG_0001.JPG#1";
+  image.width = 1000;
+  image.height = 300;
+  std::vector<std::uint8_t> rgb(static_cast<std::size_t>(image.width) * image.height * 3, 40);
+  image.pixels = PixelBuffer(rgb.data(), rgb.size());
+
+  for (const auto filter : {MipFilter::kBox, MipFilter::kLanczos3}) {
+    const auto pyramid = MipPyramid::Build(image, filter);
+    const auto& grid = pyramid.grid();
+    ASSERT_EQ(grid.levelCount(), 3);  // 1000, 500, 250
+    EXPECT_EQ(grid.levelWidth(2), 250);
+    EXPECT_EQ(grid.levelHeight(2), 75);
+
+    const auto level = pyramid.levelImage(image.cache_key, 1);
+    EXPECT_EQ(level.layout, PixelLayout::kRgba8);
+    EXPECT_EQ(level.pixels.size(), 500u * 150 * 4);
+    EXPECT_EQ(level.pixels[0], 40);
+    EXPECT_EQ(level.pixels[3], 255);
+
+    // Last column of level 0: 1000 = 3 * 256 + 232.
+    const auto tile = pyramid.tileImage(image.cache_key, TileId{0, 3, 1});
+    EXPECT_EQ(tile.width, 232);
+    EXPECT_EQ(tile.height, 300 - kTileSize);
+    EXPECT_EQ(tile.pixels.size(), 232u * 44 * 4);
+    EXPECT_NE(tile.cache_key, image.cache_key);
+  }
+}
+
+TEST(MipPyramidTests, FitViewNeedsASixteenthOfTheBytes) {
+  // A 45 MP frame shown in a 2048-wide window.
+  const TileGrid grid(8192, 5464);
+  const Viewport fit{0.0, 0.0, 8192.0, 5464.0, 2048.0 / 8192.0};
+
+  const auto tiles = grid.visibleTiles(fit);
+  ASSERT_FALSE(tiles.empty());
+  EXPECT_EQ(tiles.front().level, 2);
+  std::size_t fit_bytes = 0;
+  for (const auto& tile : tiles) {
+    fit_bytes += grid.tileBytes(tile);
+  }
+  EXPECT_EQ(fit_bytes, grid.levelBytes(2));
+  EXPECT_LE(fit_bytes * 16, grid.levelBytes(0));
+
+  // Zoomed to 1:1, only the tiles under the window are needed.
+  const Viewport zoomed{4000.0, 2000.0, 2048.0, 1280.0, 1.0};
+  const auto visible = grid.visibleTiles(zoomed);
+  EXPECT_EQ(visible.front().level, 0);
+  EXPECT_LE(visible.size(), 10u * 7u);
+  EXPECT_TRUE(grid.visibleTiles(Viewport{9000.0, 0.0, 100.0, 100.0, 1.0}).empty());
+}
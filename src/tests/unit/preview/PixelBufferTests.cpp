@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "services/preview/PixelBuffer.h"
+
+namespace {
+
+using cataloger::services::preview::PixelBuffer;
+using cataloger::services::preview::PixelBufferPool;
+
+}  // namespace
+
+TEST(PixelBufferTests, CopiesShareBytesUntilWritten) {
+  const std::vector<std::uint8_t> source{1, 2, 3, 4};
+  PixelBuffer original(source.data(), source.size());
+  PixelBuffer copy = original;
+  EXPECT_TRUE(original.shared());
+  EXPECT_EQ(original.data(), copy.data());
+
+  copy.mutableData()[0] = 9;
+  EXPECT_FALSE(original.shared());
+  EXPECT_NE(original.data(), copy.data());
+  EXPECT_EQ(original[0], 1);
+  EXPECT_EQ(copy[0], 9);
+  EXPECT_EQ(copy[3], 4);
+}
+
+TEST(PixelBufferTests, ResizeKeepsPrefixAndRoundsToSizeClass) {
+  PixelBuffer buffer(3);
+  buffer.mutableData()[0] = 7;
+  buffer.resize(5000);
+  EXPECT_EQ(buffer.size(), 5000u);
+  EXPECT_EQ(buffer[0], 7);
+  EXPECT_EQ(buffer.capacity(), PixelBufferPool::CapacityFor(5000));
+  EXPECT_GE(buffer.capacity(), 5000u);
+  EXPECT_LE(buffer.capacity(), 5000u + 5000u / 4);
+}
+
+TEST(PixelBufferTests, SteadyStateReusesBlocksWithoutHeapAllocations) {
+  auto& pool = PixelBufferPool::Shared();
+  constexpr std::size_t kPreviewBytes = 256 * 1024;
+
+  // Warm up: one decode buffer and one corrected buffer in flight.
+  for (int i = 0; i < 4; ++i) {
+    PixelBuffer decoded(kPreviewBytes);
+    PixelBuffer corrected(kPreviewBytes);
+  }
+
+  const auto before = pool.stats();
+  for (int i = 0; i < 1000; ++i) {
+    PixelBuffer decoded(kPreviewBytes);
+    PixelBuffer corrected(kPreviewBytes);
+    PixelBuffer cached = corrected;
+  }
+  const auto after = pool.stats();
+  EXPECT_EQ(after.heap_allocations, before.heap_allocations);
+  EXPECT_EQ(after.reused_blocks - before.reused_blocks, 2000u);
+}
+
+TEST(PixelBufferTests, BlocksFreedOnWorkerThreadsReturnToGlobalPool) {
+  auto& pool = PixelBufferPool::Shared();
+  pool.trim();
+  std::thread worker([] {
+    PixelBuffer scratch(64 * 1024);
+  });
+  worker.join();
+  EXPECT_GE(pool.stats().retained_bytes, 64u * 1024);
+
+  const auto before = pool.stats();
+  PixelBuffer reused(64 * 1024);
+  EXPECT_EQ(pool.stats().heap_allocations, before.heap_allocations);
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "services/preview/NavigationTracker.h"
+#include "services/preview/PrefetchController.h"
+
+namespace {
+
+using cataloger::services::preview::NavigationTracker;
+using cataloger::services::preview::PrefetchController;
+using cataloger::services::preview::PrefetchPlan;
+
+struct TraceStep {
+  std::int64_t at_ms;
+  std::int64_t index;
+};
+
+// A reviewing session: hold the arrow key, slow down to inspect, reverse,
+// then jump elsewhere in the folder and continue.
+std::vector<TraceStep> reviewTrace() {
+  std::vector<TraceStep> trace;
+  std::int64_t t = 0;
+  std::int64_t index = 100;
+  auto run = [&](int count, int step, std::int64_t interval_ms) {
+    for (int i = 0; i < count; ++i) {
+      index += step;
+      t += interval_ms;
+      trace.push_back({t, index});
+    }
+  };
+  run(60, +1, 100);   // arrow held, 10 images/s
+  run(20, +1, 2000);  // slow review
+  run(30, -1, 125);   // back through the run, 8 images/s
+  index = 600;
+  trace.push_back({t += 1000, index});
+  run(40, +1, 250);   // brisk forward, 4 images/s
+  run(10, +1, 1500);  // slow again
+  return trace;
+}
+
+struct SimulationResult {
+  std::size_t misses{0};
+  std::size_t extractions{0};
+};
+
+// Extraction pipeline with `workers` parallel slots of `latency_ms` each and
+// an LRU-ish cache of `capacity` previews (evicts the farthest from the
+// current position).
+SimulationResult simulate(const std::vector<TraceStep>& trace,
+                          std::size_t workers,
+                          std::int64_t latency_ms,
+                          std::size_t capacity,
+                          const std::function<PrefetchPlan(const TraceStep&, bool)>& planner) {
+  SimulationResult result;
+  std::map<std::int64_t, std::int64_t> ready_at;  // index -> completion time
+  std::vector<std::int64_t> worker_free(workers, 0);
+
+  auto extract = [&](std::int64_t index, std::int64_t now) {
+    if (index < 0 || ready_at.contains(index)) {
+      return;
+    }
+    auto slot = std::min_element(worker_free.begin(), worker_free.end());
+    const auto start = std::max(*slot, now);
+    *slot = start + latency_ms;
+    ready_at[index] = *slot;
+    ++result.extractions;
+  };
+
+  for (const auto& step : trace) {
+    const auto it = ready_at.find(step.index);
+    const bool hit = it != ready_at.end() && it->second <= step.at_ms;
+    if (!hit) {
+      ++result.misses;
+    }
+    extract(step.index, step.at_ms);
+
+    const auto plan = planner(step, hit);
+    const auto reach = std::max(plan.ahead, plan.behind);
+    for (std::size_t d = 1; d <= reach; ++d) {
+      const auto offset = static_cast<std::int64_t>(d);
+      if (d <= plan.ahead) {
+        extract(step.index + offset * plan.direction, step.at_ms);
+      }
+      if (d <= plan.behind) {
+        extract(step.index - offset * plan.direction, step.at_ms);
+      }
+    }
+
+    while (ready_at.size() > capacity) {
+      auto farthest = std::max_element(
+          ready_at.begin(), ready_at.end(), [&](const auto& lhs, const auto& rhs) {
+            return std::abs(lhs.first - step.index) < std::abs(rhs.first - step.index);
+          });
+      ready_at.erase(farthest);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(PrefetchControllerTests, TraceHasFewerMissesWithoutExtraWork) {
+  constexpr std::size_t kWorkers = 8;
+  constexpr std::int64_t kLatencyMs = 400;  // network volume
+  constexpr std::size_t kCapacity = 64;
+  const auto trace = reviewTrace();
+
+  const auto fixed = simulate(trace, kWorkers, kLatencyMs, kCapacity,
+                              [](const TraceStep&, bool) {
+                                return PrefetchPlan{1, 2, 2};
+                              });
+
+  NavigationTracker tracker;
+  PrefetchController controller(2);
+  const auto epoch = NavigationTracker::Clock::now();
+  const auto adaptive = simulate(
+      trace, kWorkers, kLatencyMs, kCapacity, [&](const TraceStep& step, bool hit) {
+        const auto navigation = tracker.record(
+            1, static_cast<std::size_t>(step.index),
+            epoch + std::chrono::milliseconds(step.at_ms));
+        return controller.plan(navigation, hit, kLatencyMs, kCapacity);
+      });
+
+  EXPECT_LT(adaptive.misses * 2, fixed.misses);
+  EXPECT_LE(adaptive.extractions, fixed.extractions);
+}
+
+TEST(PrefetchControllerTests, SymmetricBaseWithoutDirection) {
+  PrefetchController controller(3);
+  NavigationTracker::State idle;
+  const auto plan = controller.plan(idle, true, 100.0, 64);
+  EXPECT_EQ(plan.ahead, 3u);
+  EXPECT_EQ(plan.behind, 3u);
+}
+
+TEST(PrefetchControllerTests, RespectsCacheBudgetAndDisable) {
+  PrefetchController controller(2);
+  NavigationTracker::State fast;
+  fast.direction = 1;
+  fast.velocity = 50.0;
+  const auto plan = controller.plan(fast, false, 1000.0, 16);
+  EXPECT_EQ(plan.direction, 1);
+  EXPECT_EQ(plan.behind, 1u);
+  EXPECT_EQ(plan.ahead + plan.behind, 8u);
+
+  controller.setBaseWindow(0);
+  const auto disabled = controller.plan(fast, false, 1000.0, 16);
+  EXPECT_EQ(disabled.ahead, 0u);
+  EXPECT_EQ(disabled.behind, 0u);
+}
@@ -1,20 +1,26 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
 #include "platform/gpu/GpuBridge.h"
+#include "platform/gpu/SoftwareBridge.h"
 #include "services/catalog/CatalogService.h"
 #include "services/preview/PreviewService.h"
 #include "services/preview/PreviewTypes.h"
+#include "services/tasks/Task.h"
 #include <lcms2.h>
+#include <sqlite3.h>
 
 namespace {
 
@@ -132,6 +138,59 @@ TEST_F(PreviewServiceTest, RequestPreviewPreloadsNeighbors) {
               relative_paths.contains(relative_files_[2]));
 }
 
+TEST_F(PreviewServiceTest, AsyncApiComposesScanQueryAndRequest) {
+  using cataloger::services::preview::PreviewImage;
+  using cataloger::services::tasks::Lane;
+  using cataloger::services::tasks::SchedulerExecutor;
+  using cataloger::services::tasks::SyncWait;
+  using cataloger::services::tasks::Task;
+  using cataloger::services::tasks::TaskScheduler;
+
+  TaskScheduler scheduler;
+  SchedulerExecutor executor(scheduler, Lane::kInteractive);
+  const auto caller = std::this_thread::get_id();
+  std::thread::id query_thread;
+  const auto flow = [&]() -> Task<std::optional<PreviewImage>> {
+    co_await preview_.warmRootAsync(root_id_, root_path_);
+    const auto files = co_await catalog_.listFilesAsync(root_id_, executor);
+    query_thread = std::this_thread::get_id();
+    co_return co_await preview_.requestPreviewAsync(root_id_, files.front().relative_path);
+  };
+
+  const auto image = SyncWait(flow());
+  ASSERT_TRUE(image.has_value());
+  EXPECT_TRUE(image->color_managed);
+  EXPECT_NE(query_thread, caller);
+
+  const auto missing = SyncWait(preview_.requestPreviewAsync(root_id_, "NOPE.JPG"));
+  EXPECT_FALSE(missing.has_value());
+  preview_.waitUntilIdle();
+}
+
+TEST_F(PreviewServiceTest, ExplicitWorkerCountPinsBothStages) {
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+
+  const auto stats = preview_.stageStats();
+  EXPECT_EQ(stats.io_workers, 1u);
+  EXPECT_EQ(stats.io_limit, 1u);
+  EXPECT_EQ(stats.cpu_workers, 1u);
+  EXPECT_EQ(stats.cpu_limit, 1u);
+  EXPECT_EQ(stats.cpu_queue_capacity, 2u);
+}
+
+TEST(PreviewServiceStageTests, AutoTunedStagesStartWithinBounds) {
+  cataloger::services::preview::PreviewService preview;
+  const auto stats = preview.stageStats();
+  EXPECT_EQ(stats.io_workers,
+            cataloger::services::preview::PreviewService::kMaxIoWorkers);
+  EXPECT_GE(stats.io_limit, 1u);
+  EXPECT_LE(stats.io_limit, stats.io_workers);
+  EXPECT_GE(stats.cpu_workers, 2u);
+  EXPECT_EQ(stats.cpu_limit, stats.cpu_workers);
+  EXPECT_EQ(stats.cpu_queue_capacity, stats.cpu_workers * 2);
+}
+
 class FailingBridge : public cataloger::platform::gpu::GpuBridge {
 public:
   bool upload(const cataloger::services::preview::PreviewImage&,
@@ -167,6 +226,187 @@ TEST_F(PreviewServiceTest, EmitsErrorWhenGpuUploadFails) {
   EXPECT_EQ(it->backend, "Stub");
 }
 
+class SlowBridge : public cataloger::platform::gpu::GpuBridge {
+public:
+  bool upload(const cataloger::services::preview::PreviewImage&, std::string&) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    return true;
+  }
+
+  cataloger::platform::gpu::Backend backend() const noexcept override {
+    return cataloger::platform::gpu::Backend::kSoftware;
+  }
+};
+
+TEST_F(PreviewServiceTest, GpuLatencyDoesNotHoldCpuWorkers) {
+  preview_.setGpuBridgeForTesting(std::make_unique<SlowBridge>());
+  std::vector<cataloger::services::preview::CacheEvent> events;
+  preview_.setEventSink(
+      [&](const cataloger::services::preview::CacheEvent& event) {
+        events.push_back(event);
+      });
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+
+  const auto uploaded = std::count_if(events.begin(), events.end(), [](const auto& event) {
+    return !event.hit && !event.error && event.gpu_upload_ms > 0.0;
+  });
+  EXPECT_EQ(static_cast<std::size_t>(uploaded), relative_files_.size());
+  const auto stats = preview_.stageStats();
+  EXPECT_LT(stats.cpu_latency_ms, 150.0);
+  EXPECT_GE(stats.upload_batches, 1u);
+}
+
+TEST_F(PreviewServiceTest, GpuEvictionWritesCachedStateBack) {
+  // One 2048² page holds two of these previews; the rest get evicted.
+  cataloger::platform::gpu::SoftwareBridge::Options options;
+  options.budget_bytes = 2048u * 2048 * 4;
+  options.spare_pages = 0;
+  preview_.setGpuBridgeForTesting(
+      std::make_unique<cataloger::platform::gpu::SoftwareBridge>(options));
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+
+  const auto residency = preview_.gpuResidency();
+  EXPECT_GT(residency.evictions, 0u);
+  EXPECT_LE(residency.allocated_bytes, options.budget_bytes);
+
+  auto countState = [&](cataloger::services::preview::PreviewState state) {
+    const auto files = catalog_.listFiles(root_id_);
+    return std::count_if(files.begin(), files.end(), [&](const auto& file) {
+      return file.preview_state == static_cast<int>(state);
+    });
+  };
+  using cataloger::services::preview::PreviewState;
+  EXPECT_EQ(static_cast<std::size_t>(countState(PreviewState::kGpuResident)),
+            residency.resident_textures);
+  EXPECT_GT(countState(PreviewState::kCached), 0);
+
+  std::string resident_key;
+  for (const auto& file : relative_files_) {
+    const auto key = file + "#" + std::to_string(root_id_);
+    if (preview_.isGpuResident(key)) {
+      resident_key = key;
+    }
+  }
+  ASSERT_FALSE(resident_key.empty());
+  EXPECT_TRUE(preview_.evictTexture(resident_key));
+  EXPECT_FALSE(preview_.isGpuResident(resident_key));
+  EXPECT_FALSE(preview_.evictTexture(resident_key));
+  EXPECT_EQ(static_cast<std::size_t>(countState(PreviewState::kGpuResident)),
+            residency.resident_textures - 1);
+}
+
+TEST_F(PreviewServiceTest, AStageThatThrowsStillSettlesTheQueue) {
+  // Without a GPU the CPU stage records residency itself; make every such
+  // catalog write fail, as a locked database would.
+  sqlite3* db = nullptr;
+  ASSERT_EQ(sqlite3_open(db_path_.string().c_str(), &db), SQLITE_OK);
+  ASSERT_EQ(sqlite3_exec(db,
+                         "CREATE TRIGGER refuse_preview_state BEFORE UPDATE OF preview_state "
+                         "ON files BEGIN SELECT RAISE(ABORT, 'catalog is locked'); END;",
+                         nullptr, nullptr, nullptr),
+            SQLITE_OK);
+  sqlite3_close(db);
+  preview_.setGpuBridgeForTesting(nullptr);
+
+  std::atomic<std::size_t> errors{0};
+  std::atomic<std::size_t> thrown{0};
+  preview_.setEventSink([&](const cataloger::services::preview::CacheEvent& event) {
+    if (event.error) {
+      ++errors;
+      thrown += event.error_message.find("catalog is locked") != std::string::npos ? 1 : 0;
+    }
+  });
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();  // hung while the stage's counters stayed raised
+  EXPECT_EQ(errors.load(), relative_files_.size());
+  EXPECT_EQ(thrown.load(), relative_files_.size());
+}
+
+TEST_F(PreviewServiceTest, IccDiscoveriesThatFailToStoreAreRetried) {
+  sqlite3* db = nullptr;
+  ASSERT_EQ(sqlite3_open(db_path_.string().c_str(), &db), SQLITE_OK);
+  const auto exec = [&](const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
+  };
+  ASSERT_EQ(exec("CREATE TRIGGER refuse_icc BEFORE INSERT ON icc_discovery "
+                 "BEGIN SELECT RAISE(ABORT, 'catalog is locked'); END;"),
+            SQLITE_OK);
+
+  std::atomic<std::size_t> errors{0};
+  preview_.setEventSink([&](const cataloger::services::preview::CacheEvent& event) {
+    if (event.error && event.error_message.find("catalog is locked") != std::string::npos) {
+      ++errors;
+    }
+  });
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+  // The previews do not depend on the write.
+  EXPECT_EQ(errors.load(), 0u);
+  for (const auto& file : relative_files_) {
+    EXPECT_TRUE(preview_.cachedPreview(file + "#" + std::to_string(root_id_)).has_value())
+        << file;
+  }
+  EXPECT_TRUE(catalog_.loadIccDiscoveries().empty());
+
+  // Once the catalog takes writes again, the next batch stores them.
+  ASSERT_EQ(exec("DROP TRIGGER refuse_icc;"), SQLITE_OK);
+  sqlite3_close(db);
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+  EXPECT_EQ(catalog_.loadIccDiscoveries().size(), relative_files_.size());
+}
+
+TEST_F(PreviewServiceTest, InvalidatedPreviewsLeaveTheCaches) {
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+  const auto key = "IMG_0002.JPG#" + std::to_string(root_id_);
+  ASSERT_TRUE(preview_.cachedPreview(key).has_value());
+
+  EXPECT_EQ(preview_.invalidatePreviews(root_id_, {"IMG_0002.JPG", "IMG_0404.JPG"}), 1u);
+  EXPECT_FALSE(preview_.cachedPreview(key).has_value());
+  EXPECT_FALSE(preview_.isGpuResident(key));
+  EXPECT_TRUE(preview_.cachedPreview("IMG_0001.JPG#" + std::to_string(root_id_)).has_value());
+}
+
+TEST_F(PreviewServiceTest, LargePreviewsUploadFitLevelThenTiles) {
+  auto bridge = std::make_unique<cataloger::platform::gpu::SoftwareBridge>();
+  auto* software = bridge.get();
+  preview_.setGpuBridgeForTesting(std::move(bridge));
+  preview_.setDisplaySize(384, 300);
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+
+  const auto key = relative_files_.front() + "#" + std::to_string(root_id_);
+  const auto cached = preview_.cachedPreview(key);
+  ASSERT_TRUE(cached.has_value());
+  ASSERT_GT(cached->width, 384);
+  const cataloger::services::preview::TileGrid grid(cached->width, cached->height);
+  const double fit = std::min(384.0 / cached->width, 300.0 / cached->height);
+  const auto region = software->lookup(key);
+  ASSERT_TRUE(region.has_value());
+  EXPECT_EQ(region->width, grid.levelWidth(grid.levelForScale(fit)));
+
+  const cataloger::services::preview::Viewport view{0.0, 0.0, 384.0, 300.0, 1.0};
+  const auto first = preview_.presentViewport(key, view);
+  EXPECT_EQ(first.level, 0);
+  ASSERT_EQ(first.tiles.size(), 4u);
+  EXPECT_EQ(first.fences.size(), first.tiles.size());
+  EXPECT_EQ(first.upload_bytes, 4u * 256 * 256 * 4);
+  for (const auto& fence : first.fences) {
+    EXPECT_TRUE(fence.get().ok);
+  }
+  for (const auto& tile : first.tiles) {
+    EXPECT_TRUE(preview_.isGpuResident(cataloger::services::preview::TileKey(key, tile)));
+  }
+
+  const auto second = preview_.presentViewport(key, view);
+  EXPECT_EQ(second.tiles.size(), first.tiles.size());
+  EXPECT_EQ(second.upload_bytes, 0u);
+  EXPECT_TRUE(second.fences.empty());
+}
+
 TEST_F(PreviewServiceTest, AppliesExternalProfileWhenPresent) {
   const auto icc_path = (root_path_ / relative_files_.front()).replace_extension(".icc");
   writeICCProfile(icc_path);
@@ -179,3 +419,164 @@ TEST_F(PreviewServiceTest, AppliesExternalProfileWhenPresent) {
   ASSERT_TRUE(cached.has_value());
   EXPECT_NE(cached->color_profile.find("sRGB"), std::string::npos);
 }
+
+TEST_F(PreviewServiceTest, PersistsIccDiscoveryAndDeduplicatesProfiles) {
+  writeICCProfile((root_path_ / relative_files_[0]).replace_extension(".icc"));
+  writeICCProfile((root_path_ / relative_files_[2]).replace_extension(".ICM"));
+
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+
+  const auto discoveries = catalog_.loadIccDiscoveries();
+  std::size_t sidecars = 0;
+  std::unordered_set<std::uint64_t> hashes;
+  for (const auto& record : discoveries) {
+    if (record.source ==
+        static_cast<int>(cataloger::services::preview::IccSource::kSidecar)) {
+      ++sidecars;
+      ASSERT_TRUE(record.profile_hash.has_value());
+      hashes.insert(*record.profile_hash);
+    }
+  }
+  EXPECT_GE(discoveries.size(), relative_files_.size());
+  EXPECT_GE(sidecars, 2u);
+  ASSERT_EQ(hashes.size(), 1u);
+  EXPECT_TRUE(catalog_.loadIccProfile(*hashes.begin()).has_value());
+
+  // Keyed on the full-resolution mtime, not whole seconds.
+  for (const auto& record : discoveries) {
+    const auto mtime = std::filesystem::last_write_time(record.absolute_path);
+    EXPECT_EQ(record.mtime, static_cast<std::int64_t>(mtime.time_since_epoch().count()))
+        << record.absolute_path;
+  }
+}
+
+TEST_F(PreviewServiceTest, ReadAheadFollowsNavigationDirection) {
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+
+  preview_.requestPreview(root_id_, relative_files_[0]);
+  preview_.requestPreview(root_id_, relative_files_[1]);
+  preview_.requestPreview(root_id_, relative_files_[2]);
+  preview_.waitUntilIdle();
+
+  const auto navigation = preview_.navigationState();
+  EXPECT_EQ(navigation.direction, 1);
+  EXPECT_EQ(navigation.index, 2u);
+  // Every remaining file ahead was hinted, each once.
+  EXPECT_GE(preview_.readAheadHintsIssued(), relative_files_.size() - 1);
+  // Decoded neighbors lean the same way.
+  const auto plan = preview_.lastPrefetchPlan();
+  EXPECT_EQ(plan.direction, 1);
+  EXPECT_GT(plan.ahead, plan.behind);
+}
+
+TEST_F(PreviewServiceTest, PublishedFilesJoinTheRootAndDecodeFirst) {
+  using cataloger::services::preview::DirectoryScanner;
+  using cataloger::services::preview::PreviewDescriptor;
+  preview_.warmRoot(root_id_, root_path_);
+  preview_.waitUntilIdle();
+
+  std::vector<std::string> order;
+  preview_.setEventSink(
+      [&](const cataloger::services::preview::CacheEvent& event) {
+        order.push_back(event.relative_path);
+      });
+  // Landed mid-ingest: one sorts between known files, one after them.
+  writeFile(root_path_ / "IMG_0002.CR3", 2048);
+  writeFile(root_path_ / "IMG_0009.JPG", 2048);
+  std::vector<PreviewDescriptor> landed{
+      DirectoryScanner::describe(root_path_, root_path_ / "IMG_0009.JPG"),
+      DirectoryScanner::describe(root_path_, root_path_ / "IMG_0002.CR3")};
+  preview_.publishFiles(root_id_, landed);
+  preview_.waitUntilIdle();
+
+  ASSERT_GE(order.size(), 2u);
+  EXPECT_EQ(order[0], "IMG_0009.JPG");
+  EXPECT_EQ(order[1], "IMG_0002.CR3");
+  EXPECT_TRUE(preview_.cachedPreview("IMG_0009.JPG#" + std::to_string(root_id_)).has_value());
+  // Both are browsable in path order alongside the warmed files.
+  EXPECT_TRUE(preview_.requestPreview(root_id_, "IMG_0002.CR3"));
+  EXPECT_TRUE(preview_.requestPreview(root_id_, "IMG_0009.JPG"));
+  EXPECT_TRUE(preview_.requestPreview(root_id_, relative_files_.back()));
+  preview_.waitUntilIdle();
+}
+
+TEST(PreviewExtractorTests, HeadBytesReplaceTheFirstRead) {
+  using cataloger::services::preview::ContainerMetadata;
+  using cataloger::services::preview::PreviewDescriptor;
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("preview_head_" + uniqueSuffix() + ".JPG");
+  writeFile(path, 4096);
+  PreviewDescriptor on_disk;
+  on_disk.absolute_path = path;
+  on_disk.relative_path = path.filename().string();
+  on_disk.file_size = 4096;
+  auto from_copy = on_disk;
+  from_copy.relative_path += ".copy";
+  from_copy.head = std::make_shared<const std::vector<std::uint8_t>>(4096, 0x5a);
+  auto too_short = on_disk;
+  too_short.relative_path += ".short";
+  too_short.head = std::make_shared<const std::vector<std::uint8_t>>(100, 0x5a);
+
+  const auto reader = cataloger::platform::io::CreateThreadPoolReader(1);
+  std::vector<ContainerMetadata> metadata;
+  const std::vector<PreviewDescriptor> descriptors{on_disk, from_copy, too_short};
+  const auto images = cataloger::services::preview::PreviewExtractor().extractBatch(
+      *reader, descriptors, metadata);
+  ASSERT_EQ(images.size(), 3u);
+  ASSERT_EQ(images[1].pixels.size(), 4096u);
+  EXPECT_EQ(images[0].pixels[0], 'A');
+  EXPECT_EQ(images[1].pixels[0], 0x5a);  // never read from disk
+  EXPECT_EQ(images[2].pixels[0], 'A');   // too short to stand in
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+}
+
+TEST(NavigationTrackerTests, TracksDirectionAndVelocity) {
+  using cataloger::services::preview::NavigationTracker;
+  NavigationTracker tracker;
+  const auto start = NavigationTracker::Clock::now();
+  NavigationTracker::State state;
+  for (int i = 0; i < 6; ++i) {
+    state = tracker.record(1, 20 - i, start + std::chrono::milliseconds(100 * i));
+  }
+  EXPECT_EQ(state.direction, -1);
+  EXPECT_NEAR(state.velocity, 10.0, 0.5);
+
+  // One tap back against the run does not flip direction.
+  state = tracker.record(1, 16, start + std::chrono::milliseconds(600));
+  EXPECT_EQ(state.direction, -1);
+
+  // A far jump starts over with no direction.
+  state = tracker.record(1, 400, start + std::chrono::milliseconds(700));
+  EXPECT_EQ(state.direction, 0);
+  EXPECT_DOUBLE_EQ(state.velocity, 0.0);
+
+  // Switching roots starts over as well.
+  tracker.record(1, 401, start + std::chrono::milliseconds(800));
+  state = tracker.record(2, 402, start + std::chrono::milliseconds(900));
+  EXPECT_EQ(state.direction, 0);
+  EXPECT_EQ(state.root_id, 2);
+}
+
+TEST(IccProfileCacheTests, InvalidatesOnIdentityChange) {
+  cataloger::services::preview::IccProfileCache cache;
+  const std::filesystem::path path = "/shoot/IMG_0001.CR3";
+  EXPECT_FALSE(cache.lookup(path, 100, 7).has_value());
+
+  cache.record(path, 100, 7, cataloger::services::preview::IccSource::kEmbedded,
+               {1, 2, 3});
+  const auto hit = cache.lookup(path, 100, 7);
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(hit->source, cataloger::services::preview::IccSource::kEmbedded);
+  ASSERT_TRUE(hit->profile);
+  EXPECT_EQ(hit->profile->size(), 3u);
+
+  EXPECT_FALSE(cache.lookup(path, 100, 8).has_value());
+  EXPECT_FALSE(cache.lookup(path, 101, 7).has_value());
+
+  cache.record("/shoot/IMG_0002.CR3", 100, 7,
+               cataloger::services::preview::IccSource::kEmbedded, {1, 2, 3});
+  EXPECT_EQ(cache.uniqueProfileCount(), 1u);
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+
+#include "services/preview/StageTuner.h"
+
+namespace {
+
+using cataloger::services::preview::StageTuner;
+
+// Feeds `windows` full sample windows of latency computed from the current
+// limit, the way a stage would observe them.
+template <typename LatencyModel>
+void drive(StageTuner& tuner, int windows, LatencyModel latency_for_limit) {
+  for (int w = 0; w < windows; ++w) {
+    const auto latency = latency_for_limit(tuner.limit());
+    for (std::size_t i = 0; i < StageTuner::kSampleWindow; ++i) {
+      tuner.recordLatency(latency);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(StageTunerTests, GrowsWhileLatencyStaysFlat) {
+  StageTuner tuner(1, 32, 4);
+  drive(tuner, 40, [](std::size_t) { return 2.0; });
+  EXPECT_GE(tuner.limit(), 31u);
+}
+
+TEST(StageTunerTests, BacksOffWhenConcurrencyOnlyAddsQueueing) {
+  // A single spindle: one read at a time, everything beyond that queues.
+  StageTuner tuner(1, 32, 16);
+  drive(tuner, 60, [](std::size_t limit) { return 10.0 * static_cast<double>(limit); });
+  EXPECT_LE(tuner.limit(), 4u);
+}
+
+TEST(StageTunerTests, SettlesNearDeviceQueueDepth) {
+  // Latency is flat up to eight concurrent requests, then grows linearly.
+  StageTuner tuner(1, 32, 2);
+  drive(tuner, 200, [](std::size_t limit) {
+    return limit <= 8 ? 1.0 : static_cast<double>(limit) / 8.0;
+  });
+  EXPECT_GE(tuner.limit(), 6u);
+  EXPECT_LE(tuner.limit(), 14u);
+}
+
+TEST(StageTunerTests, PinnedLimitNeverMoves) {
+  StageTuner tuner(3, 3, 3);
+  drive(tuner, 10, [](std::size_t) { return 100.0; });
+  EXPECT_EQ(tuner.limit(), 3u);
+  EXPECT_DOUBLE_EQ(tuner.lastLatencyMs(), 100.0);
+}
@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "services/tasks/TaskScheduler.h"
+
+using cataloger::services::tasks::Lane;
+using cataloger::services::tasks::TaskHandle;
+using cataloger::services::tasks::TaskScheduler;
+using cataloger::services::tasks::TaskStatus;
+
+namespace {
+
+TaskScheduler::Options singleWorker() {
+  TaskScheduler::Options options;
+  options.worker_count = 1;
+  options.interactive_reserve = 0;
+  return options;
+}
+
+// Occupies a worker until release() is called.
+struct Gate {
+  std::promise<void> opened;
+  std::shared_future<void> ready{opened.get_future().share()};
+  std::promise<void> entered;
+
+  TaskScheduler::Task task() {
+    return [this](std::stop_token) {
+      entered.set_value();
+      ready.wait();
+    };
+  }
+  void release() { opened.set_value(); }
+};
+
+}  // namespace
+
+TEST(TaskSchedulerTests, RunsHigherPriorityLanesFirst) {
+  TaskScheduler scheduler(singleWorker());
+  Gate gate;
+  scheduler.submit(Lane::kMaintenance, gate.task());
+  gate.entered.get_future().wait();
+
+  std::mutex order_mutex;
+  std::vector<std::string> order;
+  const auto record = [&](std::string name) {
+    return [&, name](std::stop_token) {
+      std::lock_guard lock(order_mutex);
+      order.push_back(name);
+    };
+  };
+  scheduler.submit(Lane::kMetadata, record("metadata"));
+  scheduler.submit(Lane::kPreview, record("preview"));
+  scheduler.submit(Lane::kInteractive, record("interactive"));
+  scheduler.submit(Lane::kPreview, record("preview-2"));
+
+  gate.release();
+  scheduler.waitIdle();
+  EXPECT_EQ(order, (std::vector<std::string>{"interactive", "preview", "preview-2", "metadata"}));
+}
+
+TEST(TaskSchedulerTests, LaneLimitCapsConcurrency) {
+  TaskScheduler::Options options;
+  options.worker_count = 4;
+  options.lane_limits[static_cast<std::size_t>(Lane::kIngest)] = 1;
+  TaskScheduler scheduler(options);
+
+  std::atomic<int> running{0};
+  std::atomic<int> peak{0};
+  for (int i = 0; i < 6; ++i) {
+    scheduler.submit(Lane::kIngest, [&](std::stop_token) {
+      const auto now = ++running;
+      int seen = peak.load();
+      while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      --running;
+    });
+  }
+  scheduler.waitIdle();
+
+  EXPECT_EQ(peak.load(), 1);
+  const auto stats = scheduler.laneStats(Lane::kIngest);
+  EXPECT_EQ(stats.limit, 1u);
+  EXPECT_EQ(stats.completed, 6u);
+  EXPECT_EQ(stats.queued, 0u);
+  EXPECT_EQ(stats.running, 0u);
+  EXPECT_GT(stats.mean_run_ms, 0.0);
+}
+
+TEST(TaskSchedulerTests, BackgroundLanesLeaveAWorkerForInteractiveWork) {
+  TaskScheduler::Options options;
+  options.worker_count = 2;
+  options.interactive_reserve = 1;
+  TaskScheduler scheduler(options);
+
+  Gate gate;
+  scheduler.submit(Lane::kPreview, gate.task());
+  gate.entered.get_future().wait();
+  const auto second = scheduler.submit(Lane::kPreview, [](std::stop_token) {});
+
+  const auto interactive = scheduler.submit(Lane::kInteractive, [](std::stop_token) {});
+  interactive.wait();
+  EXPECT_EQ(interactive.status(), TaskStatus::kCompleted);
+  // The free worker is reserved, so background work still queues.
+  EXPECT_EQ(second.status(), TaskStatus::kQueued);
+
+  gate.release();
+  second.wait();
+  EXPECT_EQ(second.status(), TaskStatus::kCompleted);
+}
+
+TEST(TaskSchedulerTests, DependentsWaitForEveryPrerequisite) {
+  TaskScheduler scheduler;
+  std::atomic<int> finished{0};
+  std::atomic<int> seen_by_last{-1};
+  const auto first = scheduler.submit(Lane::kIngest, [&](std::stop_token) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ++finished;
+  });
+  const auto second = scheduler.submit(Lane::kMetadata, [&](std::stop_token) { ++finished; });
+  const auto last = scheduler.submit(
+      Lane::kDelivery, [&](std::stop_token) { seen_by_last = finished.load(); },
+      {"deliver", {first, second}});
+
+  last.wait();
+  EXPECT_EQ(last.status(), TaskStatus::kCompleted);
+  EXPECT_EQ(seen_by_last.load(), 2);
+}
+
+TEST(TaskSchedulerTests, FailureCancelsTheDependencyChain) {
+  TaskScheduler scheduler;
+  std::atomic<bool> ran{false};
+  const auto failing = scheduler.submit(Lane::kIngest, [](std::stop_token) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    throw std::runtime_error("copy failed");
+  });
+  const auto middle = scheduler.submit(
+      Lane::kMetadata, [&](std::stop_token) { ran = true; }, {"", {failing}});
+  const auto tail = scheduler.submit(
+      Lane::kDelivery, [&](std::stop_token) { ran = true; }, {"", {middle}});
+
+  scheduler.waitIdle();
+  EXPECT_EQ(failing.status(), TaskStatus::kFailed);
+  EXPECT_EQ(middle.status(), TaskStatus::kCancelled);
+  EXPECT_EQ(tail.status(), TaskStatus::kCancelled);
+  EXPECT_FALSE(ran.load());
+  EXPECT_EQ(scheduler.laneStats(Lane::kIngest).failed, 1u);
+
+  // Depending on an already failed task cancels at submit time.
+  const auto late = scheduler.submit(Lane::kDelivery, [](std::stop_token) {}, {"", {failing}});
+  EXPECT_EQ(late.status(), TaskStatus::kCancelled);
+}
+
+TEST(TaskSchedulerTests, CancelDropsQueuedTasksAndStopsRunningOnes) {
+  TaskScheduler scheduler(singleWorker());
+  std::promise<void> started;
+  auto running = scheduler.submit(Lane::kPreview, [&](std::stop_token token) {
+    started.set_value();
+    while (!token.stop_requested()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  started.get_future().wait();
+
+  std::atomic<bool> ran{false};
+  auto queued = scheduler.submit(Lane::kPreview, [&](std::stop_token) { ran = true; });
+  EXPECT_TRUE(queued.cancel());
+  EXPECT_EQ(queued.status(), TaskStatus::kCancelled);
+
+  EXPECT_TRUE(running.cancel());
+  running.wait();
+  EXPECT_EQ(running.status(), TaskStatus::kCancelled);
+  EXPECT_FALSE(running.cancel());
+
+  scheduler.waitIdle();
+  EXPECT_FALSE(ran.load());
+  EXPECT_EQ(scheduler.laneStats(Lane::kPreview).cancelled, 2u);
+}
+
+TEST(TaskSchedulerTests, IdleWorkersStealTasksSubmittedFromAWorker) {
+  TaskScheduler::Options options;
+  options.worker_count = 4;
+  options.interactive_reserve = 0;
+  TaskScheduler scheduler(options);
+
+  std::atomic<int> done{0};
+  constexpr int kChildren = 12;
+  const auto parent = scheduler.submit(Lane::kInteractive, [&](std::stop_token) {
+    for (int i = 0; i < kChildren; ++i) {
+      scheduler.submit(Lane::kPreview, [&](std::stop_token) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        ++done;
+      });
+    }
+    // Children sit in this worker's own deque; only thieves can run them
+    // while it spins here.
+    while (done.load() < kChildren) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  parent.wait();
+  scheduler.waitIdle();
+  const auto stats = scheduler.laneStats(Lane::kPreview);
+  EXPECT_EQ(stats.completed, static_cast<std::uint64_t>(kChildren));
+  EXPECT_EQ(stats.stolen, static_cast<std::uint64_t>(kChildren));
+}
+
+TEST(TaskSchedulerTests, DestructorCancelsPendingWork) {
+  std::atomic<bool> ran{false};
+  TaskHandle pending;
+  Gate gate;
+  std::thread releaser;
+  {
+    TaskScheduler scheduler(singleWorker());
+    scheduler.submit(Lane::kPreview, gate.task());
+    gate.entered.get_future().wait();
+    pending = scheduler.submit(Lane::kPreview, [&](std::stop_token) { ran = true; });
+    releaser = std::thread([&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      gate.release();
+    });
+    // Destroyed while the gate task still runs.
+  }
+  releaser.join();
+  EXPECT_EQ(pending.status(), TaskStatus::kCancelled);
+  EXPECT_FALSE(pending.cancel());
+  EXPECT_FALSE(ran.load());
+}
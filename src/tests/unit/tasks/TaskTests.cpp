@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "services/tasks/Task.h"
+
+using cataloger::services::tasks::Detach;
+using cataloger::services::tasks::InlineExecutor;
+using cataloger::services::tasks::Lane;
+using cataloger::services::tasks::ResumeOn;
+using cataloger::services::tasks::SchedulerExecutor;
+using cataloger::services::tasks::SyncWait;
+using cataloger::services::tasks::Task;
+using cataloger::services::tasks::TaskScheduler;
+
+namespace {
+
+Task<int> Answer() {
+  co_return 42;
+}
+
+Task<std::string> Describe() {
+  const auto value = co_await Answer();
+  co_return "answer=" + std::to_string(value);
+}
+
+Task<int> Fail() {
+  throw std::runtime_error("query failed");
+  co_return 0;
+}
+
+Task<std::thread::id> ThreadAfterHop(SchedulerExecutor& executor) {
+  co_await ResumeOn(executor);
+  co_return std::this_thread::get_id();
+}
+
+Task<void> CountOn(SchedulerExecutor& executor, std::atomic<int>& counter) {
+  co_await ResumeOn(executor);
+  ++counter;
+}
+
+Task<int> Deep(int depth) {
+  if (depth == 0) {
+    co_return 0;
+  }
+  co_return 1 + co_await Deep(depth - 1);
+}
+
+}  // namespace
+
+TEST(TaskTests, ComposesAndReturnsValues) {
+  EXPECT_EQ(SyncWait(Describe()), "answer=42");
+}
+
+TEST(TaskTests, StartsLazily) {
+  bool started = false;
+  const auto body = [&]() -> Task<void> {
+    started = true;
+    co_return;
+  };
+  auto task = body();
+  EXPECT_FALSE(started);
+  SyncWait(std::move(task));
+  EXPECT_TRUE(started);
+}
+
+TEST(TaskTests, PropagatesExceptionsToTheAwaiter) {
+  const auto body = []() -> Task<bool> {
+    try {
+      co_await Fail();
+    } catch (const std::runtime_error&) {
+      co_return true;
+    }
+    co_return false;
+  };
+  EXPECT_TRUE(SyncWait(body()));
+  EXPECT_THROW(SyncWait(Fail()), std::runtime_error);
+}
+
+TEST(TaskTests, ResumeOnMovesTheContinuationToTheExecutor) {
+  TaskScheduler scheduler;
+  SchedulerExecutor executor(scheduler, Lane::kInteractive);
+  EXPECT_NE(SyncWait(ThreadAfterHop(executor)), std::this_thread::get_id());
+
+  InlineExecutor inline_executor;
+  const auto here = [&]() -> Task<std::thread::id> {
+    co_await ResumeOn(inline_executor);
+    co_return std::this_thread::get_id();
+  };
+  EXPECT_EQ(SyncWait(here()), std::this_thread::get_id());
+}
+
+TEST(TaskTests, NestedAwaitsUnwindInOrder) {
+  EXPECT_EQ(SyncWait(Deep(1000)), 1000);
+}
+
+TEST(TaskTests, DetachedTasksRunToCompletion) {
+  TaskScheduler scheduler;
+  SchedulerExecutor executor(scheduler, Lane::kMetadata);
+  std::atomic<int> counter{0};
+  for (int i = 0; i < 16; ++i) {
+    Detach(CountOn(executor, counter));
+  }
+  scheduler.waitIdle();
+  EXPECT_EQ(counter.load(), 16);
+}
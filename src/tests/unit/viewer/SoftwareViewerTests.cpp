@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "viewer/ViewerContract.h"
+#include "viewer/software/SoftwareViewer.h"
+
+using cataloger::viewer::Backend;
+using cataloger::viewer::FrameContext;
+using cataloger::viewer::SoftwareTexture;
+using cataloger::viewer::SoftwareViewer;
+using cataloger::viewer::TileDraw;
+
+namespace {
+
+struct SolidTexture {
+  SolidTexture(std::uint32_t width, std::uint32_t height, std::uint8_t value)
+      : texels(static_cast<std::size_t>(width) * height * 4, value) {
+    texture.texels = texels.data();
+    texture.width = width;
+    texture.height = height;
+    texture.row_bytes = static_cast<std::size_t>(width) * 4;
+  }
+
+  cataloger::viewer::TextureHandle handle() {
+    return {Backend::kSoftware, &texture};
+  }
+
+  std::vector<std::uint8_t> texels;
+  SoftwareTexture texture;
+};
+
+std::uint8_t texelAt(const SoftwareViewer& viewer, std::uint32_t x, std::uint32_t y) {
+  return viewer.framebuffer()[(static_cast<std::size_t>(y) * viewer.framebufferWidth() + x) * 4];
+}
+
+}  // namespace
+
+TEST(SoftwareViewerTests, FitsTextureIntoFramebuffer) {
+  SoftwareViewer viewer;
+  SolidTexture source(200, 50, 90);
+
+  FrameContext context;
+  context.width = 100;
+  context.height = 100;
+  context.vsync = false;
+  context.texture = source.handle();
+
+  ASSERT_TRUE(viewer.beginFrame(context));
+  std::string error;
+  ASSERT_TRUE(viewer.submitFrame(context, error)) << error;
+  ASSERT_TRUE(viewer.present(error)) << error;
+
+  // 200x50 fits as 100x25, letterboxed vertically.
+  EXPECT_EQ(texelAt(viewer, 50, 50), 90);
+  EXPECT_EQ(texelAt(viewer, 50, 10), 0);
+  EXPECT_EQ(viewer.framesPresented(), 1u);
+}
+
+TEST(SoftwareViewerTests, CompositesTilesAtTheirOffsets) {
+  SoftwareViewer viewer;
+  SolidTexture left(64, 64, 10);
+  SolidTexture right(64, 64, 20);
+
+  FrameContext context;
+  context.width = 100;
+  context.height = 80;
+  context.vsync = false;
+  context.tiles = {TileDraw{left.handle(), -16, 0, 64, 64},
+                   TileDraw{right.handle(), 48, 0, 64, 64}};
+
+  ASSERT_TRUE(viewer.beginFrame(context));
+  std::string error;
+  ASSERT_TRUE(viewer.submitFrame(context, error)) << error;
+  ASSERT_TRUE(viewer.present(error)) << error;
+
+  EXPECT_EQ(texelAt(viewer, 0, 0), 10);
+  EXPECT_EQ(texelAt(viewer, 47, 63), 10);
+  EXPECT_EQ(texelAt(viewer, 48, 0), 20);
+  EXPECT_EQ(texelAt(viewer, 99, 63), 20);
+  EXPECT_EQ(texelAt(viewer, 50, 70), 0);
+}
+
+TEST(SoftwareViewerTests, CountsVblanksMissedBySlowFrames) {
+  SoftwareViewer viewer(SoftwareViewer::Options{100.0, 16});
+  SolidTexture source(8, 8, 1);
+
+  FrameContext context;
+  context.width = 8;
+  context.height = 8;
+  context.texture = source.handle();
+
+  std::string error;
+  for (int frame = 0; frame < 3; ++frame) {
+    ASSERT_TRUE(viewer.beginFrame(context));
+    if (frame == 2) {
+      // Three 10 ms vblanks go by while this frame renders.
+      std::this_thread::sleep_for(std::chrono::milliseconds(35));
+    }
+    ASSERT_TRUE(viewer.submitFrame(context, error)) << error;
+    ASSERT_TRUE(viewer.present(error)) << error;
+  }
+
+  const auto timings = viewer.timings();
+  ASSERT_EQ(timings.size(), 3u);
+  EXPECT_GE(timings[2].missed_vblanks, 2u);
+  EXPECT_EQ(viewer.droppedFrames(), timings[1].missed_vblanks + timings[2].missed_vblanks);
+  EXPECT_GE(timings[1].presented - timings[0].presented, std::chrono::milliseconds(9));
+}
+
+TEST(SoftwareViewerTests, RejectsForeignHandlesAndOutOfOrderCalls) {
+  SoftwareViewer viewer;
+  FrameContext context;
+  context.width = 8;
+  context.height = 8;
+  context.texture.backend = Backend::kMetal;
+  EXPECT_FALSE(viewer.beginFrame(context));
+
+  std::string error;
+  EXPECT_FALSE(viewer.present(error));
+  EXPECT_FALSE(error.empty());
+}
@@ -1,18 +1,38 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace cataloger::viewer {
 
-enum class Backend { kMetal, kStub };
+enum class Backend { kMetal, kSoftware, kStub };
 
 struct TextureHandle {
   Backend backend{Backend::kStub};
   void* native_handle{nullptr};
 };
 
+// What a kSoftware TextureHandle points at: 4-byte texels in the
+// framebuffer's channel order, `row_bytes` apart.
+struct SoftwareTexture {
+  const std::uint8_t* texels{nullptr};
+  std::uint32_t width{0};
+  std::uint32_t height{0};
+  std::size_t row_bytes{0};
+};
+
+// One mip tile placed in the frame, in drawable pixels.
+struct TileDraw {
+  TextureHandle texture;
+  std::int32_t x{0};
+  std::int32_t y{0};
+  std::uint32_t width{0};
+  std::uint32_t height{0};
+};
+
 struct FrameContext {
   std::uint32_t width{0};
   std::uint32_t height{0};
@@ -21,6 +41,9 @@ struct FrameContext {
   // Optional color space tag (e.g., "sRGB IEC61966-2.1", "Display P3").
   std::string color_space;
   TextureHandle texture;
+  // When non-empty, the frame is composed from these tiles instead of
+  // `texture`; tiles are clipped to the frame.
+  std::vector<TileDraw> tiles;
 };
 
 class Viewer {
@@ -40,5 +63,7 @@ public:
 #if defined(__APPLE__)
 std::unique_ptr<Viewer> CreateMetalViewer();
 #endif
+// Offscreen CPU compositor; see software/SoftwareViewer.h.
+std::unique_ptr<Viewer> CreateSoftwareViewer();
 
 }  // namespace cataloger::viewer
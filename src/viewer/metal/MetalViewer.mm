@@ -5,6 +5,7 @@
 #import <Metal/Metal.h>
 #import <QuartzCore/CAMetalLayer.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
@@ -36,10 +37,15 @@ public:
     if (!device_ || !queue_ || !layer_) {
       return false;
     }
-    if (context.texture.backend != Backend::kMetal ||
-        context.texture.native_handle == nullptr) {
+    if (context.tiles.empty() && (context.texture.backend != Backend::kMetal ||
+                                  context.texture.native_handle == nullptr)) {
       return false;
     }
+    for (const auto& tile : context.tiles) {
+      if (tile.texture.backend != Backend::kMetal || tile.texture.native_handle == nullptr) {
+        return false;
+      }
+    }
 
     layer_.drawableSize = CGSizeMake(context.width * context.scale,
                                      context.height * context.scale);
@@ -57,6 +63,10 @@ public:
       return false;
     }
 
+    if (!context.tiles.empty()) {
+      return submitTiles(context, error);
+    }
+
     id<MTLTexture> source = HandleToTexture(context.texture);
     if (!source) {
       error = "Invalid Metal texture handle";
@@ -125,6 +135,56 @@ public:
   }
 
 private:
+  // Blits each tile at its offset, clipped to the drawable, in one encoder.
+  bool submitTiles(const FrameContext& context, std::string& error) {
+    id<MTLCommandBuffer> cmd = [queue_ commandBuffer];
+    if (!cmd) {
+      error = "Failed to create Metal command buffer";
+      return false;
+    }
+    id<MTLBlitCommandEncoder> blit = [cmd blitCommandEncoder];
+    if (!blit) {
+      error = "Failed to create Metal blit encoder";
+      return false;
+    }
+
+    id<MTLTexture> target = drawable_.texture;
+    const auto target_width = static_cast<std::int64_t>([target width]);
+    const auto target_height = static_cast<std::int64_t>([target height]);
+    for (const auto& tile : context.tiles) {
+      id<MTLTexture> source = HandleToTexture(tile.texture);
+      const std::int64_t left = std::max<std::int64_t>(tile.x, 0);
+      const std::int64_t top = std::max<std::int64_t>(tile.y, 0);
+      const std::int64_t right = std::min<std::int64_t>(
+          {static_cast<std::int64_t>(tile.x) + tile.width,
+           static_cast<std::int64_t>(tile.x) + static_cast<std::int64_t>([source width]),
+           target_width});
+      const std::int64_t bottom = std::min<std::int64_t>(
+          {static_cast<std::int64_t>(tile.y) + tile.height,
+           static_cast<std::int64_t>(tile.y) + static_cast<std::int64_t>([source height]),
+           target_height});
+      if (right <= left || bottom <= top) {
+        continue;
+      }
+      [blit copyFromTexture:source
+                 sourceSlice:0
+                 sourceLevel:0
+                sourceOrigin:MTLOriginMake(static_cast<NSUInteger>(left - tile.x),
+                                           static_cast<NSUInteger>(top - tile.y), 0)
+                  sourceSize:MTLSizeMake(static_cast<NSUInteger>(right - left),
+                                         static_cast<NSUInteger>(bottom - top), 1)
+                   toTexture:target
+            destinationSlice:0
+            destinationLevel:0
+           destinationOrigin:MTLOriginMake(static_cast<NSUInteger>(left),
+                                           static_cast<NSUInteger>(top), 0)];
+    }
+    [blit endEncoding];
+
+    pending_command_ = cmd;
+    return true;
+  }
+
   id<MTLDevice> device_{nil};
   id<MTLCommandQueue> queue_{nil};
   CAMetalLayer* layer_{nil};
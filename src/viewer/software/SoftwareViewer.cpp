@@ -0,0 +1,206 @@
+#include "viewer/software/SoftwareViewer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace cataloger::viewer {
+
+namespace {
+
+constexpr std::size_t kTexelBytes = 4;
+constexpr std::uint8_t kClearTexel[kTexelBytes] = {0, 0, 0, 0xFF};
+
+double elapsedMs(std::chrono::steady_clock::time_point from,
+                 std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+const SoftwareTexture* HandleToTexture(const TextureHandle& handle) {
+  if (handle.backend != Backend::kSoftware) {
+    return nullptr;
+  }
+  return static_cast<const SoftwareTexture*>(handle.native_handle);
+}
+
+bool IsValid(const SoftwareTexture* texture) {
+  return texture && texture->texels && texture->width > 0 && texture->height > 0 &&
+         texture->row_bytes >= static_cast<std::size_t>(texture->width) * kTexelBytes;
+}
+
+}  // namespace
+
+SoftwareViewer::SoftwareViewer(Options options)
+    : options_(options),
+      interval_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / std::max(options_.refresh_hz, 1.0)))) {}
+
+bool SoftwareViewer::beginFrame(FrameContext& context) {
+  if (context.width == 0 || context.height == 0) {
+    return false;
+  }
+  if (context.tiles.empty() && !IsValid(HandleToTexture(context.texture))) {
+    return false;
+  }
+  for (const auto& tile : context.tiles) {
+    if (!IsValid(HandleToTexture(tile.texture))) {
+      return false;
+    }
+  }
+
+  const auto scale = std::max(context.scale, 1.0);
+  width_ = static_cast<std::uint32_t>(std::lround(context.width * scale));
+  height_ = static_cast<std::uint32_t>(std::lround(context.height * scale));
+  framebuffer_.resize(static_cast<std::size_t>(width_) * height_ * kTexelBytes);
+  vsync_ = context.vsync;
+  frame_open_ = true;
+  frame_submitted_ = false;
+  frame_start_ = std::chrono::steady_clock::now();
+  return true;
+}
+
+bool SoftwareViewer::submitFrame(const FrameContext& context, std::string& error) {
+  if (!frame_open_) {
+    error = "No frame in progress";
+    return false;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t offset = 0; offset < framebuffer_.size(); offset += kTexelBytes) {
+    std::memcpy(framebuffer_.data() + offset, kClearTexel, kTexelBytes);
+  }
+  if (!context.tiles.empty()) {
+    for (const auto& tile : context.tiles) {
+      compositeTile(tile);
+    }
+  } else {
+    const auto* texture = HandleToTexture(context.texture);
+    if (!IsValid(texture)) {
+      error = "Invalid software texture handle";
+      return false;
+    }
+    compositeTexture(*texture);
+  }
+  composite_ms_ = elapsedMs(start, std::chrono::steady_clock::now());
+  frame_submitted_ = true;
+  return true;
+}
+
+bool SoftwareViewer::present(std::string& error) {
+  if (!frame_open_ || !frame_submitted_) {
+    error = "No submitted frame to present";
+    return false;
+  }
+  frame_open_ = false;
+  frame_submitted_ = false;
+
+  auto presented = std::chrono::steady_clock::now();
+  std::uint32_t missed = 0;
+  if (vsync_) {
+    // The frame goes out at the first vblank after it is ready, and never
+    // two frames on one vblank.
+    if (!epoch_) {
+      epoch_ = presented;
+    }
+    auto vblank = static_cast<std::int64_t>((presented - *epoch_) / interval_);
+    if (presented > *epoch_ + vblank * interval_) {
+      ++vblank;
+    }
+    vblank = std::max(vblank, last_vblank_ + 1);
+    if (last_vblank_ >= 0) {
+      missed = static_cast<std::uint32_t>(vblank - last_vblank_ - 1);
+    }
+    last_vblank_ = vblank;
+    presented = *epoch_ + vblank * interval_;
+    std::this_thread::sleep_until(presented);
+  }
+
+  std::lock_guard lock(stats_mutex_);
+  FrameTiming timing;
+  timing.frame = frames_++;
+  timing.composite_ms = composite_ms_;
+  timing.frame_ms = elapsedMs(frame_start_, presented);
+  timing.missed_vblanks = missed;
+  timing.presented = presented;
+  dropped_ += missed;
+  timings_.push_back(timing);
+  while (timings_.size() > options_.timing_history) {
+    timings_.pop_front();
+  }
+  return true;
+}
+
+std::vector<FrameTiming> SoftwareViewer::timings() const {
+  std::lock_guard lock(stats_mutex_);
+  return {timings_.begin(), timings_.end()};
+}
+
+std::uint64_t SoftwareViewer::framesPresented() const {
+  std::lock_guard lock(stats_mutex_);
+  return frames_;
+}
+
+std::uint64_t SoftwareViewer::droppedFrames() const {
+  std::lock_guard lock(stats_mutex_);
+  return dropped_;
+}
+
+// Fit inside the framebuffer, centred, keeping the aspect ratio.
+void SoftwareViewer::compositeTexture(const SoftwareTexture& texture) {
+  const double fit = std::min(static_cast<double>(width_) / texture.width,
+                              static_cast<double>(height_) / texture.height);
+  const auto out_width = std::clamp<std::uint32_t>(
+      static_cast<std::uint32_t>(std::lround(texture.width * fit)), 1, width_);
+  const auto out_height = std::clamp<std::uint32_t>(
+      static_cast<std::uint32_t>(std::lround(texture.height * fit)), 1, height_);
+  const auto left = (width_ - out_width) / 2;
+  const auto top = (height_ - out_height) / 2;
+
+  std::vector<std::uint32_t> columns(out_width);
+  for (std::uint32_t x = 0; x < out_width; ++x) {
+    columns[x] = std::min(static_cast<std::uint32_t>((x + 0.5) / fit), texture.width - 1) *
+                 static_cast<std::uint32_t>(kTexelBytes);
+  }
+  const auto row_bytes = static_cast<std::size_t>(width_) * kTexelBytes;
+  for (std::uint32_t y = 0; y < out_height; ++y) {
+    const auto source_y = std::min(static_cast<std::uint32_t>((y + 0.5) / fit), texture.height - 1);
+    const auto* src = texture.texels + static_cast<std::size_t>(source_y) * texture.row_bytes;
+    auto* dst = framebuffer_.data() + static_cast<std::size_t>(top + y) * row_bytes +
+                static_cast<std::size_t>(left) * kTexelBytes;
+    for (std::uint32_t x = 0; x < out_width; ++x) {
+      std::memcpy(dst + static_cast<std::size_t>(x) * kTexelBytes, src + columns[x], kTexelBytes);
+    }
+  }
+}
+
+void SoftwareViewer::compositeTile(const TileDraw& tile) {
+  const auto& texture = *HandleToTexture(tile.texture);
+  const std::int64_t left = std::max<std::int64_t>(tile.x, 0);
+  const std::int64_t top = std::max<std::int64_t>(tile.y, 0);
+  const std::int64_t right =
+      std::min<std::int64_t>({static_cast<std::int64_t>(tile.x) + tile.width,
+                              static_cast<std::int64_t>(tile.x) + texture.width, width_});
+  const std::int64_t bottom =
+      std::min<std::int64_t>({static_cast<std::int64_t>(tile.y) + tile.height,
+                              static_cast<std::int64_t>(tile.y) + texture.height, height_});
+  if (right <= left || bottom <= top) {
+    return;
+  }
+
+  const auto row_bytes = static_cast<std::size_t>(width_) * kTexelBytes;
+  const auto copy_bytes = static_cast<std::size_t>(right - left) * kTexelBytes;
+  for (std::int64_t y = top; y < bottom; ++y) {
+    const auto* src = texture.texels + static_cast<std::size_t>(y - tile.y) * texture.row_bytes +
+                      static_cast<std::size_t>(left - tile.x) * kTexelBytes;
+    std::memcpy(framebuffer_.data() + static_cast<std::size_t>(y) * row_bytes +
+                    static_cast<std::size_t>(left) * kTexelBytes,
+                src, copy_bytes);
+  }
+}
+
+std::unique_ptr<Viewer> CreateSoftwareViewer() {
+  return std::make_unique<SoftwareViewer>();
+}
+
+}  // namespace cataloger::viewer
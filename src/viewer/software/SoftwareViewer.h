@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "viewer/ViewerContract.h"
+
+namespace cataloger::viewer {
+
+struct FrameTiming {
+  std::uint64_t frame{0};
+  double composite_ms{0.0};  // submitFrame work
+  double frame_ms{0.0};      // beginFrame to the frame reaching the screen
+  std::uint32_t missed_vblanks{0};
+  std::chrono::steady_clock::time_point presented;
+};
+
+// Offscreen viewer for hosts without a display (CI, Linux). Composites
+// kSoftware textures into a CPU framebuffer: a single texture is scaled to
+// fit with nearest-neighbour sampling, tiles are copied 1:1 at their
+// offsets. With vsync, present() waits for the next simulated vblank and
+// counts the vblanks that went by without a new frame as dropped.
+class SoftwareViewer : public Viewer {
+public:
+  struct Options {
+    double refresh_hz{60.0};
+    std::size_t timing_history{4096};
+  };
+
+  explicit SoftwareViewer(Options options);
+  SoftwareViewer() : SoftwareViewer(Options{}) {}
+
+  bool beginFrame(FrameContext& context) override;
+  bool submitFrame(const FrameContext& context, std::string& error) override;
+  bool present(std::string& error) override;
+
+  // BGRA framebuffer of the last submitted frame.
+  [[nodiscard]] const std::vector<std::uint8_t>& framebuffer() const noexcept {
+    return framebuffer_;
+  }
+  [[nodiscard]] std::uint32_t framebufferWidth() const noexcept { return width_; }
+  [[nodiscard]] std::uint32_t framebufferHeight() const noexcept { return height_; }
+
+  [[nodiscard]] std::vector<FrameTiming> timings() const;
+  [[nodiscard]] std::uint64_t framesPresented() const;
+  [[nodiscard]] std::uint64_t droppedFrames() const;
+
+private:
+  void compositeTexture(const SoftwareTexture& texture);
+  void compositeTile(const TileDraw& tile);
+
+  Options options_;
+  std::chrono::steady_clock::duration interval_;
+  std::vector<std::uint8_t> framebuffer_;
+  std::uint32_t width_{0};
+  std::uint32_t height_{0};
+  bool vsync_{true};
+  bool frame_open_{false};
+  bool frame_submitted_{false};
+  double composite_ms_{0.0};
+  std::chrono::steady_clock::time_point frame_start_;
+  std::optional<std::chrono::steady_clock::time_point> epoch_;
+  std::int64_t last_vblank_{-1};
+
+  mutable std::mutex stats_mutex_;
+  std::deque<FrameTiming> timings_;
+  std::uint64_t frames_{0};
+  std::uint64_t dropped_{0};
+};
+
+}  // namespace cataloger::viewer